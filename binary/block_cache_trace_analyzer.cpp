@@ -0,0 +1,189 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/trace.h"
+#include "table/block_cache_tracer.h"
+#include "table/cache_simulator.h"
+
+// Summarizes a trace recorded with DB::StartBlockCacheTrace() and replays
+// it against simulated block caches to produce a miss-ratio curve.
+//
+//   block_cache_trace_analyzer --block_cache_trace_file=/path/trace
+//       [--policies=lru,clock,fifo,opt] [--cache_sizes=8M,64M,1G]
+//
+// Without --cache_sizes the capacities double from 1/64 of the working set
+// up to the whole working set.  The curve is printed as CSV with one row
+// per policy and capacity.  "opt" is Belady's clairvoyant policy, the
+// lower bound any online policy can reach.
+
+// Trace file written by DB::StartBlockCacheTrace()
+static const char *FLAGS_block_cache_trace_file = nullptr;
+
+// Comma-separated list of cache policies to simulate
+static std::string FLAGS_policies = "lru,clock,fifo,opt";
+
+// Comma-separated list of cache capacities in bytes, with an optional
+// K, M or G suffix.  Empty means derive them from the working set.
+static std::string FLAGS_cache_sizes;
+
+static std::vector<std::string> Split(const std::string &s) {
+  std::vector<std::string> result;
+  size_t start = 0;
+  while (start <= s.size()) {
+    size_t end = s.find(',', start);
+    if (end == std::string::npos) { end = s.size(); }
+    if (end > start) { result.push_back(s.substr(start, end - start)); }
+    start = end + 1;
+  }
+  return result;
+}
+
+static bool ParseSize(const std::string &s, uint64_t *size) {
+  char *end;
+  const unsigned long long n = std::strtoull(s.c_str(), &end, 10);
+  if (end == s.c_str()) { return false; }
+  uint64_t multiplier = 1;
+  switch (*end) {
+    case '\0':
+      break;
+    case 'K':
+    case 'k':
+      multiplier = 1ull << 10;
+      end++;
+      break;
+    case 'M':
+    case 'm':
+      multiplier = 1ull << 20;
+      end++;
+      break;
+    case 'G':
+    case 'g':
+      multiplier = 1ull << 30;
+      end++;
+      break;
+    default:
+      return false;
+  }
+  if (*end != '\0') { return false; }
+  *size = n * multiplier;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strncmp(argv[i], "--block_cache_trace_file=", 25) == 0) {
+      FLAGS_block_cache_trace_file = argv[i] + 25;
+    } else if (std::strncmp(argv[i], "--policies=", 11) == 0) {
+      FLAGS_policies = argv[i] + 11;
+    } else if (std::strncmp(argv[i], "--cache_sizes=", 14) == 0) {
+      FLAGS_cache_sizes = argv[i] + 14;
+    } else {
+      std::fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+      std::exit(1);
+    }
+  }
+  if (FLAGS_block_cache_trace_file == nullptr) {
+    std::fprintf(stderr, "--block_cache_trace_file is required\n");
+    std::exit(1);
+  }
+  const std::vector<std::string> policies = Split(FLAGS_policies);
+  for (const std::string &policy : policies) {
+    if (leveldb::NewSimCache(policy, 0) == nullptr) {
+      std::fprintf(stderr, "unknown policy '%s'\n", policy.c_str());
+      std::exit(1);
+    }
+  }
+  std::vector<uint64_t> capacities;
+  for (const std::string &size : Split(FLAGS_cache_sizes)) {
+    uint64_t capacity;
+    if (!ParseSize(size, &capacity)) {
+      std::fprintf(stderr, "invalid cache size '%s'\n", size.c_str());
+      std::exit(1);
+    }
+    capacities.push_back(capacity);
+  }
+
+  std::unique_ptr<leveldb::TraceReader> trace_reader;
+  leveldb::Status s = leveldb::NewFileTraceReader(
+      leveldb::Env::Default(), FLAGS_block_cache_trace_file, &trace_reader);
+  leveldb::BlockCacheTraceReader reader(std::move(trace_reader));
+  if (s.ok()) { s = reader.ReadHeader(); }
+  if (!s.ok()) {
+    std::fprintf(stderr, "trace open error: %s\n", s.ToString().c_str());
+    std::exit(1);
+  }
+
+  // Access counts by caller and by block type
+  static const char *kCallerNames[leveldb::kMaxTableReaderCaller] = {
+      nullptr,      "get",   "multiget",     "iterator",
+      "compaction", "flush", "uncategorized"};
+  static const char *kBlockTypeNames[leveldb::kTraceBlockTypeMax] = {
+      "data", "index", "filter"};
+  uint64_t caller_accesses[leveldb::kMaxTableReaderCaller] = {};
+  uint64_t caller_misses[leveldb::kMaxTableReaderCaller] = {};
+  uint64_t type_accesses[leveldb::kTraceBlockTypeMax] = {};
+
+  leveldb::CacheSimulator simulator;
+  leveldb::BlockCacheTraceRecord record;
+  while (true) {
+    s = reader.ReadAccess(&record);
+    if (!s.ok()) { break; }
+    simulator.Add(record);
+    caller_accesses[record.caller]++;
+    if (!record.is_cache_hit) { caller_misses[record.caller]++; }
+    type_accesses[record.block_type]++;
+  }
+  if (!s.IsNotFound()) {
+    std::fprintf(stderr, "trace read error: %s\n", s.ToString().c_str());
+    std::exit(1);
+  }
+  if (simulator.num_accesses() == 0) {
+    std::fprintf(stderr, "trace has no block accesses\n");
+    std::exit(1);
+  }
+
+  std::fprintf(stdout, "accesses:          %llu\n",
+               static_cast<unsigned long long>(simulator.num_accesses()));
+  std::fprintf(stdout, "working set:       %llu bytes\n",
+               static_cast<unsigned long long>(simulator.working_set_size()));
+  std::fprintf(stdout, "traced miss ratio: %.4f\n",
+               simulator.observed_miss_ratio());
+  for (int c = 1; c < leveldb::kMaxTableReaderCaller; c++) {
+    if (caller_accesses[c] == 0) { continue; }
+    std::fprintf(stdout, "  %-14s %12llu accesses, miss ratio %.4f\n",
+                 kCallerNames[c],
+                 static_cast<unsigned long long>(caller_accesses[c]),
+                 static_cast<double>(caller_misses[c]) / caller_accesses[c]);
+  }
+  for (int t = 0; t < leveldb::kTraceBlockTypeMax; t++) {
+    if (type_accesses[t] == 0) { continue; }
+    std::fprintf(stdout, "  %-14s %12llu accesses\n", kBlockTypeNames[t],
+                 static_cast<unsigned long long>(type_accesses[t]));
+  }
+
+  if (capacities.empty()) {
+    const uint64_t working_set = simulator.working_set_size();
+    for (int shift = 6; shift >= 0; shift--) {
+      const uint64_t capacity = working_set >> shift;
+      if (capacity > 0) { capacities.push_back(capacity); }
+    }
+  }
+
+  std::fprintf(stdout, "\npolicy,capacity,miss_ratio,byte_miss_ratio\n");
+  for (const leveldb::SimResult &result :
+       simulator.MissRatioCurve(policies, capacities)) {
+    std::fprintf(stdout, "%s,%llu,%.6f,%.6f\n", result.policy.c_str(),
+                 static_cast<unsigned long long>(result.capacity),
+                 result.miss_ratio(), result.byte_miss_ratio());
+  }
+  return 0;
+}
@@ -0,0 +1,873 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/secondary_cache.h"
+#include "leveldb/statistics.h"
+#include "leveldb/trace.h"
+#include "leveldb/write_batch.h"
+#include "port/port.h"
+#include "util/histogram.h"
+#include "util/mutexlock.h"
+#include "util/random.h"
+
+// Comma-separated list of operations to run in the specified order
+//   Actual benchmarks:
+//      fillseq          -- write N values in sequential key order
+//      fillrandom       -- write N values in random key order
+//      overwrite        -- overwrite N values in random key order
+//      readseq          -- read N times sequentially
+//      readrandom       -- read N times in random order
+//      seekrandom       -- N random seeks, each followed by a short scan
+//      multireadrandom  -- N random reads issued in MultiGet batches
+//      readwhilewriting -- 1 writer, N threads doing random reads
+//      mixed            -- random reads and writes, see --readwritepercent
+//   Meta operations:
+//      stats            -- print DB stats
+static const char *FLAGS_benchmarks =
+    "fillseq,fillrandom,overwrite,readrandom,readseq,seekrandom,"
+    "multireadrandom,readwhilewriting,mixed";
+
+// Number of key/values to place in database
+static int FLAGS_num = 1000000;
+
+// Number of read operations to do.  If negative, do FLAGS_num reads.
+static int FLAGS_reads = -1;
+
+// Number of concurrent threads to run.
+static int FLAGS_threads = 1;
+
+// Size of each key, at least 16 bytes are needed to hold the key number
+static int FLAGS_key_size = 16;
+
+// Size of each value
+static int FLAGS_value_size = 100;
+
+// Distribution of the keys chosen by random operations: uniform or zipfian
+static const char *FLAGS_distribution = "uniform";
+
+// Skew of the zipfian distribution, in (0, 1)
+static double FLAGS_zipf_theta = 0.99;
+
+// Number of keys per MultiGet call in multireadrandom
+static int FLAGS_batch_size = 16;
+
+// Number of entries read after each seek in seekrandom
+static int FLAGS_seek_nexts = 10;
+
+// Percentage of operations that are reads in mixed, the rest are writes
+static int FLAGS_readwritepercent = 90;
+
+// Number of bytes to buffer in memtable before compacting
+static int FLAGS_write_buffer_size = 0;
+
+// Number of bytes to use as a cache of uncompressed data.
+// Negative means use default settings.
+static long FLAGS_cache_size = -1;
+
+// Number of bytes to use as a cache of compressed data.  0 means none.
+static long FLAGS_compressed_cache_size = 0;
+
+// Number of bytes to use as a cache of point lookup results.  0 means none.
+static long FLAGS_row_cache_size = 0;
+
+// Number of bytes of local files to keep blocks evicted from the cache in,
+// next to the database.  0 means no secondary cache.
+static long FLAGS_secondary_cache_size = 0;
+
+// Maximum number of files to keep open at the same time (use default if == 0,
+// keep every file open if -1)
+static int FLAGS_open_files = 0;
+
+// If true, keep the tables of level-0 files open for good
+static bool FLAGS_pin_l0_filter_and_index_blocks = false;
+
+// Bloom filter bits per key.
+// Negative means use default settings.
+static int FLAGS_bloom_bits = -1;
+
+// Compression algorithm: none, snappy or zlib
+static const char *FLAGS_compression = "snappy";
+
+// Sync every write
+static bool FLAGS_sync = false;
+
+// Skip the write-ahead log
+static bool FLAGS_disable_wal = false;
+
+// Overlap WAL writes of one write group with memtable inserts of the last
+static bool FLAGS_enable_pipelined_write = false;
+
+// Insert write groups into the memtable concurrently, out of order
+static bool FLAGS_unordered_write = false;
+
+// Buffer WAL records until the buffer fills instead of writing each group
+static bool FLAGS_manual_wal_flush = false;
+
+// Collect and print DB statistics at the end of the run
+static bool FLAGS_statistics = false;
+
+// If true, do not destroy the existing database.  If you set this
+// flag and also specify a benchmark that wants a fresh database, that
+// benchmark will fail.
+static bool FLAGS_use_existing_db = false;
+
+// Use the db with the following name.
+static const char *FLAGS_db = nullptr;
+
+// If set, record the calls made by the benchmarks into this trace file,
+// see the trace_replay tool.
+static const char *FLAGS_trace_file = nullptr;
+
+// If set, record every block cache access into this trace file, see the
+// block_cache_trace_analyzer tool.
+static const char *FLAGS_block_cache_trace_file = nullptr;
+
+namespace leveldb {
+
+namespace {
+
+// Helper for quickly generating random data.
+class RandomGenerator {
+ private:
+  std::string data_;
+  size_t pos_;
+
+ public:
+  RandomGenerator() : pos_(0) {
+    // Fill a buffer larger than any single value so that consecutive
+    // values differ without calling Random for every byte.
+    Random rnd(301);
+    data_.resize(std::max<size_t>(1048576, FLAGS_value_size * 4));
+    for (char &c : data_) { c = static_cast<char>(' ' + rnd.Uniform(95)); }
+  }
+
+  Slice Generate(size_t len) {
+    if (pos_ + len > data_.size()) {
+      pos_ = 0;
+      assert(len < data_.size());
+    }
+    pos_ += len;
+    return Slice(data_.data() + pos_ - len, len);
+  }
+};
+
+// Picks key indexes in [0, n) following a zipfian distribution, with
+// index 0 the most popular.  The constants are computed once per run as in
+// Gray et al., "Quickly Generating Billion-Record Synthetic Databases".
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(uint64_t n, double theta) : n_(n), theta_(theta) {
+    zetan_ = Zeta(n_, theta_);
+    const double zeta2 = Zeta(2, theta_);
+    alpha_ = 1.0 / (1.0 - theta_);
+    eta_ = (1.0 - std::pow(2.0 / n_, 1.0 - theta_)) / (1.0 - zeta2 / zetan_);
+  }
+
+  uint64_t Next(Random64 *rnd) const {
+    const double u =
+        static_cast<double>(rnd->Next() >> 11) * (1.0 / (1ull << 53));
+    const double uz = u * zetan_;
+    if (uz < 1.0) { return 0; }
+    if (uz < 1.0 + std::pow(0.5, theta_)) { return 1; }
+    const uint64_t r = static_cast<uint64_t>(
+        n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(r, n_ - 1);
+  }
+
+ private:
+  static double Zeta(uint64_t n, double theta) {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; i++) { sum += 1.0 / std::pow(i, theta); }
+    return sum;
+  }
+
+  const uint64_t n_;
+  const double theta_;
+  double zetan_;
+  double alpha_;
+  double eta_;
+};
+
+class Stats {
+ private:
+  double start_;
+  double finish_;
+  double seconds_;
+  int64_t done_;
+  int64_t bytes_;
+  double last_op_finish_;
+  HistogramImpl hist_;
+  std::string message_;
+
+ public:
+  Stats() { Start(); }
+
+  void Start() {
+    done_ = 0;
+    bytes_ = 0;
+    hist_.Clear();
+    seconds_ = 0;
+    message_.clear();
+    start_ = finish_ = last_op_finish_ = Env::Default()->NowMicros();
+  }
+
+  void Merge(const Stats &other) {
+    hist_.Merge(other.hist_);
+    done_ += other.done_;
+    bytes_ += other.bytes_;
+    seconds_ = std::max(seconds_, other.seconds_);
+    start_ = std::min(start_, other.start_);
+    finish_ = std::max(finish_, other.finish_);
+
+    // Just keep the messages from one thread
+    if (message_.empty()) { message_ = other.message_; }
+  }
+
+  void Stop() {
+    finish_ = Env::Default()->NowMicros();
+    seconds_ = (finish_ - start_) * 1e-6;
+  }
+
+  void AddMessage(Slice msg) {
+    if (!message_.empty()) { message_.push_back(' '); }
+    message_.append(msg.data(), msg.size());
+  }
+
+  void FinishedSingleOp() {
+    const double now = Env::Default()->NowMicros();
+    hist_.Add(static_cast<uint64_t>(now - last_op_finish_));
+    last_op_finish_ = now;
+    done_++;
+  }
+
+  void FinishedOps(int64_t n) {
+    const double now = Env::Default()->NowMicros();
+    hist_.Add(static_cast<uint64_t>(now - last_op_finish_));
+    last_op_finish_ = now;
+    done_ += n;
+  }
+
+  void AddBytes(int64_t n) { bytes_ += n; }
+
+  void Report(const Slice &name) {
+    // Pretend at least one op was done in case we are running a benchmark
+    // that does not call FinishedSingleOp().
+    if (done_ < 1) { done_ = 1; }
+
+    if (bytes_ > 0) {
+      // Rate is computed on actual elapsed time, not the sum of per-thread
+      // elapsed times.
+      const double elapsed = (finish_ - start_) * 1e-6;
+      char rate[100];
+      std::snprintf(rate, sizeof(rate), "%6.1f MB/s",
+                    (bytes_ / 1048576.0) / elapsed);
+      AddMessage(rate);
+    }
+    const double elapsed = (finish_ - start_) * 1e-6;
+    std::fprintf(stdout,
+                 "%-16s : %11.3f micros/op %10.0f ops/sec;%s%s\n",
+                 name.ToString().c_str(), seconds_ * 1e6 / done_,
+                 done_ / elapsed, (message_.empty() ? "" : " "),
+                 message_.c_str());
+    std::fprintf(stdout,
+                 "%-16s   latency micros: P50 %.2f P95 %.2f P99 %.2f "
+                 "P99.9 %.2f avg %.2f\n",
+                 "", hist_.Median(), hist_.Percentile(95),
+                 hist_.Percentile(99), hist_.Percentile(99.9),
+                 hist_.Average());
+    std::fflush(stdout);
+  }
+};
+
+// State shared by all concurrent executions of the same benchmark.
+struct SharedState {
+  port::Mutex mu;
+  port::CondVar cv;
+  int total;
+
+  // Each thread goes through the following states:
+  //    (1) initializing
+  //    (2) waiting for others to be initialized
+  //    (3) running
+  //    (4) done
+
+  int num_initialized;
+  int num_done;
+  bool start;
+
+  explicit SharedState(int total)
+      : cv(&mu), total(total), num_initialized(0), num_done(0), start(false) {}
+};
+
+// Per-thread state for concurrent executions of the same benchmark.
+struct ThreadState {
+  int tid;       // 0..n-1 when running in n threads
+  Random64 rand; // Has different seeds for different threads
+  Stats stats;
+  SharedState *shared;
+
+  ThreadState(int index, int seed) : tid(index), rand(seed), shared(nullptr) {}
+};
+
+}  // namespace
+
+class Benchmark {
+ private:
+  std::shared_ptr<Cache> cache_;
+  std::shared_ptr<Statistics> dbstats_;
+  const FilterPolicy *filter_policy_;
+  DB *db_;
+  int num_;
+  int reads_;
+  std::unique_ptr<ZipfianGenerator> zipf_;
+  WriteOptions write_options_;
+
+  void PrintHeader() {
+    std::fprintf(stdout, "Keys:       %d bytes each\n", FLAGS_key_size);
+    std::fprintf(stdout, "Values:     %d bytes each\n", FLAGS_value_size);
+    std::fprintf(stdout, "Entries:    %d\n", num_);
+    std::fprintf(stdout, "Threads:    %d\n", FLAGS_threads);
+    std::fprintf(stdout, "Keys picked: %s", FLAGS_distribution);
+    if (zipf_ != nullptr) {
+      std::fprintf(stdout, " (theta %.2f)", FLAGS_zipf_theta);
+    }
+    std::fprintf(stdout, "\n");
+    std::fprintf(stdout, "Compression: %s\n", FLAGS_compression);
+    std::fprintf(stdout,
+                 "------------------------------------------------\n");
+#ifndef NDEBUG
+    std::fprintf(
+        stdout,
+        "WARNING: Assertions are enabled; benchmarks unnecessarily slow\n");
+#endif
+  }
+
+  // Formats key number "k" left-padded with zeros, then pads or truncates
+  // the result to FLAGS_key_size bytes.
+  void GenerateKey(uint64_t k, std::string *key) const {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016" PRIu64, k);
+    key->assign(buf);
+    key->resize(FLAGS_key_size, 'k');
+  }
+
+  uint64_t NextKey(ThreadState *thread) const {
+    if (zipf_ != nullptr) { return zipf_->Next(&thread->rand); }
+    return thread->rand.Uniform(num_);
+  }
+
+ public:
+  Benchmark()
+      : cache_(NewBlockCache()),
+        filter_policy_(FLAGS_bloom_bits >= 0
+                           ? NewBloomFilterPolicy(FLAGS_bloom_bits)
+                           : nullptr),
+        db_(nullptr),
+        num_(FLAGS_num),
+        reads_(FLAGS_reads < 0 ? FLAGS_num : FLAGS_reads) {
+    if (std::strcmp(FLAGS_distribution, "zipfian") == 0) {
+      zipf_.reset(new ZipfianGenerator(num_, FLAGS_zipf_theta));
+    }
+    write_options_.sync = FLAGS_sync;
+    write_options_.disableWAL = FLAGS_disable_wal;
+    if (!FLAGS_use_existing_db) { DestroyDB(FLAGS_db, Options()); }
+  }
+
+  static std::shared_ptr<Cache> NewBlockCache() {
+    if (FLAGS_cache_size < 0) { return nullptr; }
+    std::shared_ptr<SecondaryCache> secondary_cache;
+    if (FLAGS_secondary_cache_size > 0) {
+      Status s = NewLogStructuredSecondaryCache(
+          Env::Default(), std::string(FLAGS_db) + "_secondary_cache",
+          FLAGS_secondary_cache_size, &secondary_cache);
+      if (!s.ok()) {
+        std::fprintf(stderr, "secondary cache error: %s\n",
+                     s.ToString().c_str());
+        std::exit(1);
+      }
+    }
+    return NewLRUCache(FLAGS_cache_size, 4, secondary_cache);
+  }
+
+  ~Benchmark() {
+    delete db_;
+    delete filter_policy_;
+  }
+
+  void Run() {
+    PrintHeader();
+    Open();
+
+    const char *benchmarks = FLAGS_benchmarks;
+    while (benchmarks != nullptr) {
+      const char *sep = std::strchr(benchmarks, ',');
+      Slice name;
+      if (sep == nullptr) {
+        name = benchmarks;
+        benchmarks = nullptr;
+      } else {
+        name = Slice(benchmarks, sep - benchmarks);
+        benchmarks = sep + 1;
+      }
+
+      void (Benchmark::*method)(ThreadState *) = nullptr;
+      int num_threads = FLAGS_threads;
+      if (name == Slice("fillseq")) {
+        method = &Benchmark::WriteSeq;
+      } else if (name == Slice("fillrandom") || name == Slice("overwrite")) {
+        method = &Benchmark::WriteRandom;
+      } else if (name == Slice("readseq")) {
+        method = &Benchmark::ReadSequential;
+      } else if (name == Slice("readrandom")) {
+        method = &Benchmark::ReadRandom;
+      } else if (name == Slice("seekrandom")) {
+        method = &Benchmark::SeekRandom;
+      } else if (name == Slice("multireadrandom")) {
+        method = &Benchmark::MultiReadRandom;
+      } else if (name == Slice("readwhilewriting")) {
+        num_threads++;  // Add extra thread for writing
+        method = &Benchmark::ReadWhileWriting;
+      } else if (name == Slice("mixed")) {
+        method = &Benchmark::Mixed;
+      } else if (name == Slice("stats")) {
+        PrintStats("leveldb.stats");
+      } else if (!name.empty()) {  // No error message for empty name
+        std::fprintf(stderr, "unknown benchmark '%s'\n",
+                     name.ToString().c_str());
+      }
+
+      if (method != nullptr) { RunBenchmark(num_threads, name, method); }
+    }
+
+    if (FLAGS_statistics) {
+      std::fprintf(stdout, "STATISTICS:\n%s\n",
+                   dbstats_->ToString().c_str());
+    }
+  }
+
+ private:
+  struct ThreadArg {
+    Benchmark *bm;
+    SharedState *shared;
+    ThreadState *thread;
+    void (Benchmark::*method)(ThreadState *);
+  };
+
+  static void ThreadBody(void *v) {
+    ThreadArg *arg = reinterpret_cast<ThreadArg *>(v);
+    SharedState *shared = arg->shared;
+    ThreadState *thread = arg->thread;
+    {
+      MutexLock l(&shared->mu);
+      shared->num_initialized++;
+      if (shared->num_initialized >= shared->total) { shared->cv.SignalAll(); }
+      while (!shared->start) { shared->cv.Wait(); }
+    }
+
+    thread->stats.Start();
+    (arg->bm->*(arg->method))(thread);
+    thread->stats.Stop();
+
+    {
+      MutexLock l(&shared->mu);
+      shared->num_done++;
+      if (shared->num_done >= shared->total) { shared->cv.SignalAll(); }
+    }
+  }
+
+  void RunBenchmark(int n, Slice name,
+                    void (Benchmark::*method)(ThreadState *)) {
+    SharedState shared(n);
+
+    std::vector<ThreadArg> arg(n);
+    for (int i = 0; i < n; i++) {
+      arg[i].bm = this;
+      arg[i].method = method;
+      arg[i].shared = &shared;
+      arg[i].thread = new ThreadState(i, 1000 + i);
+      arg[i].thread->shared = &shared;
+      Env::Default()->StartThread(ThreadBody, &arg[i]);
+    }
+
+    shared.mu.Lock();
+    while (shared.num_initialized < n) { shared.cv.Wait(); }
+
+    shared.start = true;
+    shared.cv.SignalAll();
+    while (shared.num_done < n) { shared.cv.Wait(); }
+    shared.mu.Unlock();
+
+    // readwhilewriting only reports the readers, the writer is thread 0
+    const int first = (method == &Benchmark::ReadWhileWriting) ? 1 : 0;
+    for (int i = first + 1; i < n; i++) {
+      arg[first].thread->stats.Merge(arg[i].thread->stats);
+    }
+    arg[first].thread->stats.Report(name);
+
+    for (int i = 0; i < n; i++) { delete arg[i].thread; }
+  }
+
+  void Open() {
+    assert(db_ == nullptr);
+    Options options;
+    options.create_if_missing = !FLAGS_use_existing_db;
+    options.block_cache = cache_;
+    if (FLAGS_row_cache_size > 0) {
+      options.row_cache = NewLRUCache(FLAGS_row_cache_size);
+    }
+    if (FLAGS_compressed_cache_size > 0) {
+      options.block_cache_compressed =
+          NewLRUCache(FLAGS_compressed_cache_size);
+    }
+    options.no_block_cache = (FLAGS_cache_size == 0);
+    if (FLAGS_write_buffer_size > 0) {
+      options.write_buffer_size = FLAGS_write_buffer_size;
+    }
+    if (FLAGS_open_files != 0) { options.max_open_files = FLAGS_open_files; }
+    options.pin_l0_filter_and_index_blocks =
+        FLAGS_pin_l0_filter_and_index_blocks;
+    options.enable_pipelined_write = FLAGS_enable_pipelined_write;
+    options.unordered_write = FLAGS_unordered_write;
+    options.manual_wal_flush = FLAGS_manual_wal_flush;
+    options.filter_policy = filter_policy_;
+    if (std::strcmp(FLAGS_compression, "none") == 0) {
+      options.compression = kNoCompression;
+    } else if (std::strcmp(FLAGS_compression, "zlib") == 0) {
+      options.compression = kZlibCompression;
+    } else {
+      options.compression = kSnappyCompression;
+    }
+    if (FLAGS_statistics) {
+      dbstats_ = CreateDBStatistics();
+      options.statistics = dbstats_;
+    }
+    Status s = DB::Open(options, FLAGS_db, &db_);
+    if (!s.ok()) {
+      std::fprintf(stderr, "open error: %s\n", s.ToString().c_str());
+      std::exit(1);
+    }
+    if (FLAGS_trace_file != nullptr) {
+      std::unique_ptr<TraceWriter> writer;
+      s = NewFileTraceWriter(Env::Default(), FLAGS_trace_file, &writer);
+      if (s.ok()) { s = db_->StartTrace(TraceOptions(), std::move(writer)); }
+      if (!s.ok()) {
+        std::fprintf(stderr, "trace error: %s\n", s.ToString().c_str());
+        std::exit(1);
+      }
+    }
+    if (FLAGS_block_cache_trace_file != nullptr) {
+      std::unique_ptr<TraceWriter> writer;
+      s = NewFileTraceWriter(Env::Default(), FLAGS_block_cache_trace_file,
+                             &writer);
+      if (s.ok()) {
+        s = db_->StartBlockCacheTrace(TraceOptions(), std::move(writer));
+      }
+      if (!s.ok()) {
+        std::fprintf(stderr, "block cache trace error: %s\n",
+                     s.ToString().c_str());
+        std::exit(1);
+      }
+    }
+  }
+
+  void DoWrite(ThreadState *thread, bool seq) {
+    RandomGenerator gen;
+    WriteBatch batch;
+    std::string key;
+    int64_t bytes = 0;
+    for (int i = 0; i < num_; i++) {
+      const uint64_t k = seq ? i : NextKey(thread);
+      GenerateKey(k, &key);
+      batch.Clear();
+      batch.Put(key, gen.Generate(FLAGS_value_size));
+      bytes += FLAGS_value_size + key.size();
+      Status s = db_->Write(write_options_, &batch);
+      if (!s.ok()) {
+        std::fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+        std::exit(1);
+      }
+      thread->stats.FinishedSingleOp();
+    }
+    thread->stats.AddBytes(bytes);
+  }
+
+  void WriteSeq(ThreadState *thread) { DoWrite(thread, true); }
+
+  void WriteRandom(ThreadState *thread) { DoWrite(thread, false); }
+
+  void ReadSequential(ThreadState *thread) {
+    Iterator *iter = db_->NewIterator(ReadOptions());
+    int i = 0;
+    int64_t bytes = 0;
+    for (iter->SeekToFirst(); i < reads_ && iter->Valid(); iter->Next()) {
+      bytes += iter->key().size() + iter->value().size();
+      thread->stats.FinishedSingleOp();
+      ++i;
+    }
+    delete iter;
+    thread->stats.AddBytes(bytes);
+  }
+
+  void ReadRandom(ThreadState *thread) {
+    ReadOptions options;
+    std::string key;
+    std::string value;
+    int found = 0;
+    for (int i = 0; i < reads_; i++) {
+      GenerateKey(NextKey(thread), &key);
+      if (db_->Get(options, key, &value).ok()) { found++; }
+      thread->stats.FinishedSingleOp();
+    }
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, reads_);
+    thread->stats.AddMessage(msg);
+  }
+
+  void SeekRandom(ThreadState *thread) {
+    ReadOptions options;
+    Iterator *iter = db_->NewIterator(options);
+    std::string key;
+    int found = 0;
+    for (int i = 0; i < reads_; i++) {
+      GenerateKey(NextKey(thread), &key);
+      iter->Seek(key);
+      if (iter->Valid() && iter->key() == Slice(key)) { found++; }
+      for (int j = 0; j < FLAGS_seek_nexts && iter->Valid(); j++) {
+        iter->Next();
+      }
+      thread->stats.FinishedSingleOp();
+    }
+    delete iter;
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, reads_);
+    thread->stats.AddMessage(msg);
+  }
+
+  void MultiReadRandom(ThreadState *thread) {
+    ReadOptions options;
+    const int batch_size = std::max(1, FLAGS_batch_size);
+    std::vector<std::string> keys(batch_size);
+    std::vector<Slice> key_slices(batch_size);
+    std::vector<std::string> values;
+    int found = 0;
+    int done = 0;
+    while (done < reads_) {
+      const int n = std::min(batch_size, reads_ - done);
+      keys.resize(n);
+      key_slices.resize(n);
+      for (int i = 0; i < n; i++) {
+        GenerateKey(NextKey(thread), &keys[i]);
+        key_slices[i] = keys[i];
+      }
+      std::vector<Status> statuses = db_->MultiGet(options, key_slices, &values);
+      for (const Status &s : statuses) {
+        if (s.ok()) { found++; }
+      }
+      thread->stats.FinishedOps(n);
+      done += n;
+    }
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(%d of %d found)", found, reads_);
+    thread->stats.AddMessage(msg);
+  }
+
+  void ReadWhileWriting(ThreadState *thread) {
+    if (thread->tid > 0) {
+      ReadRandom(thread);
+      return;
+    }
+
+    // Special thread that keeps writing until other threads are done.
+    RandomGenerator gen;
+    std::string key;
+    while (true) {
+      {
+        MutexLock l(&thread->shared->mu);
+        if (thread->shared->num_done + 1 >= thread->shared->num_initialized) {
+          // Other threads have finished
+          break;
+        }
+      }
+      GenerateKey(NextKey(thread), &key);
+      Status s = db_->Put(write_options_, key, gen.Generate(FLAGS_value_size));
+      if (!s.ok()) {
+        std::fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+        std::exit(1);
+      }
+    }
+
+    // Do not count any of the preceding work/delay in stats.
+    thread->stats.Start();
+  }
+
+  void Mixed(ThreadState *thread) {
+    ReadOptions options;
+    RandomGenerator gen;
+    std::string key;
+    std::string value;
+    int reads = 0;
+    int found = 0;
+    int writes = 0;
+    for (int i = 0; i < reads_; i++) {
+      GenerateKey(NextKey(thread), &key);
+      if (static_cast<int>(thread->rand.Uniform(100)) <
+          FLAGS_readwritepercent) {
+        if (db_->Get(options, key, &value).ok()) { found++; }
+        reads++;
+      } else {
+        Status s =
+            db_->Put(write_options_, key, gen.Generate(FLAGS_value_size));
+        if (!s.ok()) {
+          std::fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+          std::exit(1);
+        }
+        writes++;
+      }
+      thread->stats.FinishedSingleOp();
+    }
+    char msg[100];
+    std::snprintf(msg, sizeof(msg), "(reads:%d writes:%d found:%d)", reads,
+                  writes, found);
+    thread->stats.AddMessage(msg);
+  }
+
+  void PrintStats(const char *key) {
+    std::string stats;
+    if (!db_->GetProperty(key, &stats)) { stats = "(failed)"; }
+    std::fprintf(stdout, "\n%s\n", stats.c_str());
+  }
+};
+
+}  // namespace leveldb
+
+int main(int argc, char **argv) {
+  std::string default_db_path;
+
+  for (int i = 1; i < argc; i++) {
+    double d;
+    int n;
+    long l;
+    char junk;
+    if (leveldb::Slice(argv[i]).starts_with("--benchmarks=")) {
+      FLAGS_benchmarks = argv[i] + std::strlen("--benchmarks=");
+    } else if (std::sscanf(argv[i], "--num=%d%c", &n, &junk) == 1) {
+      FLAGS_num = n;
+    } else if (std::sscanf(argv[i], "--reads=%d%c", &n, &junk) == 1) {
+      FLAGS_reads = n;
+    } else if (std::sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1) {
+      FLAGS_threads = n;
+    } else if (std::sscanf(argv[i], "--key_size=%d%c", &n, &junk) == 1) {
+      FLAGS_key_size = n;
+    } else if (std::sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1) {
+      FLAGS_value_size = n;
+    } else if (std::strncmp(argv[i], "--distribution=", 15) == 0) {
+      FLAGS_distribution = argv[i] + 15;
+    } else if (std::sscanf(argv[i], "--zipf_theta=%lf%c", &d, &junk) == 1) {
+      FLAGS_zipf_theta = d;
+    } else if (std::sscanf(argv[i], "--batch_size=%d%c", &n, &junk) == 1) {
+      FLAGS_batch_size = n;
+    } else if (std::sscanf(argv[i], "--seek_nexts=%d%c", &n, &junk) == 1) {
+      FLAGS_seek_nexts = n;
+    } else if (std::sscanf(argv[i], "--readwritepercent=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_readwritepercent = n;
+    } else if (std::sscanf(argv[i], "--write_buffer_size=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_write_buffer_size = n;
+    } else if (std::sscanf(argv[i], "--cache_size=%ld%c", &l, &junk) == 1) {
+      FLAGS_cache_size = l;
+    } else if (std::sscanf(argv[i], "--compressed_cache_size=%ld%c", &l,
+                           &junk) == 1) {
+      FLAGS_compressed_cache_size = l;
+    } else if (std::sscanf(argv[i], "--row_cache_size=%ld%c", &l, &junk) ==
+               1) {
+      FLAGS_row_cache_size = l;
+    } else if (std::sscanf(argv[i], "--secondary_cache_size=%ld%c", &l,
+                           &junk) == 1) {
+      FLAGS_secondary_cache_size = l;
+    } else if (std::sscanf(argv[i], "--open_files=%d%c", &n, &junk) == 1) {
+      FLAGS_open_files = n;
+    } else if (std::sscanf(argv[i], "--pin_l0_filter_and_index_blocks=%d%c",
+                           &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_pin_l0_filter_and_index_blocks = n;
+    } else if (std::sscanf(argv[i], "--bloom_bits=%d%c", &n, &junk) == 1) {
+      FLAGS_bloom_bits = n;
+    } else if (std::strncmp(argv[i], "--compression=", 14) == 0) {
+      FLAGS_compression = argv[i] + 14;
+    } else if (std::sscanf(argv[i], "--sync=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_sync = n;
+    } else if (std::sscanf(argv[i], "--disable_wal=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_disable_wal = n;
+    } else if (std::sscanf(argv[i], "--enable_pipelined_write=%d%c", &n,
+                           &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_enable_pipelined_write = n;
+    } else if (std::sscanf(argv[i], "--unordered_write=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_unordered_write = n;
+    } else if (std::sscanf(argv[i], "--manual_wal_flush=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_manual_wal_flush = n;
+    } else if (std::sscanf(argv[i], "--statistics=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_statistics = n;
+    } else if (std::sscanf(argv[i], "--use_existing_db=%d%c", &n, &junk) ==
+                   1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_existing_db = n;
+    } else if (std::strncmp(argv[i], "--db=", 5) == 0) {
+      FLAGS_db = argv[i] + 5;
+    } else if (std::strncmp(argv[i], "--trace_file=", 13) == 0) {
+      FLAGS_trace_file = argv[i] + 13;
+    } else if (std::strncmp(argv[i], "--block_cache_trace_file=", 25) == 0) {
+      FLAGS_block_cache_trace_file = argv[i] + 25;
+    } else {
+      std::fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+      std::exit(1);
+    }
+  }
+
+  if (FLAGS_key_size < 16) {
+    std::fprintf(stderr, "--key_size must be at least 16\n");
+    std::exit(1);
+  }
+  if (std::strcmp(FLAGS_distribution, "uniform") != 0 &&
+      std::strcmp(FLAGS_distribution, "zipfian") != 0) {
+    std::fprintf(stderr, "--distribution must be uniform or zipfian\n");
+    std::exit(1);
+  }
+  if (FLAGS_zipf_theta <= 0 || FLAGS_zipf_theta >= 1) {
+    std::fprintf(stderr, "--zipf_theta must be in (0, 1)\n");
+    std::exit(1);
+  }
+
+  // Choose a location for the test database if none given with --db=<path>
+  if (FLAGS_db == nullptr) {
+    leveldb::Env::Default()->GetTestDirectory(&default_db_path);
+    default_db_path += "/dbbench";
+    FLAGS_db = default_db_path.c_str();
+  }
+
+  leveldb::Benchmark benchmark;
+  benchmark.Run();
+  return 0;
+}
@@ -1,5 +0,0 @@
-// SPDX-FileCopyrightText: LakeSoul Contributors
-//
-// SPDX-License-Identifier: Apache-2.0
-
-int main() { return 0; }
@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "db/trace_replay.h"
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/trace.h"
+
+// Replays a trace recorded with DB::StartTrace() against the DB at --db,
+// so that a captured production workload can be run against candidate
+// configurations offline.
+//
+//   trace_replay --trace_file=/path/trace --db=/path/db [--speed=1.0]
+//
+// --speed scales the gaps between the recorded calls: 1.0 replays at the
+// original pace, 2.0 twice as fast, 0 as fast as possible.  The remaining
+// flags mirror the db_bench options of the same name.
+
+// Trace file written by DB::StartTrace()
+static const char *FLAGS_trace_file = nullptr;
+
+// DB to replay against, created if missing
+static const char *FLAGS_db = nullptr;
+
+// Replay speed multiplier, 0 for no delays
+static double FLAGS_speed = 1.0;
+
+// Number of bytes to buffer in memtable before compacting
+static int FLAGS_write_buffer_size = 0;
+
+// Number of bytes to use as a cache of uncompressed data.
+// Negative means use default settings.
+static long FLAGS_cache_size = -1;
+
+// Maximum number of files to keep open at the same time (use default if == 0,
+// keep every file open if -1)
+static int FLAGS_open_files = 0;
+
+// Bloom filter bits per key.
+// Negative means use default settings.
+static int FLAGS_bloom_bits = -1;
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    double d;
+    int n;
+    long l;
+    char junk;
+    if (std::strncmp(argv[i], "--trace_file=", 13) == 0) {
+      FLAGS_trace_file = argv[i] + 13;
+    } else if (std::strncmp(argv[i], "--db=", 5) == 0) {
+      FLAGS_db = argv[i] + 5;
+    } else if (std::sscanf(argv[i], "--speed=%lf%c", &d, &junk) == 1) {
+      FLAGS_speed = d;
+    } else if (std::sscanf(argv[i], "--write_buffer_size=%d%c", &n, &junk) ==
+               1) {
+      FLAGS_write_buffer_size = n;
+    } else if (std::sscanf(argv[i], "--cache_size=%ld%c", &l, &junk) == 1) {
+      FLAGS_cache_size = l;
+    } else if (std::sscanf(argv[i], "--open_files=%d%c", &n, &junk) == 1) {
+      FLAGS_open_files = n;
+    } else if (std::sscanf(argv[i], "--bloom_bits=%d%c", &n, &junk) == 1) {
+      FLAGS_bloom_bits = n;
+    } else {
+      std::fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+      std::exit(1);
+    }
+  }
+  if (FLAGS_trace_file == nullptr || FLAGS_db == nullptr) {
+    std::fprintf(stderr, "--trace_file and --db are required\n");
+    std::exit(1);
+  }
+  if (FLAGS_speed < 0) {
+    std::fprintf(stderr, "--speed must not be negative\n");
+    std::exit(1);
+  }
+
+  leveldb::Env *env = leveldb::Env::Default();
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy(
+      FLAGS_bloom_bits >= 0 ? leveldb::NewBloomFilterPolicy(FLAGS_bloom_bits)
+                            : nullptr);
+  leveldb::Options options;
+  options.create_if_missing = true;
+  if (FLAGS_cache_size >= 0) {
+    options.block_cache = leveldb::NewLRUCache(FLAGS_cache_size);
+    options.no_block_cache = (FLAGS_cache_size == 0);
+  }
+  if (FLAGS_write_buffer_size > 0) {
+    options.write_buffer_size = FLAGS_write_buffer_size;
+  }
+  if (FLAGS_open_files != 0) { options.max_open_files = FLAGS_open_files; }
+  options.filter_policy = filter_policy.get();
+
+  leveldb::DB *db;
+  leveldb::Status s = leveldb::DB::Open(options, FLAGS_db, &db);
+  if (!s.ok()) {
+    std::fprintf(stderr, "open error: %s\n", s.ToString().c_str());
+    std::exit(1);
+  }
+
+  std::unique_ptr<leveldb::TraceReader> reader;
+  s = leveldb::NewFileTraceReader(env, FLAGS_trace_file, &reader);
+  if (!s.ok()) {
+    std::fprintf(stderr, "trace open error: %s\n", s.ToString().c_str());
+    delete db;
+    std::exit(1);
+  }
+
+  leveldb::Replayer replayer(db, std::move(reader));
+  const uint64_t start = env->NowMicros();
+  s = replayer.Replay(FLAGS_speed);
+  const double seconds = (env->NowMicros() - start) * 1e-6;
+
+  static const struct {
+    leveldb::TraceType type;
+    const char *name;
+  } kTypes[] = {
+      {leveldb::kTraceGet, "get"},       {leveldb::kTracePut, "put"},
+      {leveldb::kTraceDelete, "delete"}, {leveldb::kTraceMerge, "merge"},
+      {leveldb::kTraceWrite, "write"},   {leveldb::kTraceIteratorSeek, "seek"},
+  };
+  uint64_t total = 0;
+  for (const auto &t : kTypes) {
+    const uint64_t n = replayer.num_ops(t.type);
+    total += n;
+    std::fprintf(stdout, "%-8s %12llu\n", t.name,
+                 static_cast<unsigned long long>(n));
+  }
+  std::fprintf(stdout, "replayed %llu ops in %.3f secs, %.0f ops/sec\n",
+               static_cast<unsigned long long>(total), seconds,
+               seconds > 0 ? total / seconds : 0.0);
+  if (!s.ok()) {
+    std::fprintf(stderr, "replay error: %s\n", s.ToString().c_str());
+  }
+
+  delete db;
+  return s.ok() ? 0 : 1;
+}
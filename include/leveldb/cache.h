@@ -1,7 +1,141 @@
-// SPDX-FileCopyrightText: LakeSoul Contributors
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
 //
-// SPDX-License-Identifier: Apache-2.0
+// A Cache is an interface that maps keys to values.  It has internal
+// synchronization and may be safely accessed concurrently from
+// multiple threads.  It may automatically evict entries to make room
+// for new entries.  Values have a specified charge against the cache
+// capacity.  For example, a cache where the values are variable
+// length strings, may use the length of the string as the charge for
+// the string.
+//
+// A builtin cache implementation with a least-recently-used eviction
+// policy is provided.  Clients may use their own implementations if
+// they want something more sophisticated (like scan-resistance, a
+// custom eviction policy, variable cache sizing, etc.)
 
 #pragma once
 
-namespace leveldb {}
\ No newline at end of file
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+class Cache;
+class SecondaryCache;
+
+// Create a new cache with a fixed size capacity.  The cache is split into
+// 2^num_shard_bits shards by key hash, each with its own lock and LRU list.
+// With a "secondary_cache", entries inserted with a CacheItemHelper are
+// moved there when evicted, and lookups with a helper fall back on it.
+extern std::shared_ptr<Cache> NewLRUCache(size_t capacity);
+extern std::shared_ptr<Cache> NewLRUCache(
+    size_t capacity, int num_shard_bits,
+    std::shared_ptr<SecondaryCache> secondary_cache = nullptr);
+
+class Cache {
+public:
+  Cache() {}
+
+  // Destroys all existing entries by calling the "deleter"
+  // function that was passed to the constructor.
+  virtual ~Cache();
+
+  // Opaque handle to an entry stored in the cache.
+  struct Handle {};
+
+  // Insert a mapping from key->value into the cache and assign it
+  // the specified charge against the total cache capacity.
+  //
+  // Returns a handle that corresponds to the mapping.  The caller
+  // must call this->Release(handle) when the returned mapping is no
+  // longer needed.
+  //
+  // When the inserted entry is no longer needed, the key and
+  // value will be passed to "deleter".
+  virtual Handle *Insert(const Slice &key, void *value, size_t charge,
+                         void (*deleter)(const Slice &key, void *value)) = 0;
+
+  // How the value of an entry moves to and from a secondary cache.
+  struct CacheItemHelper {
+    // Appends the bytes that stand for "value" to *out.
+    void (*save_to)(void *value, std::string *out);
+    // Builds a value back from those bytes and sets *charge, or returns
+    // nullptr if they are unusable.
+    void *(*create)(const Slice &data, size_t *charge);
+    void (*deleter)(const Slice &key, void *value);
+  };
+
+  // Like Insert() above, but if the entry is evicted it is saved to the
+  // secondary cache, if any, with "helper", which must outlive the entry.
+  virtual Handle *Insert(const Slice &key, void *value, size_t charge,
+                         const CacheItemHelper *helper) {
+    return Insert(key, value, charge, helper->deleter);
+  }
+
+  // If the cache has no mapping for "key", returns nullptr.
+  //
+  // Else return a handle that corresponds to the mapping.  The caller
+  // must call this->Release(handle) when the returned mapping is no
+  // longer needed.
+  virtual Handle *Lookup(const Slice &key) = 0;
+
+  // Like Lookup() above, but a miss falls back on the secondary cache, if
+  // any, and a value found there is moved into this cache with "helper".
+  virtual Handle *Lookup(const Slice &key, const CacheItemHelper *helper) {
+    return Lookup(key);
+  }
+
+  // Builds the value the secondary cache, if any, holds for "key" with
+  // "helper", without moving it into this cache.  Returns nullptr if there
+  // is none; otherwise the caller owns the value and frees it with
+  // helper->deleter.
+  virtual void *LookupSecondary(const Slice &key,
+                                const CacheItemHelper *helper) {
+    return nullptr;
+  }
+
+  // Release a mapping returned by a previous Lookup().
+  // REQUIRES: handle must not have been released yet.
+  // REQUIRES: handle must have been returned by a method on *this.
+  virtual void Release(Handle *handle) = 0;
+
+  // Return the value encapsulated in a handle returned by a
+  // successful Lookup().
+  // REQUIRES: handle must not have been released yet.
+  // REQUIRES: handle must have been returned by a method on *this.
+  virtual void *Value(Handle *handle) = 0;
+
+  // If the cache contains entry for key, erase it.  Note that the
+  // underlying entry will be kept around until all existing handles
+  // to it have been released.
+  virtual void Erase(const Slice &key) = 0;
+
+  // Return a new numeric id.  May be used by multiple clients who are
+  // sharing the same cache to partition the key space.  Typically the
+  // client will allocate a new id at startup and prepend the id to
+  // its cache keys.
+  virtual uint64_t NewId() = 0;
+
+  // Remove all cache entries that are not actively in use.  Memory-constrained
+  // applications may wish to call this method to reduce memory usage.
+  virtual void Prune() {}
+
+  // Return an estimate of the combined charges of all elements stored in the
+  // cache.
+  virtual size_t TotalCharge() const = 0;
+
+  // Return the maximum configured capacity of the cache.
+  virtual size_t GetCapacity() const = 0;
+
+private:
+  // No copying allowed
+  Cache(const Cache &);
+  void operator=(const Cache &);
+};
+
+} // namespace leveldb
@@ -11,6 +11,7 @@
 
 #include "leveldb/iterator.h"
 #include "leveldb/options.h"
+#include "leveldb/trace.h"
 #include "leveldb/transaction_log_iterator.h"
 #include "leveldb/types.h"
 
@@ -149,8 +150,42 @@ public:
   //     about the internal operation of the DB.
   //  "leveldb.sstables" - returns a multi-line string that describes all
   //     of the sstables that make up the db contents.
+  //
+  // Every integer property accepted by GetIntProperty() below is also
+  // accepted here and formatted in decimal.
   virtual bool GetProperty(const Slice &property, std::string *value) = 0;
 
+  // Similar to GetProperty(), but only works for integer-valued properties
+  // and stores the value in *value without formatting a string.  Returns
+  // false if "property" is unknown or is not an integer property.
+  //
+  // The following properties are served without acquiring the DB mutex and
+  // are cheap enough to be polled at high frequency:
+  //
+  //  "leveldb.num-immutable-mem-table" - number of immutable memtables that
+  //     have not yet been flushed.
+  //  "leveldb.mem-table-flush-pending" - 1 if a memtable flush is pending.
+  //  "leveldb.compaction-pending" - 1 if at least one compaction is pending.
+  //  "leveldb.background-errors" - accumulated number of background errors.
+  //  "leveldb.cur-size-active-mem-table" - approximate size of the active
+  //     memtable in bytes.
+  //  "leveldb.cur-size-all-mem-tables" - approximate size of the active and
+  //     unflushed immutable memtables in bytes.
+  //  "leveldb.num-entries-active-mem-table" - total number of entries in the
+  //     active memtable.
+  //  "leveldb.num-entries-imm-mem-tables" - total number of entries in the
+  //     unflushed immutable memtables.
+  //  "leveldb.estimate-num-keys" - estimated number of live keys.
+  //  "leveldb.estimate-pending-compaction-bytes" - estimated number of bytes
+  //     compaction needs to rewrite to bring every level under its target.
+  //  "leveldb.total-sst-files-size" - total size of all live sstables.
+  //  "leveldb.num-snapshots" - number of unreleased snapshots.
+  //  "leveldb.actual-delayed-write-rate" - rate in bytes per second that
+  //     writes are currently delayed to, 0 if they are not delayed.
+  //  "leveldb.is-write-stopped" - 1 if the next memtable switch will wait
+  //     for compaction.
+  virtual bool GetIntProperty(const Slice &property, uint64_t *value) = 0;
+
   // For each i in [0,n-1], store in "sizes[i]", the approximate
   // file system space used by keys in "[range[i].start .. range[i].limit)".
   //
@@ -187,6 +222,11 @@ public:
   // Flush all mem-table data.
   virtual Status Flush(const FlushOptions &options) = 0;
 
+  // Write out WAL records buffered under Options::manual_wal_flush, and
+  // sync the WAL if "sync".  Without manual_wal_flush only the sync has
+  // any effect.
+  virtual Status FlushWAL(bool sync) = 0;
+
   // Prevent file deletions. Compactions will continue to occur,
   // but no obsolete files will be deleted. Calling this multiple
   // times have the same effect as calling it once.
@@ -221,6 +261,27 @@ public:
   virtual Status GetUpdatesSince(SequenceNumber seq_number,
                                  unique_ptr<TransactionLogIterator> *iter) = 0;
 
+  // Start recording Get, Put, Delete, Merge, Write and iterator Seek calls
+  // made on this DB into "trace_writer".  Only one trace may be active at
+  // a time.  The trace can be replayed with the trace_replay tool.
+  virtual Status StartTrace(const TraceOptions &options,
+                            std::unique_ptr<TraceWriter> &&trace_writer) = 0;
+
+  // Stop the active trace and close its writer.
+  virtual Status EndTrace() = 0;
+
+  // Start recording every block cache lookup made by reads, iterators,
+  // flushes and compactions into "trace_writer": the block, its type,
+  // the level of its file, the caller and whether it hit.  The trace can
+  // be fed to the block_cache_trace_analyzer tool to simulate other cache
+  // policies and sizes.  options.sampling_frequency samples by block.
+  virtual Status StartBlockCacheTrace(
+      const TraceOptions &options,
+      std::unique_ptr<TraceWriter> &&trace_writer) = 0;
+
+  // Stop the active block cache trace and close its writer.
+  virtual Status EndBlockCacheTrace() = 0;
+
 private:
   // No copying allowed
   DB(const DB &);
@@ -28,7 +28,7 @@ class RandomAccessFile;
 class SequentialFile;
 class Slice;
 class WritableFile;
-class Options;
+struct Options;
 
 using std::shared_ptr;
 using std::unique_ptr;
@@ -184,6 +184,11 @@ public:
   // useful for computing deltas of time.
   virtual uint64_t NowMicros() = 0;
 
+  // Returns the number of nano-seconds since some fixed point in time. Only
+  // useful for computing deltas of time in one run.
+  // Default implementation simply relies on NowMicros
+  virtual uint64_t NowNanos() { return NowMicros() * 1000; }
+
   // Sleep/delay the thread for the perscribed number of micro-seconds.
   virtual void SleepForMicroseconds(int micros) = 0;
 
@@ -415,6 +420,10 @@ extern void Log(Logger *info_log, const char *format, ...)
 extern Status WriteStringToFile(Env *env, const Slice &data,
                                 const std::string &fname);
 
+// Like WriteStringToFile(), but syncs the file before closing it.
+extern Status WriteStringToFileSync(Env *env, const Slice &data,
+                                    const std::string &fname);
+
 // A utility routine: read contents of named file into *data
 extern Status ReadFileToString(Env *env, const std::string &fname,
                                std::string *data);
@@ -483,6 +492,7 @@ public:
     return target_->NewLogger(fname, result);
   }
   uint64_t NowMicros() { return target_->NowMicros(); }
+  uint64_t NowNanos() { return target_->NowNanos(); }
   void SleepForMicroseconds(int micros) {
     target_->SleepForMicroseconds(micros);
   }
@@ -22,6 +22,7 @@ class Logger;
 class MergeOperator;
 class Snapshot;
 class CompactionFilter;
+class WriteBufferManager;
 
 using std::shared_ptr;
 
@@ -136,13 +137,49 @@ struct Options {
   // individual write buffers.  Default: 1
   int min_write_buffer_number_to_merge;
 
+  // Caps the memory used by memtables across every DB that shares the
+  // manager: once it is exceeded, the DB with the largest mutable memtable
+  // flushes it.  The manager may also charge that memory to a block cache.
+  // Default: nullptr
+  shared_ptr<WriteBufferManager> write_buffer_manager;
+
+  // If non-zero and write_buffer_manager is not set, caps the memory used
+  // by this DB's memtables, as a write buffer manager of its own would.
+  // Default: 0 (no cap beyond write_buffer_size and max_write_buffer_number)
+  size_t db_write_buffer_size;
+
   // Number of open files that can be used by the DB.  You may need to
   // increase this if your database has a large working set (budget
-  // one open file per 2MB of working set).
+  // one open file per 2MB of working set).  -1 keeps every table file
+  // open, and table lookups then take no lock at all.
   //
   // Default: 1000
   int max_open_files;
 
+  // Threads DB::Open uses to open table files ahead of the first reads to
+  // them, lowest levels first, as many as max_open_files allows (all of
+  // them with max_open_files=-1).  DB::Open returns only once they are
+  // open, which on a large database takes a while.  0 leaves every table
+  // to be opened on first access.
+  // Default: 0
+  int max_file_opening_threads;
+
+  // If true, opening a table file reads only its footer, and the index and
+  // filter blocks are read on the first access to the table.  Makes
+  // DB::Open and table cache misses cheaper, at the cost of the first read
+  // from each table.
+  // Default: false
+  bool defer_table_index_loading;
+
+  // If true, the tables of level-0 files stay open for as long as the
+  // files live, index and filter blocks included, outside the
+  // max_open_files budget, and lookups find them without locking.  Every
+  // point lookup consults level 0 first, so this keeps scans over many
+  // other files from evicting the filters that lookups need most.
+  // max_open_files=-1 pins the tables of every level.
+  // Default: false
+  bool pin_l0_filter_and_index_blocks;
+
   // Control over blocks (user data is stored in a set of blocks, and
   // a block is the unit of reading from disk).
 
@@ -151,6 +188,22 @@ struct Options {
   // Default: nullptr
   shared_ptr<Cache> block_cache;
 
+  // If non-NULL use the specified cache for compressed blocks, as they are
+  // stored in the table files.  It is looked up before the file when a
+  // block is not in block_cache, and decompressing a block found there is
+  // cheaper than reading it again.  Compressed blocks take less memory
+  // than uncompressed ones, so the same memory holds more of them.
+  // Uncompressed blocks are never stored here.
+  // Default: nullptr
+  shared_ptr<Cache> block_cache_compressed;
+
+  // If non-NULL use the specified cache for the results of point lookups
+  // in table files, keyed on the file and the user key.  A hot key is then
+  // served without touching the table's index, filter or data blocks.
+  // Only lookups that find the key in a file are cached.
+  // Default: nullptr
+  shared_ptr<Cache> row_cache;
+
   // Approximate size of user data packed per block.  Note that the
   // block size specified here corresponds to uncompressed data.  The
   // actual size of the unit read from disk may be smaller if
@@ -221,6 +274,20 @@ struct Options {
   // Maximum number of level-0 files.  We stop writes at this point.
   int level0_stop_writes_trigger;
 
+  // Writes are delayed once compaction has at least this many bytes to
+  // rewrite before every level is back under its target size, and stopped
+  // once it has hard_pending_compaction_bytes_limit.  0 disables either.
+  // Default: 64GB and 256GB
+  uint64_t soft_pending_compaction_bytes_limit;
+  uint64_t hard_pending_compaction_bytes_limit;
+
+  // Rate, in bytes per second, that writes are limited to when they are
+  // first delayed by the triggers above.  The rate falls smoothly towards
+  // 16KB/s as the DB approaches the point where writes stop, which only
+  // happens when the next memtable switch would exceed a stop trigger.
+  // Default: 16MB/s
+  uint64_t delayed_write_rate;
+
   // Maximum level to which a new compacted memtable is pushed if it
   // does not create overlap.  We try to push to level 2 to avoid the
   // relatively expensive level 0=>1 compactions and to avoid some
@@ -283,9 +350,9 @@ struct Options {
   // stop building a single file in a level->level+1 compaction.
   int max_grandparent_overlap_factor;
 
-  // If non-null, then we should collect metrics about database operations
-  // Statistics objects should not be shared between DB instances as
-  // it does not use any locks to prevent concurrent updates.
+  // If non-null, then we should collect metrics about database operations.
+  // The object returned by CreateDBStatistics() is thread safe and may be
+  // shared between DB instances, in which case it reports their sum.
   shared_ptr<Statistics> statistics;
 
   // If true, then the contents of data files are not synced
@@ -435,6 +502,13 @@ struct Options {
   // Default: false
   bool skip_log_error_on_recovery;
 
+  // Threads that replay the WAL on DB::Open.  One reads and checksums
+  // records ahead of the replay; the others build level-0 tables from
+  // the memtables the replay fills, while it moves on to the next one.
+  // With 1, the opening thread builds the tables itself.
+  // Default: 4
+  int wal_recovery_threads;
+
   // if not zero, dump leveldb.stats to LOG every stats_dump_period_sec
   // Default: 3600 (1 hour)
   unsigned int stats_dump_period_sec;
@@ -469,6 +543,35 @@ struct Options {
   // Issue one request for every bytes_per_sync written. 0 turns it off.
   // Default: 0
   uint64_t bytes_per_sync;
+
+  // If true, writes are pipelined: once a write group has been appended
+  // to the WAL, the next group can start on the WAL while the first one
+  // is still being inserted into the memtable.  Groups are still inserted
+  // and become visible in order.  Improves throughput when WAL writes and
+  // memtable inserts take comparable time, e.g. with sync=false.
+  // Default: false
+  bool enable_pipelined_write;
+
+  // If true, a write group is inserted into the memtable as soon as it is
+  // in the WAL, concurrently with the inserts of other groups, and its
+  // sequence numbers are published without waiting for earlier groups to
+  // finish their inserts.  Raises write throughput further than pipelined
+  // writes, at the cost of read consistency: a read without a snapshot may
+  // see a later write but not an earlier one still being inserted.
+  // GetSnapshot() waits for the writes below its sequence number, so
+  // reads through a snapshot stay consistent.
+  // Cannot be combined with enable_pipelined_write.
+  // Default: false
+  bool unordered_write;
+
+  // If true, WAL records are buffered in memory rather than written out
+  // after every write group, and the application calls DB::FlushWAL() at
+  // its own commit boundaries.  Many writes then share one write(2) call,
+  // and one sync with FlushWAL(true).  Buffered records are lost on a
+  // crash; they are written out when the buffer fills, when the WAL is
+  // switched, by a write with WriteOptions::sync, and on close.
+  // Default: false
+  bool manual_wal_flush;
 };
 
 // Options that control read operations
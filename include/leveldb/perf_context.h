@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// PerfContext breaks a single operation (Get, Write, iterator Seek/Next)
+// down into counters and per-stage timings.  The context is thread local:
+// reset it, run the operation, then read the counters on the same thread.
+//
+//    SetPerfLevel(kEnableTime);
+//    get_perf_context()->Reset();
+//    db->Get(ReadOptions(), key, &value);
+//    uint64_t wal = get_perf_context()->write_wal_time;
+//
+// With the default level (kDisable) every instrumentation point costs one
+// thread-local load and a branch.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace leveldb {
+
+// How much per-operation detail is collected by the calling thread.
+enum PerfLevel : unsigned char {
+  kUninitialized = 0,  // unknown setting
+  kDisable = 1,        // disable perf stats
+  kEnableCount = 2,    // enable only count stats
+  kEnableTime = 3,     // enable count and time stats
+  kOutOfBounds = 4     // N.B. Must always be the last value!
+};
+
+// Set the perf stats level for the current thread.
+void SetPerfLevel(PerfLevel level);
+
+// Get the current perf stats level for the current thread.
+PerfLevel GetPerfLevel();
+
+// A thread local context for gathering performance counters efficiently
+// and transparently.  All times are in nanoseconds.
+struct PerfContext {
+  // Reset all performance counters to zero.
+  void Reset();
+
+  std::string ToString(bool exclude_zero_counters = false) const;
+
+  uint64_t user_key_comparison_count;  // total number of user key comparisons
+  uint64_t block_cache_hit_count;      // total number of block cache hits
+  uint64_t block_read_count;           // total number of block reads (with IO)
+  uint64_t block_read_byte;            // total number of bytes from block reads
+  uint64_t block_read_time;            // total time spent on block reads
+  uint64_t block_checksum_time;        // total time spent on block checksum
+  uint64_t block_decompress_time;      // total time spent on block decompression
+
+  // total number of internal keys skipped over during iteration (overwritten
+  // or deleted, to be more specific, hidden by a put or delete of the same key)
+  uint64_t internal_key_skipped_count;
+  // total number of deletes skipped over during iteration
+  uint64_t internal_delete_skipped_count;
+
+  uint64_t get_snapshot_time;           // total time spent on getting snapshot
+  uint64_t get_from_memtable_time;      // total time spent on querying memtables
+  uint64_t get_from_memtable_count;     // number of mem tables queried
+  // total time spent after Get() finds a key
+  uint64_t get_post_process_time;
+  uint64_t get_from_output_files_time;  // total time reading from output files
+
+  uint64_t seek_on_memtable_time;       // total time spent seeking memtables
+  uint64_t seek_on_memtable_count;      // number of seeks issued on memtable
+  uint64_t next_on_memtable_count;      // number of Next()s issued on memtable
+  uint64_t seek_child_seek_time;        // total time spent on seeking child iters
+  uint64_t seek_child_seek_count;       // number of seek issued in child iterators
+  uint64_t seek_min_heap_time;          // total time spent on the merge heap
+  // total time spent on seeking the internal entries
+  uint64_t seek_internal_seek_time;
+  // total time spent on iterating internal entries to find the next user entry
+  uint64_t find_next_user_entry_time;
+
+  uint64_t write_wal_time;              // total time spent on writing to WAL
+  uint64_t write_memtable_time;         // total time spent on writing to memtable
+  // total time spent on writes delayed or stopped by the write controller
+  uint64_t write_delay_time;
+  // total time spent on writing a record, excluding the above three times
+  uint64_t write_pre_and_post_process_time;
+  uint64_t db_mutex_lock_nanos;         // time spent on acquiring DB mutex
+
+  uint64_t bloom_memtable_hit_count;    // number of memtable bloom hits
+  uint64_t bloom_memtable_miss_count;   // number of memtable bloom misses
+  uint64_t bloom_sst_hit_count;         // number of SST bloom hits
+  uint64_t bloom_sst_miss_count;        // number of SST bloom misses
+};
+
+// Returns the PerfContext of the calling thread.
+PerfContext *get_perf_context();
+
+}  // namespace leveldb
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// A SecondaryCache is a second, larger and slower tier behind a Cache.
+// Entries the cache evicts are handed to it as bytes, and a cache miss
+// looks there before giving up.  Like a Cache it has internal
+// synchronization, and it may drop entries at any time.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class Env;
+
+class SecondaryCache {
+public:
+  SecondaryCache() = default;
+  virtual ~SecondaryCache();
+
+  // No copying allowed
+  SecondaryCache(const SecondaryCache &) = delete;
+  void operator=(const SecondaryCache &) = delete;
+
+  virtual const char *Name() const = 0;
+
+  // Stores "value" under "key", replacing any earlier value.  The cache
+  // may decline to store it, or keep an equal value it already holds.
+  virtual Status Insert(const Slice &key, const Slice &value) = 0;
+
+  // If the cache holds "key", stores its value in *value and returns true.
+  virtual bool Lookup(const Slice &key, std::string *value) = 0;
+
+  // Drops any value stored under "key".
+  virtual void Erase(const Slice &key) = 0;
+
+  // Number of writes to the cache's storage that have failed so far.
+  // Values may be written after Insert() returns, so their errors show up
+  // only here.
+  virtual uint64_t NumWriteErrors() const = 0;
+};
+
+// Creates a secondary cache of up to "capacity" bytes in files under the
+// directory "path", deleting any cache files left there.  Values are
+// appended to a log of segment files and located through an index in
+// memory; the oldest segment is dropped as a whole once the log outgrows
+// the capacity.  Segments are filled in memory and written out by a
+// background thread, and served from memory if their write fails.
+// Nothing survives the cache object.
+Status NewLogStructuredSecondaryCache(Env *env, const std::string &path,
+                                      size_t capacity,
+                                      std::shared_ptr<SecondaryCache> *result);
+
+} // namespace leveldb
@@ -43,7 +43,8 @@ enum Tickers {
   NO_FILE_CLOSES = 10,
   NO_FILE_OPENS = 11,
   NO_FILE_ERRORS = 12,
-  // Time system had to wait to do LO-L1 compactions
+  // Time writes were delayed to the delayed write rate while compaction
+  // catches up
   STALL_L0_SLOWDOWN_MICROS = 13,
   // Time system had to wait to move memtable to L1.
   STALL_MEMTABLE_COMPACTION_MICROS = 14,
@@ -58,7 +59,18 @@ enum Tickers {
   NUMBER_MULTIGET_KEYS_READ = 19,
   NUMBER_MULTIGET_BYTES_READ = 20,
 
-  TICKER_ENUM_MAX = 21
+  // write stop because of too many pending compaction bytes
+  STALL_PENDING_COMPACTION_BYTES_MICROS = 21,
+
+  // Lookups of Options::block_cache_compressed
+  BLOCK_CACHE_COMPRESSED_MISS = 22,
+  BLOCK_CACHE_COMPRESSED_HIT = 23,
+
+  // Lookups of Options::row_cache
+  ROW_CACHE_HIT = 24,
+  ROW_CACHE_MISS = 25,
+
+  TICKER_ENUM_MAX = 26
 };
 
 const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
@@ -82,7 +94,13 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {NO_ITERATORS, "rocksdb.num.iterators"},
     {NUMBER_MULTIGET_CALLS, "rocksdb.number.multiget.get"},
     {NUMBER_MULTIGET_KEYS_READ, "rocksdb.number.multiget.keys.read"},
-    {NUMBER_MULTIGET_BYTES_READ, "rocksdb.number.multiget.bytes.read"}};
+    {NUMBER_MULTIGET_BYTES_READ, "rocksdb.number.multiget.bytes.read"},
+    {STALL_PENDING_COMPACTION_BYTES_MICROS,
+     "rocksdb.pending.compaction.bytes.stall.micros"},
+    {BLOCK_CACHE_COMPRESSED_MISS, "rocksdb.block.cachecompressed.miss"},
+    {BLOCK_CACHE_COMPRESSED_HIT, "rocksdb.block.cachecompressed.hit"},
+    {ROW_CACHE_HIT, "rocksdb.row.cache.hit"},
+    {ROW_CACHE_MISS, "rocksdb.row.cache.miss"}};
 
 /**
  * Keep adding histogram's here.
@@ -167,8 +185,13 @@ private:
 };
 
 // Analyze the performance of a db
+//
+// Implementations must be safe for concurrent use: recordTick() and
+// measureTime() sit on the hot path of every read and write.
 class Statistics {
 public:
+  virtual ~Statistics() {}
+
   virtual long getTickerCount(Tickers tickerType) = 0;
   virtual void recordTick(Tickers tickerType, uint64_t count = 0) = 0;
   virtual void measureTime(Histograms histogramType, uint64_t time) = 0;
@@ -178,16 +201,25 @@ public:
   std::string ToString();
 };
 
-// Create a concrete DBStatistics object
+// Create a concrete DBStatistics object.  Tickers and histograms are kept in
+// per-core shards that are only summed when read, so the returned object can
+// be shared between threads and DB instances.
 std::shared_ptr<Statistics> CreateDBStatistics();
 
 // Ease of Use functions
-inline void RecordTick(std::shared_ptr<Statistics> statistics, Tickers ticker,
-                       uint64_t count = 1) {
+inline void RecordTick(const std::shared_ptr<Statistics> &statistics,
+                       Tickers ticker, uint64_t count = 1) {
   assert(HistogramsNameMap.size() == HISTOGRAM_ENUM_MAX);
   assert(TickersNameMap.size() == TICKER_ENUM_MAX);
   if (statistics) {
     statistics->recordTick(ticker, count);
   }
 }
+
+inline void MeasureTime(const std::shared_ptr<Statistics> &statistics,
+                        Histograms histogram, uint64_t value) {
+  if (statistics) {
+    statistics->measureTime(histogram, value);
+  }
+}
 } // namespace leveldb
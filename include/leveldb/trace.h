@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+// Options for DB::StartTrace().
+struct TraceOptions {
+  // Stop recording once this many bytes have been written to the trace.
+  // Default: 64GB
+  uint64_t max_trace_file_size;
+
+  // Record one out of every "sampling_frequency" queries.  Writes are
+  // sampled as well, so a sampled trace is only useful for read-heavy
+  // analysis or for replaying against a copy of the traced DB.
+  // Default: 1 (record everything)
+  uint64_t sampling_frequency;
+
+  TraceOptions()
+      : max_trace_file_size(uint64_t{64} * 1024 * 1024 * 1024),
+        sampling_frequency(1) {}
+};
+
+// TraceWriter receives the encoded trace records produced by a traced DB.
+// Implementations do not need to be thread safe, the DB serializes calls.
+class TraceWriter {
+public:
+  TraceWriter() {}
+  virtual ~TraceWriter();
+
+  // Append one encoded record.
+  virtual Status Write(const Slice &record) = 0;
+  virtual Status Close() = 0;
+
+  // Number of bytes written so far.
+  virtual uint64_t GetFileSize() = 0;
+
+private:
+  // No copying allowed
+  TraceWriter(const TraceWriter &);
+  void operator=(const TraceWriter &);
+};
+
+// TraceReader hands back the records written by a TraceWriter, in order.
+class TraceReader {
+public:
+  TraceReader() {}
+  virtual ~TraceReader();
+
+  // Read the next record into *record.  Returns NotFound at the end of
+  // the trace.
+  virtual Status Read(std::string *record) = 0;
+  virtual Status Close() = 0;
+
+private:
+  // No copying allowed
+  TraceReader(const TraceReader &);
+  void operator=(const TraceReader &);
+};
+
+// Create a TraceWriter that stores records in the file "trace_filename".
+Status NewFileTraceWriter(Env *env, const std::string &trace_filename,
+                          std::unique_ptr<TraceWriter> *trace_writer);
+
+// Create a TraceReader over a file written by NewFileTraceWriter().
+Status NewFileTraceReader(Env *env, const std::string &trace_filename,
+                          std::unique_ptr<TraceReader> *trace_reader);
+
+} // namespace leveldb
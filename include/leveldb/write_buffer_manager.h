@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// A WriteBufferManager caps the memory held by memtables across every DB
+// that shares it.  Each memtable reports the growth of its arena; once the
+// total crosses the budget the manager asks the DB with the largest mutable
+// memtable to switch it out and flush it.  Optionally the same memory is
+// charged to a block cache, so that memtables and cached blocks share one
+// memory limit.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "leveldb/cache.h"
+
+namespace leveldb {
+
+class WriteBufferManager {
+public:
+  // A DB whose memtables are accounted here.
+  class Consumer {
+  public:
+    virtual ~Consumer() = default;
+
+    // Approximate memory used by the mutable memtable.  Called with the
+    // manager's lock held, so it must not block.
+    virtual size_t MutableMemTableUsage() const = 0;
+
+    // Asks for the mutable memtable to be switched out and flushed soon.
+    // Called with the manager's lock held, so it must not block.
+    virtual void RequestFlush() = 0;
+  };
+
+  // A "buffer_size" of 0 disables the budget; memory is still tracked.
+  // If "cache" is non-null, memtable memory is also charged to it.
+  explicit WriteBufferManager(size_t buffer_size,
+                              std::shared_ptr<Cache> cache = nullptr);
+  ~WriteBufferManager();
+
+  // No copying allowed
+  WriteBufferManager(const WriteBufferManager &) = delete;
+  void operator=(const WriteBufferManager &) = delete;
+
+  bool enabled() const { return buffer_size_ > 0; }
+  size_t buffer_size() const { return buffer_size_; }
+
+  // Memory held by all memtables, mutable or not
+  size_t memory_usage() const {
+    return memory_used_.load(std::memory_order_relaxed);
+  }
+  // Memory held by mutable memtables only
+  size_t mutable_memtable_memory_usage() const {
+    return memory_active_.load(std::memory_order_relaxed);
+  }
+  // Memory currently charged to the cache, if any
+  size_t dummy_entries_in_cache_usage() const {
+    return dummy_size_.load(std::memory_order_relaxed);
+  }
+
+  // Whether some memtable should be flushed to stay within the budget.
+  // Flushing only frees memory once the flush completes, so this looks
+  // at mutable memory first: immutable memtables are already on their way
+  // out, and flushing yet another one would not help any sooner.
+  bool ShouldFlush() const {
+    if (!enabled()) { return false; }
+    const size_t active = mutable_memtable_memory_usage();
+    if (active > mutable_limit_) { return true; }
+    return memory_usage() >= buffer_size_ && active >= buffer_size_ / 2;
+  }
+
+  // A mutable memtable grew by "mem" bytes.
+  void ReserveMem(size_t mem);
+  // A memtable holding "mem" bytes became immutable and will be freed
+  // after its flush.
+  void ScheduleFreeMem(size_t mem);
+  // A memtable holding "mem" bytes was freed.
+  void FreeMem(size_t mem);
+
+  // Consumers must unregister before they are destroyed.
+  void RegisterConsumer(Consumer *consumer);
+  void UnregisterConsumer(Consumer *consumer);
+
+  // Calls RequestFlush() on the consumer with the largest mutable memtable.
+  // Returns it, or nullptr if no consumer has anything to flush.
+  Consumer *RequestFlushOfLargest();
+
+private:
+  // Charge or release dummy cache entries until the charge covers the
+  // current usage.
+  // REQUIRES: cache_mutex_ held
+  void AdjustCacheCharge();
+  void ReleaseDummyEntry(const std::pair<uint64_t, Cache::Handle *> &entry);
+
+  const size_t buffer_size_;
+  const size_t mutable_limit_;
+  std::atomic<size_t> memory_used_;
+  std::atomic<size_t> memory_active_;
+
+  // Cache charging state, guarded by cache_mutex_
+  const std::shared_ptr<Cache> cache_;
+  std::mutex cache_mutex_;
+  // Pinned dummy entries and the ids their keys were built from
+  std::vector<std::pair<uint64_t, Cache::Handle *>> dummy_entries_;
+  std::atomic<size_t> dummy_size_;
+
+  std::mutex consumers_mutex_;
+  std::vector<Consumer *> consumers_;
+};
+
+} // namespace leveldb
@@ -0,0 +1,187 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "db/key_compare.h"
+#include "db/skiplist.h"
+#include "util/arena.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+using Key = uint64_t;
+
+struct BenchComparator {
+  int operator()(const Key &a, const Key &b) const {
+    if (a < b) {
+      return -1;
+    } else if (a > b) {
+      return +1;
+    } else {
+      return 0;
+    }
+  }
+};
+
+static std::vector<Key> RandomKeys(size_t n) {
+  Random64 rnd(301);
+  std::vector<Key> keys(n);
+  for (Key &k : keys) { k = rnd.Next(); }
+  return keys;
+}
+
+static void BM_SkipListInsertRandom(benchmark::State &state) {
+  const std::vector<Key> keys = RandomKeys(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      Arena arena;
+      SkipList<Key, BenchComparator> list(BenchComparator(), &arena);
+      state.ResumeTiming();
+      for (Key k : keys) { list.Insert(k); }
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_SkipListInsertRandom)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_SkipListInsertSequential(benchmark::State &state) {
+  const size_t n = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    {
+      Arena arena;
+      SkipList<Key, BenchComparator> list(BenchComparator(), &arena);
+      state.ResumeTiming();
+      for (Key k = 0; k < n; k++) { list.Insert(k); }
+      state.PauseTiming();
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_SkipListInsertSequential)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_SkipListContains(benchmark::State &state) {
+  const std::vector<Key> keys = RandomKeys(state.range(0));
+  Arena arena;
+  SkipList<Key, BenchComparator> list(BenchComparator(), &arena);
+  for (Key k : keys) { list.Insert(k); }
+  Random64 rnd(17);
+  for (auto _ : state) {
+    // Half of the probes hit an existing key
+    const Key k = rnd.OneIn(2) ? keys[rnd.Uniform(keys.size())] : rnd.Next();
+    benchmark::DoNotOptimize(list.Contains(k));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SkipListContains)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+
+// Internal keys of a 16-byte user key and a tag, compared like a memtable
+// on BytewiseComparator(): through the virtual InternalKeyComparator when
+// range(0) is 0, through the inline functor otherwise.
+static const size_t kInternalKeySize = 24;
+
+template <typename KeyCompare>
+struct InternalKeyBenchComparator {
+  KeyCompare compare;
+  int operator()(const char *a, const char *b) const {
+    return compare(Slice(a, kInternalKeySize), Slice(b, kInternalKeySize));
+  }
+};
+
+template <typename KeyCompare>
+static void SkipListSeekInternalKeys(benchmark::State &state,
+                                     const KeyCompare &compare) {
+  const size_t n = 1 << 16;
+  std::string storage;
+  Random64 rnd(301);
+  for (size_t i = 0; i < n; i++) {
+    // Shared "user" prefix so the comparison looks past the first word
+    std::string user_key = "user" + std::to_string(1000000 + rnd.Uniform(n));
+    user_key.resize(16, '0');
+    AppendInternalKey(&storage, ParsedInternalKey(user_key, i, kTypeValue));
+  }
+  Arena arena;
+  typedef InternalKeyBenchComparator<KeyCompare> Cmp;
+  SkipList<const char *, Cmp> list(Cmp{compare}, &arena);
+  for (size_t i = 0; i < n; i++) {
+    list.Insert(storage.data() + i * kInternalKeySize);
+  }
+  typename SkipList<const char *, Cmp>::Iterator iter(&list);
+  for (auto _ : state) {
+    iter.Seek(storage.data() + rnd.Uniform(n) * kInternalKeySize);
+    benchmark::DoNotOptimize(iter.key());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_SkipListSeekInternalKey(benchmark::State &state) {
+  const InternalKeyComparator icmp(BytewiseComparator());
+  if (state.range(0) == 0) {
+    SkipListSeekInternalKeys(state, VirtualKeyCompare{&icmp});
+  } else {
+    SkipListSeekInternalKeys(state, BytewiseInternalKeyCompare());
+  }
+}
+BENCHMARK(BM_SkipListSeekInternalKey)->Arg(0)->Arg(1);
+
+// Same comparison as InternalKeyBenchComparator<BytewiseInternalKeyCompare>,
+// plus the normalized prefix that SkipList caches in its nodes.
+struct PrefixInternalKeyBenchComparator {
+  int operator()(const char *a, const char *b) const {
+    return BytewiseInternalKeyCompare()(Slice(a, kInternalKeySize),
+                                        Slice(b, kInternalKeySize));
+  }
+  uint64_t Prefix(const char *key) const {
+    return __builtin_bswap64(DecodeFixed64(key));
+  }
+};
+
+// Seeks among range(1) keys with random 16-byte user keys, without
+// (range(0) == 0) and with the cached prefix.  The list is larger than
+// the CPU caches, so most of a seek's cost is cache misses on nodes and
+// keys.
+template <typename Cmp>
+static void SkipListSeekRandomKeys(benchmark::State &state) {
+  const size_t n = state.range(1);
+  std::string storage;
+  Random64 rnd(301);
+  for (size_t i = 0; i < n; i++) {
+    std::string user_key(16, '\0');
+    EncodeFixed64(&user_key[0], rnd.Next());
+    EncodeFixed64(&user_key[8], rnd.Next());
+    AppendInternalKey(&storage, ParsedInternalKey(user_key, i, kTypeValue));
+  }
+  Arena arena;
+  SkipList<const char *, Cmp> list(Cmp(), &arena);
+  for (size_t i = 0; i < n; i++) {
+    list.Insert(storage.data() + i * kInternalKeySize);
+  }
+  typename SkipList<const char *, Cmp>::Iterator iter(&list);
+  for (auto _ : state) {
+    iter.Seek(storage.data() + rnd.Uniform(n) * kInternalKeySize);
+    benchmark::DoNotOptimize(iter.key());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_SkipListSeekPrefixCache(benchmark::State &state) {
+  if (state.range(0) == 0) {
+    SkipListSeekRandomKeys<
+        InternalKeyBenchComparator<BytewiseInternalKeyCompare>>(state);
+  } else {
+    SkipListSeekRandomKeys<PrefixInternalKeyBenchComparator>(state);
+  }
+}
+BENCHMARK(BM_SkipListSeekPrefixCache)
+    ->Args({0, 1 << 16})
+    ->Args({1, 1 << 16})
+    ->Args({0, 1 << 20})
+    ->Args({1, 1 << 20});
+
+} // namespace leveldb
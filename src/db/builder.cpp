@@ -0,0 +1,82 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/builder.h"
+
+#include "db/dbformat.h"
+#include "db/filename.h"
+#include "db/table_cache.h"
+#include "db/version_edit.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include "leveldb/statistics.h"
+#include "table/table_builder.h"
+
+namespace leveldb {
+
+Status BuildTable(const std::string &dbname, Env *env, const Options &options,
+                  TableCache *table_cache, Iterator *iter, FileMetaData *meta) {
+  Status s;
+  meta->file_size = 0;
+  iter->SeekToFirst();
+
+  std::string fname = TableFileName(dbname, meta->number);
+  if (iter->Valid()) {
+    std::unique_ptr<WritableFile> file;
+    s = env->NewWritableFile(fname, &file, EnvOptions(options));
+    if (!s.ok()) { return s; }
+
+    TableBuilder *builder = new TableBuilder(options, file.get());
+    meta->smallest.DecodeFrom(iter->key());
+    Slice key;
+    for (; iter->Valid(); iter->Next()) {
+      key = iter->key();
+      ParsedInternalKey ikey;
+      if (ParseInternalKey(key, &ikey) && ikey.type == kTypeDeletion) {
+        meta->num_deletions++;
+      }
+      builder->Add(key, iter->value());
+    }
+    if (!key.empty()) { meta->largest.DecodeFrom(key); }
+
+    // Finish and check for builder errors
+    s = builder->Finish();
+    if (s.ok()) {
+      meta->file_size = builder->FileSize();
+      meta->num_entries = builder->NumEntries();
+      assert(meta->file_size > 0);
+    }
+    delete builder;
+
+    // Finish and check for file errors
+    if (s.ok() && !options.disableDataSync) {
+      const uint64_t start_micros = env->NowMicros();
+      s = options.use_fsync ? file->Fsync() : file->Sync();
+      MeasureTime(options.statistics, TABLE_SYNC_MICROS,
+                  env->NowMicros() - start_micros);
+    }
+    if (s.ok()) { s = file->Close(); }
+    file.reset();
+
+    if (s.ok()) {
+      // Verify that the table is usable
+      Iterator *it = table_cache->NewIterator(
+          ReadOptions(), meta->number, meta->file_size, nullptr, kFlush);
+      s = it->status();
+      delete it;
+    }
+  }
+
+  // Check for input iterator errors
+  if (!iter->status().ok()) { s = iter->status(); }
+
+  if (s.ok() && meta->file_size > 0) {
+    // Keep it
+  } else {
+    env->DeleteFile(fname);
+  }
+  return s;
+}
+
+}  // namespace leveldb
@@ -4,10 +4,2198 @@
 
 #include "db/db_impl.h"
 
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+
+#include "db/builder.h"
+#include "db/db_iter.h"
+#include "db/filename.h"
+#include "db/log_reader.h"
+#include "db/memtable.h"
+#include "db/table_cache.h"
+#include "db/trace_replay.h"
+#include "db/version_set.h"
+#include "db/write_batch_interal.h"
+#include "leveldb/cache.h"
+#include "leveldb/statistics.h"
 #include "leveldb/status.h"
+#include "table/merger.h"
+#include "table/table_builder.h"
+#include "util/logging.h"
+#include "util/mutexlock.h"
+#include "util/perf_context_imp.h"
 
 namespace leveldb {
 
+const int kNumNonTableCacheFiles = 10;
+
+// Information kept for every waiting writer
+struct DBImpl::Writer {
+  explicit Writer(port::Mutex *mu)
+      : batch(nullptr), sync(false), disableWAL(false), done(false), cv(mu) {}
+
+  Status status;
+  WriteBatch *batch;
+  bool sync;
+  bool disableWAL;
+  bool done;
+  port::CondVar cv;
+};
+
+// A write group between the WAL and memtable stages of a pipelined write
+struct DBImpl::WriteGroup {
+  Writer *leader;
+  Writer *last_writer;
+  std::vector<Writer *> followers;  // Writers other than leader
+  SequenceNumber last_sequence;
+  WriteBatch batch;                 // Combined batch, if more than one
+};
+
+struct DBImpl::CompactionState {
+  // Files produced by compaction
+  struct Output {
+    uint64_t number;
+    uint64_t file_size;
+    uint64_t num_entries;
+    uint64_t num_deletions;
+    InternalKey smallest, largest;
+  };
+
+  Output *current_output() { return &outputs[outputs.size() - 1]; }
+
+  explicit CompactionState(Compaction *c)
+      : compaction(c), smallest_snapshot(0), builder(nullptr), total_bytes(0) {}
+
+  Compaction *const compaction;
+
+  // Sequence numbers < smallest_snapshot are not significant since we
+  // will never have to service a snapshot below smallest_snapshot.
+  // Therefore if we have seen a sequence number S <= smallest_snapshot,
+  // we can drop all entries for the same key with sequence numbers < S.
+  SequenceNumber smallest_snapshot;
+
+  std::vector<Output> outputs;
+
+  // State kept for output being generated
+  std::unique_ptr<WritableFile> outfile;
+  TableBuilder *builder;
+
+  uint64_t total_bytes;
+};
+
+// Fix user-supplied options to be reasonable
+template <class T, class V>
+static void ClipToRange(T *ptr, V minvalue, V maxvalue) {
+  if (static_cast<V>(*ptr) > maxvalue) *ptr = maxvalue;
+  if (static_cast<V>(*ptr) < minvalue) *ptr = minvalue;
+}
+Options SanitizeOptions(const std::string &dbname,
+                        const InternalKeyComparator *icmp,
+                        const InternalFilterPolicy *ipolicy,
+                        const Options &src) {
+  Options result = src;
+  result.comparator = icmp;
+  result.filter_policy = (src.filter_policy != nullptr) ? ipolicy : nullptr;
+  if (result.max_open_files != -1) {
+    ClipToRange(&result.max_open_files, 64 + kNumNonTableCacheFiles, 50000);
+  }
+  ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
+  ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+  ClipToRange(&result.num_levels, 2, 64);
+  ClipToRange(&result.max_write_buffer_number, 2, 64);
+  ClipToRange(&result.wal_recovery_threads, 1, 64);
+  ClipToRange(&result.max_mem_compaction_level, 0, result.num_levels - 1);
+  if (result.max_bytes_for_level_multiplier_additional.size() <
+      static_cast<size_t>(result.num_levels)) {
+    result.max_bytes_for_level_multiplier_additional.resize(result.num_levels,
+                                                            1);
+  }
+  if (result.info_log == nullptr) {
+    // Open a log file in the same directory as the db
+    src.env->CreateDir(dbname);  // In case it does not exist
+    src.env->RenameFile(InfoLogFileName(dbname), OldInfoLogFileName(dbname));
+    Status s = src.env->NewLogger(InfoLogFileName(dbname), &result.info_log);
+    if (!s.ok()) {
+      // No place suitable for logging
+      result.info_log = nullptr;
+    }
+  }
+  if (result.block_cache == nullptr && !result.no_block_cache) {
+    result.block_cache = NewLRUCache(8 << 20);
+  }
+  if (result.no_block_cache) { result.block_cache = nullptr; }
+  if (result.write_buffer_manager == nullptr &&
+      result.db_write_buffer_size > 0) {
+    result.write_buffer_manager =
+        std::make_shared<WriteBufferManager>(result.db_write_buffer_size);
+  }
+  return result;
+}
+
+DBImpl::DBImpl(const Options &raw_options, const std::string &dbname)
+    : env_(raw_options.env),
+      internal_comparator_(raw_options.comparator),
+      internal_filter_policy_(raw_options.filter_policy),
+      options_(SanitizeOptions(dbname, &internal_comparator_,
+                               &internal_filter_policy_, raw_options)),
+      dbname_(dbname),
+      table_cache_(new TableCache(
+          dbname_, &options_,
+          options_.max_open_files < 0
+              ? -1
+              : options_.max_open_files - kNumNonTableCacheFiles,
+          &block_cache_tracer_)),
+      db_lock_(nullptr),
+      mutex_(options_.use_adaptive_mutex),
+      shutting_down_(false),
+      bg_cv_(&mutex_),
+      mem_(nullptr),
+      logfile_number_(0),
+      unordered_writes_cv_(&mutex_),
+      tmp_batch_(new WriteBatch),
+      last_batch_group_size_(0),
+      write_controller_(options_.delayed_write_rate),
+      bg_compaction_scheduled_(false),
+      manual_compaction_(nullptr),
+      versions_(new VersionSet(dbname_, &options_, table_cache_,
+                               &internal_comparator_)),
+      write_buffer_manager_(options_.write_buffer_manager.get()),
+      mutable_memtable_usage_(0),
+      flush_requested_(false),
+      pending_flush_requests_(0),
+      disable_delete_obsolete_files_(0),
+      internal_stats_(new InternalStats(options_.num_levels, env_)),
+      stats_dump_thread_running_(false),
+      last_stats_dump_time_microsec_(0),
+      last_deploy_stats_log_time_microsec_(0),
+      tracing_(false) {
+  MutexLock l(&mutex_);
+  internal_stats_->SetVersionStats(versions_->current());
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->RegisterConsumer(this);
+  }
+}
+
+DBImpl::~DBImpl() {
+  // No more flush requests from the write buffer manager
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->UnregisterConsumer(this);
+  }
+
+  // Wait for background work to finish
+  mutex_.Lock();
+  shutting_down_.store(true, std::memory_order_release);
+  bg_cv_.SignalAll();
+  while (bg_compaction_scheduled_ || stats_dump_thread_running_ ||
+         pending_flush_requests_.load(std::memory_order_acquire) > 0) {
+    bg_cv_.Wait();
+  }
+  mutex_.Unlock();
+
+  if (db_lock_ != nullptr) { env_->UnlockFile(db_lock_); }
+
+  delete versions_;
+  if (mem_ != nullptr) { mem_->Unref(); }
+  imm_.UnrefAll();
+  delete tmp_batch_;
+  log_.reset();
+  delete table_cache_;
+}
+
+Status DBImpl::NewDB() {
+  VersionEdit new_db;
+  new_db.SetComparatorName(user_comparator()->Name());
+  new_db.SetLogNumber(0);
+  new_db.SetNextFile(2);
+  new_db.SetLastSequence(0);
+
+  const std::string manifest = DescriptorFileName(dbname_, 1);
+  std::unique_ptr<WritableFile> file;
+  Status s = env_->NewWritableFile(manifest, &file, EnvOptions(options_));
+  if (!s.ok()) { return s; }
+  {
+    log::Writer log(std::move(file));
+    std::string record;
+    new_db.EncodeTo(&record);
+    s = log.AddRecord(record);
+    if (s.ok()) { s = log.file()->Sync(); }
+    if (s.ok()) { s = log.file()->Close(); }
+  }
+  if (s.ok()) {
+    // Make "CURRENT" file that points to the new manifest file.
+    s = SetCurrentFile(env_, dbname_, 1);
+  } else {
+    env_->DeleteFile(manifest);
+  }
+  return s;
+}
+
+void DBImpl::MaybeIgnoreError(Status *s) const {
+  if (s->ok() || options_.paranoid_checks) {
+    // No change needed
+  } else {
+    Log(options_.info_log, "Ignoring error %s", s->ToString().c_str());
+    *s = Status::OK();
+  }
+}
+
+void DBImpl::DeleteObsoleteFiles() {
+  mutex_.AssertHeld();
+
+  if (!bg_error_.ok() || disable_delete_obsolete_files_ > 0) {
+    // After a background error, we don't know whether a new version may
+    // or may not have been committed, so we cannot safely garbage collect.
+    return;
+  }
+
+  // Unpin moved tables that no reader can get at level 0 any more
+  if (!pending_unpins_.empty()) {
+    std::set<uint64_t> level0;
+    versions_->AddLiveFilesAtLevel(0, &level0);
+    for (auto it = pending_unpins_.begin(); it != pending_unpins_.end();) {
+      if (level0.count(*it) == 0) {
+        table_cache_->Unpin(*it);
+        it = pending_unpins_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // Make a set of all of the live files
+  std::set<uint64_t> live = pending_outputs_;
+  versions_->AddLiveFiles(&live);
+
+  std::vector<std::string> filenames;
+  env_->GetChildren(dbname_, &filenames);  // Ignoring errors on purpose
+  uint64_t number;
+  FileType type;
+  std::vector<std::string> files_to_delete;
+  for (std::string &filename : filenames) {
+    if (ParseFileName(filename, &number, &type)) {
+      bool keep = true;
+      switch (type) {
+        case kLogFile:
+          keep = ((number >= versions_->LogNumber()) ||
+                  (number == versions_->PrevLogNumber()));
+          break;
+        case kDescriptorFile:
+          // Keep my manifest file, and any newer incarnations'
+          // (in case there is a race that allows other incarnations)
+          keep = (number >= versions_->ManifestFileNumber());
+          break;
+        case kTableFile:
+          keep = (live.find(number) != live.end());
+          break;
+        case kTempFile:
+          // Any temp files that are currently being written to must
+          // be recorded in pending_outputs_, which is inserted into "live"
+          keep = (live.find(number) != live.end());
+          break;
+        case kCurrentFile:
+        case kDBLockFile:
+        case kInfoLogFile:
+          keep = true;
+          break;
+      }
+
+      if (!keep) {
+        files_to_delete.push_back(std::move(filename));
+        if (type == kTableFile) { table_cache_->Evict(number); }
+        Log(options_.info_log, "Delete type=%d #%lld\n", static_cast<int>(type),
+            static_cast<unsigned long long>(number));
+      }
+    }
+  }
+
+  // While deleting all files unblock other threads. All files being deleted
+  // have unique names which will not collide with newly created files and
+  // are therefore safe to delete while allowing other threads to proceed.
+  mutex_.Unlock();
+  for (const std::string &filename : files_to_delete) {
+    env_->DeleteFile(dbname_ + "/" + filename);
+  }
+  mutex_.Lock();
+}
+
+Status DBImpl::Recover(VersionEdit *edit) {
+  mutex_.AssertHeld();
+
+  // Ignore error from CreateDir since the creation of the DB is
+  // committed only when the descriptor is created, and this directory
+  // may already exist from a previous failed creation attempt.
+  env_->CreateDir(dbname_);
+  assert(db_lock_ == nullptr);
+  Status s = env_->LockFile(LockFileName(dbname_), &db_lock_);
+  if (!s.ok()) { return s; }
+
+  if (!env_->FileExists(CurrentFileName(dbname_))) {
+    if (options_.create_if_missing) {
+      s = NewDB();
+      if (!s.ok()) { return s; }
+    } else {
+      return Status::InvalidArgument(
+          dbname_, "does not exist (create_if_missing is false)");
+    }
+  } else {
+    if (options_.error_if_exists) {
+      return Status::InvalidArgument(dbname_,
+                                     "exists (error_if_exists is true)");
+    }
+  }
+
+  s = versions_->Recover();
+  if (!s.ok()) { return s; }
+  SequenceNumber max_sequence(0);
+
+  // Recover from all newer log files than the ones named in the
+  // descriptor (new log files may have been added by the previous
+  // incarnation without registering them in the descriptor).
+  //
+  // Note that PrevLogNumber() is no longer used, but we pay
+  // attention to it in case we are recovering a database
+  // produced by an older version of leveldb.
+  const uint64_t min_log = versions_->LogNumber();
+  const uint64_t prev_log = versions_->PrevLogNumber();
+  std::vector<std::string> filenames;
+  s = env_->GetChildren(dbname_, &filenames);
+  if (!s.ok()) { return s; }
+  std::set<uint64_t> expected;
+  versions_->AddLiveFiles(&expected);
+  uint64_t number;
+  FileType type;
+  std::vector<uint64_t> logs;
+  for (size_t i = 0; i < filenames.size(); i++) {
+    if (ParseFileName(filenames[i], &number, &type)) {
+      expected.erase(number);
+      if (type == kLogFile && ((number >= min_log) || (number == prev_log))) {
+        logs.push_back(number);
+      }
+    }
+  }
+  if (!expected.empty()) {
+    char buf[50];
+    std::snprintf(buf, sizeof(buf), "%d missing files; e.g.",
+                  static_cast<int>(expected.size()));
+    return Status::Corruption(buf, TableFileName(dbname_, *(expected.begin())));
+  }
+
+  // Recover in the order in which the logs were generated
+  std::sort(logs.begin(), logs.end());
+  for (size_t i = 0; i < logs.size(); i++) {
+    s = RecoverLogFile(logs[i], edit, &max_sequence);
+    if (!s.ok()) { return s; }
+
+    // The previous incarnation may not have written any MANIFEST
+    // records after allocating this log number.  So we manually
+    // update the file number allocation counter in VersionSet.
+    versions_->MarkFileNumberUsed(logs[i]);
+  }
+
+  if (versions_->LastSequence() < max_sequence) {
+    versions_->SetLastSequence(max_sequence);
+  }
+
+  return Status::OK();
+}
+
+namespace {
+
+// WAL records read ahead of the replay.  Bounded, so that a large log
+// does not have to fit in memory.
+class RecordQueue {
+public:
+  explicit RecordQueue(size_t max_bytes)
+      : cv_(&mu_), max_bytes_(max_bytes), bytes_(0), done_(false),
+        closed_(false) {}
+
+  // Called by the reader.  Returns false if the replay stopped early.
+  bool Push(std::string &&record) {
+    MutexLock l(&mu_);
+    while (bytes_ >= max_bytes_ && !closed_) { cv_.Wait(); }
+    if (closed_) { return false; }
+    bytes_ += record.size();
+    records_.push_back(std::move(record));
+    cv_.SignalAll();
+    return true;
+  }
+
+  // Called by the reader when it has read everything it will.
+  void Finish() {
+    MutexLock l(&mu_);
+    done_ = true;
+    cv_.SignalAll();
+  }
+
+  // Called by the replay.  Moves every queued record to *records, waiting
+  // for some.  Returns false once the reader is done and nothing is left.
+  bool PopAll(std::deque<std::string> *records) {
+    MutexLock l(&mu_);
+    while (records_.empty() && !done_) { cv_.Wait(); }
+    if (records_.empty()) { return false; }
+    records->swap(records_);
+    bytes_ = 0;
+    cv_.SignalAll();
+    return true;
+  }
+
+  // Called by the replay when it is done, possibly early.  Waits for the
+  // reader to finish.
+  void Close() {
+    MutexLock l(&mu_);
+    closed_ = true;
+    cv_.SignalAll();
+    while (!done_) { cv_.Wait(); }
+  }
+
+private:
+  port::Mutex mu_;
+  port::CondVar cv_;
+  const size_t max_bytes_;
+  size_t bytes_;
+  bool done_;
+  bool closed_;
+  std::deque<std::string> records_;
+};
+
+// Read ahead of the replay; a few write buffers' worth keeps the reader
+// busy while the replay inserts.
+constexpr size_t kRecoveryReadAheadBytes = 16 << 20;
+
+struct LogReporter : public log::Reader::Reporter {
+  Env *env;
+  Logger *info_log;
+  const char *fname;
+  Status *status;  // null if options_.paranoid_checks==false
+  void Corruption(size_t bytes, const Status &s) override {
+    Log(info_log, "%s%s: dropping %d bytes; %s",
+        (this->status == nullptr ? "(ignoring error) " : ""), fname,
+        static_cast<int>(bytes), s.ToString().c_str());
+    if (this->status != nullptr && this->status->ok()) *this->status = s;
+  }
+};
+
+// The reader stage of recovery: reads records and checks their CRCs.
+struct LogReadState {
+  log::Reader *reader;
+  LogReporter *reporter;
+  const Status *status;  // Where *reporter records errors, if anywhere
+  RecordQueue *queue;
+};
+
+void ReadLogRecords(void *arg) {
+  LogReadState *state = reinterpret_cast<LogReadState *>(arg);
+  std::string scratch;
+  Slice record;
+  while (state->reader->ReadRecord(&record, &scratch) &&
+         state->status->ok()) {
+    if (record.size() < 12) {
+      state->reporter->Corruption(record.size(),
+                                  Status::Corruption("log record too small"));
+      continue;
+    }
+    if (!state->queue->Push(record.ToString())) { break; }
+  }
+  state->queue->Finish();
+}
+
+} // namespace
+
+struct DBImpl::RecoveryFlushes {
+  int in_flight = 0;
+  Status status;  // First error of any flush
+};
+
+struct DBImpl::RecoveryFlush {
+  DBImpl *db;
+  MemTable *mem;
+  VersionEdit *edit;
+  uint64_t number;
+  RecoveryFlushes *flushes;
+};
+
+Status DBImpl::RecoverLogFile(uint64_t log_number, VersionEdit *edit,
+                              SequenceNumber *max_sequence) {
+  mutex_.AssertHeld();
+
+  // Open the log file
+  std::string fname = LogFileName(dbname_, log_number);
+  std::unique_ptr<SequentialFile> file;
+  Status status = env_->NewSequentialFile(fname, &file, EnvOptions(options_));
+  if (!status.ok()) {
+    MaybeIgnoreError(&status);
+    return status;
+  }
+
+  // Create the log reader.  It reports to its own status, since it runs
+  // on its own thread.
+  Status read_status;
+  LogReporter reporter;
+  reporter.env = env_;
+  reporter.info_log = options_.info_log.get();
+  reporter.fname = fname.c_str();
+  reporter.status =
+      (options_.paranoid_checks && !options_.skip_log_error_on_recovery
+           ? &read_status
+           : nullptr);
+  // We intentionally make log::Reader do checksumming even if
+  // paranoid_checks==false so that corruptions cause entire commits
+  // to be skipped instead of propagating bad information (like overly
+  // large sequence numbers).
+  log::Reader reader(std::move(file), &reporter, true /*checksum*/,
+                     0 /*initial_offset*/);
+  Log(options_.info_log, "Recovering log #%llu",
+      static_cast<unsigned long long>(log_number));
+
+  // Recovery is a pipeline: a thread reads and checksums records, this one
+  // decodes them into memtables, and full memtables are built into tables
+  // by ScheduleRecoveryFlush() while the replay goes on.  Nothing else
+  // uses the DB yet, so the replay runs without mutex_, which flushes need.
+  RecordQueue queue(kRecoveryReadAheadBytes);
+  LogReadState read_state{&reader, &reporter, &read_status, &queue};
+  env_->StartThread(&ReadLogRecords, &read_state);
+
+  RecoveryFlushes flushes;
+  std::deque<std::string> records;
+  WriteBatch batch;
+  MemTable *mem = nullptr;
+  mutex_.Unlock();
+  while (status.ok() && queue.PopAll(&records)) {
+    for (const std::string &record : records) {
+      WriteBatchInternal::SetContents(&batch, record);
+
+      if (mem == nullptr) {
+        mem = new MemTable(internal_comparator_, write_buffer_manager_);
+        mem->Ref();
+      }
+      status = WriteBatchInternal::InsertInto(&batch, mem);
+      MaybeIgnoreError(&status);
+      if (!status.ok()) { break; }
+      const SequenceNumber last_seq = WriteBatchInternal::Sequence(&batch) +
+                                      WriteBatchInternal::Count(&batch) - 1;
+      if (last_seq > *max_sequence) { *max_sequence = last_seq; }
+
+      if (mem->ApproximateMemoryUsage() > options_.write_buffer_size) {
+        mutex_.Lock();
+        status = ScheduleRecoveryFlush(mem, edit, &flushes);
+        mutex_.Unlock();
+        mem = nullptr;
+        if (!status.ok()) {
+          // Reflect errors immediately so that conditions like full
+          // file-systems cause the DB::Open() to fail.
+          break;
+        }
+      }
+    }
+    records.clear();
+  }
+  queue.Close();
+  mutex_.Lock();
+  if (status.ok()) { status = read_status; }
+
+  if (status.ok() && mem != nullptr) {
+    status = ScheduleRecoveryFlush(mem, edit, &flushes);
+    mem = nullptr;
+  }
+  while (flushes.in_flight > 0) { bg_cv_.Wait(); }
+  if (status.ok()) { status = flushes.status; }
+
+  if (mem != nullptr) { mem->Unref(); }
+  return status;
+}
+
+Status DBImpl::ScheduleRecoveryFlush(MemTable *mem, VersionEdit *edit,
+                                     RecoveryFlushes *flushes) {
+  mutex_.AssertHeld();
+  const int max_in_flight = options_.wal_recovery_threads - 1;
+  if (max_in_flight == 0) {
+    Status s = WriteLevel0Table(mem, edit, nullptr);
+    mem->Unref();
+    return s;
+  }
+  while (flushes->in_flight >= max_in_flight) { bg_cv_.Wait(); }
+  // Level-0 tables are ordered by file number, which must follow the log
+  // whichever flush finishes first.
+  RecoveryFlush *flush = new RecoveryFlush{this, mem, edit,
+                                           versions_->NewFileNumber(), flushes};
+  flushes->in_flight++;
+  env_->StartThread(&DBImpl::BGWorkRecoveryFlush, flush);
+  return flushes->status;
+}
+
+void DBImpl::BGWorkRecoveryFlush(void *arg) {
+  RecoveryFlush *flush = reinterpret_cast<RecoveryFlush *>(arg);
+  DBImpl *db = flush->db;
+  MutexLock l(&db->mutex_);
+  Status s = db->WriteLevel0Table(flush->mem, flush->edit, nullptr, nullptr,
+                                  flush->number);
+  flush->mem->Unref();
+  if (flush->flushes->status.ok()) { flush->flushes->status = s; }
+  flush->flushes->in_flight--;
+  delete flush;
+  db->bg_cv_.SignalAll();
+}
+
+Status DBImpl::WriteLevel0Table(MemTable *mem, VersionEdit *edit,
+                                Version *base, uint64_t *file_number,
+                                uint64_t number) {
+  mutex_.AssertHeld();
+  const uint64_t start_micros = env_->NowMicros();
+  FileMetaData meta;
+  meta.number = number != 0 ? number : versions_->NewFileNumber();
+  pending_outputs_.insert(meta.number);
+  Iterator *iter = mem->NewIterator();
+  Log(options_.info_log, "Level-0 table #%llu: started",
+      static_cast<unsigned long long>(meta.number));
+
+  Status s;
+  {
+    mutex_.Unlock();
+    s = BuildTable(dbname_, env_, options_, table_cache_, iter, &meta);
+    mutex_.Lock();
+  }
+
+  Log(options_.info_log, "Level-0 table #%llu: %lld bytes %s",
+      static_cast<unsigned long long>(meta.number),
+      static_cast<unsigned long long>(meta.file_size), s.ToString().c_str());
+  delete iter;
+  pending_outputs_.erase(meta.number);
+
+  // Note that if file_size is zero, the file has been deleted and
+  // should not be added to the manifest.
+  int level = 0;
+  if (s.ok() && meta.file_size > 0) {
+    const Slice min_user_key = meta.smallest.user_key();
+    const Slice max_user_key = meta.largest.user_key();
+    if (base != nullptr) {
+      level = base->PickLevelForMemTableOutput(min_user_key, max_user_key);
+    }
+    edit->AddFile(level, meta);
+  }
+  if (file_number != nullptr) {
+    *file_number = (s.ok() && meta.file_size > 0) ? meta.number : 0;
+  }
+
+  InternalStats::CompactionStats stats;
+  stats.micros = env_->NowMicros() - start_micros;
+  stats.bytes_written = meta.file_size;
+  stats.files_out_levelnp1 = 1;
+  internal_stats_->AddCompactionStats(level, stats);
+  return s;
+}
+
+Status DBImpl::FlushMemTableToOutputFile() {
+  mutex_.AssertHeld();
+  MemTable *m = imm_.PickMemtableToFlush();
+  if (m == nullptr) { return Status::OK(); }
+
+  // Save the contents of the memtable as a new Table
+  VersionEdit edit;
+  Version *base = versions_->current();
+  base->Ref();
+  uint64_t file_number;
+  Status s = WriteLevel0Table(m, &edit, base, &file_number);
+  base->Unref();
+
+  if (s.ok() && shutting_down_.load(std::memory_order_acquire)) {
+    s = Status::IOError("Deleting DB during memtable compaction");
+  }
+
+  // Replace immutable memtable with the generated Table
+  if (s.ok()) {
+    // Earlier logs no longer needed
+    edit.SetPrevLogNumber(0);
+    edit.SetLogNumber(m->GetLogNumber());
+    s = versions_->LogAndApply(&edit, &mutex_);
+  }
+
+  if (s.ok()) {
+    imm_.RemoveFlushed(m, file_number);
+    UpdateMemTableStats();
+    UpdateVersionStats();
+    DeleteObsoleteFiles();
+    if (flush_requested_.load(std::memory_order_acquire)) {
+      // A flush request that found imm_ full gave up; retry it now that
+      // there is room, in case no writer comes along to handle it.
+      pending_flush_requests_.fetch_add(1, std::memory_order_relaxed);
+      env_->Schedule(&DBImpl::BGWorkFlushRequest, this);
+    }
+  } else {
+    imm_.RollbackMemtableFlush(m);
+    RecordBackgroundError(s);
+  }
+  return s;
+}
+
+void DBImpl::CompactRange(const Slice *begin, const Slice *end) {
+  int max_level_with_files = 1;
+  {
+    MutexLock l(&mutex_);
+    Version *base = versions_->current();
+    for (int level = 1; level < NumberLevels(); level++) {
+      if (base->OverlapInLevel(level, begin, end)) {
+        max_level_with_files = level;
+      }
+    }
+  }
+  TEST_FlushMemTable();  // TODO(sanjay): Skip if memtable does not overlap
+  for (int level = 0; level < max_level_with_files; level++) {
+    TEST_CompactRange(level, begin, end);
+  }
+}
+
+void DBImpl::TEST_CompactRange(int level, const Slice *begin,
+                               const Slice *end) {
+  assert(level >= 0);
+  assert(level + 1 < NumberLevels());
+
+  InternalKey begin_storage, end_storage;
+
+  ManualCompaction manual;
+  manual.level = level;
+  manual.done = false;
+  if (begin == nullptr) {
+    manual.begin = nullptr;
+  } else {
+    begin_storage = InternalKey(*begin, kMaxSequenceNumber, kValueTypeForSeek);
+    manual.begin = &begin_storage;
+  }
+  if (end == nullptr) {
+    manual.end = nullptr;
+  } else {
+    end_storage = InternalKey(*end, 0, static_cast<ValueType>(0));
+    manual.end = &end_storage;
+  }
+
+  MutexLock l(&mutex_);
+  while (!manual.done && !shutting_down_.load(std::memory_order_acquire) &&
+         bg_error_.ok()) {
+    if (manual_compaction_ == nullptr) {  // Idle
+      manual_compaction_ = &manual;
+      MaybeScheduleCompaction();
+    } else {  // Running either my compaction or another compaction.
+      bg_cv_.Wait();
+    }
+  }
+  if (manual_compaction_ == &manual) {
+    // Cancel my manual compaction since we aborted early for some reason.
+    manual_compaction_ = nullptr;
+  }
+}
+
+Status DBImpl::Flush(const FlushOptions &options) {
+  // nullptr batch means just wait for earlier writes to be done
+  Status s = WriteImpl(WriteOptions(), nullptr);
+  if (s.ok() && options.wait) {
+    // Wait until the compaction completes
+    MutexLock l(&mutex_);
+    while (imm_.size() > 0 && bg_error_.ok()) { bg_cv_.Wait(); }
+    if (imm_.size() > 0) { s = bg_error_; }
+  }
+  return s;
+}
+
+Status DBImpl::TEST_FlushMemTable() { return Flush(FlushOptions()); }
+
+void DBImpl::RecordBackgroundError(const Status &s) {
+  mutex_.AssertHeld();
+  if (bg_error_.ok()) {
+    bg_error_ = s;
+    internal_stats_->IncBackgroundErrors();
+    bg_cv_.SignalAll();
+  }
+}
+
+void DBImpl::MaybeScheduleCompaction() {
+  mutex_.AssertHeld();
+  if (bg_compaction_scheduled_) {
+    // Already scheduled
+  } else if (shutting_down_.load(std::memory_order_acquire)) {
+    // DB is being deleted; no more background compactions
+  } else if (!bg_error_.ok()) {
+    // Already got an error; no more changes
+  } else if (!imm_.IsFlushPending() && manual_compaction_ == nullptr &&
+             !versions_->NeedsCompaction()) {
+    // No work to be done
+  } else {
+    bg_compaction_scheduled_ = true;
+    env_->Schedule(&DBImpl::BGWork, this);
+  }
+  internal_stats_->SetBackgroundWork(imm_.IsFlushPending(),
+                                     versions_->NeedsCompaction());
+}
+
+void DBImpl::BGWork(void *db) {
+  reinterpret_cast<DBImpl *>(db)->BackgroundCall();
+}
+
+void DBImpl::BackgroundCall() {
+  MutexLock l(&mutex_);
+  assert(bg_compaction_scheduled_);
+  if (shutting_down_.load(std::memory_order_acquire)) {
+    // No more background work when shutting down.
+  } else if (!bg_error_.ok()) {
+    // No more background work after a background error.
+  } else {
+    BackgroundCompaction();
+  }
+
+  bg_compaction_scheduled_ = false;
+
+  // Previous compaction may have produced too many files in a level,
+  // so reschedule another compaction if needed.
+  MaybeScheduleCompaction();
+  bg_cv_.SignalAll();
+}
+
+void DBImpl::BackgroundCompaction() {
+  mutex_.AssertHeld();
+
+  if (imm_.IsFlushPending()) {
+    FlushMemTableToOutputFile();
+    return;
+  }
+
+  Compaction *c;
+  const bool is_manual = (manual_compaction_ != nullptr);
+  InternalKey manual_end;
+  if (is_manual) {
+    ManualCompaction *m = manual_compaction_;
+    c = versions_->CompactRange(m->level, m->begin, m->end);
+    m->done = (c == nullptr);
+    if (c != nullptr) {
+      manual_end = c->input(0, c->num_input_files(0) - 1)->largest;
+    }
+    Log(options_.info_log,
+        "Manual compaction at level-%d from %s .. %s; will stop at %s\n",
+        m->level, (m->begin ? m->begin->DebugString().c_str() : "(begin)"),
+        (m->end ? m->end->DebugString().c_str() : "(end)"),
+        (m->done ? "(end)" : manual_end.DebugString().c_str()));
+  } else {
+    c = versions_->PickCompaction();
+  }
+
+  Status status;
+  if (c == nullptr) {
+    // Nothing to do
+  } else if (!is_manual && c->IsTrivialMove()) {
+    // Move file to next level
+    assert(c->num_input_files(0) == 1);
+    FileMetaData *f = c->input(0, 0);
+    c->edit()->DeleteFile(c->level(), f->number);
+    c->edit()->AddFile(c->level() + 1, *f);
+    status = versions_->LogAndApply(c->edit(), &mutex_);
+    if (!status.ok()) { RecordBackgroundError(status); }
+    if (status.ok() && c->level() == 0 &&
+        options_.pin_l0_filter_and_index_blocks) {
+      pending_unpins_.insert(f->number);
+    }
+    UpdateVersionStats();
+    VersionSet::LevelSummaryStorage tmp;
+    Log(options_.info_log, "Moved #%lld to level-%d %lld bytes %s: %s\n",
+        static_cast<unsigned long long>(f->number), c->level() + 1,
+        static_cast<unsigned long long>(f->file_size),
+        status.ToString().c_str(), versions_->LevelSummary(&tmp));
+  } else {
+    CompactionState *compact = new CompactionState(c);
+    status = DoCompactionWork(compact);
+    if (!status.ok()) { RecordBackgroundError(status); }
+    CleanupCompaction(compact);
+    c->ReleaseInputs();
+    DeleteObsoleteFiles();
+  }
+  delete c;
+
+  if (status.ok()) {
+    // Done
+  } else if (shutting_down_.load(std::memory_order_acquire)) {
+    // Ignore compaction errors found during shutting down
+  } else {
+    Log(options_.info_log, "Compaction error: %s", status.ToString().c_str());
+  }
+
+  if (is_manual) {
+    ManualCompaction *m = manual_compaction_;
+    if (!status.ok()) { m->done = true; }
+    if (!m->done) {
+      // We only compacted part of the requested range.  Update *m
+      // to the range that is left to be compacted.
+      m->tmp_storage = manual_end;
+      m->begin = &m->tmp_storage;
+    }
+    manual_compaction_ = nullptr;
+  }
+}
+
+void DBImpl::CleanupCompaction(CompactionState *compact) {
+  mutex_.AssertHeld();
+  if (compact->builder != nullptr) {
+    // May happen if we get a shutdown call in the middle of compaction
+    compact->builder->Abandon();
+    delete compact->builder;
+  } else {
+    assert(compact->outfile == nullptr);
+  }
+  compact->outfile.reset();
+  for (size_t i = 0; i < compact->outputs.size(); i++) {
+    const CompactionState::Output &out = compact->outputs[i];
+    pending_outputs_.erase(out.number);
+  }
+  delete compact;
+}
+
+Status DBImpl::OpenCompactionOutputFile(CompactionState *compact) {
+  assert(compact != nullptr);
+  assert(compact->builder == nullptr);
+  uint64_t file_number;
+  {
+    mutex_.Lock();
+    file_number = versions_->NewFileNumber();
+    pending_outputs_.insert(file_number);
+    CompactionState::Output out;
+    out.number = file_number;
+    out.num_entries = 0;
+    out.num_deletions = 0;
+    out.smallest.Clear();
+    out.largest.Clear();
+    compact->outputs.push_back(out);
+    mutex_.Unlock();
+  }
+
+  // Make the output file
+  std::string fname = TableFileName(dbname_, file_number);
+  Status s = env_->NewWritableFile(fname, &compact->outfile,
+                                   EnvOptions(options_));
+  if (s.ok()) {
+    compact->builder = new TableBuilder(options_, compact->outfile.get());
+  }
+  return s;
+}
+
+Status DBImpl::FinishCompactionOutputFile(CompactionState *compact,
+                                          Iterator *input) {
+  assert(compact != nullptr);
+  assert(compact->outfile != nullptr);
+  assert(compact->builder != nullptr);
+
+  const uint64_t output_number = compact->current_output()->number;
+  assert(output_number != 0);
+
+  // Check for iterator errors
+  Status s = input->status();
+  const uint64_t current_entries = compact->builder->NumEntries();
+  if (s.ok()) {
+    s = compact->builder->Finish();
+  } else {
+    compact->builder->Abandon();
+  }
+  const uint64_t current_bytes = compact->builder->FileSize();
+  compact->current_output()->file_size = current_bytes;
+  compact->current_output()->num_entries = current_entries;
+  compact->total_bytes += current_bytes;
+  delete compact->builder;
+  compact->builder = nullptr;
+
+  // Finish and check for file errors
+  if (s.ok() && !options_.disableDataSync) {
+    const uint64_t start_micros = env_->NowMicros();
+    s = options_.use_fsync ? compact->outfile->Fsync()
+                           : compact->outfile->Sync();
+    MeasureTime(options_.statistics, COMPACTION_OUTFILE_SYNC_MICROS,
+                env_->NowMicros() - start_micros);
+  }
+  if (s.ok()) { s = compact->outfile->Close(); }
+  compact->outfile.reset();
+
+  if (s.ok() && current_entries > 0) {
+    // Verify that the table is usable
+    Iterator *iter = table_cache_->NewIterator(
+        ReadOptions(), output_number, current_bytes, nullptr, kCompaction,
+        compact->compaction->level() + 1);
+    s = iter->status();
+    delete iter;
+    if (s.ok()) {
+      Log(options_.info_log, "Generated table #%llu@%d: %lld keys, %lld bytes",
+          static_cast<unsigned long long>(output_number),
+          compact->compaction->level(),
+          static_cast<unsigned long long>(current_entries),
+          static_cast<unsigned long long>(current_bytes));
+    }
+  }
+  return s;
+}
+
+Status DBImpl::InstallCompactionResults(CompactionState *compact) {
+  mutex_.AssertHeld();
+  Log(options_.info_log, "Compacted %d@%d + %d@%d files => %lld bytes",
+      compact->compaction->num_input_files(0), compact->compaction->level(),
+      compact->compaction->num_input_files(1), compact->compaction->level() + 1,
+      static_cast<long long>(compact->total_bytes));
+
+  // Add compaction outputs
+  compact->compaction->AddInputDeletions(compact->compaction->edit());
+  const int level = compact->compaction->level();
+  for (size_t i = 0; i < compact->outputs.size(); i++) {
+    const CompactionState::Output &out = compact->outputs[i];
+    FileMetaData meta;
+    meta.number = out.number;
+    meta.file_size = out.file_size;
+    meta.num_entries = out.num_entries;
+    meta.num_deletions = out.num_deletions;
+    meta.smallest = out.smallest;
+    meta.largest = out.largest;
+    compact->compaction->edit()->AddFile(level + 1, meta);
+  }
+  return versions_->LogAndApply(compact->compaction->edit(), &mutex_);
+}
+
+Status DBImpl::DoCompactionWork(CompactionState *compact) {
+  const uint64_t start_micros = env_->NowMicros();
+  int64_t imm_micros = 0;  // Micros spent doing imm_ compactions
+
+  Log(options_.info_log, "Compacting %d@%d + %d@%d files",
+      compact->compaction->num_input_files(0), compact->compaction->level(),
+      compact->compaction->num_input_files(1),
+      compact->compaction->level() + 1);
+
+  assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
+  assert(compact->builder == nullptr);
+  assert(compact->outfile == nullptr);
+  if (snapshots_.empty()) {
+    compact->smallest_snapshot = versions_->LastSequence();
+  } else {
+    compact->smallest_snapshot = snapshots_.oldest()->number_;
+  }
+
+  Iterator *input = versions_->MakeInputIterator(compact->compaction);
+
+  // Release mutex while we're actually doing the compaction work
+  mutex_.Unlock();
+
+  input->SeekToFirst();
+  Status status;
+  ParsedInternalKey ikey;
+  std::string current_user_key;
+  bool has_current_user_key = false;
+  SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
+  while (input->Valid() && !shutting_down_.load(std::memory_order_acquire)) {
+    // Prioritize immutable compaction work
+    if (imm_.size() > 0) {
+      const uint64_t imm_start = env_->NowMicros();
+      mutex_.Lock();
+      if (imm_.IsFlushPending()) {
+        FlushMemTableToOutputFile();
+        // Wake up MakeRoomForWrite() if necessary.
+        bg_cv_.SignalAll();
+      }
+      mutex_.Unlock();
+      imm_micros += (env_->NowMicros() - imm_start);
+    }
+
+    Slice key = input->key();
+    if (compact->compaction->ShouldStopBefore(key) &&
+        compact->builder != nullptr) {
+      status = FinishCompactionOutputFile(compact, input);
+      if (!status.ok()) { break; }
+    }
+
+    // Handle key/value, add to state, etc.
+    bool drop = false;
+    if (!ParseInternalKey(key, &ikey)) {
+      // Do not hide error keys
+      current_user_key.clear();
+      has_current_user_key = false;
+      last_sequence_for_key = kMaxSequenceNumber;
+    } else {
+      if (!has_current_user_key ||
+          user_comparator()->Compare(ikey.user_key, Slice(current_user_key)) !=
+              0) {
+        // First occurrence of this user key
+        current_user_key.assign(ikey.user_key.data(), ikey.user_key.size());
+        has_current_user_key = true;
+        last_sequence_for_key = kMaxSequenceNumber;
+      }
+
+      if (last_sequence_for_key <= compact->smallest_snapshot) {
+        // Hidden by an newer entry for same user key
+        drop = true;  // (A)
+        RecordTick(options_.statistics, COMPACTION_KEY_DROP_NEWER_ENTRY);
+      } else if (ikey.type == kTypeDeletion &&
+                 ikey.sequence <= compact->smallest_snapshot &&
+                 compact->compaction->IsBaseLevelForKey(ikey.user_key)) {
+        // For this user key:
+        // (1) there is no data in higher levels
+        // (2) data in lower levels will have larger sequence numbers
+        // (3) data in layers that are being compacted here and have
+        //     smaller sequence numbers will be dropped in the next
+        //     few iterations of this loop (by rule (A) above).
+        // Therefore this deletion marker is obsolete and can be dropped.
+        drop = true;
+        RecordTick(options_.statistics, COMPACTION_KEY_DROP_OBSOLETE);
+      }
+
+      last_sequence_for_key = ikey.sequence;
+    }
+
+    if (!drop) {
+      // Open output file if necessary
+      if (compact->builder == nullptr) {
+        status = OpenCompactionOutputFile(compact);
+        if (!status.ok()) { break; }
+      }
+      if (compact->builder->NumEntries() == 0) {
+        compact->current_output()->smallest.DecodeFrom(key);
+      }
+      compact->current_output()->largest.DecodeFrom(key);
+      if (ikey.type == kTypeDeletion) {
+        compact->current_output()->num_deletions++;
+      }
+      compact->builder->Add(key, input->value());
+
+      // Close output file if it is big enough
+      if (compact->builder->FileSize() >=
+          compact->compaction->MaxOutputFileSize()) {
+        status = FinishCompactionOutputFile(compact, input);
+        if (!status.ok()) { break; }
+      }
+    }
+
+    input->Next();
+  }
+
+  if (status.ok() && shutting_down_.load(std::memory_order_acquire)) {
+    status = Status::IOError("Deleting DB during compaction");
+  }
+  if (status.ok() && compact->builder != nullptr) {
+    status = FinishCompactionOutputFile(compact, input);
+  }
+  if (status.ok()) { status = input->status(); }
+  delete input;
+  input = nullptr;
+
+  InternalStats::CompactionStats stats;
+  stats.micros = env_->NowMicros() - start_micros - imm_micros;
+  stats.files_in_leveln = compact->compaction->num_input_files(0);
+  stats.files_in_levelnp1 = compact->compaction->num_input_files(1);
+  for (int i = 0; i < compact->compaction->num_input_files(0); i++) {
+    stats.bytes_readn += compact->compaction->input(0, i)->file_size;
+  }
+  for (int i = 0; i < compact->compaction->num_input_files(1); i++) {
+    stats.bytes_readnp1 += compact->compaction->input(1, i)->file_size;
+  }
+  for (size_t i = 0; i < compact->outputs.size(); i++) {
+    stats.bytes_written += compact->outputs[i].file_size;
+  }
+  stats.files_out_levelnp1 = compact->outputs.size();
+  MeasureTime(options_.statistics, COMPACTION_TIME, stats.micros);
+
+  mutex_.Lock();
+  internal_stats_->AddCompactionStats(compact->compaction->level() + 1, stats);
+
+  if (status.ok()) { status = InstallCompactionResults(compact); }
+  UpdateVersionStats();
+  VersionSet::LevelSummaryStorage tmp;
+  Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
+  return status;
+}
+
+namespace {
+
+struct IterState {
+  port::Mutex *const mu;
+  Version *const version;
+  std::vector<MemTable *> mems;
+
+  IterState(port::Mutex *mutex, Version *version)
+      : mu(mutex), version(version) {}
+};
+
+static void CleanupIteratorState(void *arg1, void *arg2) {
+  IterState *state = reinterpret_cast<IterState *>(arg1);
+  state->mu->Lock();
+  for (MemTable *m : state->mems) { m->Unref(); }
+  state->version->Unref();
+  state->mu->Unlock();
+  delete state;
+}
+
+}  // anonymous namespace
+
+Iterator *DBImpl::NewInternalIterator(const ReadOptions &options,
+                                      SequenceNumber *latest_snapshot) {
+  mutex_.Lock();
+  *latest_snapshot = versions_->LastSequence();
+
+  // Collect together all needed child iterators
+  IterState *cleanup = new IterState(&mutex_, versions_->current());
+  cleanup->mems.push_back(mem_);
+  imm_.GetMemTables(&cleanup->mems);
+  std::vector<Iterator *> list;
+  for (MemTable *m : cleanup->mems) {
+    m->Ref();
+    list.push_back(m->NewIterator());
+  }
+  versions_->current()->AddIterators(options, &list);
+  Iterator *internal_iter =
+      NewMergingIterator(&internal_comparator_, &list[0], list.size());
+  versions_->current()->Ref();
+
+  internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, nullptr);
+
+  mutex_.Unlock();
+  return internal_iter;
+}
+
+Status DBImpl::Get(const ReadOptions &options, const Slice &key,
+                   std::string *value) {
+  const uint64_t start_micros = env_->NowMicros();
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) { tracer_->Get(key); }
+  }
+  PERF_TIMER_GUARD(get_snapshot_time);
+  Status s;
+  PERF_TIMER_GUARD(db_mutex_lock_nanos);
+  MutexLock l(&mutex_);
+  PERF_TIMER_STOP(db_mutex_lock_nanos);
+  SequenceNumber snapshot;
+  if (options.snapshot != nullptr) {
+    snapshot = static_cast<const SnapshotImpl *>(options.snapshot)->number_;
+  } else {
+    snapshot = versions_->LastSequence();
+  }
+
+  MemTable *mem = mem_;
+  std::vector<MemTable *> imms;
+  imm_.GetMemTables(&imms);
+  Version *current = versions_->current();
+  mem->Ref();
+  for (MemTable *m : imms) { m->Ref(); }
+  current->Ref();
+
+  // Unlock while reading from files and memtables
+  {
+    mutex_.Unlock();
+    PERF_TIMER_STOP(get_snapshot_time);
+    // First look in the memtable, then in the immutable memtables (if any).
+    LookupKey lkey(key, snapshot);
+    bool done = false;
+    {
+      PERF_TIMER_GUARD(get_from_memtable_time);
+      PERF_COUNTER_ADD(get_from_memtable_count, 1);
+      done = mem->Get(lkey, value, &s);
+      for (size_t i = 0; !done && i < imms.size(); i++) {
+        PERF_COUNTER_ADD(get_from_memtable_count, 1);
+        done = imms[i]->Get(lkey, value, &s);
+      }
+    }
+    if (!done) {
+      PERF_TIMER_GUARD(get_from_output_files_time);
+      s = current->Get(options, lkey, value);
+    }
+    PERF_TIMER_GUARD(db_mutex_lock_nanos);
+    mutex_.Lock();
+  }
+
+  PERF_TIMER_GUARD(get_post_process_time);
+  mem->Unref();
+  for (MemTable *m : imms) { m->Unref(); }
+  current->Unref();
+
+  RecordTick(options_.statistics, NUMBER_KEYS_READ);
+  if (s.ok()) { RecordTick(options_.statistics, BYTES_READ, value->size()); }
+  MeasureTime(options_.statistics, DB_GET, env_->NowMicros() - start_micros);
+  return s;
+}
+
+std::vector<Status> DBImpl::MultiGet(const ReadOptions &options,
+                                     const std::vector<Slice> &keys,
+                                     std::vector<std::string> *values) {
+  const uint64_t start_micros = env_->NowMicros();
+  if (tracing_.load(std::memory_order_relaxed)) {
+    // Traced as individual Gets, which is what a replay would issue
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) {
+      for (const Slice &key : keys) { tracer_->Get(key); }
+    }
+  }
+  SequenceNumber snapshot;
+  MemTable *mem;
+  std::vector<MemTable *> imms;
+  Version *current;
+  {
+    MutexLock l(&mutex_);
+    if (options.snapshot != nullptr) {
+      snapshot = static_cast<const SnapshotImpl *>(options.snapshot)->number_;
+    } else {
+      snapshot = versions_->LastSequence();
+    }
+    mem = mem_;
+    imm_.GetMemTables(&imms);
+    current = versions_->current();
+    mem->Ref();
+    for (MemTable *m : imms) { m->Ref(); }
+    current->Ref();
+  }
+
+  // Every key is looked up against the same snapshot and the same set of
+  // memtables and files, so the references above are taken only once.
+  const size_t num_keys = keys.size();
+  std::vector<Status> stat_list(num_keys);
+  values->resize(num_keys);
+  uint64_t bytes_read = 0;
+  for (size_t i = 0; i < num_keys; i++) {
+    std::string *value = &(*values)[i];
+    LookupKey lkey(keys[i], snapshot);
+    Status s;
+    bool done = mem->Get(lkey, value, &s);
+    for (size_t j = 0; !done && j < imms.size(); j++) {
+      done = imms[j]->Get(lkey, value, &s);
+    }
+    if (!done) { s = current->Get(options, lkey, value, kUserMultiGet); }
+    if (s.ok()) { bytes_read += value->size(); }
+    stat_list[i] = s;
+  }
+
+  {
+    MutexLock l(&mutex_);
+    mem->Unref();
+    for (MemTable *m : imms) { m->Unref(); }
+    current->Unref();
+  }
+
+  RecordTick(options_.statistics, NUMBER_MULTIGET_CALLS);
+  RecordTick(options_.statistics, NUMBER_MULTIGET_KEYS_READ, num_keys);
+  RecordTick(options_.statistics, NUMBER_MULTIGET_BYTES_READ, bytes_read);
+  MeasureTime(options_.statistics, DB_MULTIGET,
+              env_->NowMicros() - start_micros);
+  return stat_list;
+}
+
+Iterator *DBImpl::NewIterator(const ReadOptions &options) {
+  SequenceNumber latest_snapshot;
+  Iterator *iter = NewInternalIterator(options, &latest_snapshot);
+  return NewDBIterator(
+      &dbname_, env_, user_comparator(), iter,
+      (options.snapshot != nullptr
+           ? static_cast<const SnapshotImpl *>(options.snapshot)->number_
+           : latest_snapshot),
+      this);
+}
+
+const Snapshot *DBImpl::GetSnapshot() {
+  MutexLock l(&mutex_);
+  const SequenceNumber sequence = versions_->LastSequence();
+  // Unordered writes publish their sequence numbers before they are in
+  // mem_.  Later writes get larger ones, so this waits at most for the
+  // writes already in flight.
+  while (!unordered_writes_.empty() &&
+         *unordered_writes_.begin() <= sequence) {
+    unordered_writes_cv_.Wait();
+  }
+  const Snapshot *s = snapshots_.New(sequence);
+  internal_stats_->SetNumSnapshots(snapshots_.count());
+  return s;
+}
+
+void DBImpl::ReleaseSnapshot(const Snapshot *s) {
+  MutexLock l(&mutex_);
+  snapshots_.Delete(static_cast<const SnapshotImpl *>(s));
+  internal_stats_->SetNumSnapshots(snapshots_.count());
+}
+
+// Convenience methods
+Status DBImpl::Put(const WriteOptions &o, const Slice &key, const Slice &val) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) { tracer_->Put(key, val); }
+  }
+  WriteBatch batch;
+  batch.Put(key, val);
+  return WriteImpl(o, &batch);
+}
+
+Status DBImpl::Delete(const WriteOptions &options, const Slice &key) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) { tracer_->Delete(key); }
+  }
+  WriteBatch batch;
+  batch.Delete(key);
+  return WriteImpl(options, &batch);
+}
+
+Status DBImpl::Merge(const WriteOptions &o, const Slice &key,
+                     const Slice &val) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) { tracer_->Merge(key, val); }
+  }
+  return Status::NotSupported("merge operator not implemented");
+}
+
+Status DBImpl::Write(const WriteOptions &options, WriteBatch *my_batch) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) { tracer_->Write(my_batch); }
+  }
+  return WriteImpl(options, my_batch);
+}
+
+Status DBImpl::WriteImpl(const WriteOptions &options, WriteBatch *my_batch) {
+  if (options_.enable_pipelined_write) {
+    return PipelinedWriteImpl(options, my_batch);
+  }
+  if (options_.unordered_write) {
+    return UnorderedWriteImpl(options, my_batch);
+  }
+  const uint64_t start_micros = env_->NowMicros();
+  Writer w(&mutex_);
+  w.batch = my_batch;
+  w.sync = options.sync;
+  w.disableWAL = options.disableWAL;
+  w.done = false;
+
+  PERF_TIMER_GUARD(write_pre_and_post_process_time);
+  PERF_TIMER_GUARD(db_mutex_lock_nanos);
+  MutexLock l(&mutex_);
+  PERF_TIMER_STOP(db_mutex_lock_nanos);
+  writers_.push_back(&w);
+  while (!w.done && &w != writers_.front()) { w.cv.Wait(); }
+  if (w.done) {
+    internal_stats_->AddDBStats(InternalStats::WRITE_DONE_BY_OTHER, 1);
+    MeasureTime(options_.statistics, DB_WRITE,
+                env_->NowMicros() - start_micros);
+    return w.status;
+  }
+
+  // May temporarily unlock and wait.
+  Status status = MakeRoomForWrite(my_batch == nullptr);
+  uint64_t last_sequence = versions_->LastSequence();
+  Writer *last_writer = &w;
+  if (status.ok() && my_batch != nullptr) {  // nullptr batch is for flushes
+    WriteBatch *updates = BuildBatchGroup(&last_writer, tmp_batch_);
+    WriteBatchInternal::SetSequence(updates, last_sequence + 1);
+    last_sequence += WriteBatchInternal::Count(updates);
+    RecordWriteGroup(updates);
+
+    // Add to log and apply to memtable.  We can release the lock
+    // during this phase since &w is currently responsible for logging
+    // and protects against concurrent loggers and concurrent writes
+    // into mem_.
+    {
+      mutex_.Unlock();
+      PERF_TIMER_STOP(write_pre_and_post_process_time);
+      bool sync_error = false;
+      status = WriteToWAL(options, updates, &sync_error);
+      if (status.ok()) {
+        PERF_TIMER_GUARD(write_memtable_time);
+        status = WriteBatchInternal::InsertInto(updates, mem_);
+      }
+      PERF_TIMER_START(write_pre_and_post_process_time);
+      mutex_.Lock();
+      if (sync_error) {
+        // The state of the log file is indeterminate: the log record we
+        // just added may or may not show up when the DB is re-opened.
+        // So we force the DB into a mode where all future writes fail.
+        RecordBackgroundError(status);
+      }
+    }
+    if (updates == tmp_batch_) { tmp_batch_->Clear(); }
+
+    versions_->SetLastSequence(last_sequence);
+    UpdateActiveMemTableStats();
+  }
+
+  while (true) {
+    Writer *ready = writers_.front();
+    writers_.pop_front();
+    if (ready != &w) {
+      ready->status = status;
+      ready->done = true;
+      ready->cv.Signal();
+    }
+    if (ready == last_writer) break;
+  }
+
+  // Notify new head of write queue
+  if (!writers_.empty()) { writers_.front()->cv.Signal(); }
+
+  MeasureTime(options_.statistics, DB_WRITE, env_->NowMicros() - start_micros);
+  return status;
+}
+
+Status DBImpl::PipelinedWriteImpl(const WriteOptions &options,
+                                  WriteBatch *my_batch) {
+  const uint64_t start_micros = env_->NowMicros();
+  Writer w(&mutex_);
+  w.batch = my_batch;
+  w.sync = options.sync;
+  w.disableWAL = options.disableWAL;
+  w.done = false;
+
+  PERF_TIMER_GUARD(write_pre_and_post_process_time);
+  MutexLock l(&mutex_);
+  writers_.push_back(&w);
+  // Followers stay here until their group is in the memtable.
+  while (!w.done && &w != writers_.front()) { w.cv.Wait(); }
+  if (w.done) {
+    internal_stats_->AddDBStats(InternalStats::WRITE_DONE_BY_OTHER, 1);
+    MeasureTime(options_.statistics, DB_WRITE,
+                env_->NowMicros() - start_micros);
+    return w.status;
+  }
+
+  // WAL stage.  May temporarily unlock and wait, also for earlier groups
+  // to leave the memtable stage before it switches mem_.
+  Status status = MakeRoomForWrite(my_batch == nullptr);
+  if (!status.ok() || my_batch == nullptr) {  // nullptr batch is for flushes
+    writers_.pop_front();
+    if (!writers_.empty()) { writers_.front()->cv.Signal(); }
+    return status;
+  }
+
+  WriteGroup group;
+  group.leader = &w;
+  WriteBatch *updates = BuildBatchGroup(&group.last_writer, &group.batch);
+  // Groups still in the memtable stage have not published their sequence
+  // numbers yet.
+  const SequenceNumber last_sequence =
+      memtable_write_groups_.empty()
+          ? versions_->LastSequence()
+          : memtable_write_groups_.back()->last_sequence;
+  WriteBatchInternal::SetSequence(updates, last_sequence + 1);
+  group.last_sequence = last_sequence + WriteBatchInternal::Count(updates);
+  RecordWriteGroup(updates);
+  {
+    mutex_.Unlock();
+    PERF_TIMER_STOP(write_pre_and_post_process_time);
+    bool sync_error = false;
+    status = WriteToWAL(options, updates, &sync_error);
+    PERF_TIMER_START(write_pre_and_post_process_time);
+    mutex_.Lock();
+    if (sync_error) { RecordBackgroundError(status); }
+  }
+
+  // Hand the group over to the memtable stage, and the WAL to the next
+  // group.
+  while (true) {
+    Writer *ready = writers_.front();
+    writers_.pop_front();
+    if (ready != &w) { group.followers.push_back(ready); }
+    if (ready == group.last_writer) break;
+  }
+  if (!writers_.empty()) { writers_.front()->cv.Signal(); }
+  memtable_write_groups_.push_back(&group);
+
+  // Memtable stage.  Groups insert one at a time, in sequence order: mem_
+  // takes a single writer, and sequence numbers are published in order.
+  while (memtable_write_groups_.front() != &group) { w.cv.Wait(); }
+  if (status.ok()) {
+    mutex_.Unlock();
+    {
+      PERF_TIMER_GUARD(write_memtable_time);
+      status = WriteBatchInternal::InsertInto(updates, mem_);
+    }
+    mutex_.Lock();
+  }
+  versions_->SetLastSequence(group.last_sequence);
+  UpdateActiveMemTableStats();
+  memtable_write_groups_.pop_front();
+  if (!memtable_write_groups_.empty()) {
+    memtable_write_groups_.front()->leader->cv.Signal();
+  } else if (!writers_.empty()) {
+    // The WAL stage may be waiting for the memtable stage to drain.
+    writers_.front()->cv.Signal();
+  }
+
+  for (Writer *ready : group.followers) {
+    ready->status = status;
+    ready->done = true;
+    ready->cv.Signal();
+  }
+
+  MeasureTime(options_.statistics, DB_WRITE, env_->NowMicros() - start_micros);
+  return status;
+}
+
+Status DBImpl::UnorderedWriteImpl(const WriteOptions &options,
+                                  WriteBatch *my_batch) {
+  const uint64_t start_micros = env_->NowMicros();
+  Writer w(&mutex_);
+  w.batch = my_batch;
+  w.sync = options.sync;
+  w.disableWAL = options.disableWAL;
+  w.done = false;
+
+  PERF_TIMER_GUARD(write_pre_and_post_process_time);
+  MutexLock l(&mutex_);
+  writers_.push_back(&w);
+  // Followers stay here until their group is in the memtable.
+  while (!w.done && &w != writers_.front()) { w.cv.Wait(); }
+  if (w.done) {
+    internal_stats_->AddDBStats(InternalStats::WRITE_DONE_BY_OTHER, 1);
+    MeasureTime(options_.statistics, DB_WRITE,
+                env_->NowMicros() - start_micros);
+    return w.status;
+  }
+
+  // May temporarily unlock and wait, also for the inserts in flight to
+  // finish before it switches mem_.
+  Status status = MakeRoomForWrite(my_batch == nullptr);
+  if (!status.ok() || my_batch == nullptr) {  // nullptr batch is for flushes
+    writers_.pop_front();
+    if (!writers_.empty()) { writers_.front()->cv.Signal(); }
+    return status;
+  }
+
+  Writer *last_writer = &w;
+  WriteBatch group_batch;
+  WriteBatch *updates = BuildBatchGroup(&last_writer, &group_batch);
+  const SequenceNumber first_sequence = versions_->LastSequence() + 1;
+  WriteBatchInternal::SetSequence(updates, first_sequence);
+  RecordWriteGroup(updates);
+  {
+    mutex_.Unlock();
+    PERF_TIMER_STOP(write_pre_and_post_process_time);
+    bool sync_error = false;
+    status = WriteToWAL(options, updates, &sync_error);
+    PERF_TIMER_START(write_pre_and_post_process_time);
+    mutex_.Lock();
+    if (sync_error) { RecordBackgroundError(status); }
+  }
+
+  // Publish the sequence numbers and hand the WAL to the next group, which
+  // may insert into mem_ alongside this one.
+  versions_->SetLastSequence(first_sequence - 1 +
+                             WriteBatchInternal::Count(updates));
+  std::multiset<SequenceNumber>::iterator in_flight;
+  if (status.ok()) { in_flight = unordered_writes_.insert(first_sequence); }
+  std::vector<Writer *> followers;
+  while (true) {
+    Writer *ready = writers_.front();
+    writers_.pop_front();
+    if (ready != &w) { followers.push_back(ready); }
+    if (ready == last_writer) break;
+  }
+  if (!writers_.empty()) { writers_.front()->cv.Signal(); }
+
+  if (status.ok()) {
+    MemTable *mem = mem_;
+    mutex_.Unlock();
+    {
+      PERF_TIMER_GUARD(write_memtable_time);
+      status = WriteBatchInternal::InsertInto(updates, mem, true);
+    }
+    mutex_.Lock();
+    unordered_writes_.erase(in_flight);
+    unordered_writes_cv_.SignalAll();
+    UpdateActiveMemTableStats();
+    // The next group may be waiting for the inserts to drain.
+    if (unordered_writes_.empty() && !writers_.empty()) {
+      writers_.front()->cv.Signal();
+    }
+  }
+
+  for (Writer *ready : followers) {
+    ready->status = status;
+    ready->done = true;
+    ready->cv.Signal();
+  }
+
+  MeasureTime(options_.statistics, DB_WRITE, env_->NowMicros() - start_micros);
+  return status;
+}
+
+void DBImpl::RecordWriteGroup(const WriteBatch *updates) {
+  const int count = WriteBatchInternal::Count(updates);
+  const Slice contents = WriteBatchInternal::Contents(updates);
+  last_batch_group_size_ = contents.size();
+  internal_stats_->AddDBStats(InternalStats::WRITE_DONE_BY_SELF, 1);
+  internal_stats_->AddDBStats(InternalStats::NUMBER_KEYS_WRITTEN, count);
+  internal_stats_->AddDBStats(InternalStats::BYTES_WRITTEN, contents.size());
+  RecordTick(options_.statistics, NUMBER_KEYS_WRITTEN, count);
+  RecordTick(options_.statistics, BYTES_WRITTEN, contents.size());
+}
+
+Status DBImpl::WriteToWAL(const WriteOptions &options,
+                          const WriteBatch *updates, bool *sync_error) {
+  Status status;
+  if (options.disableWAL) { return status; }
+  PERF_TIMER_GUARD(write_wal_time);
+  const Slice contents = WriteBatchInternal::Contents(updates);
+  MutexLock l(&log_write_mutex_);
+  status = log_->AddRecord(contents);
+  internal_stats_->AddDBStats(InternalStats::WAL_FILE_BYTES, contents.size());
+  internal_stats_->AddDBStats(InternalStats::WRITE_WITH_WAL, 1);
+  if (status.ok() && options.sync) {
+    status = SyncWAL();
+    if (!status.ok()) { *sync_error = true; }
+  }
+  return status;
+}
+
+Status DBImpl::SyncWAL() {
+  log_write_mutex_.AssertHeld();
+  // Also writes out anything buffered under manual_wal_flush
+  const uint64_t sync_start = env_->NowMicros();
+  Status s = options_.use_fsync ? log_->file()->Fsync() : log_->file()->Sync();
+  MeasureTime(options_.statistics, WAL_FILE_SYNC_MICROS,
+              env_->NowMicros() - sync_start);
+  internal_stats_->AddDBStats(InternalStats::WAL_FILE_SYNCED, 1);
+  return s;
+}
+
+Status DBImpl::FlushWAL(bool sync) {
+  Status s;
+  {
+    MutexLock l(&log_write_mutex_);
+    s = sync ? SyncWAL() : log_->WriteBuffer();
+  }
+  if (!s.ok()) {
+    // As for a failed sync in WriteToWAL(), records may or may not have
+    // made it to the log.
+    MutexLock l(&mutex_);
+    RecordBackgroundError(s);
+  }
+  return s;
+}
+
+void DBImpl::UpdateActiveMemTableStats() {
+  mutex_.AssertHeld();
+  internal_stats_->SetActiveMemTableStats(mem_->ApproximateMemoryUsage(),
+                                          mem_->num_entries(),
+                                          mem_->num_deletes());
+  mutable_memtable_usage_.store(mem_->ApproximateMemoryUsage(),
+                                std::memory_order_relaxed);
+}
+
+// REQUIRES: Writer list must be non-empty
+// REQUIRES: First writer must have a non-null batch
+WriteBatch *DBImpl::BuildBatchGroup(Writer **last_writer,
+                                    WriteBatch *scratch) {
+  mutex_.AssertHeld();
+  assert(!writers_.empty());
+  Writer *first = writers_.front();
+  WriteBatch *result = first->batch;
+  assert(result != nullptr);
+
+  size_t size = WriteBatchInternal::ByteSize(first->batch);
+
+  // Allow the group to grow up to a maximum size, but if the
+  // original write is small, limit the growth so we do not slow
+  // down the small write too much.
+  size_t max_size = 1 << 20;
+  if (size <= (128 << 10)) { max_size = size + (128 << 10); }
+
+  *last_writer = first;
+  std::deque<Writer *>::iterator iter = writers_.begin();
+  ++iter;  // Advance past "first"
+  for (; iter != writers_.end(); ++iter) {
+    Writer *w = *iter;
+    if (w->sync && !first->sync) {
+      // Do not include a sync write into a batch handled by a non-sync write.
+      break;
+    }
+
+    if (w->disableWAL != first->disableWAL) {
+      // Do not mix writes that skip the log with writes that need it.
+      break;
+    }
+
+    if (w->batch != nullptr) {
+      size += WriteBatchInternal::ByteSize(w->batch);
+      if (size > max_size) {
+        // Do not make batch too big
+        break;
+      }
+
+      // Append to *result
+      if (result == first->batch) {
+        // Switch to temporary batch instead of disturbing caller's batch
+        result = scratch;
+        assert(WriteBatchInternal::Count(result) == 0);
+        WriteBatchInternal::Append(result, first->batch);
+      }
+      WriteBatchInternal::Append(result, w->batch);
+    }
+    *last_writer = w;
+  }
+  return result;
+}
+
+// REQUIRES: mutex_ is held
+// REQUIRES: this thread is currently at the front of the writer queue
+Status DBImpl::MakeRoomForWrite(bool force) {
+  mutex_.AssertHeld();
+  assert(!writers_.empty());
+  bool allow_delay = !force;
+  Status s;
+  while (true) {
+    if (!bg_error_.ok()) {
+      // Yield previous error
+      s = bg_error_;
+      break;
+    } else if (allow_delay && write_controller_.NeedsDelay()) {
+      // Compaction is falling behind.  Rather than letting writes run
+      // until they hit a hard limit and stall for seconds, pace them to
+      // the delayed write rate, which drops as the backlog grows.  This
+      // also hands over some CPU to the compaction thread in case it is
+      // sharing the same core as the writer.
+      const uint64_t delay =
+          write_controller_.GetDelay(env_->NowMicros(), last_batch_group_size_);
+      allow_delay = false;  // Do not delay a single write more than once
+      if (delay > 0) {
+        mutex_.Unlock();
+        const uint64_t delayed_start = env_->NowMicros();
+        {
+          PERF_TIMER_GUARD(write_delay_time);
+          // Sleep in short slices, so that writes speed up as soon as
+          // compaction catches up.
+          uint64_t slept = 0;
+          while (slept < delay && write_controller_.NeedsDelay()) {
+            env_->SleepForMicroseconds(
+                static_cast<int>(std::min<uint64_t>(delay - slept, 1000)));
+            slept = env_->NowMicros() - delayed_start;
+          }
+        }
+        const uint64_t delayed = env_->NowMicros() - delayed_start;
+        RecordTick(options_.statistics, STALL_L0_SLOWDOWN_MICROS, delayed);
+        internal_stats_->AddDBStats(InternalStats::WRITE_STALL_MICROS,
+                                    delayed);
+        mutex_.Lock();
+      }
+    } else if (!force &&
+               (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size) &&
+               !MemTableFlushRequested()) {
+      // There is room in current memtable
+      break;
+    } else if (imm_.size() >= options_.max_write_buffer_number - 1) {
+      // We have filled up the current memtable, but the previous
+      // ones are still being compacted, so we wait.
+      Log(options_.info_log, "Current memtable full; waiting...\n");
+      const uint64_t stall_start = env_->NowMicros();
+      {
+        PERF_TIMER_GUARD(write_delay_time);
+        bg_cv_.Wait();
+      }
+      const uint64_t stalled = env_->NowMicros() - stall_start;
+      RecordTick(options_.statistics, STALL_MEMTABLE_COMPACTION_MICROS,
+                 stalled);
+      internal_stats_->AddDBStats(InternalStats::WRITE_STALL_MICROS, stalled);
+    } else if (versions_->NumLevelFiles(0) >=
+               options_.level0_stop_writes_trigger) {
+      // There are too many level-0 files.
+      Log(options_.info_log, "Too many L0 files; waiting...\n");
+      const uint64_t stall_start = env_->NowMicros();
+      {
+        PERF_TIMER_GUARD(write_delay_time);
+        bg_cv_.Wait();
+      }
+      const uint64_t stalled = env_->NowMicros() - stall_start;
+      RecordTick(options_.statistics, STALL_L0_NUM_FILES_MICROS, stalled);
+      internal_stats_->AddDBStats(InternalStats::WRITE_STALL_MICROS, stalled);
+    } else if (options_.hard_pending_compaction_bytes_limit > 0 &&
+               versions_->current()->estimated_compaction_needed_bytes() >=
+                   options_.hard_pending_compaction_bytes_limit) {
+      // Compaction is too far behind for delays to help.
+      Log(options_.info_log, "Too many pending compaction bytes; waiting...\n");
+      const uint64_t stall_start = env_->NowMicros();
+      {
+        PERF_TIMER_GUARD(write_delay_time);
+        bg_cv_.Wait();
+      }
+      const uint64_t stalled = env_->NowMicros() - stall_start;
+      RecordTick(options_.statistics, STALL_PENDING_COMPACTION_BYTES_MICROS,
+                 stalled);
+      internal_stats_->AddDBStats(InternalStats::WRITE_STALL_MICROS, stalled);
+    } else if (!memtable_write_groups_.empty() || !unordered_writes_.empty()) {
+      // Earlier pipelined or unordered writes are still being inserted
+      // into mem_.
+      writers_.front()->cv.Wait();
+    } else {
+      // Attempt to switch to a new memtable and trigger compaction of old
+      s = SwitchMemTable();
+      if (!s.ok()) { break; }
+      force = false;  // Do not force another compaction if have room
+    }
+  }
+  return s;
+}
+
+Status DBImpl::SwitchMemTable() {
+  mutex_.AssertHeld();
+  assert(versions_->PrevLogNumber() == 0);
+  uint64_t new_log_number = versions_->NewFileNumber();
+  std::unique_ptr<WritableFile> lfile;
+  Status s = env_->NewWritableFile(LogFileName(dbname_, new_log_number),
+                                   &lfile, EnvOptions(options_));
+  if (!s.ok()) {
+    // Avoid chewing through file number space in a tight loop.
+    versions_->ReuseFileNumber(new_log_number);
+    return s;
+  }
+  {
+    MutexLock l(&log_write_mutex_);
+    // Records buffered under manual_wal_flush must reach the old log
+    // before mem_, which they belong to, is switched out.
+    if (options_.manual_wal_flush) {
+      s = log_->WriteBuffer();
+      if (!s.ok()) {
+        RecordBackgroundError(s);
+        return s;
+      }
+    }
+    log_.reset(new log::Writer(std::move(lfile), options_.manual_wal_flush));
+  }
+  logfile_number_ = new_log_number;
+  // Everything in mem_ is covered by logs older than the new one
+  mem_->SetLogNumber(new_log_number);
+  mem_->MarkImmutable();
+  imm_.Add(mem_);
+  mem_->Unref();
+  mem_ = new MemTable(internal_comparator_, write_buffer_manager_);
+  mem_->Ref();
+  flush_requested_.store(false, std::memory_order_release);
+  UpdateMemTableStats();
+  MaybeScheduleCompaction();
+  return s;
+}
+
+bool DBImpl::MemTableFlushRequested() {
+  mutex_.AssertHeld();
+  if (write_buffer_manager_ == nullptr) { return false; }
+  if (write_buffer_manager_->ShouldFlush()) {
+    // Usually finds this DB's own request already pending, in which case
+    // it does nothing
+    write_buffer_manager_->RequestFlushOfLargest();
+  }
+  if (!flush_requested_.load(std::memory_order_acquire)) { return false; }
+  if (mem_->num_entries() == 0) {
+    // Nothing to flush; the request was for memory that is already gone
+    flush_requested_.store(false, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+size_t DBImpl::MutableMemTableUsage() const {
+  return mutable_memtable_usage_.load(std::memory_order_relaxed);
+}
+
+void DBImpl::RequestFlush() {
+  // Called with the write buffer manager's lock held, from any DB's write
+  // path: it must not take mutex_.  A writer at the front of writers_
+  // sees the flag in MakeRoomForWrite(); the scheduled call handles a DB
+  // that is not being written to.
+  if (!flush_requested_.exchange(true, std::memory_order_acq_rel)) {
+    pending_flush_requests_.fetch_add(1, std::memory_order_relaxed);
+    env_->Schedule(&DBImpl::BGWorkFlushRequest, this);
+  }
+}
+
+void DBImpl::BGWorkFlushRequest(void *db) {
+  reinterpret_cast<DBImpl *>(db)->BackgroundFlushRequest();
+}
+
+void DBImpl::BackgroundFlushRequest() {
+  MutexLock l(&mutex_);
+  // While writers_ is not empty its front writer owns mem_, and switches
+  // it itself; so do pipelined and unordered writes still inserting into
+  // it.  Until imm_ has room the request also waits for a writer.
+  if (!shutting_down_.load(std::memory_order_acquire) && bg_error_.ok() &&
+      writers_.empty() && memtable_write_groups_.empty() &&
+      unordered_writes_.empty() &&
+      mem_ != nullptr && flush_requested_.load(std::memory_order_acquire)) {
+    if (mem_->num_entries() == 0) {
+      flush_requested_.store(false, std::memory_order_release);
+    } else if (imm_.size() < options_.max_write_buffer_number - 1) {
+      Status s = SwitchMemTable();
+      if (!s.ok()) {
+        Log(options_.info_log, "Requested memtable switch failed: %s\n",
+            s.ToString().c_str());
+      }
+    }
+  }
+  pending_flush_requests_.fetch_sub(1, std::memory_order_release);
+  bg_cv_.SignalAll();
+}
+
+void DBImpl::UpdateMemTableStats() {
+  mutex_.AssertHeld();
+  mutable_memtable_usage_.store(mem_->ApproximateMemoryUsage(),
+                                std::memory_order_relaxed);
+  internal_stats_->SetActiveMemTableStats(mem_->ApproximateMemoryUsage(),
+                                          mem_->num_entries(),
+                                          mem_->num_deletes());
+  internal_stats_->SetImmutableMemTableStats(
+      imm_.size(), imm_.ApproximateMemoryUsage(), imm_.NumEntries(),
+      imm_.NumDeletes());
+  internal_stats_->SetBackgroundWork(imm_.IsFlushPending(),
+                                     versions_->NeedsCompaction());
+  RecomputeWriteStallConditions();
+}
+
+void DBImpl::UpdateVersionStats() {
+  mutex_.AssertHeld();
+  internal_stats_->SetVersionStats(versions_->current());
+  internal_stats_->SetBackgroundWork(imm_.IsFlushPending(),
+                                     versions_->NeedsCompaction());
+  RecomputeWriteStallConditions();
+}
+
+void DBImpl::RecomputeWriteStallConditions() {
+  mutex_.AssertHeld();
+  const int l0_files = versions_->NumLevelFiles(0);
+  const uint64_t pending_bytes =
+      versions_->current()->estimated_compaction_needed_bytes();
+  const uint64_t soft_limit = options_.soft_pending_compaction_bytes_limit;
+  const uint64_t hard_limit = options_.hard_pending_compaction_bytes_limit;
+
+  double pressure = WriteController::Pressure(
+      l0_files, options_.level0_slowdown_writes_trigger,
+      options_.level0_stop_writes_trigger);
+  if (soft_limit > 0) {
+    pressure = std::max(
+        pressure,
+        WriteController::Pressure(static_cast<double>(pending_bytes),
+                                  static_cast<double>(soft_limit),
+                                  static_cast<double>(hard_limit > 0
+                                                          ? hard_limit
+                                                          : soft_limit)));
+  }
+  // With more than three write buffers, slow down while the last one
+  // fills up rather than stopping dead when it is full.  With fewer, a
+  // single pending flush would already slow writes down.
+  const int max_buffers = options_.max_write_buffer_number;
+  if (max_buffers > 3) {
+    pressure = std::max(pressure, WriteController::Pressure(
+                                      imm_.size(), max_buffers - 2,
+                                      max_buffers - 1));
+  }
+  write_controller_.SetPressure(pressure);
+
+  const bool stopped =
+      l0_files >= options_.level0_stop_writes_trigger ||
+      (hard_limit > 0 && pending_bytes >= hard_limit);
+  internal_stats_->SetWriteStall(write_controller_.delayed_write_rate(),
+                                 stopped);
+}
+
+void DBImpl::GetApproximateSizes(const Range *range, int n, uint64_t *sizes) {
+  Version *v;
+  {
+    MutexLock l(&mutex_);
+    versions_->current()->Ref();
+    v = versions_->current();
+  }
+
+  for (int i = 0; i < n; i++) {
+    // Convert user_key into a corresponding internal key.
+    InternalKey k1(range[i].start, kMaxSequenceNumber, kValueTypeForSeek);
+    InternalKey k2(range[i].limit, kMaxSequenceNumber, kValueTypeForSeek);
+    uint64_t start = versions_->ApproximateOffsetOf(v, k1);
+    uint64_t limit = versions_->ApproximateOffsetOf(v, k2);
+    sizes[i] = (limit >= start ? limit - start : 0);
+  }
+
+  {
+    MutexLock l(&mutex_);
+    v->Unref();
+  }
+}
+
+int DBImpl::NumberLevels() { return options_.num_levels; }
+
+int DBImpl::MaxMemCompactionLevel() { return options_.max_mem_compaction_level; }
+
+int DBImpl::Level0StopWriteTrigger() {
+  return options_.level0_stop_writes_trigger;
+}
+
+Status DBImpl::DisableFileDeletions() {
+  MutexLock l(&mutex_);
+  ++disable_delete_obsolete_files_;
+  return Status::OK();
+}
+
+Status DBImpl::EnableFileDeletions() {
+  MutexLock l(&mutex_);
+  if (disable_delete_obsolete_files_ > 0) { --disable_delete_obsolete_files_; }
+  if (disable_delete_obsolete_files_ == 0) { DeleteObsoleteFiles(); }
+  return Status::OK();
+}
+
+Status DBImpl::GetLiveFiles(std::vector<std::string> &ret,
+                            uint64_t *manifest_file_size) {
+  // Flush so that the live files cover everything written so far
+  Status s = Flush(FlushOptions());
+  if (!s.ok()) { return s; }
+
+  MutexLock l(&mutex_);
+  std::set<uint64_t> live;
+  versions_->AddLiveFiles(&live);
+
+  ret.clear();
+  ret.reserve(live.size() + 2);  // *.sst + CURRENT + MANIFEST
+  for (uint64_t number : live) {
+    ret.push_back(TableFileName("", number));
+  }
+  ret.push_back(CurrentFileName(""));
+  ret.push_back(DescriptorFileName("", versions_->ManifestFileNumber()));
+
+  *manifest_file_size = 0;
+  return env_->GetFileSize(
+      DescriptorFileName(dbname_, versions_->ManifestFileNumber()),
+      manifest_file_size);
+}
+
+SequenceNumber DBImpl::GetLatestSequenceNumber() {
+  return versions_->LastSequence();
+}
+
+Status DBImpl::GetUpdatesSince(SequenceNumber seq,
+                               unique_ptr<TransactionLogIterator> *iter) {
+  return Status::NotSupported("transaction log iterator not implemented");
+}
+
+Status DBImpl::StartTrace(const TraceOptions &options,
+                          std::unique_ptr<TraceWriter> &&trace_writer) {
+  MutexLock l(&trace_mutex_);
+  if (tracer_ != nullptr) {
+    return Status::InvalidArgument("a trace is already running");
+  }
+  tracer_.reset(new Tracer(env_, options, std::move(trace_writer)));
+  tracing_.store(true, std::memory_order_release);
+  return Status::OK();
+}
+
+Status DBImpl::EndTrace() {
+  MutexLock l(&trace_mutex_);
+  if (tracer_ == nullptr) { return Status::InvalidArgument("no active trace"); }
+  tracing_.store(false, std::memory_order_release);
+  Status s = tracer_->Close();
+  tracer_.reset();
+  return s;
+}
+
+Status DBImpl::StartBlockCacheTrace(
+    const TraceOptions &options, std::unique_ptr<TraceWriter> &&trace_writer) {
+  return block_cache_tracer_.StartTrace(env_, options,
+                                        std::move(trace_writer));
+}
+
+Status DBImpl::EndBlockCacheTrace() { return block_cache_tracer_.EndTrace(); }
+
+void DBImpl::TraceIteratorSeek(const Slice &target) {
+  if (tracing_.load(std::memory_order_relaxed)) {
+    MutexLock l(&trace_mutex_);
+    if (tracer_ != nullptr) { tracer_->IteratorSeek(target); }
+  }
+}
+
 // Default implementations of convenience methods that subclasses of DB
 // can call if they wish
 Status DB::Put(const WriteOptions &opt, const Slice &key, const Slice &value) {
@@ -16,6 +2204,264 @@ Status DB::Put(const WriteOptions &opt, const Slice &key, const Slice &value) {
   return Write(opt, &batch);
 }
 
-Status DBImpl::Write(const WriteOptions &options, WriteBatch *my_batch) {}
+Status DB::Delete(const WriteOptions &opt, const Slice &key) {
+  WriteBatch batch;
+  batch.Delete(key);
+  return Write(opt, &batch);
+}
+
+Snapshot::~Snapshot() = default;
+
+DB::~DB() = default;
+
+Status DB::Open(const Options &options, const std::string &dbname,
+                DB **dbptr) {
+  *dbptr = nullptr;
+  if (options.unordered_write && options.enable_pipelined_write) {
+    return Status::InvalidArgument(
+        "unordered_write is incompatible with enable_pipelined_write");
+  }
+
+  DBImpl *impl = new DBImpl(options, dbname);
+  impl->mutex_.Lock();
+  VersionEdit edit;
+  Status s = impl->Recover(&edit);  // Handles create_if_missing, error_if_exists
+  if (s.ok()) {
+    uint64_t new_log_number = impl->versions_->NewFileNumber();
+    std::unique_ptr<WritableFile> lfile;
+    s = options.env->NewWritableFile(LogFileName(dbname, new_log_number),
+                                     &lfile, EnvOptions(impl->options_));
+    if (s.ok()) {
+      edit.SetLogNumber(new_log_number);
+      edit.SetPrevLogNumber(0);  // No older logs needed after recovery.
+      impl->logfile_number_ = new_log_number;
+      impl->log_.reset(
+          new log::Writer(std::move(lfile), options.manual_wal_flush));
+      impl->mem_ = new MemTable(impl->internal_comparator_,
+                                impl->write_buffer_manager_);
+      impl->mem_->Ref();
+      s = impl->versions_->LogAndApply(&edit, &impl->mutex_);
+    }
+    if (s.ok()) {
+      impl->DeleteObsoleteFiles();
+      impl->UpdateMemTableStats();
+      impl->UpdateVersionStats();
+      impl->MaybeScheduleCompaction();
+    }
+  }
+  impl->mutex_.Unlock();
+  if (s.ok()) {
+    impl->PreloadTables();
+    impl->StartPeriodicStatsDump();
+    *dbptr = impl;
+  } else {
+    delete impl;
+  }
+  return s;
+}
+
+void DBImpl::PreloadTables() {
+  if (options_.max_file_opening_threads <= 0) { return; }
+  const uint64_t start_micros = env_->NowMicros();
+  std::vector<TableCache::PreloadFile> files;
+  mutex_.Lock();
+  // Compactions may already be running; the reference keeps the files.
+  Version *v = versions_->current();
+  v->Ref();
+  v->GetTableFiles(options_.max_open_files < 0
+                       ? SIZE_MAX
+                       : options_.max_open_files - kNumNonTableCacheFiles,
+                   &files);
+  mutex_.Unlock();
+
+  table_cache_->Preload(files, options_.max_file_opening_threads);
+  Log(options_.info_log, "Preloaded %zu tables in %llu us", files.size(),
+      static_cast<unsigned long long>(env_->NowMicros() - start_micros));
+
+  mutex_.Lock();
+  v->Unref();
+  mutex_.Unlock();
+}
+
+Status DB::OpenForReadOnly(const Options &options, const std::string &dbname,
+                           DB **dbptr, bool error_if_log_file_exist) {
+  *dbptr = nullptr;
+  return Status::NotSupported("read only mode not implemented");
+}
+
+Status DestroyDB(const std::string &dbname, const Options &options) {
+  Env *env = options.env;
+  std::vector<std::string> filenames;
+  Status result = env->GetChildren(dbname, &filenames);
+  if (!result.ok()) {
+    // Ignore error in case directory does not exist
+    return Status::OK();
+  }
+
+  FileLock *lock;
+  const std::string lockname = LockFileName(dbname);
+  result = env->LockFile(lockname, &lock);
+  if (result.ok()) {
+    uint64_t number;
+    FileType type;
+    for (size_t i = 0; i < filenames.size(); i++) {
+      if (ParseFileName(filenames[i], &number, &type) &&
+          type != kDBLockFile) {  // Lock file will be deleted at end
+        Status del = env->DeleteFile(dbname + "/" + filenames[i]);
+        if (result.ok() && !del.ok()) { result = del; }
+      }
+    }
+    env->UnlockFile(lock);  // Ignore error since state is already gone
+    env->DeleteFile(lockname);
+    env->DeleteDir(dbname);  // Ignore error in case dir contains other files
+  }
+  return result;
+}
+
+Status RepairDB(const std::string &dbname, const Options &options) {
+  return Status::NotSupported("repair not implemented");
+}
+
+bool DBImpl::GetProperty(const Slice &property, std::string *value) {
+  value->clear();
+  Slice suffix;
+  const DBPropertyInfo *info = GetPropertyInfo(property, &suffix);
+  if (info == nullptr) { return false; }
+
+  if (info->handle_int != nullptr) {
+    uint64_t int_value;
+    if (!GetIntPropertyInternal(*info, &int_value)) { return false; }
+    *value = std::to_string(int_value);
+    return true;
+  }
+
+  MutexLock l(&mutex_);
+  return (internal_stats_.get()->*info->handle_string)(value, suffix,
+                                                        versions_->current());
+}
+
+bool DBImpl::GetIntProperty(const Slice &property, uint64_t *value) {
+  Slice suffix;
+  const DBPropertyInfo *info = GetPropertyInfo(property, &suffix);
+  if (info == nullptr || info->handle_int == nullptr) { return false; }
+  return GetIntPropertyInternal(*info, value);
+}
+
+bool DBImpl::GetIntPropertyInternal(const DBPropertyInfo &info,
+                                    uint64_t *value) {
+  assert(info.handle_int != nullptr);
+  if (info.need_out_of_mutex) {
+    return (internal_stats_.get()->*info.handle_int)(value, nullptr);
+  }
+  MutexLock l(&mutex_);
+  return (internal_stats_.get()->*info.handle_int)(value,
+                                                   versions_->current());
+}
+
+void DBImpl::StartPeriodicStatsDump() {
+  if (options_.stats_dump_period_sec == 0 &&
+      options_.db_stats_log_interval < 0) {
+    return;
+  }
+  MutexLock l(&mutex_);
+  assert(!stats_dump_thread_running_);
+  const uint64_t now_micros = env_->NowMicros();
+  last_stats_dump_time_microsec_ = now_micros;
+  last_deploy_stats_log_time_microsec_ = now_micros;
+  stats_dump_thread_running_ = true;
+  env_->StartThread(&DBImpl::BGWorkStatsDump, this);
+}
+
+void DBImpl::BGWorkStatsDump(void *db) {
+  reinterpret_cast<DBImpl *>(db)->StatsDumpLoop();
+}
+
+void DBImpl::StatsDumpLoop() {
+  MutexLock l(&mutex_);
+  while (!shutting_down_.load(std::memory_order_acquire)) {
+    // Sleep until the earliest enabled deadline.  bg_cv_ is also signalled
+    // by unrelated background work, so MaybeDumpStats() re-checks the time.
+    uint64_t deadline = UINT64_MAX;
+    if (options_.stats_dump_period_sec > 0) {
+      deadline = std::min<uint64_t>(
+          deadline, last_stats_dump_time_microsec_ +
+                        options_.stats_dump_period_sec * 1000000ULL);
+    }
+    if (options_.db_stats_log_interval >= 0) {
+      deadline = std::min<uint64_t>(
+          deadline, last_deploy_stats_log_time_microsec_ +
+                        options_.db_stats_log_interval * 1000000ULL);
+    }
+    bg_cv_.TimedWait(deadline);
+    if (shutting_down_.load(std::memory_order_acquire)) { break; }
+    MaybeDumpStats();
+  }
+  stats_dump_thread_running_ = false;
+  bg_cv_.SignalAll();
+}
+
+void DBImpl::MaybeDumpStats() {
+  mutex_.AssertHeld();
+  const uint64_t now_micros = env_->NowMicros();
+
+  if (options_.stats_dump_period_sec > 0 &&
+      now_micros - last_stats_dump_time_microsec_ >=
+          options_.stats_dump_period_sec * 1000000ULL) {
+    last_stats_dump_time_microsec_ = now_micros;
+    std::string stats;
+    internal_stats_->HandleStats(&stats, Slice(), versions_->current());
+
+    // Formatting the statistics object and writing to the log do not touch
+    // DB state, so keep them outside the mutex.
+    mutex_.Unlock();
+    Log(options_.info_log, "------- DUMPING STATS -------");
+    Log(options_.info_log, "%s", stats.c_str());
+    if (options_.statistics) {
+      Log(options_.info_log, "%s", options_.statistics->ToString().c_str());
+    }
+    mutex_.Lock();
+  }
+
+  if (options_.db_stats_log_interval >= 0 &&
+      now_micros - last_deploy_stats_log_time_microsec_ >=
+          static_cast<uint64_t>(options_.db_stats_log_interval) * 1000000ULL) {
+    last_deploy_stats_log_time_microsec_ = now_micros;
+    LogDBDeployStats();
+  }
+}
+
+void DBImpl::LogDBDeployStats() {
+  mutex_.AssertHeld();
+
+  char hostname[256];
+  if (!env_->GetHostName(hostname, sizeof(hostname)).ok()) {
+    snprintf(hostname, sizeof(hostname), "unknown");
+  }
+
+  Version *current = versions_->current();
+  std::string data_sizes;
+  uint64_t total_bytes = 0;
+  for (int level = 0; level < versions_->NumberLevels(); level++) {
+    const uint64_t level_bytes = current->NumLevelBytes(level);
+    total_bytes += level_bytes;
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%s%" PRIu64, level == 0 ? "" : " ",
+             level_bytes);
+    data_sizes.append(buf);
+  }
+  VersionSet::LevelSummaryStorage files;
+  versions_->LevelSummary(&files);
+  const uint64_t active_keys = current->GetEstimatedActiveKeys();
+  const uint64_t last_sequence = versions_->LastSequence();
+
+  mutex_.Unlock();
+  Log(options_.info_log,
+      "DB deploy stats: host %s db %s total-bytes %" PRIu64
+      " level-bytes [%s] %s estimate-num-keys %" PRIu64
+      " last-sequence %" PRIu64,
+      hostname, dbname_.c_str(), total_bytes, data_sizes.c_str(),
+      files.buffer, active_keys, last_sequence);
+  mutex_.Lock();
+}
 
-}  // namespace leveldb
\ No newline at end of file
+}  // namespace leveldb
@@ -4,25 +4,332 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "db/dbformat.h"
+#include "db/internal_stats.h"
+#include "db/log_writer.h"
+#include "db/memtablelist.h"
+#include "db/snapshot.h"
+#include "db/write_controller.h"
 #include "leveldb/db.h"
+#include "leveldb/env.h"
 #include "leveldb/options.h"
 #include "leveldb/status.h"
+#include "leveldb/write_buffer_manager.h"
+#include "port/port.h"
+#include "table/block_cache_tracer.h"
 
 namespace leveldb {
-class DBImpl : public DB {
+
+class MemTable;
+class TableCache;
+class Tracer;
+class Version;
+class VersionEdit;
+class VersionSet;
+
+class DBImpl : public DB, private WriteBufferManager::Consumer {
 public:
   DBImpl(const Options &options, const std::string &dbname);
   virtual ~DBImpl();
+
   // Implementations of the DB interface
   virtual Status Put(const WriteOptions &, const Slice &key,
                      const Slice &value);
-
+  virtual Status Delete(const WriteOptions &, const Slice &key);
+  virtual Status Merge(const WriteOptions &, const Slice &key,
+                       const Slice &value);
   virtual Status Write(const WriteOptions &options, WriteBatch *updates);
+  virtual Status Get(const ReadOptions &options, const Slice &key,
+                     std::string *value);
+  virtual std::vector<Status> MultiGet(const ReadOptions &options,
+                                       const std::vector<Slice> &keys,
+                                       std::vector<std::string> *values);
+  virtual Iterator *NewIterator(const ReadOptions &);
+  virtual const Snapshot *GetSnapshot();
+  virtual void ReleaseSnapshot(const Snapshot *snapshot);
+  virtual bool GetProperty(const Slice &property, std::string *value);
+  virtual bool GetIntProperty(const Slice &property, uint64_t *value);
+  virtual void GetApproximateSizes(const Range *range, int n, uint64_t *sizes);
+  virtual void CompactRange(const Slice *begin, const Slice *end);
+  virtual int NumberLevels();
+  virtual int MaxMemCompactionLevel();
+  virtual int Level0StopWriteTrigger();
+  virtual Status Flush(const FlushOptions &options);
+  virtual Status FlushWAL(bool sync);
+  virtual Status DisableFileDeletions();
+  virtual Status EnableFileDeletions();
+  virtual Status GetLiveFiles(std::vector<std::string> &,
+                              uint64_t *manifest_file_size);
+  virtual SequenceNumber GetLatestSequenceNumber();
+  virtual Status GetUpdatesSince(SequenceNumber seq_number,
+                                 unique_ptr<TransactionLogIterator> *iter);
+  virtual Status StartTrace(const TraceOptions &options,
+                            std::unique_ptr<TraceWriter> &&trace_writer);
+  virtual Status EndTrace();
+  virtual Status StartBlockCacheTrace(
+      const TraceOptions &options,
+      std::unique_ptr<TraceWriter> &&trace_writer);
+  virtual Status EndBlockCacheTrace();
+
+  // Called by iterators returned from NewIterator() on every Seek().
+  void TraceIteratorSeek(const Slice &target);
+
+  // Compact any files in the named level that overlap [*begin,*end]
+  void TEST_CompactRange(int level, const Slice *begin, const Slice *end);
+
+  // Force current memtable contents to be flushed and wait for it.
+  Status TEST_FlushMemTable();
 
 private:
-  struct DeletionState;
+  friend class DB;
+  struct CompactionState;
+  struct Writer;
+  struct WriteGroup;
+
+  Iterator *NewInternalIterator(const ReadOptions &,
+                                SequenceNumber *latest_snapshot);
+
+  Status NewDB();
+
+  // Recover the descriptor from persistent storage.  May do a significant
+  // amount of work to recover recently logged updates.  Any changes to
+  // be made to the descriptor are added to *edit.
+  Status Recover(VersionEdit *edit);
+
+  void MaybeIgnoreError(Status *s) const;
+
+  // Delete any unneeded files and stale in-memory entries.
+  void DeleteObsoleteFiles();
+
+  // Flush the oldest immutable memtable to a new level-0 (or lower) table
+  // and install it.  Errors are recorded in bg_error_.
+  // REQUIRES: mutex_ held
+  Status FlushMemTableToOutputFile();
+
+  Status RecoverLogFile(uint64_t log_number, VersionEdit *edit,
+                        SequenceNumber *max_sequence);
+
+  // Recovery builds level-0 tables on threads of its own.
+  struct RecoveryFlushes;
+  struct RecoveryFlush;
+  // Build a table from "mem", a full memtable replayed from the WAL, and
+  // drop the reference to it.  Runs on a thread of *flushes unless there
+  // is only one recovery thread.
+  // REQUIRES: mutex_ held
+  Status ScheduleRecoveryFlush(MemTable *mem, VersionEdit *edit,
+                               RecoveryFlushes *flushes);
+  static void BGWorkRecoveryFlush(void *flush);
+
+  // Build a table from "mem" and record it in *edit.  If non-null,
+  // *file_number is set to the number of the new table (0 if it was empty).
+  // If "number" is non-zero the table gets that file number, allocated by
+  // the caller, rather than a new one.
+  Status WriteLevel0Table(MemTable *mem, VersionEdit *edit, Version *base,
+                          uint64_t *file_number = nullptr,
+                          uint64_t number = 0);
+
+  // Switch to a fresh memtable (and log) if "force" or the current one
+  // is full, waiting or slowing the writer down as needed.
+  // REQUIRES: mutex_ held and this thread is at the front of writers_
+  Status MakeRoomForWrite(bool force);
+  // Combine the batches of writers_ from the front into one group, in
+  // *scratch if there is more than one.
+  WriteBatch *BuildBatchGroup(Writer **last_writer, WriteBatch *scratch);
+
+  // Start a new log and make mem_ immutable, scheduling its flush.
+  // REQUIRES: mutex_ held, no writer is adding to mem_, and imm_ has room
+  Status SwitchMemTable();
+
+  // Whether options_.write_buffer_manager wants mem_ switched out, either
+  // because it asked for it or because mem_ is the largest memtable and
+  // the budget is exceeded.  Asks another DB to flush if that one is the
+  // largest instead.
+  // REQUIRES: mutex_ held
+  bool MemTableFlushRequested();
+
+  // WriteBufferManager::Consumer
+  size_t MutableMemTableUsage() const override;
+  void RequestFlush() override;
+  static void BGWorkFlushRequest(void *db);
+  void BackgroundFlushRequest();
+
+  // Write() without tracing, shared by Put(), Delete() and Flush().
+  Status WriteImpl(const WriteOptions &options, WriteBatch *updates);
+  // WriteImpl() with options_.enable_pipelined_write
+  Status PipelinedWriteImpl(const WriteOptions &options, WriteBatch *updates);
+  // WriteImpl() with options_.unordered_write
+  Status UnorderedWriteImpl(const WriteOptions &options, WriteBatch *updates);
+
+  // Stats for a write group about to be written.
+  // REQUIRES: mutex_ held
+  void RecordWriteGroup(const WriteBatch *updates);
+  // Append "updates" to the log, and sync it if requested.  *sync_error
+  // is set if the log is left in an unknown state.
+  // REQUIRES: mutex_ not held, this thread owns the WAL stage
+  Status WriteToWAL(const WriteOptions &options, const WriteBatch *updates,
+                    bool *sync_error);
+  // REQUIRES: log_write_mutex_ held
+  Status SyncWAL();
+  // REQUIRES: mutex_ held
+  void UpdateActiveMemTableStats();
+
+  void RecordBackgroundError(const Status &s);
+
+  void MaybeScheduleCompaction();
+  static void BGWork(void *db);
   void BackgroundCall();
-  Status BackgroundCompaction(bool *madeProgress,
-                              DeletionState &deletion_state);
+  void BackgroundCompaction();
+  void CleanupCompaction(CompactionState *compact);
+  Status DoCompactionWork(CompactionState *compact);
+
+  Status OpenCompactionOutputFile(CompactionState *compact);
+  Status FinishCompactionOutputFile(CompactionState *compact, Iterator *input);
+  Status InstallCompactionResults(CompactionState *compact);
+
+  // Publish the memtable, background work and version gauges behind the
+  // out-of-mutex integer properties.
+  // REQUIRES: mutex_ held
+  void UpdateMemTableStats();
+  void UpdateVersionStats();
+
+  // Recompute how much writes are delayed from the L0 file count, pending
+  // compaction bytes and immutable memtable count.  Called from the two
+  // functions above, which cover every change to those.
+  // REQUIRES: mutex_ held
+  void RecomputeWriteStallConditions();
+
+  const Comparator *user_comparator() const {
+    return internal_comparator_.user_comparator();
+  }
+
+  bool GetIntPropertyInternal(const DBPropertyInfo &info, uint64_t *value);
+
+  // Start the background thread that writes "leveldb.stats" and the deploy
+  // stats summary to the info log.  Does nothing if both are disabled.
+  // REQUIRES: mutex_ not held
+  void StartPeriodicStatsDump();
+
+  // Open tables ahead of the first reads to them, as far as the table cache
+  // holds them; see Options::max_file_opening_threads.
+  // REQUIRES: mutex_ not held
+  void PreloadTables();
+  static void BGWorkStatsDump(void *db);
+  void StatsDumpLoop();
+
+  // Dump whatever is due at the current time.
+  // REQUIRES: mutex_ held; temporarily releases it while logging
+  void MaybeDumpStats();
+  void LogDBDeployStats();
+
+  // Constant after construction
+  Env *const env_;
+  const InternalKeyComparator internal_comparator_;
+  const InternalFilterPolicy internal_filter_policy_;
+  const Options options_;  // options_.comparator == &internal_comparator_
+  const std::string dbname_;
+
+  // Shared by every table read through table_cache_
+  BlockCacheTracer block_cache_tracer_;
+
+  // table_cache_ provides its own synchronization
+  TableCache *const table_cache_;
+
+  // Lock over the persistent DB state.  Non-null iff successfully acquired.
+  FileLock *db_lock_;
+
+  port::Mutex mutex_;
+  std::atomic<bool> shutting_down_;
+  port::CondVar bg_cv_; // Signalled when background work finishes
+  MemTable *mem_;
+  MemTableList imm_;    // Memtables being flushed, newest first
+  // log_ is written outside mutex_ by the writer at the front of writers_,
+  // and flushed by FlushWAL() from anywhere, so all use of it is under
+  // log_write_mutex_.  Replacing it requires mutex_ as well.
+  port::Mutex log_write_mutex_;
+  std::unique_ptr<log::Writer> log_;
+  uint64_t logfile_number_;
+
+  // Queue of writers.  With pipelined writes only the WAL stage; groups
+  // that are through it wait in memtable_write_groups_, oldest first.
+  std::deque<Writer *> writers_;
+  std::deque<WriteGroup *> memtable_write_groups_;
+  // With unordered writes, the first sequence numbers of the groups whose
+  // sequence numbers are published but which are still being inserted
+  // into mem_.  unordered_writes_cv_ is signalled as they finish.
+  std::multiset<SequenceNumber> unordered_writes_;
+  port::CondVar unordered_writes_cv_;
+  WriteBatch *tmp_batch_;
+  // Bytes written by the last write group, which the next one is delayed
+  // for while writes are throttled
+  uint64_t last_batch_group_size_;
+  WriteController write_controller_;
+
+  SnapshotList snapshots_;
+
+  // Set of table files to protect from deletion because they are
+  // part of ongoing compactions.
+  std::set<uint64_t> pending_outputs_;
+
+  // Files moved out of level 0 whose tables are pinned until no version
+  // has them at level 0; see Options::pin_l0_filter_and_index_blocks.
+  std::set<uint64_t> pending_unpins_;
+
+  // Has a background compaction been scheduled or is running?
+  bool bg_compaction_scheduled_;
+
+  // Information for a manual compaction
+  struct ManualCompaction {
+    int level;
+    bool done;
+    const InternalKey *begin; // null means beginning of key range
+    const InternalKey *end;   // null means end of key range
+    InternalKey tmp_storage;  // Used to keep track of compaction progress
+  };
+  ManualCompaction *manual_compaction_;
+
+  VersionSet *const versions_;
+
+  // Non-null iff memtable memory is accounted in a write buffer manager
+  WriteBufferManager *const write_buffer_manager_;
+  // Published for the write buffer manager, which reads it without mutex_
+  std::atomic<size_t> mutable_memtable_usage_;
+  // Set by RequestFlush(), cleared once mem_ is switched out
+  std::atomic<bool> flush_requested_;
+  // Scheduled BackgroundFlushRequest() calls that have not finished
+  std::atomic<int> pending_flush_requests_;
+
+  // Have we encountered a background error in paranoid mode?
+  Status bg_error_;
+
+  // Files are only deleted when this is zero, see DisableFileDeletions()
+  int disable_delete_obsolete_files_;
+
+  std::unique_ptr<InternalStats> internal_stats_;
+
+  // State of the periodic stats dump, guarded by mutex_
+  bool stats_dump_thread_running_;
+  uint64_t last_stats_dump_time_microsec_;
+  uint64_t last_deploy_stats_log_time_microsec_;
+
+  // Active trace, if any.  tracing_ lets the hot paths skip trace_mutex_
+  // when no trace is running.
+  port::Mutex trace_mutex_;
+  std::atomic<bool> tracing_;
+  std::unique_ptr<Tracer> tracer_;
 };
+
+// Sanitize db options: clip sizes to sane ranges, switch to the internal
+// key comparator and filter policy, and create the info log and block cache
+// when the caller did not supply them.
+Options SanitizeOptions(const std::string &db,
+                        const InternalKeyComparator *icmp,
+                        const InternalFilterPolicy *ipolicy,
+                        const Options &src);
+
 } // namespace leveldb
@@ -0,0 +1,25 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include <cstdint>
+
+#include "db/dbformat.h"
+#include "leveldb/db.h"
+
+namespace leveldb {
+
+class DBImpl;
+
+// Return a new iterator that converts internal keys (yielded by
+// "*internal_iter") that were live at the specified "sequence" number
+// into appropriate user keys.  If "db" is non-null, Seek() calls are
+// reported to it for tracing.
+Iterator *NewDBIterator(const std::string *dbname, Env *env,
+                        const Comparator *user_key_comparator,
+                        Iterator *internal_iter, SequenceNumber sequence,
+                        DBImpl *db = nullptr);
+
+}  // namespace leveldb
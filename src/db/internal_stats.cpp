@@ -0,0 +1,386 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "db/internal_stats.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "db/version_set.h"
+
+namespace leveldb {
+
+namespace {
+
+const std::string kPrefix = "leveldb.";
+
+// Keyed by string_view over the literals below so lookups by a Slice into
+// the caller's property name do not allocate.
+const std::unordered_map<std::string_view, DBPropertyInfo> &PropertyInfoMap() {
+  static const std::unordered_map<std::string_view, DBPropertyInfo> kMap = {
+      {"num-files-at-level",
+       {false, &InternalStats::HandleNumFilesAtLevel, nullptr}},
+      {"stats", {false, &InternalStats::HandleStats, nullptr}},
+      {"sstables", {false, &InternalStats::HandleSsTables, nullptr}},
+      {"num-immutable-mem-table",
+       {true, nullptr, &InternalStats::HandleNumImmutableMemTable}},
+      {"mem-table-flush-pending",
+       {true, nullptr, &InternalStats::HandleMemTableFlushPending}},
+      {"compaction-pending",
+       {true, nullptr, &InternalStats::HandleCompactionPending}},
+      {"background-errors",
+       {true, nullptr, &InternalStats::HandleBackgroundErrors}},
+      {"cur-size-active-mem-table",
+       {true, nullptr, &InternalStats::HandleCurSizeActiveMemTable}},
+      {"cur-size-all-mem-tables",
+       {true, nullptr, &InternalStats::HandleCurSizeAllMemTables}},
+      {"num-entries-active-mem-table",
+       {true, nullptr, &InternalStats::HandleNumEntriesActiveMemTable}},
+      {"num-entries-imm-mem-tables",
+       {true, nullptr, &InternalStats::HandleNumEntriesImmMemTables}},
+      {"estimate-num-keys",
+       {true, nullptr, &InternalStats::HandleEstimateNumKeys}},
+      {"estimate-pending-compaction-bytes",
+       {true, nullptr, &InternalStats::HandleEstimatePendingCompactionBytes}},
+      {"total-sst-files-size",
+       {true, nullptr, &InternalStats::HandleTotalSstFilesSize}},
+      {"num-snapshots", {true, nullptr, &InternalStats::HandleNumSnapshots}},
+      {"actual-delayed-write-rate",
+       {true, nullptr, &InternalStats::HandleActualDelayedWriteRate}},
+      {"is-write-stopped",
+       {true, nullptr, &InternalStats::HandleIsWriteStopped}},
+  };
+  return kMap;
+}
+
+// Property names that take a numeric suffix, e.g. num-files-at-level2.
+const char *const kNumFilesAtLevelPrefix = "num-files-at-level";
+
+}  // namespace
+
+const DBPropertyInfo *GetPropertyInfo(const Slice &property, Slice *suffix) {
+  Slice in = property;
+  if (!in.starts_with(kPrefix)) { return nullptr; }
+  in.remove_prefix(kPrefix.size());
+  *suffix = Slice();
+  if (in.starts_with(kNumFilesAtLevelPrefix)) {
+    *suffix = Slice(in.data() + strlen(kNumFilesAtLevelPrefix),
+                    in.size() - strlen(kNumFilesAtLevelPrefix));
+    in = Slice(kNumFilesAtLevelPrefix);
+  }
+  const auto &map = PropertyInfoMap();
+  auto it = map.find(std::string_view(in.data(), in.size()));
+  if (it == map.end()) { return nullptr; }
+  return &it->second;
+}
+
+InternalStats::InternalStats(int num_levels, Env *env)
+    : number_levels_(num_levels),
+      env_(env),
+      started_at_(env->NowMicros()),
+      compaction_stats_(num_levels),
+      active_mem_bytes_(0),
+      active_mem_entries_(0),
+      active_mem_deletes_(0),
+      num_imm_mem_tables_(0),
+      imm_mem_bytes_(0),
+      imm_mem_entries_(0),
+      imm_mem_deletes_(0),
+      version_active_keys_(0),
+      pending_compaction_bytes_(0),
+      total_sst_bytes_(0),
+      num_snapshots_(0),
+      bg_errors_(0),
+      flush_pending_(false),
+      compaction_pending_(false),
+      delayed_write_rate_(0),
+      write_stopped_(false) {
+  for (auto &s : db_stats_) { s.store(0, std::memory_order_relaxed); }
+}
+
+void InternalStats::SetVersionStats(Version *current) {
+  uint64_t total = 0;
+  for (int level = 0; level < number_levels_; level++) {
+    total += current->NumLevelBytes(level);
+  }
+  version_active_keys_.store(current->GetEstimatedActiveKeys(),
+                             std::memory_order_relaxed);
+  pending_compaction_bytes_.store(current->estimated_compaction_needed_bytes(),
+                                  std::memory_order_relaxed);
+  total_sst_bytes_.store(total, std::memory_order_relaxed);
+}
+
+bool InternalStats::HandleNumFilesAtLevel(std::string *value, Slice suffix,
+                                          Version *current) {
+  // Parse the level number, all of "suffix" must be digits
+  uint64_t level = 0;
+  if (suffix.empty()) { return false; }
+  for (size_t i = 0; i < suffix.size(); i++) {
+    char c = suffix[i];
+    if (c < '0' || c > '9') { return false; }
+    level = level * 10 + (c - '0');
+    if (level >= static_cast<uint64_t>(number_levels_)) { return false; }
+  }
+  char buf[100];
+  snprintf(buf, sizeof(buf), "%d", current->NumFiles(static_cast<int>(level)));
+  *value = buf;
+  return true;
+}
+
+bool InternalStats::HandleStats(std::string *value, Slice suffix,
+                                Version *current) {
+  char buf[1000];
+  snprintf(buf, sizeof(buf),
+           "                               Compactions\n"
+           "Level  Files Size(MB) Time(sec)  Read(MB) Write(MB)    "
+           "Rn(MB)  Rnp1(MB)  Wnew(MB) Comp(cnt)\n"
+           "--------------------------------------------------------------"
+           "------------------------------\n");
+  value->append(buf);
+
+  CompactionStats total;
+  int total_count = 0;
+  int total_files = 0;
+  uint64_t total_bytes = 0;
+  for (int level = 0; level < number_levels_; level++) {
+    int files = current->NumFiles(level);
+    const CompactionStats &stats = compaction_stats_[level];
+    if (files == 0 && stats.count == 0) { continue; }
+    uint64_t level_bytes = current->NumLevelBytes(level);
+    total_files += files;
+    total_bytes += level_bytes;
+    total.Add(stats);
+    total_count += stats.count;
+
+    double bytes_read = stats.bytes_readn + stats.bytes_readnp1;
+    double bytes_new = static_cast<double>(stats.bytes_written) -
+                       static_cast<double>(stats.bytes_readnp1);
+    snprintf(buf, sizeof(buf),
+             "%3d %8d %8.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9d\n",
+             level, files, level_bytes / 1048576.0, stats.micros / 1e6,
+             bytes_read / 1048576.0, stats.bytes_written / 1048576.0,
+             stats.bytes_readn / 1048576.0, stats.bytes_readnp1 / 1048576.0,
+             bytes_new / 1048576.0, stats.count);
+    value->append(buf);
+  }
+  snprintf(buf, sizeof(buf),
+           "Sum %8d %8.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9.0f %9d\n",
+           total_files, total_bytes / 1048576.0, total.micros / 1e6,
+           (total.bytes_readn + total.bytes_readnp1) / 1048576.0,
+           total.bytes_written / 1048576.0, total.bytes_readn / 1048576.0,
+           total.bytes_readnp1 / 1048576.0,
+           (static_cast<double>(total.bytes_written) -
+            static_cast<double>(total.bytes_readnp1)) /
+               1048576.0,
+           total_count);
+  value->append(buf);
+
+  snprintf(buf, sizeof(buf),
+           "MemTables: active %" PRIu64 " bytes / %" PRIu64
+           " entries, %" PRIu64 " immutable %" PRIu64 " bytes / %" PRIu64
+           " entries\n",
+           active_mem_bytes_.load(std::memory_order_relaxed),
+           active_mem_entries_.load(std::memory_order_relaxed),
+           num_imm_mem_tables_.load(std::memory_order_relaxed),
+           imm_mem_bytes_.load(std::memory_order_relaxed),
+           imm_mem_entries_.load(std::memory_order_relaxed));
+  value->append(buf);
+
+  DumpDBStats(value);
+  return true;
+}
+
+bool InternalStats::HandleSsTables(std::string *value, Slice suffix,
+                                   Version *current) {
+  *value = current->DebugString();
+  return true;
+}
+
+void InternalStats::DumpDBStats(std::string *value) {
+  char buf[1000];
+  // DB-level stats, only available from the DB mutex but accessible
+  // atomically so writers never wait on us.
+  double seconds_up = (env_->NowMicros() - started_at_ + 1) / 1000000.0;
+  double interval_seconds_up = seconds_up - db_stats_snapshot_.seconds_up;
+  snprintf(buf, sizeof(buf), "\nUptime(secs): %.1f total, %.1f interval\n",
+           seconds_up, interval_seconds_up);
+  value->append(buf);
+
+  const uint64_t user_bytes_written = GetDBStats(BYTES_WRITTEN);
+  const uint64_t num_keys_written = GetDBStats(NUMBER_KEYS_WRITTEN);
+  const uint64_t write_other = GetDBStats(WRITE_DONE_BY_OTHER);
+  const uint64_t write_self = GetDBStats(WRITE_DONE_BY_SELF);
+  const uint64_t wal_bytes = GetDBStats(WAL_FILE_BYTES);
+  const uint64_t wal_synced = GetDBStats(WAL_FILE_SYNCED);
+  const uint64_t write_with_wal = GetDBStats(WRITE_WITH_WAL);
+  const uint64_t write_stall_micros = GetDBStats(WRITE_STALL_MICROS);
+
+  // Cumulative
+  snprintf(buf, sizeof(buf),
+           "Cumulative writes: %" PRIu64 " writes, %" PRIu64 " keys, %" PRIu64
+           " commit groups, %.1f writes per commit group, "
+           "ingest: %.2f MB, %.2f MB/s\n",
+           write_other + write_self, num_keys_written, write_self,
+           (write_other + write_self) / static_cast<double>(write_self + 1),
+           user_bytes_written / 1048576.0,
+           user_bytes_written / 1048576.0 / seconds_up);
+  value->append(buf);
+  snprintf(buf, sizeof(buf),
+           "Cumulative WAL: %" PRIu64 " writes, %" PRIu64 " syncs, "
+           "%.2f writes per sync, written: %.2f MB, %.2f MB/s\n",
+           write_with_wal, wal_synced,
+           write_with_wal / static_cast<double>(wal_synced + 1),
+           wal_bytes / 1048576.0, wal_bytes / 1048576.0 / seconds_up);
+  value->append(buf);
+  snprintf(buf, sizeof(buf), "Cumulative stall: %.3f secs, %.1f percent\n",
+           write_stall_micros / 1e6,
+           write_stall_micros / 10000.0 / seconds_up);
+  value->append(buf);
+
+  // Interval
+  const DBStatsSnapshot &prev = db_stats_snapshot_;
+  uint64_t interval_write_other = write_other - prev.write_other;
+  uint64_t interval_write_self = write_self - prev.write_self;
+  uint64_t interval_num_keys_written =
+      num_keys_written - prev.num_keys_written;
+  uint64_t interval_bytes = user_bytes_written - prev.ingest_bytes;
+  snprintf(buf, sizeof(buf),
+           "Interval writes: %" PRIu64 " writes, %" PRIu64 " keys, %" PRIu64
+           " commit groups, %.1f writes per commit group, "
+           "ingest: %.2f MB, %.2f MB/s\n",
+           interval_write_other + interval_write_self,
+           interval_num_keys_written, interval_write_self,
+           static_cast<double>(interval_write_other + interval_write_self) /
+               (interval_write_self + 1),
+           interval_bytes / 1048576.0,
+           interval_bytes / 1048576.0 / std::max(interval_seconds_up, 0.001));
+  value->append(buf);
+
+  uint64_t interval_write_with_wal = write_with_wal - prev.write_with_wal;
+  uint64_t interval_wal_synced = wal_synced - prev.wal_synced;
+  uint64_t interval_wal_bytes = wal_bytes - prev.wal_bytes;
+  snprintf(buf, sizeof(buf),
+           "Interval WAL: %" PRIu64 " writes, %" PRIu64 " syncs, "
+           "%.2f writes per sync, written: %.2f MB, %.2f MB/s\n",
+           interval_write_with_wal, interval_wal_synced,
+           interval_write_with_wal /
+               static_cast<double>(interval_wal_synced + 1),
+           interval_wal_bytes / 1048576.0,
+           interval_wal_bytes / 1048576.0 /
+               std::max(interval_seconds_up, 0.001));
+  value->append(buf);
+
+  uint64_t interval_stall = write_stall_micros - prev.write_stall_micros;
+  snprintf(buf, sizeof(buf), "Interval stall: %.3f secs, %.1f percent\n",
+           interval_stall / 1e6,
+           interval_stall / 10000.0 / std::max(interval_seconds_up, 0.001));
+  value->append(buf);
+
+  db_stats_snapshot_.seconds_up = seconds_up;
+  db_stats_snapshot_.ingest_bytes = user_bytes_written;
+  db_stats_snapshot_.num_keys_written = num_keys_written;
+  db_stats_snapshot_.write_other = write_other;
+  db_stats_snapshot_.write_self = write_self;
+  db_stats_snapshot_.wal_bytes = wal_bytes;
+  db_stats_snapshot_.wal_synced = wal_synced;
+  db_stats_snapshot_.write_with_wal = write_with_wal;
+  db_stats_snapshot_.write_stall_micros = write_stall_micros;
+}
+
+bool InternalStats::HandleNumImmutableMemTable(uint64_t *value,
+                                               Version *current) {
+  *value = num_imm_mem_tables_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleMemTableFlushPending(uint64_t *value,
+                                               Version *current) {
+  *value = flush_pending_.load(std::memory_order_relaxed) ? 1 : 0;
+  return true;
+}
+
+bool InternalStats::HandleCompactionPending(uint64_t *value,
+                                            Version *current) {
+  *value = compaction_pending_.load(std::memory_order_relaxed) ? 1 : 0;
+  return true;
+}
+
+bool InternalStats::HandleBackgroundErrors(uint64_t *value,
+                                           Version *current) {
+  *value = bg_errors_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleCurSizeActiveMemTable(uint64_t *value,
+                                                Version *current) {
+  *value = active_mem_bytes_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleCurSizeAllMemTables(uint64_t *value,
+                                              Version *current) {
+  *value = active_mem_bytes_.load(std::memory_order_relaxed) +
+           imm_mem_bytes_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleNumEntriesActiveMemTable(uint64_t *value,
+                                                   Version *current) {
+  *value = active_mem_entries_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleNumEntriesImmMemTables(uint64_t *value,
+                                                 Version *current) {
+  *value = imm_mem_entries_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleEstimateNumKeys(uint64_t *value, Version *current) {
+  // Estimate number of entries in the column family:
+  // Use estimated entries in tables + total entries in memtables, and
+  // assume every deletion cancels one entry stored elsewhere.
+  uint64_t entries = active_mem_entries_.load(std::memory_order_relaxed) +
+                     imm_mem_entries_.load(std::memory_order_relaxed);
+  uint64_t deletes = active_mem_deletes_.load(std::memory_order_relaxed) +
+                     imm_mem_deletes_.load(std::memory_order_relaxed);
+  uint64_t mem_keys = entries > 2 * deletes ? entries - 2 * deletes : 0;
+  *value = mem_keys + version_active_keys_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleEstimatePendingCompactionBytes(uint64_t *value,
+                                                         Version *current) {
+  *value = pending_compaction_bytes_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleTotalSstFilesSize(uint64_t *value,
+                                            Version *current) {
+  *value = total_sst_bytes_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleNumSnapshots(uint64_t *value, Version *current) {
+  *value = num_snapshots_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleActualDelayedWriteRate(uint64_t *value,
+                                                 Version *current) {
+  *value = delayed_write_rate_.load(std::memory_order_relaxed);
+  return true;
+}
+
+bool InternalStats::HandleIsWriteStopped(uint64_t *value, Version *current) {
+  *value = write_stopped_.load(std::memory_order_relaxed) ? 1 : 0;
+  return true;
+}
+
+}  // namespace leveldb
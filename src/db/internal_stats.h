@@ -0,0 +1,231 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+class InternalStats;
+class Version;
+class VersionSet;
+
+// Describes how a property named by DB::GetProperty() is computed.
+struct DBPropertyInfo {
+  // True if the property can be served without holding the DB mutex.  Such
+  // properties only read gauges in InternalStats and never format strings,
+  // so they are cheap enough to be polled at high frequency.
+  bool need_out_of_mutex;
+
+  // Exactly one of the handlers is set.  "suffix" is whatever follows the
+  // registered name, e.g. "3" for "leveldb.num-files-at-level3".
+  bool (InternalStats::*handle_string)(std::string *value, Slice suffix,
+                                       Version *current);
+  bool (InternalStats::*handle_int)(uint64_t *value, Version *current);
+};
+
+// Returns the handler for "property", or nullptr if it is not a property
+// this DB implementation understands.  On success *suffix is set to the part
+// of "property" that follows the registered name.
+const DBPropertyInfo *GetPropertyInfo(const Slice &property, Slice *suffix);
+
+// Collects the statistics behind DB::GetProperty() and the periodic
+// "leveldb.stats" dump.
+//
+// There are three kinds of state:
+//  * per-level compaction stats, updated and read under the DB mutex;
+//  * cumulative DB stats (InternalDBStatsType), plain atomic counters that
+//    the write path bumps without any lock;
+//  * gauges describing the memtables and the current version, published by
+//    DBImpl whenever they change so that integer properties can be read
+//    without the DB mutex.
+class InternalStats {
+public:
+  enum InternalDBStatsType {
+    WAL_FILE_BYTES,
+    WAL_FILE_SYNCED,
+    BYTES_WRITTEN,
+    NUMBER_KEYS_WRITTEN,
+    WRITE_DONE_BY_OTHER,
+    WRITE_DONE_BY_SELF,
+    WRITE_WITH_WAL,
+    WRITE_STALL_MICROS,
+    INTERNAL_DB_STATS_ENUM_MAX,
+  };
+
+  // Per level compaction stats.  stats_[level] stores the stats for
+  // compactions that produced data for the specified "level".
+  struct CompactionStats {
+    uint64_t micros;
+
+    // Bytes read from level N during compaction between levels N and N+1
+    uint64_t bytes_readn;
+
+    // Bytes read from level N+1 during compaction between levels N and N+1
+    uint64_t bytes_readnp1;
+
+    // Total bytes written during compaction between levels N and N+1
+    uint64_t bytes_written;
+
+    // Files read from level N during compaction between levels N and N+1
+    int files_in_leveln;
+
+    // Files read from level N+1 during compaction between levels N and N+1
+    int files_in_levelnp1;
+
+    // Files written during compaction between levels N and N+1
+    int files_out_levelnp1;
+
+    // Number of compactions done
+    int count;
+
+    CompactionStats()
+        : micros(0),
+          bytes_readn(0),
+          bytes_readnp1(0),
+          bytes_written(0),
+          files_in_leveln(0),
+          files_in_levelnp1(0),
+          files_out_levelnp1(0),
+          count(0) {}
+
+    void Add(const CompactionStats &c) {
+      this->micros += c.micros;
+      this->bytes_readn += c.bytes_readn;
+      this->bytes_readnp1 += c.bytes_readnp1;
+      this->bytes_written += c.bytes_written;
+      this->files_in_leveln += c.files_in_leveln;
+      this->files_in_levelnp1 += c.files_in_levelnp1;
+      this->files_out_levelnp1 += c.files_out_levelnp1;
+      this->count += 1;
+    }
+  };
+
+  InternalStats(int num_levels, Env *env);
+
+  // No copying allowed
+  InternalStats(const InternalStats &) = delete;
+  void operator=(const InternalStats &) = delete;
+
+  // REQUIRES: DB mutex held
+  void AddCompactionStats(int level, const CompactionStats &stats) {
+    compaction_stats_[level].Add(stats);
+  }
+
+  void AddDBStats(InternalDBStatsType type, uint64_t value) {
+    db_stats_[type].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  uint64_t GetDBStats(InternalDBStatsType type) const {
+    return db_stats_[type].load(std::memory_order_relaxed);
+  }
+
+  // Gauges published by DBImpl.  Each setter replaces the previous value.
+  void SetActiveMemTableStats(uint64_t bytes, uint64_t entries,
+                              uint64_t deletes) {
+    active_mem_bytes_.store(bytes, std::memory_order_relaxed);
+    active_mem_entries_.store(entries, std::memory_order_relaxed);
+    active_mem_deletes_.store(deletes, std::memory_order_relaxed);
+  }
+  void SetImmutableMemTableStats(uint64_t count, uint64_t bytes,
+                                 uint64_t entries, uint64_t deletes) {
+    num_imm_mem_tables_.store(count, std::memory_order_relaxed);
+    imm_mem_bytes_.store(bytes, std::memory_order_relaxed);
+    imm_mem_entries_.store(entries, std::memory_order_relaxed);
+    imm_mem_deletes_.store(deletes, std::memory_order_relaxed);
+  }
+  // REQUIRES: DB mutex held, "current" is the newly installed version
+  void SetVersionStats(Version *current);
+  void SetBackgroundWork(bool flush_pending, bool compaction_pending) {
+    flush_pending_.store(flush_pending, std::memory_order_relaxed);
+    compaction_pending_.store(compaction_pending, std::memory_order_relaxed);
+  }
+  void SetNumSnapshots(uint64_t n) {
+    num_snapshots_.store(n, std::memory_order_relaxed);
+  }
+  void SetWriteStall(uint64_t delayed_write_rate, bool stopped) {
+    delayed_write_rate_.store(delayed_write_rate, std::memory_order_relaxed);
+    write_stopped_.store(stopped, std::memory_order_relaxed);
+  }
+  void IncBackgroundErrors() {
+    bg_errors_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Property handlers, see GetPropertyInfo().
+  // String handlers require the DB mutex, integer handlers marked
+  // need_out_of_mutex must not touch "current" (it is nullptr).
+  bool HandleNumFilesAtLevel(std::string *value, Slice suffix,
+                             Version *current);
+  bool HandleStats(std::string *value, Slice suffix, Version *current);
+  bool HandleSsTables(std::string *value, Slice suffix, Version *current);
+
+  bool HandleNumImmutableMemTable(uint64_t *value, Version *current);
+  bool HandleMemTableFlushPending(uint64_t *value, Version *current);
+  bool HandleCompactionPending(uint64_t *value, Version *current);
+  bool HandleBackgroundErrors(uint64_t *value, Version *current);
+  bool HandleCurSizeActiveMemTable(uint64_t *value, Version *current);
+  bool HandleCurSizeAllMemTables(uint64_t *value, Version *current);
+  bool HandleNumEntriesActiveMemTable(uint64_t *value, Version *current);
+  bool HandleNumEntriesImmMemTables(uint64_t *value, Version *current);
+  bool HandleEstimateNumKeys(uint64_t *value, Version *current);
+  bool HandleEstimatePendingCompactionBytes(uint64_t *value,
+                                            Version *current);
+  bool HandleTotalSstFilesSize(uint64_t *value, Version *current);
+  bool HandleNumSnapshots(uint64_t *value, Version *current);
+  bool HandleActualDelayedWriteRate(uint64_t *value, Version *current);
+  bool HandleIsWriteStopped(uint64_t *value, Version *current);
+
+private:
+  void DumpDBStats(std::string *value);
+
+  const int number_levels_;
+  Env *const env_;
+  const uint64_t started_at_;
+
+  // REQUIRES: DB mutex held
+  std::vector<CompactionStats> compaction_stats_;
+
+  std::atomic<uint64_t> db_stats_[INTERNAL_DB_STATS_ENUM_MAX];
+
+  // Values of db_stats_ at the previous "leveldb.stats" call, used to
+  // report the interval since then.
+  // REQUIRES: DB mutex held
+  struct DBStatsSnapshot {
+    uint64_t ingest_bytes = 0;
+    uint64_t num_keys_written = 0;
+    uint64_t write_other = 0;
+    uint64_t write_self = 0;
+    uint64_t write_with_wal = 0;
+    uint64_t wal_bytes = 0;
+    uint64_t wal_synced = 0;
+    uint64_t write_stall_micros = 0;
+    double seconds_up = 0;
+  } db_stats_snapshot_;
+
+  std::atomic<uint64_t> active_mem_bytes_;
+  std::atomic<uint64_t> active_mem_entries_;
+  std::atomic<uint64_t> active_mem_deletes_;
+  std::atomic<uint64_t> num_imm_mem_tables_;
+  std::atomic<uint64_t> imm_mem_bytes_;
+  std::atomic<uint64_t> imm_mem_entries_;
+  std::atomic<uint64_t> imm_mem_deletes_;
+  std::atomic<uint64_t> version_active_keys_;
+  std::atomic<uint64_t> pending_compaction_bytes_;
+  std::atomic<uint64_t> total_sst_bytes_;
+  std::atomic<uint64_t> num_snapshots_;
+  std::atomic<uint64_t> bg_errors_;
+  std::atomic<bool> flush_pending_;
+  std::atomic<bool> compaction_pending_;
+  std::atomic<uint64_t> delayed_write_rate_;
+  std::atomic<bool> write_stopped_;
+};
+
+} // namespace leveldb
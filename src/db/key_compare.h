@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Comparison functors for the hot search loops: SkipList, Block::Iter and
+// the merging iterator are templated on them, so that the common case of
+// a DB on BytewiseComparator() compiles to inline code instead of one or
+// two virtual calls per comparison.
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "comparator.h"
+#include "db/dbformat.h"
+#include "leveldb/slice.h"
+#include "port/port.h"
+
+namespace leveldb {
+
+// Same order as Slice::compare().  Compares the first 16 bytes inline as
+// big-endian words, which decides most comparisons of short keys without a
+// memcmp() call; memcmp() is faster past that.
+inline int BytewiseCompare(const Slice &a, const Slice &b) {
+  const size_t min_len = std::min(a.size(), b.size());
+  size_t i = 0;
+  for (; i < 16 && i + 8 <= min_len; i += 8) {
+    uint64_t x, y;
+    std::memcpy(&x, a.data() + i, sizeof(x));
+    std::memcpy(&y, b.data() + i, sizeof(y));
+    if (x != y) {
+      if (port::kLittleEndian) {
+        x = __builtin_bswap64(x);
+        y = __builtin_bswap64(y);
+      }
+      return x < y ? -1 : +1;
+    }
+  }
+  if (i < min_len) {
+    const int r = std::memcmp(a.data() + i, b.data() + i, min_len - i);
+    if (r != 0) { return r < 0 ? -1 : +1; }
+  }
+  if (a.size() != b.size()) { return a.size() < b.size() ? -1 : +1; }
+  return 0;
+}
+
+// BytewiseComparator()
+struct BytewiseKeyCompare {
+  int operator()(const Slice &a, const Slice &b) const {
+    return BytewiseCompare(a, b);
+  }
+};
+
+// InternalKeyComparator over BytewiseComparator()
+struct BytewiseInternalKeyCompare {
+  int operator()(const Slice &a, const Slice &b) const {
+    int r = BytewiseCompare(ExtractUserKey(a), ExtractUserKey(b));
+    if (r == 0) {
+      // Decreasing sequence number and type
+      const uint64_t anum = DecodeFixed64(a.data() + a.size() - 8);
+      const uint64_t bnum = DecodeFixed64(b.data() + b.size() - 8);
+      if (anum > bnum) {
+        r = -1;
+      } else if (anum < bnum) {
+        r = +1;
+      }
+    }
+    return r;
+  }
+};
+
+// Any other comparator, through its virtual Compare()
+struct VirtualKeyCompare {
+  const Comparator *comparator;
+
+  int operator()(const Slice &a, const Slice &b) const {
+    return comparator->Compare(a, b);
+  }
+};
+
+// Whether "comparator" orders keys like BytewiseInternalKeyCompare.
+inline bool IsBytewiseInternalKeyComparator(const Comparator *comparator) {
+  const InternalKeyComparator *icmp =
+      dynamic_cast<const InternalKeyComparator *>(comparator);
+  return icmp != nullptr && icmp->user_comparator() == BytewiseComparator();
+}
+
+// Returns f(compare) for the fastest functor that orders keys like
+// "comparator".  "f" is instantiated for every functor type, e.g.
+//
+//   return DispatchKeyCompare(comparator, [&](auto compare) -> Iterator * {
+//     return new Iter<decltype(compare)>(compare, ...);
+//   });
+template <typename Function>
+auto DispatchKeyCompare(const Comparator *comparator, Function &&f) {
+  if (comparator == BytewiseComparator()) { return f(BytewiseKeyCompare()); }
+  if (IsBytewiseInternalKeyComparator(comparator)) {
+    return f(BytewiseInternalKeyCompare());
+  }
+  return f(VirtualKeyCompare{comparator});
+}
+
+} // namespace leveldb
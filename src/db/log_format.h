@@ -0,0 +1,39 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Log format information shared by reader and writer.
+// A log file is a sequence of 32KB blocks.  Each block holds records of
+// the form
+//    checksum: uint32   // crc32c of type and data[] ; little-endian
+//    length: uint16     // little-endian
+//    type: uint8        // One of FULL, FIRST, MIDDLE, LAST
+//    data: uint8[length]
+// A record never starts within the last six bytes of a block (since it
+// won't fit); those bytes are zero-filled and skipped by readers.
+
+#pragma once
+
+namespace leveldb {
+namespace log {
+
+enum RecordType {
+  // Zero is reserved for preallocated files
+  kZeroType = 0,
+
+  kFullType = 1,
+
+  // For fragments
+  kFirstType = 2,
+  kMiddleType = 3,
+  kLastType = 4
+};
+static const int kMaxRecordType = kLastType;
+
+static const int kBlockSize = 32768;
+
+// Header is checksum (4 bytes), length (2 bytes), type (1 byte).
+static const int kHeaderSize = 4 + 2 + 1;
+
+}  // namespace log
+}  // namespace leveldb
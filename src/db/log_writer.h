@@ -0,0 +1,56 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "db/log_format.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class WritableFile;
+
+namespace log {
+
+class Writer {
+public:
+  // Create a writer that will append data to "*dest".
+  // "*dest" must be initially empty.
+  // If "manual_flush", records stay in the file's buffer until
+  // WriteBuffer() is called, rather than being flushed one by one.
+  explicit Writer(std::unique_ptr<WritableFile> &&dest,
+                  bool manual_flush = false);
+
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  ~Writer();
+
+  Status AddRecord(const Slice &slice);
+
+  // Hand buffered records to the OS.
+  Status WriteBuffer();
+
+  WritableFile *file() { return dest_.get(); }
+  const WritableFile *file() const { return dest_.get(); }
+
+private:
+  Status EmitPhysicalRecord(RecordType type, const char *ptr, size_t length);
+
+  std::unique_ptr<WritableFile> dest_;
+  int block_offset_;  // Current offset in block
+  const bool manual_flush_;
+
+  // crc32c values for all supported record types.  These are
+  // pre-computed to reduce the overhead of computing the crc of the
+  // record type stored in the header.
+  uint32_t type_crc_[kMaxRecordType + 1];
+};
+
+}  // namespace log
+}  // namespace leveldb
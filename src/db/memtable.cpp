@@ -0,0 +1,272 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "db/memtable.h"
+
+#include <cstring>
+
+#include "db/key_compare.h"
+#include "leveldb/write_buffer_manager.h"
+#include "util/coding.h"
+#include "util/perf_context_imp.h"
+
+namespace leveldb {
+
+static Slice GetLengthPrefixedSlice(const char *data) {
+  uint32_t len;
+  const char *p = data;
+  p = GetVarint32Ptr(p, p + 5, &len);  // +5: we assume "p" is not corrupted
+  return Slice(p, len);
+}
+
+MemTable::MemTable(const InternalKeyComparator &comparator,
+                   WriteBufferManager *write_buffer_manager)
+    : comparator_(comparator),
+      refs_(0),
+      write_buffer_manager_(write_buffer_manager),
+      reserved_memory_(0),
+      immutable_(false),
+      num_entries_(0),
+      num_deletes_(0),
+      flush_in_progress_(false),
+      flush_completed_(false),
+      file_number_(0),
+      first_seqno_(0),
+      mem_logfile_number_(0) {
+  if (comparator_.bytewise) {
+    prefix_table_.emplace(PrefixKeyComparator(comparator), &arena_);
+  } else {
+    table_.emplace(comparator_, &arena_);
+  }
+  UpdateWriteBufferManager();
+}
+
+MemTable::~MemTable() {
+  assert(refs_ == 0);
+  if (write_buffer_manager_ != nullptr) {
+    MarkImmutable();
+    write_buffer_manager_->FreeMem(reserved_memory_);
+  }
+}
+
+void MemTable::UpdateWriteBufferManager() {
+  if (write_buffer_manager_ == nullptr) { return; }
+  // Only the arena grows, and it does so a block at a time, so this is a
+  // cheap comparison for most entries.
+  // Concurrent writers race to report the same growth; whoever advances
+  // reserved_memory_ reports the difference.
+  const size_t usage = arena_.MemoryUsage();
+  size_t reserved = reserved_memory_.load(std::memory_order_relaxed);
+  while (usage > reserved) {
+    if (reserved_memory_.compare_exchange_weak(reserved, usage,
+                                               std::memory_order_relaxed)) {
+      write_buffer_manager_->ReserveMem(usage - reserved);
+      return;
+    }
+  }
+}
+
+void MemTable::MarkImmutable() {
+  if (immutable_) { return; }
+  immutable_ = true;
+  if (write_buffer_manager_ != nullptr) {
+    write_buffer_manager_->ScheduleFreeMem(reserved_memory_);
+  }
+}
+
+int MemTable::KeyComparator::operator()(const char *aptr,
+                                        const char *bptr) const {
+  // Internal keys are encoded as length-prefixed strings.
+  Slice a = GetLengthPrefixedSlice(aptr);
+  Slice b = GetLengthPrefixedSlice(bptr);
+  PERF_COUNTER_ADD(user_key_comparison_count, 1);
+  if (bytewise) { return BytewiseInternalKeyCompare()(a, b); }
+  return comparator.Compare(a, b);
+}
+
+uint64_t MemTable::PrefixKeyComparator::Prefix(const char *entry) const {
+  assert(bytewise);
+  const Slice user_key = ExtractUserKey(GetLengthPrefixedSlice(entry));
+  if (user_key.size() >= 8) {
+    return __builtin_bswap64(DecodeFixed64(user_key.data()));
+  }
+  uint64_t prefix = 0;
+  for (size_t i = 0; i < user_key.size(); i++) {
+    prefix |= static_cast<uint64_t>(static_cast<uint8_t>(user_key[i]))
+              << (56 - 8 * i);
+  }
+  return prefix;
+}
+
+// Encode a suitable internal key target for "target" and return it.
+// Uses *scratch as scratch space, and the returned pointer will point
+// into this scratch space.
+static const char *EncodeKey(std::string *scratch, const Slice &target) {
+  scratch->clear();
+  PutVarint32(scratch, target.size());
+  scratch->append(target.data(), target.size());
+  return scratch->data();
+}
+
+template <typename Table>
+class MemTableIterator : public Iterator {
+ public:
+  explicit MemTableIterator(Table *table) : iter_(table) {}
+
+  MemTableIterator(const MemTableIterator &) = delete;
+  MemTableIterator &operator=(const MemTableIterator &) = delete;
+
+  ~MemTableIterator() override = default;
+
+  bool Valid() const override { return iter_.Valid(); }
+  void Seek(const Slice &k) override {
+    PERF_TIMER_GUARD(seek_on_memtable_time);
+    PERF_COUNTER_ADD(seek_on_memtable_count, 1);
+    iter_.Seek(EncodeKey(&tmp_, k));
+  }
+  void SeekToFirst() override { iter_.SeekToFirst(); }
+  void SeekToLast() override { iter_.SeekToLast(); }
+  void Next() override {
+    PERF_COUNTER_ADD(next_on_memtable_count, 1);
+    iter_.Next();
+  }
+  void Prev() override { iter_.Prev(); }
+  Slice key() const override { return GetLengthPrefixedSlice(iter_.key()); }
+  Slice value() const override {
+    Slice key_slice = GetLengthPrefixedSlice(iter_.key());
+    return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
+  }
+
+  Status status() const override { return Status::OK(); }
+
+ private:
+  typename Table::Iterator iter_;
+  std::string tmp_;  // For passing to EncodeKey
+};
+
+Iterator *MemTable::NewIterator() {
+  if (prefix_table_) {
+    return new MemTableIterator<PrefixTable>(&*prefix_table_);
+  }
+  return new MemTableIterator<Table>(&*table_);
+}
+
+void MemTable::Add(SequenceNumber s, ValueType type, const Slice &key,
+                   const Slice &value, bool allow_concurrent) {
+  // Format of an entry is concatenation of:
+  //  key_size     : varint32 of internal_key.size()
+  //  key bytes    : char[internal_key.size()]
+  //  tag          : uint64((sequence << 8) | type)
+  //  value_size   : varint32 of value.size()
+  //  value bytes  : char[value.size()]
+  size_t key_size = key.size();
+  size_t val_size = value.size();
+  size_t internal_key_size = key_size + 8;
+  const size_t encoded_len = VarintLength(internal_key_size) +
+                             internal_key_size + VarintLength(val_size) +
+                             val_size;
+  auto encode = [&](char *buf) -> const char * {
+    char *p = EncodeVarint32(buf, internal_key_size);
+    std::memcpy(p, key.data(), key_size);
+    p += key_size;
+    EncodeFixed64(p, (s << 8) | type);
+    p += 8;
+    p = EncodeVarint32(p, val_size);
+    std::memcpy(p, value.data(), val_size);
+    assert(p + val_size == buf + encoded_len);
+    return buf;
+  };
+  if (allow_concurrent) {
+    // The entry goes in the same arena allocation as its skiplist node
+    if (prefix_table_) {
+      prefix_table_->InsertConcurrently(encoded_len, encode);
+    } else {
+      table_->InsertConcurrently(encoded_len, encode);
+    }
+    UpdateWriteBufferManager();
+    num_entries_.fetch_add(1, std::memory_order_relaxed);
+    if (type == kTypeDeletion) {
+      num_deletes_.fetch_add(1, std::memory_order_relaxed);
+    }
+    SequenceNumber first = first_seqno_.load(std::memory_order_relaxed);
+    while ((first == 0 || s < first) &&
+           !first_seqno_.compare_exchange_weak(first, s,
+                                               std::memory_order_relaxed)) {
+    }
+    return;
+  }
+
+  const char *buf = encode(arena_.Allocate(encoded_len));
+  if (prefix_table_) {
+    prefix_table_->Insert(buf);
+  } else {
+    table_->Insert(buf);
+  }
+  UpdateWriteBufferManager();
+
+  num_entries_.store(num_entries_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+  if (type == kTypeDeletion) {
+    num_deletes_.store(num_deletes_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+  }
+
+  // The first sequence number inserted into the memtable
+  const SequenceNumber first = first_seqno_.load(std::memory_order_relaxed);
+  assert(first == 0 || s > first);
+  if (first == 0) { first_seqno_.store(s, std::memory_order_relaxed); }
+}
+
+bool MemTable::Get(const LookupKey &key, std::string *value, Status *s) {
+  Slice memkey = key.memtable_key();
+  const char *entry = nullptr;
+  if (prefix_table_) {
+    PrefixTable::Iterator iter(&*prefix_table_);
+    iter.Seek(memkey.data());
+    if (iter.Valid()) { entry = iter.key(); }
+  } else {
+    Table::Iterator iter(&*table_);
+    iter.Seek(memkey.data());
+    if (iter.Valid()) { entry = iter.key(); }
+  }
+  if (entry != nullptr) {
+    // entry format is:
+    //    klength  varint32
+    //    userkey  char[klength]
+    //    tag      uint64
+    //    vlength  varint32
+    //    value    char[vlength]
+    // Check that it belongs to same user key.  We do not check the
+    // sequence number since the Seek() call above should have skipped
+    // all entries with overly large sequence numbers.
+    uint32_t key_length;
+    const char *key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+    const Slice user_key(key_ptr, key_length - 8);
+    PERF_COUNTER_ADD(user_key_comparison_count, 1);
+    const int r = comparator_.bytewise
+                      ? BytewiseCompare(user_key, key.user_key())
+                      : comparator_.comparator.user_comparator()->Compare(
+                            user_key, key.user_key());
+    if (r == 0) {
+      // Correct user key
+      const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+      switch (static_cast<ValueType>(tag & 0xff)) {
+        case kTypeValue: {
+          Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
+          value->assign(v.data(), v.size());
+          return true;
+        }
+        case kTypeDeletion:
+          *s = Status::NotFound(Slice());
+          return true;
+        case kTypeMerge:
+          *s = Status::NotSupported("merge operator not implemented");
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace leveldb
@@ -4,30 +4,155 @@
 
 #pragma once
 
+#include <atomic>
+#include <optional>
+#include <string>
+
+#include "db/dbformat.h"
+#include "db/skiplist.h"
+#include "leveldb/iterator.h"
 #include "leveldb/types.h"
 #include "util/arena.h"
 namespace leveldb {
 
+template <typename Table> class MemTableIterator;
+class WriteBufferManager;
+
 class MemTable {
 public:
+  // MemTables are reference counted.  The initial reference count
+  // is zero and the caller must call Ref() at least once.
+  // If "write_buffer_manager" is non-null, arena memory is accounted there
+  // until the memtable is deleted.
+  explicit MemTable(const InternalKeyComparator &comparator,
+                    WriteBufferManager *write_buffer_manager = nullptr);
+
   // No copying allowed
   MemTable(const MemTable &) = delete;
   void operator=(const MemTable &) = delete;
 
+  // Increase reference count.
+  void Ref() { ++refs_; }
+
+  // Drop reference count.  Delete if no more references exist.
+  void Unref() {
+    --refs_;
+    assert(refs_ >= 0);
+    if (refs_ <= 0) { delete this; }
+  }
+
+  // Returns an estimate of the number of bytes of data in use by this
+  // data structure. It is safe to call when MemTable is being modified.
+  size_t ApproximateMemoryUsage() const { return arena_.MemoryUsage(); }
+
+  // Return an iterator that yields the contents of the memtable.
+  //
+  // The caller must ensure that the underlying MemTable remains live
+  // while the returned iterator is live.  The keys returned by this
+  // iterator are internal keys encoded by AppendInternalKey in the
+  // db/dbformat.{h,cpp} module.
+  Iterator *NewIterator();
+
+  // Add an entry into memtable that maps key to value at the
+  // specified sequence number and with the specified type.
+  // Typically value will be empty if type==kTypeDeletion.
+  // If "allow_concurrent", other threads may be adding entries at the same
+  // time, and entries need not arrive in sequence order; a memtable must
+  // be written either always or never this way.
+  void Add(SequenceNumber seq, ValueType type, const Slice &key,
+           const Slice &value, bool allow_concurrent = false);
+
+  // If memtable contains a value for key, store it in *value and return true.
+  // If memtable contains a deletion for key, store a NotFound() error
+  // in *status and return true.
+  // If memtable contains a merge operand for key, store a NotSupported()
+  // error in *status and return true; merge operators are not implemented.
+  // Else, return false.
+  bool Get(const LookupKey &key, std::string *value, Status *s);
+
+  // Number of entries and of deletion markers added so far.  Safe to call
+  // when MemTable is being modified.
+  uint64_t num_entries() const {
+    return num_entries_.load(std::memory_order_relaxed);
+  }
+  uint64_t num_deletes() const {
+    return num_deletes_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the sequence number of the first element that was inserted
+  // into the memtable, or 0 if it is empty.
+  SequenceNumber GetFirstSequenceNumber() const {
+    return first_seqno_.load(std::memory_order_relaxed);
+  }
+
+  // Log files older than this number are not needed once this memtable
+  // has been flushed.
+  uint64_t GetLogNumber() const { return mem_logfile_number_; }
+  void SetLogNumber(uint64_t num) { mem_logfile_number_ = num; }
+
+  // Called once no more entries will be added, i.e. when the memtable is
+  // switched out for a new one.  Its memory stops counting as mutable in
+  // the write buffer manager.
+  void MarkImmutable();
+
 private:
+  template <typename Table> friend class MemTableIterator;
+  friend class MemTableList;
+
   // Private since only Unref() should be used to delete it
   ~MemTable();
+
+  // Report arena growth since the last call to write_buffer_manager_.
+  void UpdateWriteBufferManager();
+
+  struct KeyComparator {
+    const InternalKeyComparator comparator;
+    // Whether the user comparator is BytewiseComparator(), in which case
+    // keys are compared inline rather than through virtual calls.  MemTable
+    // is not a template, so the skiplist branches on this instead; the
+    // branch always goes the same way.
+    const bool bytewise;
+    explicit KeyComparator(const InternalKeyComparator &c)
+        : comparator(c),
+          bytewise(c.user_comparator() == BytewiseComparator()) {}
+    int operator()(const char *a, const char *b) const;
+  };
+
+  // KeyComparator that also gives the skiplist a prefix to cache in its
+  // nodes.  Only valid for the bytewise user comparator, whose order the
+  // prefix follows; other comparators get a skiplist without the prefix.
+  struct PrefixKeyComparator : public KeyComparator {
+    using KeyComparator::KeyComparator;
+    // First 8 bytes of the user key as a big-endian integer, zero-padded,
+    // so the skiplist can order most nodes without touching their keys.
+    uint64_t Prefix(const char *entry) const;
+  };
+
+  typedef SkipList<const char *, KeyComparator> Table;
+  typedef SkipList<const char *, PrefixKeyComparator> PrefixTable;
+
+  KeyComparator comparator_;
   int refs_;
   Arena arena_;
+  // Exactly one of the two is set, prefix_table_ if comparator_.bytewise
+  std::optional<Table> table_;
+  std::optional<PrefixTable> prefix_table_;
+  WriteBufferManager *const write_buffer_manager_;
+  // Arena usage reported to write_buffer_manager_ so far
+  std::atomic<size_t> reserved_memory_;
+  bool immutable_;
+  std::atomic<uint64_t> num_entries_;
+  std::atomic<uint64_t> num_deletes_;
   // These are used to manage memtable flushes to storage
   bool flush_in_progress_; // started the flush
   bool flush_completed_;   // finished the flush
   uint64_t file_number_;   // filled up after flush is complete
 
-  // The sequence number of the kv that was inserted first
-  SequenceNumber first_seqno_;
+  // The smallest sequence number inserted, which is the first one unless
+  // entries were added concurrently
+  std::atomic<SequenceNumber> first_seqno_;
   // The log files earlier than this number can be deleted.
   uint64_t mem_logfile_number_;
 };
 
-} // namespace leveldb
\ No newline at end of file
+} // namespace leveldb
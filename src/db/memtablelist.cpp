@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "db/memtablelist.h"
+
+#include <cassert>
+
+#include "db/memtable.h"
+
+namespace leveldb {
+
+void MemTableList::Add(MemTable *m) {
+  m->Ref();
+  memlist_.push_front(m);
+}
+
+bool MemTableList::IsFlushPending() const {
+  for (const MemTable *m : memlist_) {
+    if (!m->flush_in_progress_) { return true; }
+  }
+  return false;
+}
+
+MemTable *MemTableList::PickMemtableToFlush() {
+  if (memlist_.empty()) { return nullptr; }
+  MemTable *m = memlist_.back();
+  if (m->flush_in_progress_) { return nullptr; }
+  assert(!m->flush_completed_);
+  m->flush_in_progress_ = true;
+  return m;
+}
+
+void MemTableList::RollbackMemtableFlush(MemTable *m) {
+  assert(m->flush_in_progress_);
+  assert(!m->flush_completed_);
+  m->flush_in_progress_ = false;
+  m->file_number_ = 0;
+}
+
+void MemTableList::RemoveFlushed(MemTable *m, uint64_t file_number) {
+  assert(!memlist_.empty() && memlist_.back() == m);
+  m->flush_completed_ = true;
+  m->file_number_ = file_number;
+  memlist_.pop_back();
+  m->Unref();
+}
+
+void MemTableList::GetMemTables(std::vector<MemTable *> *output) const {
+  for (MemTable *m : memlist_) { output->push_back(m); }
+}
+
+uint64_t MemTableList::ApproximateMemoryUsage() const {
+  uint64_t size = 0;
+  for (const MemTable *m : memlist_) { size += m->ApproximateMemoryUsage(); }
+  return size;
+}
+
+uint64_t MemTableList::NumEntries() const {
+  uint64_t total = 0;
+  for (const MemTable *m : memlist_) { total += m->num_entries(); }
+  return total;
+}
+
+uint64_t MemTableList::NumDeletes() const {
+  uint64_t total = 0;
+  for (const MemTable *m : memlist_) { total += m->num_deletes(); }
+  return total;
+}
+
+void MemTableList::UnrefAll() {
+  for (MemTable *m : memlist_) { m->Unref(); }
+  memlist_.clear();
+}
+
+} // namespace leveldb
@@ -4,8 +4,60 @@
 
 #pragma once
 
+#include <cstdint>
+#include <list>
+#include <vector>
+
 namespace leveldb {
 
-class MemTableList {};
+class MemTable;
+
+// The list of immutable memtables waiting to be flushed to level 0,
+// newest first.  Flushes complete oldest first so that the log number
+// recorded in the manifest only ever moves forward.
+//
+// REQUIRES: every method is called with the DB mutex held.
+class MemTableList {
+public:
+  MemTableList() = default;
+
+  // No copying allowed
+  MemTableList(const MemTableList &) = delete;
+  void operator=(const MemTableList &) = delete;
+
+  int size() const { return static_cast<int>(memlist_.size()); }
+
+  // Takes a reference on "m" and makes it the newest immutable memtable.
+  void Add(MemTable *m);
+
+  // True if some memtable has not been picked for a flush yet.
+  bool IsFlushPending() const;
+
+  // Returns the oldest memtable and marks it as being flushed, or
+  // nullptr if there is nothing to flush or the oldest one is already
+  // being flushed.
+  MemTable *PickMemtableToFlush();
+
+  // The flush of "m" failed; make it available to the next flush.
+  void RollbackMemtableFlush(MemTable *m);
+
+  // "m" has been written to table file "file_number" and recorded in the
+  // manifest; drop it from the list and release our reference.
+  void RemoveFlushed(MemTable *m, uint64_t file_number);
+
+  // Appends all immutable memtables to *output, newest first.
+  void GetMemTables(std::vector<MemTable *> *output) const;
+
+  // Totals over all immutable memtables.
+  uint64_t ApproximateMemoryUsage() const;
+  uint64_t NumEntries() const;
+  uint64_t NumDeletes() const;
+
+  // Releases the references on all memtables.
+  void UnrefAll();
+
+private:
+  std::list<MemTable *> memlist_;
+};
 
 } // namespace leveldb
@@ -5,10 +5,11 @@
 // Thread safety
 // -------------
 //
-// Writes require external synchronization, most likely a mutex.
-// Reads require a guarantee that the SkipList will not be destroyed
-// while the read is in progress.  Apart from that, reads progress
-// without any internal locking or synchronization.
+// Writes require external synchronization, most likely a mutex, unless
+// they all go through InsertConcurrently().  Reads require a guarantee
+// that the SkipList will not be destroyed while the read is in progress.
+// Apart from that, reads progress without any internal locking or
+// synchronization.
 //
 // Invariants:
 //
@@ -18,9 +19,9 @@
 //
 // (2) The contents of a Node except for the next/prev pointers are
 // immutable after the Node has been linked into the SkipList.
-// Only Insert() modifies the list, and it is careful to initialize
-// a node and use release-stores to publish the nodes in one or
-// more lists.
+// Only Insert() and InsertConcurrently() modify the list, and they are
+// careful to initialize a node and use release-stores to publish the
+// nodes in one or more lists.
 //
 // ... prev vs. next pointer ordering ...
 //
@@ -28,7 +29,12 @@
 #pragma once
 
 #include <cassert>
+#include <concepts>
+#include <cstdint>
 #include <cstdlib>
+#include <functional>
+#include <thread>
+#include <type_traits>
 
 #include "port/atomic_pointer.h"
 #include "util/arena.h"
@@ -38,24 +44,108 @@ namespace leveldb {
 
 class Arena;
 
+// Optional comparator extension: "cmp.Prefix(key)" returns a normalized
+// 64-bit prefix of key such that Prefix(a) < Prefix(b) implies a < b.  When
+// the comparator has it, every node stores the prefix of its key next to
+// its links and searches compare prefixes first, calling the comparator
+// (and touching the key's memory) only when they are equal.
+template <typename Key, class Comparator>
+concept PrefixComparator = requires(const Comparator &cmp, const Key &key) {
+  { cmp.Prefix(key) } -> std::same_as<uint64_t>;
+};
+
 template <typename Key, class Comparator>
 class SkipList {
  private:
   struct Node;
 
+  static constexpr bool kCachePrefix = PrefixComparator<Key, Comparator>;
+
  public:
+  // Create a new SkipList object that will use "cmp" for comparing keys,
+  // and will allocate memory using "*arena".  Objects allocated in the arena
+  // must remain allocated for the lifetime of the skiplist object.
   explicit SkipList(Comparator cmp, Arena* arena);
+
+  // Insert key into the list.
+  // REQUIRES: nothing that compares equal to key is currently in the list.
   void Insert(const Key& key);
-  bool Contains(const Key& key);
+
+  // Like Insert(), but safe to call from several threads at once.  Links
+  // the new node with a compare-and-swap at each level, and allocates it
+  // with Arena::AllocateAlignedConcurrently().
+  // REQUIRES: the list is never written with Insert(), whose sequential
+  // insert hint concurrent inserts would invalidate.
+  void InsertConcurrently(const Key& key);
+
+  // Same as InsertConcurrently(key), but allocates "key_size" bytes along
+  // with the node, in the same arena call, for "encode(buf)" to fill and
+  // return the key that points into them.
+  template <typename EncodeKey>
+  void InsertConcurrently(size_t key_size, const EncodeKey& encode);
+
+  // Returns true iff an entry that compares equal to key is in the list.
+  bool Contains(const Key& key) const;
+
+  // Iteration over the contents of a skip list
+  class Iterator {
+   public:
+    // Initialize an iterator over the specified list.
+    // The returned iterator is not valid.
+    explicit Iterator(const SkipList* list);
+
+    // Returns true iff the iterator is positioned at a valid node.
+    bool Valid() const;
+
+    // Returns the key at the current position.
+    // REQUIRES: Valid()
+    const Key& key() const;
+
+    // Advances to the next position.
+    // REQUIRES: Valid()
+    void Next();
+
+    // Advances to the previous position.
+    // REQUIRES: Valid()
+    void Prev();
+
+    // Advance to the first entry with a key >= target
+    void Seek(const Key& target);
+
+    // Position at the first entry in list.
+    // Final state of iterator is Valid() iff list is not empty.
+    void SeekToFirst();
+
+    // Position at the last entry in list.
+    // Final state of iterator is Valid() iff list is not empty.
+    void SeekToLast();
+
+   private:
+    const SkipList* list_;
+    Node* node_;
+    // Intentionally copyable
+  };
 
  private:
   enum { kMaxHeight = 12 };
+
+  // Immutable after construction
   Comparator const compare_;
-  Arena* const arena_;
+  Arena* const arena_;  // Arena used for allocations of nodes
+
   Node* const head_;
-  port::AtomicPointer max_height_;
-  // what is this
+
+  // Modified only by Insert().  Read racily by readers, but stale
+  // values are ok.
+  port::AtomicPointer max_height_;  // Height of the entire list
+
+  // Used for optimizing sequential insert patterns.  Outside of Insert(),
+  // prev_[0] is the last inserted node and prev_[1..prev_height_-1] are its
+  // predecessors at the levels it is linked into.
   Node* prev_[kMaxHeight];
+  int prev_height_;
+
+  // Read/written only by Insert().
   Random rnd_;
 
   inline int GetMaxHeight() const {
@@ -63,27 +153,76 @@ class SkipList {
         reinterpret_cast<intptr_t>(max_height_.NoBarrier_Load()));
   }
 
-  Node* NewNode(const Key& key, int height);
-  int RandomHeight();
+  Node* NewNode(const Key& key, uint64_t prefix, int height);
+  int RandomHeight(Random* rnd);
   bool Equal(const Key& a, const Key& b) const { return (compare_(a, b) == 0); }
-  bool KeyIsAfterNode(const Key& key, Node* n) const;
-  Node* FindGreatOrEqual(const Key& key, Node** prev) const;
+
+  // Normalized prefix of key, or 0 if the comparator has none
+  uint64_t PrefixOf(const Key& key) const {
+    if constexpr (kCachePrefix) {
+      return compare_.Prefix(key);
+    } else {
+      return 0;
+    }
+  }
+
+  // Same as compare_(n->key, key), where prefix == PrefixOf(key)
+  int CompareNode(Node* n, const Key& key, uint64_t prefix) const;
+
+  // Return true if key is greater than the data stored in "n"
+  bool KeyIsAfterNode(const Key& key, uint64_t prefix, Node* n) const;
+
+  // Return the earliest node that comes at or after key.
+  // Return nullptr if there is no such node.
+  //
+  // If prev is non-null, fills prev[level] with pointer to previous
+  // node at "level" for every level in [0..max_height_-1].
+  Node* FindGreaterOrEqual(const Key& key, uint64_t prefix,
+                           Node** prev) const;
+
+  // Starting at "before", which is before key, find the nodes at "level"
+  // between which key belongs.
+  void FindSpliceForLevel(const Key& key, uint64_t prefix, Node* before,
+                          int level, Node** out_prev, Node** out_next) const;
+
+  // Return the latest node with a key < key.
+  // Return head_ if there is no such node.
   Node* FindLessThan(const Key& key) const;
+
+  // Return the last node in the list.
+  // Return head_ if list is empty.
   Node* FindLast() const;
 };
 
+// Implementation details follow
 template <typename Key, class Comparator>
 struct SkipList<Key, Comparator>::Node {
-  explicit Node(const Key& k) : key(k) {}
+  struct NoPrefix {};
+
+  Node(const Key& k, uint64_t prefix) : key(k) {
+    if constexpr (kCachePrefix) { key_prefix = prefix; }
+  }
+
   Key const key;
+  [[no_unique_address]] std::conditional_t<kCachePrefix, uint64_t, NoPrefix>
+      key_prefix;
+
+  // Accessors/mutators for links.  Wrapped in methods so we can
+  // add the appropriate barriers as necessary.
   Node* Next(int n) {
     assert(n >= 0);
+    // Use an 'acquire load' so that we observe a fully initialized
+    // version of the returned Node.
     return reinterpret_cast<Node*>(next_[n].Acquire_Load());
   }
   void SetNext(int n, Node* x) {
     assert(n >= 0);
+    // Use a 'release store' so that anybody who reads through this
+    // pointer observes a fully initialized version of the inserted node.
     next_[n].Release_Store(x);
   }
+
+  // No-barrier variants that can be safely used in a few locations.
   Node* NoBarrier_Next(int n) {
     assert(n >= 0);
     return reinterpret_cast<Node*>(next_[n].NoBarrier_Load());
@@ -93,95 +232,118 @@ struct SkipList<Key, Comparator>::Node {
     next_[n].NoBarrier_Store(x);
   }
 
+  // Links "x" if the link is still "expected", with the same barrier as
+  // SetNext().
+  bool CASNext(int n, Node* expected, Node* x) {
+    assert(n >= 0);
+    return next_[n].CompareAndSwap(expected, x);
+  }
+
  private:
+  // Array of length equal to the node height.  next_[0] is lowest level link.
   port::AtomicPointer next_[1];
 };
 
 template <typename Key, class Comparator>
-SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena)
-    : compare_(cmp),
-      arena_(arena),
-      head_(NewNode(0, kMaxHeight)),
-      max_height_(reinterpret_cast<void*>(1)),
-      rnd_(0xdeadbeef) {
-  for (int i = 0; i < kMaxHeight; i++) {
-    head_->SetNext(i, nullptr);
-    prev_[i] = head_;
-  }
+typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::NewNode(
+    const Key& key, uint64_t prefix, int height) {
+  char* mem = arena_->AllocateAligned(
+      sizeof(Node) + sizeof(port::AtomicPointer) * (height - 1));
+  return new (mem) Node(key, prefix);
 }
 
 template <typename Key, class Comparator>
-void SkipList<Key, Comparator>::Insert(const Key& key) {
-  Node* x = FindGreatOrEqual(key, prev_);
-  int height = RandomHeight();
-  if (height > GetMaxHeight()) {
-    // 补充
-    for (int i = GetMaxHeight(); i < height; i++) { prev_[i] = head_; }
-    max_height_.NoBarrier_Store(reinterpret_cast<void*>(height));
-  }
-  x = NewNode(key, height);
-  for (int i = 0; i < height; i++) {
-    x->NoBarrier_Next(prev_[i]->NoBarrier_Next(i));
-    prev_[i]->SetNext(i, x);
-  }
-  prev_[0] = x;
+inline SkipList<Key, Comparator>::Iterator::Iterator(const SkipList* list) {
+  list_ = list;
+  node_ = nullptr;
 }
+
 template <typename Key, class Comparator>
-bool SkipList<Key, Comparator>::Contains(const Key& key) {
-  Node* x = FindGreatOrEqual(key, nullptr);
-  if (x != nullptr && Equal(key, x->key)) {
-    return true;
-  } else {
-    return false;
-  }
+inline bool SkipList<Key, Comparator>::Iterator::Valid() const {
+  return node_ != nullptr;
 }
 
 template <typename Key, class Comparator>
-SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::SkipList::NewNode(
-    const Key& key, int height) {
-  char* mem = arena_->AllocateAligned(
-      // Node contain one
-      sizeof(Node) + sizeof(port ::AtomicPointer) * (height - 1));
-  return new (mem) Node(key);
+inline const Key& SkipList<Key, Comparator>::Iterator::key() const {
+  assert(Valid());
+  return node_->key;
+}
+
+template <typename Key, class Comparator>
+inline void SkipList<Key, Comparator>::Iterator::Next() {
+  assert(Valid());
+  node_ = node_->Next(0);
+}
+
+template <typename Key, class Comparator>
+inline void SkipList<Key, Comparator>::Iterator::Prev() {
+  // Instead of using explicit "prev" links, we just search for the
+  // last node that falls before key.
+  assert(Valid());
+  node_ = list_->FindLessThan(node_->key);
+  if (node_ == list_->head_) { node_ = nullptr; }
+}
+
+template <typename Key, class Comparator>
+inline void SkipList<Key, Comparator>::Iterator::Seek(const Key& target) {
+  node_ = list_->FindGreaterOrEqual(target, list_->PrefixOf(target), nullptr);
+}
+
+template <typename Key, class Comparator>
+inline void SkipList<Key, Comparator>::Iterator::SeekToFirst() {
+  node_ = list_->head_->Next(0);
+}
+
+template <typename Key, class Comparator>
+inline void SkipList<Key, Comparator>::Iterator::SeekToLast() {
+  node_ = list_->FindLast();
+  if (node_ == list_->head_) { node_ = nullptr; }
 }
 
 template <typename Key, class Comparator>
-int SkipList<Key, Comparator>::RandomHeight() {
+int SkipList<Key, Comparator>::RandomHeight(Random* rnd) {
+  // Increase height with probability 1 in kBranching
   static const unsigned int kBranching = 4;
   int height = 1;
-  while (height < kMaxHeight && ((rnd_.Next() & kBranching) == 0)) { height++; }
+  while (height < kMaxHeight && ((rnd->Next() % kBranching) == 0)) { height++; }
   assert(height > 0);
   assert(height <= kMaxHeight);
   return height;
 }
 
 template <typename Key, class Comparator>
-bool SkipList<Key, Comparator>::KeyIsAfterNode(const Key& key, Node* n) const {
-  // n->key , key
-  return (n != nullptr) && (compare_(n->key, key) < 0);
+inline int SkipList<Key, Comparator>::CompareNode(Node* n, const Key& key,
+                                                  uint64_t prefix) const {
+  if constexpr (kCachePrefix) {
+    if (n->key_prefix != prefix) { return n->key_prefix < prefix ? -1 : +1; }
+  }
+  return compare_(n->key, key);
 }
+
 template <typename Key, class Comparator>
-SkipList<Key, Comparator>::Node*
-SkipList<Key, Comparator>::SkipList::FindGreatOrEqual(const Key& key,
-                                                      Node** prev) const {
-  if (prev && !KeyIsAfterNode(key, prev[0]->Next(0))) {
-    Node* x = prev[0];
-    Node* next = x->Next(0);
-    if ((x == head_) || KeyIsAfterNode(key, x)) { return next; }
-  }
-  // Normal
+bool SkipList<Key, Comparator>::KeyIsAfterNode(const Key& key, uint64_t prefix,
+                                               Node* n) const {
+  // nullptr n is considered infinite
+  return (n != nullptr) && (CompareNode(n, key, prefix) < 0);
+}
+
+template <typename Key, class Comparator>
+typename SkipList<Key, Comparator>::Node*
+SkipList<Key, Comparator>::FindGreaterOrEqual(const Key& key, uint64_t prefix,
+                                              Node** prev) const {
   Node* x = head_;
   int level = GetMaxHeight() - 1;
   while (true) {
     Node* next = x->Next(level);
-    if (KeyIsAfterNode(key, next)) {
+    if (KeyIsAfterNode(key, prefix, next)) {
+      // Keep searching in this list
       x = next;
     } else {
-      // why this
       if (prev != nullptr) prev[level] = x;
       if (level == 0) {
         return next;
       } else {
+        // Switch to next list
         level--;
       }
     }
@@ -189,17 +351,36 @@ SkipList<Key, Comparator>::SkipList::FindGreatOrEqual(const Key& key,
 }
 
 template <typename Key, class Comparator>
-SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLessThan(
-    const Key& key) const {
+void SkipList<Key, Comparator>::FindSpliceForLevel(const Key& key,
+                                                   uint64_t prefix,
+                                                   Node* before, int level,
+                                                   Node** out_prev,
+                                                   Node** out_next) const {
+  while (true) {
+    Node* next = before->Next(level);
+    if (!KeyIsAfterNode(key, prefix, next)) {
+      *out_prev = before;
+      *out_next = next;
+      return;
+    }
+    before = next;
+  }
+}
+
+template <typename Key, class Comparator>
+typename SkipList<Key, Comparator>::Node*
+SkipList<Key, Comparator>::FindLessThan(const Key& key) const {
+  const uint64_t prefix = PrefixOf(key);
   Node* x = head_;
   int level = GetMaxHeight() - 1;
   while (true) {
     assert(x == head_ || compare_(x->key, key) < 0);
     Node* next = x->Next(level);
-    if (next == nullptr || compare_(next->key, key) >= 0) {
+    if (next == nullptr || CompareNode(next, key, prefix) >= 0) {
       if (level == 0) {
         return x;
       } else {
+        // Switch to next list
         level--;
       }
     } else {
@@ -209,7 +390,8 @@ SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLessThan(
 }
 
 template <typename Key, class Comparator>
-SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast() const {
+typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast()
+    const {
   Node* x = head_;
   int level = GetMaxHeight() - 1;
   while (true) {
@@ -218,6 +400,7 @@ SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast() const {
       if (level == 0) {
         return x;
       } else {
+        // Switch to next list
         level--;
       }
     } else {
@@ -226,4 +409,133 @@ SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast() const {
   }
 }
 
+template <typename Key, class Comparator>
+SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena)
+    : compare_(cmp),
+      arena_(arena),
+      head_(NewNode(0 /* any key will do */, 0, kMaxHeight)),
+      max_height_(reinterpret_cast<void*>(1)),
+      prev_height_(1),
+      rnd_(0xdeadbeef) {
+  for (int i = 0; i < kMaxHeight; i++) {
+    head_->SetNext(i, nullptr);
+    prev_[i] = head_;
+  }
+}
+
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::Insert(const Key& key) {
+  const uint64_t prefix = PrefixOf(key);
+
+  // Fast path for sequential insertion: if key lands right after the last
+  // inserted node, prev_ already holds every predecessor we need.
+  if (!KeyIsAfterNode(key, prefix, prev_[0]->NoBarrier_Next(0)) &&
+      (prev_[0] == head_ || KeyIsAfterNode(key, prefix, prev_[0]))) {
+    assert(prev_[0] != head_ || (prev_height_ == 1 && GetMaxHeight() == 1));
+
+    // Outside of Insert prev_[1..prev_height_-1] are the predecessors of
+    // prev_[0]; inside, prev_[0..max_height-1] are the predecessors of key.
+    for (int i = 1; i < prev_height_; i++) { prev_[i] = prev_[0]; }
+  } else {
+    FindGreaterOrEqual(key, prefix, prev_);
+  }
+
+  // Our data structure does not allow duplicate insertion
+  assert(prev_[0]->Next(0) == nullptr || !Equal(key, prev_[0]->Next(0)->key));
+
+  int height = RandomHeight(&rnd_);
+  if (height > GetMaxHeight()) {
+    for (int i = GetMaxHeight(); i < height; i++) { prev_[i] = head_; }
+
+    // It is ok to mutate max_height_ without any synchronization
+    // with concurrent readers.  A concurrent reader that observes
+    // the new value of max_height_ will see either the old value of
+    // new level pointers from head_ (nullptr), or a new value set in
+    // the loop below.  In the former case the reader will
+    // immediately drop to the next level since nullptr sorts after all
+    // keys.  In the latter case the reader will use the new node.
+    max_height_.NoBarrier_Store(reinterpret_cast<void*>(height));
+  }
+
+  Node* x = NewNode(key, prefix, height);
+  for (int i = 0; i < height; i++) {
+    // NoBarrier_SetNext() suffices since we will add a barrier when
+    // we publish a pointer to "x" in prev[i].
+    x->NoBarrier_SetNext(i, prev_[i]->NoBarrier_Next(i));
+    prev_[i]->SetNext(i, x);
+  }
+  prev_[0] = x;
+  prev_height_ = height;
+}
+
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::InsertConcurrently(const Key& key) {
+  InsertConcurrently(0, [&key](char*) { return key; });
+}
+
+template <typename Key, class Comparator>
+template <typename EncodeKey>
+void SkipList<Key, Comparator>::InsertConcurrently(size_t key_size,
+                                                   const EncodeKey& encode) {
+  // rnd_ belongs to Insert(); each thread draws heights from its own.
+  static thread_local Random rnd(
+      static_cast<uint32_t>(
+          std::hash<std::thread::id>()(std::this_thread::get_id())) |
+      1);
+  const int height = RandomHeight(&rnd);
+  const size_t node_size =
+      sizeof(Node) + sizeof(port::AtomicPointer) * (height - 1);
+  char* mem = arena_->AllocateAlignedConcurrently(node_size + key_size);
+  const Key key = encode(mem + node_size);
+  const uint64_t prefix = PrefixOf(key);
+  Node* x = new (mem) Node(key, prefix);
+
+  // Raise max_height_ first, so that readers find the new levels once
+  // they are linked; as in Insert() they skip levels that are not yet.
+  int max_height = GetMaxHeight();
+  while (height > max_height) {
+    if (max_height_.CompareAndSwap(reinterpret_cast<void*>(max_height),
+                                   reinterpret_cast<void*>(height))) {
+      max_height = height;
+      break;
+    }
+    max_height = GetMaxHeight();
+  }
+
+  // Predecessor and successor at each level, top down.  Each level's
+  // search starts at the predecessor found one level up.
+  Node* prev[kMaxHeight];
+  Node* next[kMaxHeight];
+  Node* before = head_;
+  for (int level = max_height - 1; level >= 0; level--) {
+    FindSpliceForLevel(key, prefix, before, level, &prev[level], &next[level]);
+    before = prev[level];
+  }
+
+  // Our data structure does not allow duplicate insertion
+  assert(next[0] == nullptr || !Equal(key, next[0]->key));
+
+  // Link bottom up, so that a node reachable at some level is reachable
+  // at every level below it.  When another insert wins a race for a link,
+  // search again from the predecessor we had, which is still before key.
+  for (int level = 0; level < height; level++) {
+    while (true) {
+      x->NoBarrier_SetNext(level, next[level]);
+      if (prev[level]->CASNext(level, next[level], x)) { break; }
+      FindSpliceForLevel(key, prefix, prev[level], level, &prev[level],
+                         &next[level]);
+    }
+  }
+}
+
+template <typename Key, class Comparator>
+bool SkipList<Key, Comparator>::Contains(const Key& key) const {
+  Node* x = FindGreaterOrEqual(key, PrefixOf(key), nullptr);
+  if (x != nullptr && Equal(key, x->key)) {
+    return true;
+  } else {
+    return false;
+  }
+}
+
 }  // namespace leveldb
@@ -0,0 +1,376 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/table_cache.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "db/filename.h"
+#include "leveldb/statistics.h"
+#include "port/port.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+static void DeleteEntry(const Slice &key, void *value) {
+  Table *table = reinterpret_cast<Table *>(value);
+  delete table;
+}
+
+static void DeleteRow(const Slice &key, void *value) {
+  delete reinterpret_cast<std::string *>(value);
+}
+
+static void UnrefEntry(void *arg1, void *arg2) {
+  Cache *cache = reinterpret_cast<Cache *>(arg1);
+  Cache::Handle *h = reinterpret_cast<Cache::Handle *>(arg2);
+  cache->Release(h);
+}
+
+TableCache::TableCache(const std::string &dbname, const Options *options,
+                       int entries, BlockCacheTracer *block_cache_tracer)
+    : env_(options->env),
+      dbname_(dbname),
+      options_(options),
+      storage_options_(*options),
+      // Pinned tables use the cache only for copies opened before they
+      // were pinned; a few entries do.
+      cache_(NewLRUCache(entries < 0 ? 64 : entries,
+                         options->table_cache_numshardbits)),
+      row_cache_id_(options->row_cache ? options->row_cache->NewId() : 0),
+      pin_all_(entries < 0),
+      pin_l0_(options->pin_l0_filter_and_index_blocks),
+      pinned_(nullptr),
+      block_cache_tracer_(block_cache_tracer) {
+  if (pin_all_ || pin_l0_) {
+    pinned_directories_.push_back(
+        std::make_unique<PinnedDirectory>(kInitialPinnedChunks));
+    pinned_.store(pinned_directories_.back().get(),
+                  std::memory_order_release);
+  }
+}
+
+TableCache::~TableCache() {
+  PinnedDirectory *directory = pinned_.load(std::memory_order_relaxed);
+  if (directory == nullptr) { return; }
+  // The newest directory holds every chunk
+  for (size_t i = 0; i < directory->size; i++) {
+    PinnedChunk *chunk = directory->chunks[i].load(std::memory_order_relaxed);
+    if (chunk == nullptr) { continue; }
+    for (std::atomic<Table *> &slot : chunk->tables) {
+      delete slot.load(std::memory_order_relaxed);
+    }
+    delete chunk;
+  }
+}
+
+std::atomic<Table *> *TableCache::PinnedSlot(uint64_t file_number,
+                                            bool create) {
+  PinnedDirectory *directory = pinned_.load(std::memory_order_acquire);
+  if (directory == nullptr) { return nullptr; }
+  const uint64_t index = file_number >> kPinnedChunkBits;
+  PinnedChunk *chunk =
+      index < directory->size
+          ? directory->chunks[index].load(std::memory_order_acquire)
+          : nullptr;
+  if (chunk == nullptr) {
+    if (!create) { return nullptr; }
+    chunk = NewPinnedChunk(index);
+  }
+  return &chunk->tables[file_number & (kPinnedChunkSize - 1)];
+}
+
+TableCache::PinnedChunk *TableCache::NewPinnedChunk(uint64_t index) {
+  MutexLock l(&pinned_mutex_);
+  PinnedDirectory *directory = pinned_.load(std::memory_order_relaxed);
+  if (index >= directory->size) {
+    // Chunks only change under the lock, so the copy misses none
+    size_t size = directory->size;
+    while (size <= index) { size *= 2; }
+    auto grown = std::make_unique<PinnedDirectory>(size);
+    for (size_t i = 0; i < directory->size; i++) {
+      grown->chunks[i].store(
+          directory->chunks[i].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+    }
+    directory = grown.get();
+    pinned_directories_.push_back(std::move(grown));
+    pinned_.store(directory, std::memory_order_release);
+  }
+  PinnedChunk *chunk = directory->chunks[index].load(std::memory_order_relaxed);
+  if (chunk == nullptr) {
+    chunk = new PinnedChunk;
+    directory->chunks[index].store(chunk, std::memory_order_release);
+  }
+  return chunk;
+}
+
+Status TableCache::OpenTable(uint64_t file_number, uint64_t file_size,
+                             Table **table) {
+  *table = nullptr;
+  std::string fname = TableFileName(dbname_, file_number);
+  std::unique_ptr<RandomAccessFile> file;
+  Status s = env_->NewRandomAccessFile(fname, &file, storage_options_);
+  RecordTick(options_->statistics, NO_FILE_OPENS);
+  if (s.ok()) {
+    if (options_->advise_random_on_open) {
+      file->Hint(RandomAccessFile::RANDOM);
+    }
+    s = Table::Open(*options_, std::move(file), file_size, table);
+  }
+  if (!s.ok()) {
+    assert(*table == nullptr);
+    RecordTick(options_->statistics, NO_FILE_ERRORS);
+    // We do not cache error results so that if the error is transient,
+    // or somebody repairs the file, we recover automatically.
+  }
+  return s;
+}
+
+Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
+                             int level, Table **table,
+                             Cache::Handle **handle) {
+  *handle = nullptr;
+  const bool pin = pin_all_ || (pin_l0_ && level == 0);
+  std::atomic<Table *> *slot = pin ? PinnedSlot(file_number, true) : nullptr;
+  if (slot != nullptr) {
+    *table = slot->load(std::memory_order_acquire);
+    if (*table != nullptr) { return Status::OK(); }
+  }
+
+  Status s;
+  char buf[sizeof(file_number)];
+  EncodeFixed64(buf, file_number);
+  Slice key(buf, sizeof(buf));
+  if (slot != nullptr) {
+    // Open without a lock; if another reader opened the same table in
+    // the meantime, keep theirs.
+    Table *opened;
+    s = OpenTable(file_number, file_size, &opened);
+    if (!s.ok()) { return s; }
+    Table *expected = nullptr;
+    if (slot->compare_exchange_strong(expected, opened,
+                                      std::memory_order_acq_rel)) {
+      *table = opened;
+      // Drop any copy opened before the table was pinned, e.g. to verify
+      // a flush; readers still using it hold their own handles.
+      cache_->Erase(key);
+    } else {
+      delete opened;
+      *table = expected;
+    }
+    return s;
+  }
+
+  *handle = cache_->Lookup(key);
+  if (*handle == nullptr) {
+    Table *opened;
+    s = OpenTable(file_number, file_size, &opened);
+    if (s.ok()) { *handle = cache_->Insert(key, opened, 1, &DeleteEntry); }
+  }
+  if (s.ok()) { *table = reinterpret_cast<Table *>(cache_->Value(*handle)); }
+  return s;
+}
+
+void TableCache::ReleaseTable(Cache::Handle *handle) {
+  if (handle != nullptr) { cache_->Release(handle); }
+}
+
+Iterator *TableCache::NewIterator(const ReadOptions &options,
+                                  uint64_t file_number, uint64_t file_size,
+                                  Table **tableptr, TableReaderCaller caller,
+                                  int level) {
+  if (tableptr != nullptr) { *tableptr = nullptr; }
+
+  Table *table = nullptr;
+  Cache::Handle *handle = nullptr;
+  Status s = FindTable(file_number, file_size, level, &table, &handle);
+  if (!s.ok()) { return NewErrorIterator(s); }
+
+  BlockCacheLookupContext context(caller, level);
+  context.file_number = file_number;
+  context.tracer = block_cache_tracer_;
+  Iterator *result = table->NewIterator(options, &context);
+  if (handle != nullptr) {
+    result->RegisterCleanup(&UnrefEntry, cache_.get(), handle);
+  }
+  if (tableptr != nullptr) { *tableptr = table; }
+  return result;
+}
+
+namespace {
+
+// Passes on what a table lookup finds, and saves it as a row cache entry,
+// the found key length-prefixed and then its value, if it is for the user
+// key looked up.
+struct RowSaver {
+  void *arg;
+  void (*handle_result)(void *, const Slice &, const Slice &);
+  const Comparator *ucmp;
+  Slice user_key;
+  std::string *row;
+
+  static void Save(void *arg, const Slice &found_key, const Slice &value) {
+    RowSaver *saver = reinterpret_cast<RowSaver *>(arg);
+    if (found_key.size() >= 8 &&
+        saver->ucmp->Compare(ExtractUserKey(found_key), saver->user_key) ==
+            0) {
+      PutLengthPrefixedSlice(saver->row, found_key);
+      saver->row->append(value.data(), value.size());
+    }
+    (*saver->handle_result)(saver->arg, found_key, value);
+  }
+};
+
+} // namespace
+
+Status TableCache::Get(const ReadOptions &options, uint64_t file_number,
+                       uint64_t file_size, const Slice &k, void *arg,
+                       void (*handle_result)(void *, const Slice &,
+                                             const Slice &),
+                       TableReaderCaller caller, int level) {
+  Cache *row_cache = options_->row_cache.get();
+  std::string row_key;
+  std::string *row = nullptr;
+  RowSaver saver;
+  if (row_cache != nullptr) {
+    // A read without a snapshot sees every entry in the file, so all such
+    // reads share one row; reads at a snapshot only share with each other.
+    const uint64_t sequence =
+        options.snapshot == nullptr
+            ? 0
+            : (DecodeFixed64(k.data() + k.size() - 8) >> 8) + 1;
+    PutFixed64(&row_key, row_cache_id_);
+    PutVarint64(&row_key, file_number);
+    PutVarint64(&row_key, sequence);
+    const Slice user_key = ExtractUserKey(k);
+    row_key.append(user_key.data(), user_key.size());
+
+    Cache::Handle *row_handle = row_cache->Lookup(row_key);
+    if (row_handle != nullptr) {
+      RecordTick(options_->statistics, ROW_CACHE_HIT);
+      Slice input(
+          *reinterpret_cast<std::string *>(row_cache->Value(row_handle)));
+      Slice found_key;
+      GetLengthPrefixedSlice(&input, &found_key);
+      (*handle_result)(arg, found_key, input);
+      row_cache->Release(row_handle);
+      return Status::OK();
+    }
+    RecordTick(options_->statistics, ROW_CACHE_MISS);
+
+    if (options.fill_cache) {
+      row = new std::string;
+      saver.arg = arg;
+      saver.handle_result = handle_result;
+      saver.ucmp = static_cast<const InternalKeyComparator *>(
+                       options_->comparator)
+                       ->user_comparator();
+      saver.user_key = user_key;
+      saver.row = row;
+      arg = &saver;
+      handle_result = &RowSaver::Save;
+    }
+  }
+
+  Table *t = nullptr;
+  Cache::Handle *handle = nullptr;
+  Status s = FindTable(file_number, file_size, level, &t, &handle);
+  if (s.ok()) {
+    BlockCacheLookupContext context(caller, level);
+    context.file_number = file_number;
+    context.tracer = block_cache_tracer_;
+    s = t->InternalGet(options, k, arg, handle_result, &context);
+    ReleaseTable(handle);
+  }
+  if (row != nullptr) {
+    if (s.ok() && !row->empty()) {
+      row_cache->Release(row_cache->Insert(
+          row_key, row, row_key.size() + row->size(), &DeleteRow));
+    } else {
+      delete row;
+    }
+  }
+  return s;
+}
+
+void TableCache::Evict(uint64_t file_number) {
+  // Only obsolete files are evicted, which no live version, and so no
+  // reader, refers to any more.  A file may have been in the cache before
+  // its table was pinned, so both are cleared.
+  std::atomic<Table *> *slot = PinnedSlot(file_number, false);
+  if (slot != nullptr) {
+    delete slot->exchange(nullptr, std::memory_order_acq_rel);
+  }
+  char buf[sizeof(file_number)];
+  EncodeFixed64(buf, file_number);
+  cache_->Erase(Slice(buf, sizeof(buf)));
+}
+
+void TableCache::Unpin(uint64_t file_number) {
+  if (pin_all_) { return; }
+  std::atomic<Table *> *slot = PinnedSlot(file_number, false);
+  if (slot != nullptr) {
+    delete slot->exchange(nullptr, std::memory_order_acq_rel);
+  }
+}
+
+namespace {
+
+struct PreloadState {
+  TableCache *cache;
+  const std::vector<TableCache::PreloadFile> *files;
+  std::atomic<size_t> next;
+  port::Mutex mu;
+  port::CondVar cv;
+  int running;  // Guarded by mu
+
+  PreloadState() : next(0), cv(&mu), running(0) {}
+};
+
+} // namespace
+
+void TableCache::PreloadWorker(void *arg) {
+  PreloadState *state = reinterpret_cast<PreloadState *>(arg);
+  // Workers take files one at a time, so that slow opens spread evenly.
+  size_t i;
+  while ((i = state->next.fetch_add(1, std::memory_order_relaxed)) <
+         state->files->size()) {
+    const PreloadFile &file = (*state->files)[i];
+    Table *table;
+    Cache::Handle *handle;
+    if (state->cache
+            ->FindTable(file.number, file.file_size, file.level, &table,
+                        &handle)
+            .ok()) {
+      state->cache->ReleaseTable(handle);
+    }
+  }
+  MutexLock l(&state->mu);
+  state->running--;
+  state->cv.SignalAll();
+}
+
+void TableCache::Preload(const std::vector<PreloadFile> &files,
+                         int max_threads) {
+  const int threads =
+      static_cast<int>(std::min<size_t>(std::max(max_threads, 0),
+                                        files.size()));
+  if (threads == 0) { return; }
+  PreloadState state;
+  state.cache = this;
+  state.files = &files;
+  state.running = threads;
+  // The calling thread is one of the workers.
+  for (int i = 1; i < threads; i++) {
+    env_->StartThread(&PreloadWorker, &state);
+  }
+  PreloadWorker(&state);
+  MutexLock l(&state.mu);
+  while (state.running > 0) { state.cv.Wait(); }
+}
+
+}  // namespace leveldb
@@ -0,0 +1,141 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Thread-safe (provides internal synchronization)
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "leveldb/cache.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "port/port.h"
+#include "table/block_cache_tracer.h"
+#include "table/table.h"
+
+namespace leveldb {
+
+class TableCache {
+public:
+  // A table file for Preload(), and the level it is at
+  struct PreloadFile {
+    uint64_t number;
+    uint64_t file_size;
+    int level;
+  };
+
+  // Keeps up to "entries" tables open, in an LRU cache sharded by file
+  // number.  A negative "entries" keeps every table open until it is
+  // evicted, in an array indexed by file number that lookups read without
+  // locking.  With options->pin_l0_filter_and_index_blocks, the tables of
+  // level-0 files are kept the same way on top of the "entries" others.
+  // Block cache accesses are traced with "block_cache_tracer" (if non-null)
+  // while it is tracing.
+  TableCache(const std::string &dbname, const Options *options, int entries,
+             BlockCacheTracer *block_cache_tracer = nullptr);
+  ~TableCache();
+
+  // Return an iterator for the specified file number (the corresponding
+  // file length must be exactly "file_size" bytes).  If "tableptr" is
+  // non-null, also sets "*tableptr" to point to the Table object
+  // underlying the returned iterator, or to nullptr if no Table object
+  // underlies the returned iterator.  The returned "*tableptr" object is
+  // owned by the cache and should not be deleted, and is valid for as long
+  // as the returned iterator is live.  "caller" labels traced block cache
+  // accesses, and so does "level", which also decides whether the table
+  // is pinned.
+  Iterator *NewIterator(const ReadOptions &options, uint64_t file_number,
+                        uint64_t file_size, Table **tableptr = nullptr,
+                        TableReaderCaller caller = kUncategorized,
+                        int level = -1);
+
+  // If a seek to internal key "k" in specified file finds an entry,
+  // call (*handle_result)(arg, found_key, found_value).  Entries for the
+  // user key of "k" are kept in options->row_cache, if any.
+  Status Get(const ReadOptions &options, uint64_t file_number,
+             uint64_t file_size, const Slice &k, void *arg,
+             void (*handle_result)(void *, const Slice &, const Slice &),
+             TableReaderCaller caller = kUserGet, int level = -1);
+
+  // Evict any entry for the specified file number
+  void Evict(uint64_t file_number);
+
+  // Drop the pinned table of "file_number", if its level alone pinned it;
+  // reads at other levels get the table through the LRU cache.  Only
+  // call this once no live version has the file at level 0.
+  void Unpin(uint64_t file_number);
+
+  // Open the tables of "files" ahead of their first use, on up to
+  // "max_threads" threads, pinning those that their level calls for.
+  // Errors are left for the first real access to report.
+  void Preload(const std::vector<PreloadFile> &files, int max_threads);
+
+private:
+  // Tables of kPinnedChunkSize consecutive file numbers.  Chunks are
+  // allocated on first use, so that pinning needs a few pointers up front
+  // rather than a slot for every possible file number.
+  static constexpr int kPinnedChunkBits = 14;
+  static constexpr size_t kPinnedChunkSize = size_t{1} << kPinnedChunkBits;
+  static constexpr size_t kInitialPinnedChunks = 4;
+  struct PinnedChunk {
+    std::atomic<Table *> tables[kPinnedChunkSize] = {};
+  };
+  // The chunks of the first "size" * kPinnedChunkSize file numbers
+  struct PinnedDirectory {
+    explicit PinnedDirectory(size_t n)
+        : size(n), chunks(new std::atomic<PinnedChunk *>[n]()) {}
+    const size_t size;
+    std::unique_ptr<std::atomic<PinnedChunk *>[]> chunks;
+  };
+
+  // The pinned slot of "file_number", allocating its chunk if "create".
+  // nullptr if tables are not pinned, or if the chunk does not exist and
+  // "create" is false.
+  std::atomic<Table *> *PinnedSlot(uint64_t file_number, bool create);
+  // Returns the chunk with index "index", creating it and growing the
+  // directory to cover it as needed.
+  PinnedChunk *NewPinnedChunk(uint64_t index);
+
+  Status OpenTable(uint64_t file_number, uint64_t file_size, Table **table);
+
+  // Sets *table to the open table of "file_number", and *handle to the
+  // cache handle to pass to ReleaseTable() once done with it (nullptr if
+  // the table is pinned).  Only reads at a level that calls for pinning
+  // use, and if need be pin, the pinned table, so that Unpin() knows
+  // which reads may still hold it.
+  Status FindTable(uint64_t file_number, uint64_t file_size, int level,
+                   Table **table, Cache::Handle **handle);
+  void ReleaseTable(Cache::Handle *handle);
+  // Runs a share of Preload(); "arg" is its state
+  static void PreloadWorker(void *arg);
+
+  Env *const env_;
+  const std::string dbname_;
+  const Options *options_;
+  const EnvOptions storage_options_;
+  std::shared_ptr<Cache> cache_;
+  // Prefix of this cache's keys in options->row_cache, which DBs may share
+  const uint64_t row_cache_id_;
+  // Whether to pin the tables of every level, or of level 0
+  const bool pin_all_;
+  const bool pin_l0_;
+  // Non-null if any table is pinned.  Read without locking; a larger
+  // directory replaces it as file numbers grow.
+  std::atomic<PinnedDirectory *> pinned_;
+  // Guards the creation of chunks and directories
+  port::Mutex pinned_mutex_;
+  // Every directory pinned_ has pointed to, which readers may still be
+  // using, so they live as long as the cache
+  std::vector<std::unique_ptr<PinnedDirectory>> pinned_directories_;
+  BlockCacheTracer *const block_cache_tracer_;
+};
+
+}  // namespace leveldb
@@ -0,0 +1,725 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "db/db_impl.h"
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/iostats_context.h"
+#include "leveldb/perf_context.h"
+#include "leveldb/statistics.h"
+#include "leveldb/write_batch.h"
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+class DBTest : public testing::Test {
+public:
+  DBTest() : env_(Env::Default()), db_(nullptr) {
+    env_->GetTestDirectory(&dbname_);
+    dbname_ += "/db_test";
+    options_.create_if_missing = true;
+    DestroyDB(dbname_, options_);
+  }
+
+  ~DBTest() override {
+    delete db_;
+    DestroyDB(dbname_, options_);
+  }
+
+  void Reopen() {
+    delete db_;
+    db_ = nullptr;
+    ASSERT_TRUE(DB::Open(options_, dbname_, &db_).ok());
+  }
+
+  Status Put(const std::string &k, const std::string &v) {
+    return db_->Put(WriteOptions(), k, v);
+  }
+
+  std::string Get(const std::string &k, const Snapshot *snapshot = nullptr) {
+    ReadOptions options;
+    options.snapshot = snapshot;
+    std::string result;
+    Status s = db_->Get(options, k, &result);
+    if (s.IsNotFound()) {
+      result = "NOT_FOUND";
+    } else if (!s.ok()) {
+      result = s.ToString();
+    }
+    return result;
+  }
+
+  std::string Contents() {
+    std::string result;
+    Iterator *iter = db_->NewIterator(ReadOptions());
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      result += iter->key().ToString() + "=" + iter->value().ToString() + ";";
+    }
+    delete iter;
+    return result;
+  }
+
+  int NumTableFilesAtLevel(int level) {
+    std::string property;
+    EXPECT_TRUE(db_->GetProperty(
+        "leveldb.num-files-at-level" + std::to_string(level), &property));
+    return std::stoi(property);
+  }
+
+  Env *env_;
+  std::string dbname_;
+  Options options_;
+  DB *db_;
+};
+
+TEST_F(DBTest, Empty) {
+  Reopen();
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+  ASSERT_EQ("", Contents());
+}
+
+TEST_F(DBTest, PutGetDelete) {
+  Reopen();
+  ASSERT_TRUE(Put("foo", "v1").ok());
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_TRUE(Put("bar", "v2").ok());
+  ASSERT_TRUE(Put("foo", "v3").ok());
+  ASSERT_EQ("v3", Get("foo"));
+  ASSERT_EQ("v2", Get("bar"));
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "foo").ok());
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+  ASSERT_EQ("bar=v2;", Contents());
+}
+
+TEST_F(DBTest, WriteBatchAndSnapshot) {
+  Reopen();
+  ASSERT_TRUE(Put("a", "1").ok());
+  const Snapshot *snapshot = db_->GetSnapshot();
+  WriteBatch batch;
+  batch.Put("a", "2");
+  batch.Put("b", "3");
+  batch.Delete("c");
+  ASSERT_TRUE(db_->Write(WriteOptions(), &batch).ok());
+  ASSERT_EQ("1", Get("a", snapshot));
+  ASSERT_EQ("NOT_FOUND", Get("b", snapshot));
+  ASSERT_EQ("2", Get("a"));
+  ASSERT_EQ("a=2;b=3;", Contents());
+  db_->ReleaseSnapshot(snapshot);
+}
+
+TEST_F(DBTest, RecoverFromLog) {
+  Reopen();
+  ASSERT_TRUE(Put("foo", "v1").ok());
+  ASSERT_TRUE(Put("baz", "v5").ok());
+  Reopen();
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("v5", Get("baz"));
+  ASSERT_TRUE(Put("foo", "v2").ok());
+  Reopen();
+  ASSERT_EQ("v2", Get("foo"));
+  ASSERT_EQ("baz=v5;foo=v2;", Contents());
+}
+
+TEST_F(DBTest, FlushAndCompact) {
+  options_.filter_policy = NewBloomFilterPolicy(10);
+  Reopen();
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(Put("key" + std::to_string(i), std::string(100, 'x')).ok());
+  }
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  uint64_t num_imm = 1;
+  ASSERT_TRUE(db_->GetIntProperty("leveldb.num-immutable-mem-table", &num_imm));
+  ASSERT_EQ(0u, num_imm);
+
+  for (int i = 0; i < 1000; i += 2) {
+    ASSERT_TRUE(db_->Delete(WriteOptions(), "key" + std::to_string(i)).ok());
+  }
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i % 2 == 0 ? "NOT_FOUND" : std::string(100, 'x'),
+              Get("key" + std::to_string(i)));
+  }
+
+  Reopen();
+  ASSERT_EQ(std::string(100, 'x'), Get("key999"));
+  ASSERT_EQ("NOT_FOUND", Get("key998"));
+  delete db_;
+  db_ = nullptr;
+  delete options_.filter_policy;
+  options_.filter_policy = nullptr;
+}
+
+TEST_F(DBTest, MultiGet) {
+  Reopen();
+  ASSERT_TRUE(Put("a", "1").ok());
+  ASSERT_TRUE(Put("c", "3").ok());
+  std::vector<std::string> values;
+  std::vector<Status> s =
+      db_->MultiGet(ReadOptions(), {Slice("a"), Slice("b"), Slice("c")},
+                    &values);
+  ASSERT_EQ(3u, s.size());
+  ASSERT_TRUE(s[0].ok());
+  ASSERT_TRUE(s[1].IsNotFound());
+  ASSERT_TRUE(s[2].ok());
+  ASSERT_EQ("1", values[0]);
+  ASSERT_EQ("3", values[2]);
+}
+
+TEST_F(DBTest, IntProperties) {
+  Reopen();
+  uint64_t mem_bytes = 0;
+  ASSERT_TRUE(db_->GetIntProperty("leveldb.cur-size-active-mem-table",
+                                  &mem_bytes));
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(Put("key" + std::to_string(i), std::string(100, 'x')).ok());
+  }
+  uint64_t value = 0;
+  ASSERT_TRUE(
+      db_->GetIntProperty("leveldb.cur-size-active-mem-table", &value));
+  ASSERT_GT(value, mem_bytes);
+  ASSERT_TRUE(
+      db_->GetIntProperty("leveldb.num-entries-active-mem-table", &value));
+  ASSERT_EQ(100u, value);
+  ASSERT_TRUE(db_->GetIntProperty("leveldb.estimate-num-keys", &value));
+  ASSERT_EQ(100u, value);
+
+  // Once flushed the keys are counted from the version instead
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  ASSERT_TRUE(
+      db_->GetIntProperty("leveldb.num-entries-active-mem-table", &value));
+  ASSERT_EQ(0u, value);
+  ASSERT_TRUE(db_->GetIntProperty("leveldb.estimate-num-keys", &value));
+  ASSERT_EQ(100u, value);
+  ASSERT_TRUE(db_->GetIntProperty("leveldb.total-sst-files-size", &value));
+  ASSERT_GT(value, 0u);
+  ASSERT_TRUE(db_->GetIntProperty("leveldb.estimate-pending-compaction-bytes",
+                                  &value));
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_TRUE(db_->GetIntProperty("leveldb.estimate-pending-compaction-bytes",
+                                  &value));
+  ASSERT_EQ(0u, value);
+
+  // String properties go through GetProperty as well
+  std::string str;
+  ASSERT_TRUE(db_->GetProperty("leveldb.estimate-num-keys", &str));
+  ASSERT_EQ("100", str);
+  ASSERT_FALSE(db_->GetIntProperty("leveldb.stats", &value));
+  ASSERT_FALSE(db_->GetIntProperty("leveldb.no-such-property", &value));
+}
+
+TEST_F(DBTest, StringProperties) {
+  Reopen();
+  ASSERT_TRUE(Put("a", "v").ok());
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+
+  std::string value;
+  ASSERT_TRUE(db_->GetProperty("leveldb.stats", &value));
+  ASSERT_NE(std::string::npos, value.find("Compactions"));
+  ASSERT_NE(std::string::npos, value.find("Cumulative writes: 1 writes"));
+  ASSERT_TRUE(db_->GetProperty("leveldb.sstables", &value));
+  ASSERT_NE(std::string::npos, value.find("--- level 0 ---"));
+  ASSERT_NE(std::string::npos, value.find("'a' @ 1"));
+
+  // The flushed table may be pushed below level 0
+  int files = 0;
+  for (int level = 0; level < options_.num_levels; level++) {
+    files += NumTableFilesAtLevel(level);
+  }
+  ASSERT_EQ(1, files);
+  ASSERT_FALSE(db_->GetProperty("leveldb.num-files-at-level", &value));
+  ASSERT_FALSE(db_->GetProperty("leveldb.num-files-at-levelx", &value));
+  ASSERT_FALSE(db_->GetProperty("leveldb.num-files-at-level1x", &value));
+  ASSERT_FALSE(db_->GetProperty(
+      "leveldb.num-files-at-level" + std::to_string(options_.num_levels),
+      &value));
+  ASSERT_FALSE(db_->GetProperty("leveldb.num-files-at-level99999999999999999",
+                                &value));
+  ASSERT_FALSE(db_->GetProperty("leveldb.no-such-property", &value));
+  ASSERT_FALSE(db_->GetProperty("rocksdb.stats", &value));
+}
+
+namespace {
+
+class CapturingLogger : public Logger {
+public:
+  void Logv(const char *format, va_list ap) override {
+    char buf[4096];
+    vsnprintf(buf, sizeof(buf), format, ap);
+    MutexLock l(&mu_);
+    lines_.push_back(buf);
+  }
+
+  bool Contains(const std::string &s) {
+    MutexLock l(&mu_);
+    for (const std::string &line : lines_) {
+      if (line.find(s) != std::string::npos) { return true; }
+    }
+    return false;
+  }
+
+private:
+  port::Mutex mu_;
+  std::vector<std::string> lines_;
+};
+
+}  // namespace
+
+TEST_F(DBTest, PeriodicStatsDump) {
+  auto logger = std::make_shared<CapturingLogger>();
+  options_.info_log = logger;
+  options_.stats_dump_period_sec = 1;
+  Reopen();
+  ASSERT_TRUE(Put("a", "v").ok());
+  for (int i = 0; i < 50 && !logger->Contains("DUMPING STATS"); i++) {
+    env_->SleepForMicroseconds(100000);
+  }
+  ASSERT_TRUE(logger->Contains("DUMPING STATS"));
+  ASSERT_TRUE(logger->Contains("Cumulative writes"));
+
+  // Closing the DB must stop the dump thread promptly
+  uint64_t start = env_->NowMicros();
+  delete db_;
+  db_ = nullptr;
+  ASSERT_LT(env_->NowMicros() - start, 1000000u);
+  options_.info_log.reset();
+}
+
+TEST_F(DBTest, PerfContext) {
+  Reopen();
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(Put("key" + std::to_string(i), "v").ok());
+  }
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  ASSERT_TRUE(Put("key0", "w").ok());
+  PerfContext *perf = get_perf_context();
+
+  // Nothing is counted by default
+  SetPerfLevel(kDisable);
+  perf->Reset();
+  get_iostats_context()->Reset();
+  ASSERT_TRUE(Put("key1", "w").ok());
+  ASSERT_EQ("v", Get("key50"));
+  Iterator *iter = db_->NewIterator(ReadOptions());
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {}
+  delete iter;
+  ASSERT_EQ(0u, perf->user_key_comparison_count);
+  ASSERT_EQ(0u, perf->get_from_memtable_count);
+  ASSERT_EQ(0u, perf->next_on_memtable_count);
+  ASSERT_EQ(0u, perf->db_mutex_lock_nanos);
+  ASSERT_EQ(0u, perf->write_wal_time);
+  // Byte counters are kept at every level
+  ASSERT_GT(get_iostats_context()->bytes_written, 0u);
+
+  // Writes compare keys in the memtable, past the 8-byte prefixes that
+  // its skiplist caches
+  SetPerfLevel(kEnableCount);
+  ASSERT_TRUE(Put("samepref1", "w").ok());
+  perf->Reset();
+  ASSERT_TRUE(Put("samepref2", "w").ok());
+  ASSERT_GT(perf->user_key_comparison_count, 0u);
+  ASSERT_EQ(0u, perf->write_wal_time);
+
+  // Gets from table files compare keys in blocks
+  perf->Reset();
+  ASSERT_EQ("v", Get("key50"));
+  ASSERT_GT(perf->user_key_comparison_count, 0u);
+  ASSERT_EQ(1u, perf->get_from_memtable_count);
+
+  // Iteration merges the memtable with the table
+  perf->Reset();
+  iter = db_->NewIterator(ReadOptions());
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) { count++; }
+  delete iter;
+  ASSERT_EQ(102, count);
+  ASSERT_GT(perf->user_key_comparison_count, 0u);
+  ASSERT_GT(perf->next_on_memtable_count, 0u);
+  ASSERT_EQ(0u, perf->db_mutex_lock_nanos);
+
+  // Timers need kEnableTime
+  SetPerfLevel(kEnableTime);
+  perf->Reset();
+  ASSERT_TRUE(Put("key3", "w").ok());
+  ASSERT_EQ("v", Get("key50"));
+  ASSERT_GT(perf->write_wal_time, 0u);
+  ASSERT_GT(perf->db_mutex_lock_nanos, 0u);
+  ASSERT_GT(perf->get_from_output_files_time, 0u);
+  SetPerfLevel(kDisable);
+}
+
+TEST_F(DBTest, PipelinedWrite) {
+  options_.enable_pipelined_write = true;
+  // Small enough to switch memtables while writers are in both stages
+  options_.write_buffer_size = 64 << 10;
+  Reopen();
+  const int kThreads = 4;
+  const int kWritesPerThread = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < kWritesPerThread; i++) {
+        const std::string k = std::to_string(t) + "." + std::to_string(i);
+        ASSERT_TRUE(Put(k, std::string(100, 'a' + t)).ok());
+      }
+    });
+  }
+  for (std::thread &thread : threads) { thread.join(); }
+  ASSERT_EQ(static_cast<SequenceNumber>(kThreads * kWritesPerThread),
+            db_->GetLatestSequenceNumber());
+
+  Reopen();
+  for (int t = 0; t < kThreads; t++) {
+    for (int i = 0; i < kWritesPerThread; i += 97) {
+      const std::string k = std::to_string(t) + "." + std::to_string(i);
+      ASSERT_EQ(std::string(100, 'a' + t), Get(k));
+    }
+  }
+  ASSERT_TRUE(Put("flush", "me").ok());
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  ASSERT_EQ("me", Get("flush"));
+}
+
+TEST_F(DBTest, UnorderedWrite) {
+  options_.unordered_write = true;
+  options_.enable_pipelined_write = true;
+  DB *db;
+  ASSERT_TRUE(DB::Open(options_, dbname_, &db).IsInvalidArgument());
+  options_.enable_pipelined_write = false;
+  options_.write_buffer_size = 64 << 10;
+  Reopen();
+
+  // Each thread writes "a" keys before the matching "b" keys, in separate
+  // writes; a snapshot that sees a "b" key must see its "a" key too.
+  const int kThreads = 4;
+  const int kWritesPerThread = 1000;
+  std::atomic<int> running(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, t, &running]() {
+      for (int i = 0; i < kWritesPerThread; i++) {
+        const std::string k = std::to_string(t) + "." + std::to_string(i);
+        ASSERT_TRUE(Put("a" + k, std::string(100, 'a' + t)).ok());
+        ASSERT_TRUE(Put("b" + k, std::string(100, 'a' + t)).ok());
+      }
+      running.fetch_sub(1);
+    });
+  }
+  int snapshots = 0;
+  while (running.load() > 0 || snapshots == 0) {
+    const Snapshot *snapshot = db_->GetSnapshot();
+    ReadOptions options;
+    options.snapshot = snapshot;
+    Iterator *iter = db_->NewIterator(options);
+    for (iter->Seek("b"); iter->Valid(); iter->Next()) {
+      const std::string k = iter->key().ToString().substr(1);
+      ASSERT_EQ(iter->value().ToString(), Get("a" + k, snapshot));
+    }
+    delete iter;
+    db_->ReleaseSnapshot(snapshot);
+    snapshots++;
+  }
+  for (std::thread &thread : threads) { thread.join(); }
+  ASSERT_EQ(static_cast<SequenceNumber>(2 * kThreads * kWritesPerThread),
+            db_->GetLatestSequenceNumber());
+
+  Reopen();
+  for (int t = 0; t < kThreads; t++) {
+    for (int i = 0; i < kWritesPerThread; i += 97) {
+      const std::string k = std::to_string(t) + "." + std::to_string(i);
+      ASSERT_EQ(std::string(100, 'a' + t), Get("a" + k));
+      ASSERT_EQ(std::string(100, 'a' + t), Get("b" + k));
+    }
+  }
+}
+
+TEST_F(DBTest, ManualWALFlush) {
+  options_.manual_wal_flush = true;
+  Reopen();
+  std::string log_name;
+  std::vector<std::string> files;
+  ASSERT_TRUE(env_->GetChildren(dbname_, &files).ok());
+  for (const std::string &file : files) {
+    if (file.size() > 4 && file.compare(file.size() - 4, 4, ".log") == 0) {
+      log_name = dbname_ + "/" + file;
+    }
+  }
+  ASSERT_FALSE(log_name.empty());
+
+  // Records stay buffered until FlushWAL()
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(Put("k" + std::to_string(i), "v").ok());
+  }
+  uint64_t size;
+  ASSERT_TRUE(env_->GetFileSize(log_name, &size).ok());
+  ASSERT_EQ(0u, size);
+  ASSERT_TRUE(db_->FlushWAL(false).ok());
+  ASSERT_TRUE(env_->GetFileSize(log_name, &size).ok());
+  ASSERT_GT(size, 0u);
+
+  ASSERT_TRUE(Put("synced", "v").ok());
+  ASSERT_TRUE(db_->FlushWAL(true).ok());
+  uint64_t synced_size;
+  ASSERT_TRUE(env_->GetFileSize(log_name, &synced_size).ok());
+  ASSERT_GT(synced_size, size);
+
+  ASSERT_TRUE(Put("switched", "v").ok());
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  ASSERT_TRUE(Put("closed", "v").ok());
+  Reopen();
+  ASSERT_EQ("v", Get("k0"));
+  ASSERT_EQ("v", Get("synced"));
+  ASSERT_EQ("v", Get("switched"));
+  ASSERT_EQ("v", Get("closed"));
+}
+
+TEST_F(DBTest, ParallelRecovery) {
+  // Everything stays in the WAL
+  options_.write_buffer_size = 64 << 20;
+  Reopen();
+  const int kKeys = 2000;
+  for (int round = 0; round < 4; round++) {
+    for (int i = 0; i < kKeys; i++) {
+      ASSERT_TRUE(
+          Put("key" + std::to_string(i),
+              std::to_string(round) + std::string(200, 'v'))
+              .ok());
+    }
+  }
+  const SequenceNumber last_sequence = db_->GetLatestSequenceNumber();
+
+  // Replays into many small memtables, flushed on several threads; the
+  // last round must win although it is in a different table than the
+  // first.
+  options_.write_buffer_size = 64 << 10;
+  options_.wal_recovery_threads = 4;
+  Reopen();
+  ASSERT_EQ(last_sequence, db_->GetLatestSequenceNumber());
+  for (int i = 0; i < kKeys; i++) {
+    ASSERT_EQ("3" + std::string(200, 'v'), Get("key" + std::to_string(i)));
+  }
+
+  // And once more serially, from the tables the first replay wrote
+  options_.wal_recovery_threads = 1;
+  ASSERT_TRUE(Put("key0", "new").ok());
+  Reopen();
+  ASSERT_EQ("new", Get("key0"));
+  ASSERT_EQ("3" + std::string(200, 'v'), Get("key1"));
+}
+
+TEST_F(DBTest, PreloadTablesWithDeferredIndex) {
+  std::unique_ptr<const FilterPolicy> policy(NewBloomFilterPolicy(10));
+  options_.filter_policy = policy.get();
+  Reopen();
+  for (int file = 0; file < 8; file++) {
+    for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(
+          Put("key" + std::to_string(file * 100 + i), std::to_string(file))
+              .ok());
+    }
+    ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  }
+
+  options_.defer_table_index_loading = true;
+  options_.max_file_opening_threads = 4;
+  Reopen();
+  for (int file = 0; file < 8; file++) {
+    ASSERT_EQ(std::to_string(file), Get("key" + std::to_string(file * 100)));
+  }
+  ASSERT_EQ("NOT_FOUND", Get("missing"));
+  Iterator *iter = db_->NewIterator(ReadOptions());
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) { count++; }
+  ASSERT_TRUE(iter->status().ok());
+  delete iter;
+  ASSERT_EQ(800, count);
+
+  // Tables open on first access again
+  options_.max_file_opening_threads = 0;
+  Reopen();
+  ASSERT_EQ("7", Get("key799"));
+}
+
+TEST_F(DBTest, KeepAllTablesOpen) {
+  options_.max_open_files = -1;
+  Reopen();
+  for (int file = 0; file < 4; file++) {
+    for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(Put("key" + std::to_string(i), std::to_string(file)).ok());
+    }
+    ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  }
+
+  // Readers race to open the same tables
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([this]() {
+      for (int i = 0; i < 100; i++) {
+        ASSERT_EQ("3", Get("key" + std::to_string(i)));
+      }
+    });
+  }
+  for (std::thread &thread : threads) { thread.join(); }
+
+  // Compaction evicts the tables it replaces
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_EQ("3", Get("key0"));
+  Reopen();
+  ASSERT_EQ("3", Get("key99"));
+}
+
+TEST_F(DBTest, PinL0FilterAndIndexBlocks) {
+  options_.pin_l0_filter_and_index_blocks = true;
+  options_.level0_file_num_compaction_trigger = 100;
+  options_.max_mem_compaction_level = 0;
+  options_.max_file_opening_threads = 0;
+  options_.statistics = CreateDBStatistics();
+  Reopen();
+  for (int file = 0; file < 3; file++) {
+    // Overlapping files, so that lookups go through all of them
+    for (int i = file; i < 300; i += 3) {
+      ASSERT_TRUE(Put("key" + std::to_string(i), std::to_string(file)).ok());
+    }
+    ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  }
+  ASSERT_EQ(3, NumTableFilesAtLevel(0));
+
+  // Each level-0 table is opened once and then stays pinned
+  Reopen();
+  const long opens = options_.statistics->getTickerCount(NO_FILE_OPENS);
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 300; i++) {
+      ASSERT_EQ(std::to_string(i % 3), Get("key" + std::to_string(i)));
+    }
+    ASSERT_EQ(opens + 3,
+              options_.statistics->getTickerCount(NO_FILE_OPENS));
+  }
+
+  // Tables preloaded by DB::Open are pinned there and then
+  options_.max_file_opening_threads = 4;
+  Reopen();
+  const long preloaded = options_.statistics->getTickerCount(NO_FILE_OPENS);
+  for (int i = 0; i < 300; i++) {
+    ASSERT_EQ(std::to_string(i % 3), Get("key" + std::to_string(i)));
+  }
+  ASSERT_EQ(preloaded, options_.statistics->getTickerCount(NO_FILE_OPENS));
+
+  // Compaction evicts the pinned tables it replaces
+  db_->CompactRange(nullptr, nullptr);
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  ASSERT_EQ("0", Get("key0"));
+  ASSERT_EQ("2", Get("key299"));
+}
+
+TEST_F(DBTest, PinL0TablesMovedToLevel1) {
+  options_.pin_l0_filter_and_index_blocks = true;
+  options_.level0_file_num_compaction_trigger = 2;
+  options_.max_mem_compaction_level = 0;
+  options_.statistics = CreateDBStatistics();
+  Reopen();
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(Put("a" + std::to_string(i), "v").ok());
+  }
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  ASSERT_EQ("v", Get("a0"));  // Pins the table
+
+  // A second, disjoint file triggers a compaction that moves the first
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(Put("b" + std::to_string(i), "v").ok());
+  }
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  for (int i = 0; i < 1000 && NumTableFilesAtLevel(1) == 0; i++) {
+    env_->SleepForMicroseconds(10000);
+  }
+  ASSERT_EQ(1, NumTableFilesAtLevel(0));
+  ASSERT_EQ(1, NumTableFilesAtLevel(1));
+
+  // Reads at level 1 do not use the pinned table, but open it once more
+  // through the LRU cache
+  const long opens = options_.statistics->getTickerCount(NO_FILE_OPENS);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ("v", Get("a" + std::to_string(i)));
+  }
+  ASSERT_EQ(opens + 1, options_.statistics->getTickerCount(NO_FILE_OPENS));
+
+  // The next flush unpins the moved table
+  ASSERT_TRUE(Put("a0", "w").ok());
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  ASSERT_EQ("w", Get("a0"));
+  ASSERT_EQ("v", Get("a99"));
+  ASSERT_EQ("v", Get("b99"));
+}
+
+TEST_F(DBTest, CompressedBlockCache) {
+  options_.compression = kZlibCompression;
+  // Zlib-wrapped rather than raw deflate, which readers must be told of
+  options_.compression_opts.window_bits = 15;
+  // Caches nothing, so that every read misses it
+  options_.block_cache = NewLRUCache(0);
+  options_.block_cache_compressed = NewLRUCache(1 << 20);
+  options_.statistics = CreateDBStatistics();
+  Reopen();
+  const std::string value(100, 'v');
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(Put("key" + std::to_string(i), value).ok());
+  }
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 1000; i += 7) {
+      ASSERT_EQ(value, Get("key" + std::to_string(i)));
+    }
+  }
+
+  // Blocks are only compressed, and cached, with zlib compiled in
+  const CompressionOptions zlib;
+  std::string compressed;
+  if (port::Zlib_Compress(zlib.window_bits, zlib.level, zlib.strategy,
+                          value.data(), value.size(), &compressed)) {
+    ASSERT_GT(options_.statistics->getTickerCount(BLOCK_CACHE_COMPRESSED_HIT),
+              0);
+    ASSERT_GT(options_.block_cache_compressed->TotalCharge(), 0u);
+  }
+}
+
+TEST_F(DBTest, RowCache) {
+  options_.row_cache = NewLRUCache(1 << 20);
+  options_.statistics = CreateDBStatistics();
+  Reopen();
+  ASSERT_TRUE(Put("a", "v1").ok());
+  const Snapshot *snapshot = db_->GetSnapshot();
+  ASSERT_TRUE(Put("a", "v2").ok());
+  ASSERT_TRUE(Put("b", "v1").ok());
+  // Both versions of "a" end up in the same file
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+
+  ASSERT_EQ("v2", Get("a"));
+  ASSERT_EQ(0, options_.statistics->getTickerCount(ROW_CACHE_HIT));
+  ASSERT_EQ("v2", Get("a"));
+  ASSERT_EQ(1, options_.statistics->getTickerCount(ROW_CACHE_HIT));
+  // A snapshot does not see the cached row
+  ASSERT_EQ("v1", Get("a", snapshot));
+  ASSERT_EQ("v1", Get("a", snapshot));
+  ASSERT_EQ(2, options_.statistics->getTickerCount(ROW_CACHE_HIT));
+  db_->ReleaseSnapshot(snapshot);
+
+  // Newer files are looked up first, under rows of their own
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "b").ok());
+  ASSERT_TRUE(db_->Flush(FlushOptions()).ok());
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ("NOT_FOUND", Get("c"));
+  ASSERT_EQ("v2", Get("a"));
+}
+
+} // namespace leveldb
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <type_traits>
+#include <string>
+#include <vector>
+
+#include "db/key_compare.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+static int Sign(int r) { return r < 0 ? -1 : (r > 0 ? +1 : 0); }
+
+TEST(KeyCompareTest, BytewiseMatchesSliceCompare) {
+  // Short alphabets and lengths around the 8-byte word size, so keys often
+  // share prefixes and differ in the tail or only in length.
+  Random64 rnd(301);
+  std::vector<std::string> keys;
+  for (int i = 0; i < 300; i++) {
+    std::string key(rnd.Uniform(20), '\0');
+    for (char &c : key) {
+      c = static_cast<char>(rnd.OneIn(2) ? 'a' : 0xf0 + rnd.Uniform(2));
+    }
+    keys.push_back(key);
+  }
+  for (const std::string &a : keys) {
+    for (const std::string &b : keys) {
+      ASSERT_EQ(Sign(Slice(a).compare(b)), BytewiseCompare(a, b));
+    }
+  }
+}
+
+TEST(KeyCompareTest, BytewiseInternalKeyMatchesComparator) {
+  const InternalKeyComparator icmp(BytewiseComparator());
+  std::vector<std::string> keys;
+  for (const char *user_key : {"", "a", "abcdefgh", "abcdefghi", "b"}) {
+    for (SequenceNumber seq : {1, 2, 100}) {
+      for (ValueType type : {kTypeDeletion, kTypeValue}) {
+        keys.push_back(InternalKey(user_key, seq, type).Encode().ToString());
+      }
+    }
+  }
+  for (const std::string &a : keys) {
+    for (const std::string &b : keys) {
+      ASSERT_EQ(Sign(icmp.Compare(a, b)), BytewiseInternalKeyCompare()(a, b));
+    }
+  }
+}
+
+TEST(KeyCompareTest, Dispatch) {
+  auto name = [](const Comparator *comparator) {
+    return DispatchKeyCompare(comparator, [](auto compare) -> std::string {
+      if (std::is_same_v<decltype(compare), BytewiseKeyCompare>) {
+        return "bytewise";
+      } else if (std::is_same_v<decltype(compare),
+                                BytewiseInternalKeyCompare>) {
+        return "internal";
+      }
+      return "virtual";
+    });
+  };
+  const InternalKeyComparator icmp(BytewiseComparator());
+  const InternalKeyComparator nested(&icmp);
+  ASSERT_EQ("bytewise", name(BytewiseComparator()));
+  ASSERT_EQ("internal", name(&icmp));
+  ASSERT_EQ("virtual", name(&nested));
+}
+
+} // namespace leveldb
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
 #include <cstdint>
+#include <iterator>
+#include <set>
+#include <thread>
+#include <vector>
 
 #include "skiplist.h"
+#include "util/random.h"
 
 // The purpose of these tests are just to  make sure that gtest was properly
 // installed.
@@ -39,4 +44,78 @@ TEST(SkipTest, Empty) {
   ASSERT_TRUE(!iter.Valid());
 }
 
+// Prefix of the high 32 bits only, so that many keys tie on the prefix
+struct PrefixTestComparator : public TestComparator {
+  uint64_t Prefix(const Key& key) const { return key >> 32; }
+};
+
+TEST(SkipTest, CachedPrefix) {
+  static_assert(PrefixComparator<Key, PrefixTestComparator>);
+  static_assert(!PrefixComparator<Key, TestComparator>);
+
+  Arena arena;
+  SkipList<Key, PrefixTestComparator> list(PrefixTestComparator(), &arena);
+  std::set<Key> keys;
+  Random rnd(301);
+  for (int i = 0; i < 2000; i++) {
+    const Key key = (static_cast<Key>(rnd.Uniform(8)) << 32) | rnd.Next();
+    if (keys.insert(key).second) { list.Insert(key); }
+  }
+  for (Key key : keys) { ASSERT_TRUE(list.Contains(key)); }
+  ASSERT_FALSE(list.Contains(*keys.rbegin() + 1));
+
+  SkipList<Key, PrefixTestComparator>::Iterator iter(&list);
+  iter.SeekToFirst();
+  for (Key key : keys) {
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(key, iter.key());
+    iter.Next();
+  }
+  ASSERT_FALSE(iter.Valid());
+
+  // Seek and Prev across prefix boundaries
+  for (Key key : keys) {
+    iter.Seek(key - 1);
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(key, iter.key());
+    iter.Prev();
+    auto pos = keys.find(key);
+    if (pos == keys.begin()) {
+      ASSERT_FALSE(iter.Valid());
+    } else {
+      ASSERT_EQ(*std::prev(pos), iter.key());
+    }
+  }
+}
+
+TEST(SkipTest, InsertConcurrently) {
+  Arena arena;
+  TestComparator cmp;
+  SkipList<Key, TestComparator> list(cmp, &arena);
+  // Threads insert interleaved keys, so that they race for the same links.
+  const int kThreads = 4;
+  const int kKeysPerThread = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&list, t]() {
+      for (int i = 0; i < kKeysPerThread; i++) {
+        list.InsertConcurrently(static_cast<Key>(i) * kThreads + t);
+      }
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+
+  SkipList<Key, TestComparator>::Iterator iter(&list);
+  iter.SeekToFirst();
+  for (Key key = 0; key < kThreads * kKeysPerThread; key++) {
+    ASSERT_TRUE(iter.Valid());
+    ASSERT_EQ(key, iter.key());
+    iter.Next();
+  }
+  ASSERT_FALSE(iter.Valid());
+  for (Key key = 0; key < kThreads * kKeysPerThread; key += 7) {
+    ASSERT_TRUE(list.Contains(key));
+  }
+}
+
 }  // namespace leveldb
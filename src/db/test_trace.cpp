@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "db/trace_replay.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/trace.h"
+#include "leveldb/write_batch.h"
+
+namespace leveldb {
+
+TEST(TraceTest, EncodeDecode) {
+  uint64_t last_ts = 0;
+  std::string encoded;
+  Trace put;
+  put.ts = 1000;
+  put.type = kTracePut;
+  put.key = "key";
+  put.value = "value";
+  EncodeTrace(put, &last_ts, &encoded);
+
+  last_ts = 0;
+  Trace decoded;
+  ASSERT_TRUE(DecodeTrace(encoded, &last_ts, &decoded).ok());
+  ASSERT_EQ(1000u, decoded.ts);
+  ASSERT_EQ(kTracePut, decoded.type);
+  ASSERT_EQ("key", decoded.key);
+  ASSERT_EQ("value", decoded.value);
+
+  ASSERT_FALSE(DecodeTrace(Slice(encoded.data(), 3), &last_ts, &decoded).ok());
+}
+
+TEST(TraceTest, CaptureAndReplay) {
+  Env *env = Env::Default();
+  std::string dir;
+  env->GetTestDirectory(&dir);
+  const std::string src_name = dir + "/trace_src";
+  const std::string dst_name = dir + "/trace_dst";
+  const std::string trace_file = dir + "/trace_file";
+  Options options;
+  options.create_if_missing = true;
+  DestroyDB(src_name, options);
+  DestroyDB(dst_name, options);
+
+  DB *db;
+  ASSERT_TRUE(DB::Open(options, src_name, &db).ok());
+  std::unique_ptr<TraceWriter> writer;
+  ASSERT_TRUE(NewFileTraceWriter(env, trace_file, &writer).ok());
+  ASSERT_TRUE(db->StartTrace(TraceOptions(), std::move(writer)).ok());
+  ASSERT_TRUE(db->Put(WriteOptions(), "a", "1").ok());
+  ASSERT_TRUE(db->Put(WriteOptions(), "b", "2").ok());
+  ASSERT_TRUE(db->Delete(WriteOptions(), "a").ok());
+  ASSERT_TRUE(db->Merge(WriteOptions(), "a", "x").IsNotSupported());
+  WriteBatch batch;
+  batch.Put("c", "3");
+  batch.Put("d", "4");
+  ASSERT_TRUE(db->Write(WriteOptions(), &batch).ok());
+  std::string value;
+  ASSERT_TRUE(db->Get(ReadOptions(), "b", &value).ok());
+  Iterator *iter = db->NewIterator(ReadOptions());
+  iter->Seek("c");
+  delete iter;
+  ASSERT_TRUE(db->EndTrace().ok());
+  ASSERT_FALSE(db->EndTrace().ok());
+  // Not traced
+  ASSERT_TRUE(db->Put(WriteOptions(), "e", "5").ok());
+  delete db;
+
+  ASSERT_TRUE(DB::Open(options, dst_name, &db).ok());
+  std::unique_ptr<TraceReader> reader;
+  ASSERT_TRUE(NewFileTraceReader(env, trace_file, &reader).ok());
+  Replayer replayer(db, std::move(reader));
+  ASSERT_TRUE(replayer.Replay(0).ok());
+  ASSERT_EQ(2u, replayer.num_ops(kTracePut));
+  ASSERT_EQ(1u, replayer.num_ops(kTraceDelete));
+  ASSERT_EQ(1u, replayer.num_ops(kTraceMerge));
+  ASSERT_EQ(1u, replayer.num_ops(kTraceWrite));
+  ASSERT_EQ(1u, replayer.num_ops(kTraceGet));
+  ASSERT_EQ(1u, replayer.num_ops(kTraceIteratorSeek));
+
+  ASSERT_TRUE(db->Get(ReadOptions(), "a", &value).IsNotFound());
+  ASSERT_TRUE(db->Get(ReadOptions(), "d", &value).ok());
+  ASSERT_EQ("4", value);
+  ASSERT_TRUE(db->Get(ReadOptions(), "e", &value).IsNotFound());
+  delete db;
+
+  DestroyDB(src_name, options);
+  DestroyDB(dst_name, options);
+  env->DeleteFile(trace_file);
+}
+
+} // namespace leveldb
@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/write_buffer_manager.h"
+#include "port/port.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+TEST(WriteBufferManagerTest, ShouldFlush) {
+  WriteBufferManager wbm(1 << 20);
+  ASSERT_TRUE(wbm.enabled());
+  wbm.ReserveMem(512 << 10);
+  ASSERT_FALSE(wbm.ShouldFlush());
+  // Mutable memory above 7/8 of the budget
+  wbm.ReserveMem(400 << 10);
+  ASSERT_EQ(912u << 10, wbm.mutable_memtable_memory_usage());
+  ASSERT_TRUE(wbm.ShouldFlush());
+
+  // Switched out: no longer mutable, but not freed yet
+  wbm.ScheduleFreeMem(912 << 10);
+  ASSERT_EQ(0u, wbm.mutable_memtable_memory_usage());
+  ASSERT_EQ(912u << 10, wbm.memory_usage());
+  ASSERT_FALSE(wbm.ShouldFlush());
+
+  // Over the budget in total, with half of it mutable
+  wbm.ReserveMem(512 << 10);
+  ASSERT_TRUE(wbm.ShouldFlush());
+  wbm.FreeMem(912 << 10);
+  ASSERT_FALSE(wbm.ShouldFlush());
+  wbm.ScheduleFreeMem(512 << 10);
+  wbm.FreeMem(512 << 10);
+  ASSERT_EQ(0u, wbm.memory_usage());
+
+  WriteBufferManager disabled(0);
+  disabled.ReserveMem(1 << 30);
+  ASSERT_FALSE(disabled.ShouldFlush());
+  disabled.ScheduleFreeMem(1 << 30);
+  disabled.FreeMem(1 << 30);
+}
+
+TEST(WriteBufferManagerTest, ChargesCache) {
+  std::shared_ptr<Cache> cache = NewLRUCache(4 << 20);
+  {
+    WriteBufferManager wbm(0, cache);
+    wbm.ReserveMem(1 << 20);
+    ASSERT_GE(wbm.dummy_entries_in_cache_usage(), 1u << 20);
+    ASSERT_GE(cache->TotalCharge(), 1u << 20);
+
+    // Entries are only given back once usage drops well below the charge
+    wbm.ScheduleFreeMem(1 << 20);
+    wbm.FreeMem(100 << 10);
+    ASSERT_GE(cache->TotalCharge(), wbm.memory_usage());
+    wbm.FreeMem((1 << 20) - (100 << 10));
+    ASSERT_EQ(0u, wbm.dummy_entries_in_cache_usage());
+    ASSERT_EQ(0u, cache->TotalCharge());
+
+    wbm.ReserveMem(300 << 10);
+    ASSERT_GE(cache->TotalCharge(), 300u << 10);
+  }
+  // Destroying the manager releases what it still held
+  ASSERT_EQ(0u, cache->TotalCharge());
+}
+
+// Holds background work while asked to, so that tests can run it in an
+// order of their choosing.
+class HoldWorkEnv : public EnvWrapper {
+public:
+  HoldWorkEnv() : EnvWrapper(Env::Default()), hold_(false) {}
+
+  void Schedule(void (*function)(void *), void *arg) override {
+    {
+      MutexLock l(&mu_);
+      if (hold_) {
+        work_.emplace_back(function, arg);
+        return;
+      }
+    }
+    target()->Schedule(function, arg);
+  }
+
+  void Hold() {
+    MutexLock l(&mu_);
+    hold_ = true;
+  }
+
+  size_t NumHeld() {
+    MutexLock l(&mu_);
+    return work_.size();
+  }
+
+  // Runs the i-th held work item on the calling thread.
+  void RunHeld(size_t i) {
+    std::pair<void (*)(void *), void *> work;
+    {
+      MutexLock l(&mu_);
+      work = work_[i];
+      work_.erase(work_.begin() + i);
+    }
+    work.first(work.second);
+  }
+
+  // Runs all held work, including any it schedules, and stops holding.
+  void Release() {
+    while (NumHeld() > 0) { RunHeld(0); }
+    MutexLock l(&mu_);
+    hold_ = false;
+  }
+
+private:
+  port::Mutex mu_;
+  bool hold_;
+  std::deque<std::pair<void (*)(void *), void *>> work_;
+};
+
+class WriteBufferManagerDBTest : public testing::Test {
+public:
+  WriteBufferManagerDBTest()
+      : env_(Env::Default()),
+        wbm_(std::make_shared<WriteBufferManager>(1 << 20)) {
+    std::string dir;
+    env_->GetTestDirectory(&dir);
+    for (int i = 0; i < 2; i++) {
+      dbnames_[i] = dir + "/write_buffer_manager_test" + std::to_string(i);
+    }
+    options_.create_if_missing = true;
+    // Large enough that only the write buffer manager switches memtables
+    options_.write_buffer_size = 64 << 20;
+    options_.write_buffer_manager = wbm_;
+    for (int i = 0; i < 2; i++) {
+      DestroyDB(dbnames_[i], options_);
+      dbs_[i] = nullptr;
+      EXPECT_TRUE(DB::Open(options_, dbnames_[i], &dbs_[i]).ok());
+    }
+  }
+
+  ~WriteBufferManagerDBTest() override {
+    hold_work_env_.Release();
+    for (int i = 0; i < 2; i++) {
+      delete dbs_[i];
+      DestroyDB(dbnames_[i], options_);
+    }
+  }
+
+  // Writes about "bytes" of memtable data to dbs_[db].
+  void Fill(int db, size_t bytes) {
+    const std::string value(1000, 'v');
+    for (size_t i = 0; i < bytes / value.size(); i++) {
+      ASSERT_TRUE(dbs_[db]
+                      ->Put(WriteOptions(),
+                            "key" + std::to_string(db) + std::to_string(i),
+                            value)
+                      .ok());
+    }
+  }
+
+  uint64_t ActiveEntries(int db) {
+    uint64_t n = 0;
+    EXPECT_TRUE(
+        dbs_[db]->GetIntProperty("leveldb.num-entries-active-mem-table", &n));
+    return n;
+  }
+
+  Env *env_;
+  HoldWorkEnv hold_work_env_;
+  std::shared_ptr<WriteBufferManager> wbm_;
+  std::string dbnames_[2];
+  Options options_;
+  DB *dbs_[2];
+};
+
+TEST_F(WriteBufferManagerDBTest, CapsMemTableMemory) {
+  Fill(0, 4 << 20);
+  ASSERT_LE(wbm_->mutable_memtable_memory_usage(), 1u << 20);
+  std::string value;
+  ASSERT_TRUE(dbs_[0]->Get(ReadOptions(), "key00", &value).ok());
+  ASSERT_EQ(1000u, value.size());
+}
+
+TEST_F(WriteBufferManagerDBTest, FlushesLargestDB) {
+  Fill(0, 600 << 10);
+  ASSERT_GT(ActiveEntries(0), 0u);
+  // Pushes the total over the budget; dbs_[0] holds the largest memtable
+  // and switches it out although nothing is written to it.
+  Fill(1, 500 << 10);
+  for (int i = 0; i < 1000 && ActiveEntries(0) > 0; i++) {
+    env_->SleepForMicroseconds(10000);
+  }
+  ASSERT_EQ(0u, ActiveEntries(0));
+  ASSERT_GT(ActiveEntries(1), 0u);
+}
+
+TEST_F(WriteBufferManagerDBTest, RetriesFlushRequestOnceImmHasRoom) {
+  // dbs_[0] can hold a single immutable memtable, which it fills before
+  // the budget is crossed
+  delete dbs_[0];
+  dbs_[0] = nullptr;
+  Options options = options_;
+  options.env = &hold_work_env_;
+  options.write_buffer_size = 700 << 10;
+  options.max_write_buffer_number = 2;
+  ASSERT_TRUE(DB::Open(options, dbnames_[0], &dbs_[0]).ok());
+  hold_work_env_.Hold();
+  const std::string value(1000, 'v');
+  // Write until the memtable is switched and the imm_ flush is scheduled
+  for (int i = 0; hold_work_env_.NumHeld() == 0; i++) {
+    ASSERT_LT(i, 1000);
+    ASSERT_TRUE(
+        dbs_[0]->Put(WriteOptions(), "key0" + std::to_string(i), value).ok());
+  }
+  uint64_t num_imm = 0;
+  ASSERT_TRUE(
+      dbs_[0]->GetIntProperty("leveldb.num-immutable-mem-table", &num_imm));
+  ASSERT_EQ(1u, num_imm);
+  Fill(0, 250 << 10);
+
+  // Crossing it requests a flush of dbs_[0], the largest
+  for (int i = 0; hold_work_env_.NumHeld() == 1; i++) {
+    ASSERT_LT(i, 1000);
+    ASSERT_TRUE(
+        dbs_[1]->Put(WriteOptions(), "key1" + std::to_string(i), value).ok());
+  }
+  ASSERT_EQ(2u, hold_work_env_.NumHeld());
+
+  // The request runs first and finds no room in imm_
+  hold_work_env_.RunHeld(1);
+  ASSERT_GT(ActiveEntries(0), 0u);
+  // Flushing imm_ retries it, although dbs_[0] is not written to
+  hold_work_env_.Release();
+  ASSERT_EQ(0u, ActiveEntries(0));
+}
+
+} // namespace leveldb
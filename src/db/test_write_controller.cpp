@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "db/write_controller.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+
+namespace leveldb {
+
+TEST(WriteControllerTest, Pressure) {
+  ASSERT_LT(WriteController::Pressure(7, 8, 12), 0);
+  ASSERT_EQ(0, WriteController::Pressure(8, 8, 12));
+  ASSERT_EQ(0.5, WriteController::Pressure(10, 8, 12));
+  ASSERT_EQ(1, WriteController::Pressure(12, 8, 12));
+  ASSERT_LT(WriteController::Pressure(100, -1, 12), 0);
+  ASSERT_EQ(1, WriteController::Pressure(8, 8, 8));
+}
+
+TEST(WriteControllerTest, RateFallsWithPressure) {
+  const uint64_t max_rate = 16 << 20;
+  WriteController controller(max_rate);
+  ASSERT_FALSE(controller.NeedsDelay());
+  ASSERT_EQ(0u, controller.delayed_write_rate());
+
+  controller.SetPressure(0);
+  ASSERT_TRUE(controller.NeedsDelay());
+  ASSERT_EQ(max_rate, controller.delayed_write_rate());
+  // Geometric: halfway between 16MB/s and 16KB/s is 512KB/s
+  controller.SetPressure(0.5);
+  ASSERT_NEAR(512 << 10, controller.delayed_write_rate(), 1024);
+  controller.SetPressure(1);
+  ASSERT_EQ(WriteController::kMinDelayedWriteRate,
+            controller.delayed_write_rate());
+  controller.SetPressure(5);
+  ASSERT_EQ(WriteController::kMinDelayedWriteRate,
+            controller.delayed_write_rate());
+
+  controller.SetPressure(-1);
+  ASSERT_FALSE(controller.NeedsDelay());
+  ASSERT_EQ(0u, controller.GetDelay(1000000, 1 << 20));
+}
+
+TEST(WriteControllerTest, GetDelay) {
+  WriteController controller(1 << 20);  // 1MB/s
+  controller.SetPressure(0);
+  uint64_t now = 1000000;
+
+  // 100KB at 1MB/s takes 1/10.24 seconds
+  const uint64_t delay = controller.GetDelay(now, 100 << 10);
+  ASSERT_NEAR(97656, delay, 1000);
+
+  // Writes over a second of simulated time are paced to the rate
+  uint64_t written = 0;
+  const uint64_t start = now + delay;
+  now = start;
+  while (now < start + 1000000) {
+    now += controller.GetDelay(now, 1000);
+    written += 1000;
+    now += 10;  // the write itself
+  }
+  ASSERT_NEAR(1 << 20, written, 1 << 16);
+
+  // Idle time only buys a small burst
+  now += 10000000;
+  ASSERT_EQ(0u, controller.GetDelay(now, 1000));
+  ASSERT_GT(controller.GetDelay(now, 1 << 20), 900000u);
+}
+
+TEST(WriteControllerTest, DelaysWrites) {
+  Env *env = Env::Default();
+  std::string dbname;
+  env->GetTestDirectory(&dbname);
+  dbname += "/write_controller_test";
+  Options options;
+  options.create_if_missing = true;
+  // Every write is delayed, without any level-0 files
+  options.level0_slowdown_writes_trigger = 0;
+  options.delayed_write_rate = 1 << 20;
+  DestroyDB(dbname, options);
+  DB *db;
+  ASSERT_TRUE(DB::Open(options, dbname, &db).ok());
+
+  uint64_t rate;
+  ASSERT_TRUE(db->GetIntProperty("leveldb.actual-delayed-write-rate", &rate));
+  ASSERT_EQ(1u << 20, rate);
+  uint64_t stopped;
+  ASSERT_TRUE(db->GetIntProperty("leveldb.is-write-stopped", &stopped));
+  ASSERT_EQ(0u, stopped);
+
+  const uint64_t start = env->NowMicros();
+  const std::string value(10000, 'x');
+  for (int i = 0; i < 30; i++) {
+    ASSERT_TRUE(db->Put(WriteOptions(), std::to_string(i), value).ok());
+  }
+  // 300KB at 1MB/s, less the first write, which is not delayed
+  ASSERT_GE(env->NowMicros() - start, 250000u);
+
+  delete db;
+  DestroyDB(dbname, options);
+}
+
+} // namespace leveldb
@@ -0,0 +1,355 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "db/trace_replay.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "db/write_batch_interal.h"
+#include "leveldb/db.h"
+#include "leveldb/iterator.h"
+#include "leveldb/write_batch.h"
+#include "util/coding.h"
+
+namespace leveldb {
+
+static const char kTraceMagic[] = "leveldb.trace";
+static const uint32_t kTraceVersion = 1;
+
+TraceWriter::~TraceWriter() {}
+
+TraceReader::~TraceReader() {}
+
+void EncodeTrace(const Trace &trace, uint64_t *last_ts, std::string *dst) {
+  PutVarint64(dst, trace.ts - *last_ts);
+  *last_ts = trace.ts;
+  dst->push_back(static_cast<char>(trace.type));
+  switch (trace.type) {
+    case kTraceBegin:
+      PutLengthPrefixedSlice(dst, Slice(kTraceMagic));
+      PutVarint32(dst, kTraceVersion);
+      break;
+    case kTraceEnd:
+      break;
+    case kTracePut:
+    case kTraceMerge:
+      PutLengthPrefixedSlice(dst, trace.key);
+      PutLengthPrefixedSlice(dst, trace.value);
+      break;
+    default:
+      PutLengthPrefixedSlice(dst, trace.key);
+      break;
+  }
+}
+
+Status DecodeTrace(const Slice &src, uint64_t *last_ts, Trace *trace) {
+  Slice input = src;
+  uint64_t delta;
+  if (!GetVarint64(&input, &delta) || input.empty()) {
+    return Status::Corruption("truncated trace record");
+  }
+  trace->ts = *last_ts + delta;
+  *last_ts = trace->ts;
+  const unsigned char type = input[0];
+  input.remove_prefix(1);
+  if (type < kTraceBegin || type >= kTraceTypeMax) {
+    return Status::Corruption("unknown trace record type");
+  }
+  trace->type = static_cast<TraceType>(type);
+  trace->key.clear();
+  trace->value.clear();
+
+  Slice key, value;
+  switch (trace->type) {
+    case kTraceBegin: {
+      uint32_t version;
+      if (!GetLengthPrefixedSlice(&input, &key) || key != Slice(kTraceMagic) ||
+          !GetVarint32(&input, &version)) {
+        return Status::Corruption("not a trace file");
+      }
+      if (version != kTraceVersion) {
+        return Status::NotSupported("unknown trace version");
+      }
+      break;
+    }
+    case kTraceEnd:
+      break;
+    case kTracePut:
+    case kTraceMerge:
+      if (!GetLengthPrefixedSlice(&input, &key) ||
+          !GetLengthPrefixedSlice(&input, &value)) {
+        return Status::Corruption("bad trace record payload");
+      }
+      trace->key.assign(key.data(), key.size());
+      trace->value.assign(value.data(), value.size());
+      break;
+    default:
+      if (!GetLengthPrefixedSlice(&input, &key)) {
+        return Status::Corruption("bad trace record payload");
+      }
+      trace->key.assign(key.data(), key.size());
+      break;
+  }
+  return Status::OK();
+}
+
+namespace {
+
+class FileTraceWriter : public TraceWriter {
+ public:
+  explicit FileTraceWriter(std::unique_ptr<WritableFile> &&file)
+      : file_(std::move(file)), size_(0) {}
+  ~FileTraceWriter() override { Close(); }
+
+  Status Write(const Slice &record) override {
+    buf_.clear();
+    PutLengthPrefixedSlice(&buf_, record);
+    size_ += buf_.size();
+    return file_->Append(buf_);
+  }
+
+  Status Close() override {
+    if (file_ == nullptr) { return Status::OK(); }
+    Status s = file_->Close();
+    file_.reset();
+    return s;
+  }
+
+  uint64_t GetFileSize() override { return size_; }
+
+ private:
+  std::unique_ptr<WritableFile> file_;
+  std::string buf_;
+  uint64_t size_;
+};
+
+class FileTraceReader : public TraceReader {
+ public:
+  explicit FileTraceReader(std::unique_ptr<SequentialFile> &&file)
+      : file_(std::move(file)),
+        backing_(new char[kBufferSize]),
+        eof_(false) {}
+
+  Status Read(std::string *record) override {
+    // A varint32 length never takes more than 5 bytes.
+    Status s = Fill(5);
+    if (!s.ok()) { return s; }
+    if (buffer_.empty()) { return Status::NotFound("end of trace"); }
+    const char *start = buffer_.data();
+    uint32_t len;
+    const char *p = GetVarint32Ptr(start, start + buffer_.size(), &len);
+    if (p == nullptr) { return Status::Corruption("bad trace record length"); }
+    const size_t header = p - start;
+    s = Fill(header + len);
+    if (!s.ok()) { return s; }
+    if (buffer_.size() < header + len) {
+      return Status::Corruption("truncated trace file");
+    }
+    record->assign(buffer_.data() + header, len);
+    buffer_.erase(0, header + len);
+    return Status::OK();
+  }
+
+  Status Close() override {
+    file_.reset();
+    return Status::OK();
+  }
+
+ private:
+  static const size_t kBufferSize = 64 << 10;
+
+  // Read from the file until buffer_ holds at least "n" bytes or the end
+  // of the file is reached.
+  Status Fill(size_t n) {
+    while (buffer_.size() < n && !eof_) {
+      Slice fragment;
+      Status s = file_->Read(kBufferSize, &fragment, backing_.get());
+      if (!s.ok()) { return s; }
+      if (fragment.empty()) { eof_ = true; }
+      buffer_.append(fragment.data(), fragment.size());
+    }
+    return Status::OK();
+  }
+
+  std::unique_ptr<SequentialFile> file_;
+  std::unique_ptr<char[]> backing_;
+  std::string buffer_;
+  bool eof_;
+};
+
+}  // anonymous namespace
+
+Status NewFileTraceWriter(Env *env, const std::string &trace_filename,
+                          std::unique_ptr<TraceWriter> *trace_writer) {
+  std::unique_ptr<WritableFile> file;
+  Status s = env->NewWritableFile(trace_filename, &file, EnvOptions());
+  if (s.ok()) { trace_writer->reset(new FileTraceWriter(std::move(file))); }
+  return s;
+}
+
+Status NewFileTraceReader(Env *env, const std::string &trace_filename,
+                          std::unique_ptr<TraceReader> *trace_reader) {
+  std::unique_ptr<SequentialFile> file;
+  Status s = env->NewSequentialFile(trace_filename, &file, EnvOptions());
+  if (s.ok()) { trace_reader->reset(new FileTraceReader(std::move(file))); }
+  return s;
+}
+
+Tracer::Tracer(Env *env, const TraceOptions &options,
+               std::unique_ptr<TraceWriter> &&writer)
+    : env_(env),
+      options_(options),
+      writer_(std::move(writer)),
+      trace_request_count_(0),
+      last_ts_(0) {
+  WriteTrace(kTraceBegin, Slice(), Slice());
+}
+
+Tracer::~Tracer() { Close(); }
+
+Status Tracer::Get(const Slice &key) {
+  if (ShouldSkipTrace()) { return Status::OK(); }
+  return WriteTrace(kTraceGet, key, Slice());
+}
+
+Status Tracer::Put(const Slice &key, const Slice &value) {
+  if (ShouldSkipTrace()) { return Status::OK(); }
+  return WriteTrace(kTracePut, key, value);
+}
+
+Status Tracer::Delete(const Slice &key) {
+  if (ShouldSkipTrace()) { return Status::OK(); }
+  return WriteTrace(kTraceDelete, key, Slice());
+}
+
+Status Tracer::Merge(const Slice &key, const Slice &value) {
+  if (ShouldSkipTrace()) { return Status::OK(); }
+  return WriteTrace(kTraceMerge, key, value);
+}
+
+Status Tracer::Write(WriteBatch *batch) {
+  if (batch == nullptr || ShouldSkipTrace()) { return Status::OK(); }
+  return WriteTrace(kTraceWrite, WriteBatchInternal::Contents(batch), Slice());
+}
+
+Status Tracer::IteratorSeek(const Slice &target) {
+  if (ShouldSkipTrace()) { return Status::OK(); }
+  return WriteTrace(kTraceIteratorSeek, target, Slice());
+}
+
+Status Tracer::Close() {
+  if (writer_ == nullptr) { return Status::OK(); }
+  Status s = WriteTrace(kTraceEnd, Slice(), Slice());
+  Status c = writer_->Close();
+  writer_.reset();
+  return s.ok() ? c : s;
+}
+
+bool Tracer::ShouldSkipTrace() {
+  if (writer_ == nullptr ||
+      writer_->GetFileSize() > options_.max_trace_file_size) {
+    return true;
+  }
+  ++trace_request_count_;
+  if (trace_request_count_ < options_.sampling_frequency) { return true; }
+  trace_request_count_ = 0;
+  return false;
+}
+
+Status Tracer::WriteTrace(TraceType type, const Slice &key,
+                          const Slice &value) {
+  Trace trace;
+  trace.ts = env_->NowMicros();
+  trace.type = type;
+  trace.key.assign(key.data(), key.size());
+  trace.value.assign(value.data(), value.size());
+  std::string record;
+  EncodeTrace(trace, &last_ts_, &record);
+  return writer_->Write(record);
+}
+
+Replayer::Replayer(DB *db, std::unique_ptr<TraceReader> &&reader)
+    : db_(db), reader_(std::move(reader)) {
+  std::memset(num_ops_, 0, sizeof(num_ops_));
+}
+
+Status Replayer::Replay(double speed) {
+  Env *env = Env::Default();
+  std::string record;
+  Trace trace;
+  uint64_t last_ts = 0;
+
+  Status s = reader_->Read(&record);
+  if (s.ok()) { s = DecodeTrace(record, &last_ts, &trace); }
+  if (s.ok() && trace.type != kTraceBegin) {
+    s = Status::Corruption("trace does not start with a header");
+  }
+  if (!s.ok()) { return s; }
+  const uint64_t trace_start = trace.ts;
+  const uint64_t replay_start = env->NowMicros();
+
+  ReadOptions read_options;
+  WriteOptions write_options;
+  std::string value;
+  while (true) {
+    s = reader_->Read(&record);
+    if (s.IsNotFound()) {
+      // Trace was cut short without a trailer, e.g. the traced process died
+      s = Status::OK();
+      break;
+    }
+    if (s.ok()) { s = DecodeTrace(record, &last_ts, &trace); }
+    if (!s.ok() || trace.type == kTraceEnd) { break; }
+
+    if (speed > 0) {
+      const uint64_t due = replay_start + static_cast<uint64_t>(
+                                              (trace.ts - trace_start) / speed);
+      // Sleep in slices, SleepForMicroseconds() takes an int
+      for (uint64_t now = env->NowMicros(); due > now;
+           now = env->NowMicros()) {
+        env->SleepForMicroseconds(
+            static_cast<int>(std::min<uint64_t>(due - now, 1000000)));
+      }
+    }
+
+    switch (trace.type) {
+      case kTraceGet:
+        s = db_->Get(read_options, trace.key, &value);
+        break;
+      case kTracePut:
+        s = db_->Put(write_options, trace.key, trace.value);
+        break;
+      case kTraceDelete:
+        s = db_->Delete(write_options, trace.key);
+        break;
+      case kTraceMerge:
+        s = db_->Merge(write_options, trace.key, trace.value);
+        break;
+      case kTraceWrite: {
+        WriteBatch batch;
+        WriteBatchInternal::SetContents(&batch, trace.key);
+        s = db_->Write(write_options, &batch);
+        break;
+      }
+      case kTraceIteratorSeek: {
+        std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+        iter->Seek(trace.key);
+        s = iter->status();
+        break;
+      }
+      default:
+        s = Status::Corruption("unexpected trace record");
+        break;
+    }
+    if (s.IsNotFound()) { s = Status::OK(); }
+    // The traced DB failed the same way, merge is not implemented
+    if (trace.type == kTraceMerge && s.IsNotSupported()) { s = Status::OK(); }
+    if (!s.ok()) { break; }
+    num_ops_[trace.type]++;
+  }
+  return s;
+}
+
+} // namespace leveldb
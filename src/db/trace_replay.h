@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+#include "leveldb/trace.h"
+
+namespace leveldb {
+
+class DB;
+class WriteBatch;
+
+// A trace is a sequence of records, each stored in the file as a
+// length-prefixed slice.  A record is laid out as
+//    delta_micros: varint64  -- time since the previous record
+//    type:         uint8     -- TraceType
+//    payload:      length-prefixed slices, depending on the type
+// kTraceBegin payload: magic string, then the version as a varint32.
+// Its delta is the absolute start time, so every timestamp in the trace
+// can be recovered by summing the deltas.
+enum TraceType : unsigned char {
+  kTraceBegin = 1,
+  kTraceEnd = 2,
+  kTraceGet = 3,          // key
+  kTracePut = 4,          // key, value
+  kTraceDelete = 5,       // key
+  kTraceMerge = 6,        // key, value
+  kTraceWrite = 7,        // WriteBatch contents
+  kTraceIteratorSeek = 8, // target
+  kTraceTypeMax
+};
+
+struct Trace {
+  uint64_t ts = 0; // micros
+  TraceType type = kTraceTypeMax;
+  std::string key;   // key, seek target or WriteBatch contents
+  std::string value; // Put and Merge only
+};
+
+// Encodes/decodes a record, "*last_ts" carries the timestamp of the
+// previous record between calls and starts at 0.
+void EncodeTrace(const Trace &trace, uint64_t *last_ts, std::string *dst);
+Status DecodeTrace(const Slice &src, uint64_t *last_ts, Trace *trace);
+
+// Tracer records the calls made on a DB.  Not thread safe, DBImpl
+// serializes access.
+class Tracer {
+public:
+  Tracer(Env *env, const TraceOptions &options,
+         std::unique_ptr<TraceWriter> &&writer);
+  ~Tracer();
+
+  // No copying allowed
+  Tracer(const Tracer &) = delete;
+  void operator=(const Tracer &) = delete;
+
+  Status Get(const Slice &key);
+  Status Put(const Slice &key, const Slice &value);
+  Status Delete(const Slice &key);
+  Status Merge(const Slice &key, const Slice &value);
+  Status Write(WriteBatch *batch);
+  Status IteratorSeek(const Slice &target);
+
+  // Write the trailer and close the writer.
+  Status Close();
+
+private:
+  // Returns true if the current query is not sampled or the trace is
+  // already full.
+  bool ShouldSkipTrace();
+  Status WriteTrace(TraceType type, const Slice &key, const Slice &value);
+
+  Env *const env_;
+  const TraceOptions options_;
+  std::unique_ptr<TraceWriter> writer_;
+  uint64_t trace_request_count_;
+  uint64_t last_ts_;
+};
+
+// Replayer issues the calls recorded in a trace against "db".
+class Replayer {
+public:
+  Replayer(DB *db, std::unique_ptr<TraceReader> &&reader);
+
+  // No copying allowed
+  Replayer(const Replayer &) = delete;
+  void operator=(const Replayer &) = delete;
+
+  // Replay the whole trace.  Calls are issued with the gaps between them
+  // divided by "speed", so 1.0 is the original pace and 2.0 twice as fast.
+  // A speed of 0 replays as fast as possible.  Errors from the DB (other
+  // than NotFound) stop the replay and are returned.
+  Status Replay(double speed);
+
+  // Number of replayed calls of the given type.
+  uint64_t num_ops(TraceType type) const { return num_ops_[type]; }
+
+private:
+  DB *const db_;
+  std::unique_ptr<TraceReader> reader_;
+  uint64_t num_ops_[kTraceTypeMax];
+};
+
+} // namespace leveldb
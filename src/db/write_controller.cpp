@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "db/write_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace leveldb {
+
+namespace {
+
+constexpr uint64_t kMicrosPerSecond = 1000000;
+// Writers never sleep for less than this, and idle time never buys more
+// than this much credit.
+constexpr uint64_t kRefillIntervalMicros = 1000;
+
+} // namespace
+
+WriteController::WriteController(uint64_t max_delayed_write_rate)
+    : max_delayed_write_rate_(
+          std::max(max_delayed_write_rate, kMinDelayedWriteRate)),
+      delayed_(false),
+      delayed_write_rate_(max_delayed_write_rate_),
+      credit_bytes_(0),
+      last_refill_micros_(0) {}
+
+double WriteController::Pressure(double value, double slowdown, double stop) {
+  if (slowdown < 0 || value < slowdown) { return -1; }
+  if (stop <= slowdown) { return 1; }
+  return (value - slowdown) / (stop - slowdown);
+}
+
+void WriteController::SetPressure(double pressure) {
+  if (pressure < 0) {
+    delayed_.store(false, std::memory_order_relaxed);
+    return;
+  }
+  // Interpolate geometrically, so that each step of pressure cuts the
+  // rate by the same factor.
+  const double p = std::min(pressure, 1.0);
+  const double min_ratio = static_cast<double>(kMinDelayedWriteRate) /
+                           static_cast<double>(max_delayed_write_rate_);
+  delayed_write_rate_ = std::max(
+      kMinDelayedWriteRate,
+      static_cast<uint64_t>(max_delayed_write_rate_ * std::pow(min_ratio, p)));
+  if (!NeedsDelay()) {
+    // Start from an empty bucket
+    credit_bytes_ = 0;
+    last_refill_micros_ = 0;
+    delayed_.store(true, std::memory_order_relaxed);
+  }
+}
+
+uint64_t WriteController::GetDelay(uint64_t now_micros, uint64_t num_bytes) {
+  if (!NeedsDelay()) { return 0; }
+  if (last_refill_micros_ == 0) {
+    last_refill_micros_ = now_micros;
+  } else if (last_refill_micros_ < now_micros) {
+    const uint64_t burst =
+        delayed_write_rate_ * kRefillIntervalMicros / kMicrosPerSecond;
+    credit_bytes_ = std::min(
+        burst, credit_bytes_ + (now_micros - last_refill_micros_) *
+                                   delayed_write_rate_ / kMicrosPerSecond);
+    last_refill_micros_ = now_micros;
+  }
+  if (credit_bytes_ >= num_bytes) {
+    credit_bytes_ -= num_bytes;
+    return 0;
+  }
+
+  // Sleep until the missing bytes are credited, in whole refill intervals;
+  // whatever that credits beyond them is left for the next writers.
+  const uint64_t deficit = num_bytes - credit_bytes_;
+  uint64_t micros = (deficit * kMicrosPerSecond + delayed_write_rate_ - 1) /
+                    delayed_write_rate_;
+  micros = std::max(micros, kRefillIntervalMicros);
+  credit_bytes_ = micros * delayed_write_rate_ / kMicrosPerSecond - deficit;
+  last_refill_micros_ += micros;
+  return last_refill_micros_ - now_micros;
+}
+
+} // namespace leveldb
@@ -0,0 +1,63 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace leveldb {
+
+// Throttles writes while compaction falls behind.  DBImpl reduces its
+// state to a single "pressure" figure: below 0 writes run at full speed,
+// from 0 they are delayed to a rate that falls smoothly from the
+// configured delayed write rate at 0 to kMinDelayedWriteRate at 1.
+// Stopping writes is left to the caller, for when even that is not
+// enough.
+//
+// Not thread safe; DBImpl calls everything with its mutex held, except
+// NeedsDelay().
+class WriteController {
+public:
+  static constexpr uint64_t kMinDelayedWriteRate = 16 << 10; // bytes/s
+
+  explicit WriteController(uint64_t max_delayed_write_rate);
+
+  // No copying allowed
+  WriteController(const WriteController &) = delete;
+  void operator=(const WriteController &) = delete;
+
+  // How far "value" is from "slowdown" towards "stop", e.g. 0.5 halfway
+  // between them and negative below "slowdown".  Returns -1 if "slowdown"
+  // is negative, which disables the trigger.
+  static double Pressure(double value, double slowdown, double stop);
+
+  // Set the pressure, the largest of Pressure() over every signal.
+  void SetPressure(double pressure);
+
+  // Safe to call without synchronization.
+  bool NeedsDelay() const { return delayed_.load(std::memory_order_relaxed); }
+
+  // Current delayed write rate in bytes per second, 0 if not delayed.
+  uint64_t delayed_write_rate() const {
+    return NeedsDelay() ? delayed_write_rate_ : 0;
+  }
+
+  // Micros to sleep before writing "num_bytes" at the delayed write rate.
+  // Small writes mostly draw on credit and return 0.
+  uint64_t GetDelay(uint64_t now_micros, uint64_t num_bytes);
+
+private:
+  const uint64_t max_delayed_write_rate_;
+  std::atomic<bool> delayed_;
+  uint64_t delayed_write_rate_;
+
+  // Token bucket: bytes that may be written without sleeping, and the time
+  // up to which they were credited.  The latter is in the future while
+  // earlier writers are still sleeping off their delay.
+  uint64_t credit_bytes_;
+  uint64_t last_refill_micros_;
+};
+
+} // namespace leveldb
@@ -23,6 +23,12 @@ class AtomicPointer {
   inline void NoBarrier_Store(void *v) {
     rep_.store(v, std::memory_order_relaxed);
   }
+  // Release-stores "v" if the value is still "expected".  Returns whether
+  // it did.
+  inline bool CompareAndSwap(void *expected, void *v) {
+    return rep_.compare_exchange_strong(expected, v, std::memory_order_release,
+                                        std::memory_order_relaxed);
+  }
 
  private:
   std::atomic<void *> rep_;
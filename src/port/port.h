@@ -6,11 +6,20 @@
 
 #include <pthread.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
 #include "atomic_pointer.h"
 
 namespace leveldb::port {
 static constexpr bool kLittleEndian = true;
 
+// Size of a cache line on the platforms we build for.  Used to pad hot,
+// per-thread or per-core data so that writers on different cores do not
+// invalidate each other's lines.
+static constexpr size_t kCacheLineSize = 64;
+
 class CondVar;
 class Mutex {
  public:
@@ -29,4 +38,44 @@ class Mutex {
   pthread_mutex_t mu_;
 };
 
-}  // namespace leveldb::port
\ No newline at end of file
+class CondVar {
+ public:
+  explicit CondVar(Mutex *mu);
+  ~CondVar();
+  void Wait();
+  // Timed condition wait.  Returns true if timeout occurred.
+  // "abs_time_us" is an absolute wall clock time in microseconds.
+  bool TimedWait(uint64_t abs_time_us);
+  void Signal();
+  void SignalAll();
+
+  // No copying
+  CondVar(const CondVar &) = delete;
+  void operator=(const CondVar &) = delete;
+
+ private:
+  pthread_cond_t cv_;
+  Mutex *mu_;
+};
+
+// Block compression.  Each routine returns false if the library it wraps
+// was not compiled in (SNAPPY / ZLIB), in which case callers store the
+// block uncompressed.
+bool Snappy_Compress(const char *input, size_t length, std::string *output);
+bool Snappy_GetUncompressedLength(const char *input, size_t length,
+                                  size_t *result);
+bool Snappy_Uncompress(const char *input, size_t length, char *output);
+
+bool Zlib_Compress(int window_bits, int level, int strategy, const char *input,
+                   size_t length, std::string *output);
+// Returns a new[]-allocated buffer holding the uncompressed data and sets
+// *decompress_size, or nullptr on failure.
+char *Zlib_Uncompress(int window_bits, const char *input, size_t length,
+                      int *decompress_size);
+
+// Returns the id of the cpu the calling thread is currently running on, or
+// a negative value if the platform cannot tell.  The result is only a hint:
+// the thread may be migrated right after the call returns.
+int PhysicalCoreID();
+
+}  // namespace leveldb::port
@@ -1,11 +1,44 @@
-// SPDX-FileCopyrightText: LakeSoul Contributors
-//
-// SPDX-License-Identifier: Apache-2.0
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "leveldb/iterator.h"
+
+namespace leveldb {
+
+struct BlockContents;
+class Comparator;
 
 class Block {
+public:
+  // Initialize the block with the specified contents.
+  explicit Block(const BlockContents &contents);
+
+  ~Block();
+
+  size_t size() const { return size_; }
+  const char *data() const { return data_; }
+  Iterator *NewIterator(const Comparator *comparator);
 
 private:
+  template <typename KeyCompare>
+  class Iter;
+
+  uint32_t NumRestarts() const;
+
+  const char *data_;
+  size_t size_;
+  uint32_t restart_offset_;  // Offset in data_ of restart array
+  bool owned_;               // Block owns data_[]
+
   // No copying allowed
   Block(const Block &);
   void operator=(const Block &);
-};
\ No newline at end of file
+};
+
+}  // namespace leveldb
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "table/block_cache_tracer.h"
+
+#include <algorithm>
+
+#include "util/coding.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+static const char kBlockCacheTraceMagic[] = "leveldb.block_cache_trace";
+static const uint32_t kBlockCacheTraceVersion = 1;
+
+void EncodeBlockCacheTraceRecord(const BlockCacheTraceRecord &record,
+                                 uint64_t *last_ts, std::string *dst) {
+  PutVarint64(dst, record.access_timestamp - *last_ts);
+  *last_ts = record.access_timestamp;
+  PutVarint64(dst, record.file_number);
+  PutVarint64(dst, record.block_offset);
+  PutVarint64(dst, record.block_size);
+  dst->push_back(static_cast<char>(record.block_type));
+  dst->push_back(static_cast<char>(record.caller));
+  PutVarint32(dst, static_cast<uint32_t>(record.level + 1));
+  dst->push_back(static_cast<char>((record.is_cache_hit ? 1 : 0) |
+                                   (record.no_insert ? 2 : 0)));
+}
+
+Status DecodeBlockCacheTraceRecord(const Slice &src, uint64_t *last_ts,
+                                   BlockCacheTraceRecord *record) {
+  Slice input = src;
+  uint64_t delta;
+  uint32_t level;
+  if (!GetVarint64(&input, &delta) ||
+      !GetVarint64(&input, &record->file_number) ||
+      !GetVarint64(&input, &record->block_offset) ||
+      !GetVarint64(&input, &record->block_size) || input.size() < 2) {
+    return Status::Corruption("truncated block cache trace record");
+  }
+  const unsigned char type = input[0];
+  const unsigned char caller = input[1];
+  input.remove_prefix(2);
+  if (!GetVarint32(&input, &level) || input.size() != 1) {
+    return Status::Corruption("truncated block cache trace record");
+  }
+  if (type >= kTraceBlockTypeMax || caller == 0 ||
+      caller >= kMaxTableReaderCaller) {
+    return Status::Corruption("bad block cache trace record");
+  }
+  const unsigned char flags = input[0];
+  record->access_timestamp = *last_ts + delta;
+  *last_ts = record->access_timestamp;
+  record->block_type = static_cast<TraceBlockType>(type);
+  record->caller = static_cast<TableReaderCaller>(caller);
+  record->level = static_cast<int>(level) - 1;
+  record->is_cache_hit = (flags & 1) != 0;
+  record->no_insert = (flags & 2) != 0;
+  return Status::OK();
+}
+
+BlockCacheTracer::BlockCacheTracer()
+    : tracing_(false), env_(nullptr), last_ts_(0) {}
+
+BlockCacheTracer::~BlockCacheTracer() { EndTrace(); }
+
+Status BlockCacheTracer::StartTrace(Env *env, const TraceOptions &options,
+                                    std::unique_ptr<TraceWriter> &&writer) {
+  MutexLock l(&mu_);
+  if (writer_ != nullptr) {
+    return Status::InvalidArgument("a block cache trace is already running");
+  }
+  std::string header;
+  PutLengthPrefixedSlice(&header, Slice(kBlockCacheTraceMagic));
+  PutVarint32(&header, kBlockCacheTraceVersion);
+  Status s = writer->Write(header);
+  if (!s.ok()) { return s; }
+  env_ = env;
+  options_ = options;
+  writer_ = std::move(writer);
+  last_ts_ = 0;
+  tracing_.store(true, std::memory_order_release);
+  return s;
+}
+
+Status BlockCacheTracer::EndTrace() {
+  MutexLock l(&mu_);
+  if (writer_ == nullptr) {
+    return Status::InvalidArgument("no active block cache trace");
+  }
+  tracing_.store(false, std::memory_order_release);
+  Status s = writer_->Close();
+  writer_.reset();
+  return s;
+}
+
+Status BlockCacheTracer::WriteBlockAccess(BlockCacheTraceRecord record) {
+  char key[16];
+  EncodeFixed64(key, record.file_number);
+  EncodeFixed64(key + 8, record.block_offset);
+  const uint32_t hash = Hash(key, sizeof(key), 0);
+  std::string encoded;
+  MutexLock l(&mu_);
+  if (writer_ == nullptr ||
+      writer_->GetFileSize() > options_.max_trace_file_size ||
+      (options_.sampling_frequency > 1 &&
+       hash % options_.sampling_frequency != 0)) {
+    return Status::OK();
+  }
+  // Keep the deltas non-negative even if the clock steps backwards
+  record.access_timestamp = std::max(env_->NowMicros(), last_ts_);
+  EncodeBlockCacheTraceRecord(record, &last_ts_, &encoded);
+  return writer_->Write(encoded);
+}
+
+BlockCacheTraceReader::BlockCacheTraceReader(
+    std::unique_ptr<TraceReader> &&reader)
+    : reader_(std::move(reader)), last_ts_(0) {}
+
+Status BlockCacheTraceReader::ReadHeader() {
+  Status s = reader_->Read(&buffer_);
+  if (!s.ok()) { return s.IsNotFound() ? Status::Corruption("empty trace") : s; }
+  Slice input(buffer_);
+  Slice magic;
+  uint32_t version;
+  if (!GetLengthPrefixedSlice(&input, &magic) ||
+      magic != Slice(kBlockCacheTraceMagic) || !GetVarint32(&input, &version)) {
+    return Status::Corruption("not a block cache trace");
+  }
+  if (version != kBlockCacheTraceVersion) {
+    return Status::NotSupported("unknown block cache trace version");
+  }
+  return Status::OK();
+}
+
+Status BlockCacheTraceReader::ReadAccess(BlockCacheTraceRecord *record) {
+  Status s = reader_->Read(&buffer_);
+  if (!s.ok()) { return s; }
+  return DecodeBlockCacheTraceRecord(buffer_, &last_ts_, record);
+}
+
+} // namespace leveldb
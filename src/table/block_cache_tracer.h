@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "leveldb/env.h"
+#include "leveldb/status.h"
+#include "leveldb/trace.h"
+#include "port/port.h"
+
+namespace leveldb {
+
+class BlockCacheTracer;
+
+// Who caused a block to be looked up in the block cache.
+enum TableReaderCaller : unsigned char {
+  kUserGet = 1,
+  kUserMultiGet = 2,
+  kUserIterator = 3,
+  kCompaction = 4,
+  kFlush = 5, // verification read of a freshly flushed table
+  kUncategorized = 6,
+  kMaxTableReaderCaller
+};
+
+enum TraceBlockType : unsigned char {
+  kTraceDataBlock = 0,
+  kTraceIndexBlock = 1,
+  kTraceFilterBlock = 2,
+  kTraceBlockTypeMax
+};
+
+// Describes a table read to the block cache tracer.  TableCache fills in
+// the file number and tracer, the caller and level come from whoever asks
+// TableCache for the table.
+struct BlockCacheLookupContext {
+  explicit BlockCacheLookupContext(TableReaderCaller c, int l = -1)
+      : caller(c), level(l), file_number(0), tracer(nullptr) {}
+
+  TableReaderCaller caller;
+  int level; // -1 if unknown
+  uint64_t file_number;
+  BlockCacheTracer *tracer;
+};
+
+// One block cache access.
+struct BlockCacheTraceRecord {
+  uint64_t access_timestamp = 0; // micros
+  uint64_t file_number = 0;
+  uint64_t block_offset = 0; // (file_number, block_offset) names the block
+  uint64_t block_size = 0;   // charge of the block in the cache
+  TraceBlockType block_type = kTraceDataBlock;
+  TableReaderCaller caller = kUncategorized;
+  int level = -1;
+  bool is_cache_hit = false;
+  bool no_insert = false; // a miss that did not fill the cache
+};
+
+// A block cache trace starts with a header record followed by one record
+// per access, each written through TraceWriter::Write().  An access is
+//    delta_micros  varint64  -- time since the previous record
+//    file_number   varint64
+//    block_offset  varint64
+//    block_size    varint64
+//    block_type    uint8
+//    caller        uint8
+//    level + 1     varint32
+//    flags         uint8     -- bit 0: cache hit, bit 1: no insert
+// and the header is the magic string as a length-prefixed slice followed
+// by the version as a varint32.
+void EncodeBlockCacheTraceRecord(const BlockCacheTraceRecord &record,
+                                 uint64_t *last_ts, std::string *dst);
+Status DecodeBlockCacheTraceRecord(const Slice &src, uint64_t *last_ts,
+                                   BlockCacheTraceRecord *record);
+
+// BlockCacheTracer writes block cache accesses to a trace while a trace is
+// running.  Thread safe; IsTracing() is a single relaxed load so the read
+// path can call it unconditionally.
+class BlockCacheTracer {
+public:
+  BlockCacheTracer();
+  ~BlockCacheTracer();
+
+  // No copying allowed
+  BlockCacheTracer(const BlockCacheTracer &) = delete;
+  void operator=(const BlockCacheTracer &) = delete;
+
+  // Sampling is done per block, so a sampled trace keeps every access to
+  // the blocks it covers and still yields meaningful miss ratios.
+  Status StartTrace(Env *env, const TraceOptions &options,
+                    std::unique_ptr<TraceWriter> &&writer);
+  Status EndTrace();
+
+  bool IsTracing() const { return tracing_.load(std::memory_order_relaxed); }
+
+  // Record "record", stamping it with the current time.
+  Status WriteBlockAccess(BlockCacheTraceRecord record);
+
+private:
+  port::Mutex mu_;
+  std::atomic<bool> tracing_;
+  Env *env_;
+  TraceOptions options_;
+  std::unique_ptr<TraceWriter> writer_;
+  uint64_t last_ts_;
+};
+
+// Reads back a trace written by BlockCacheTracer.
+class BlockCacheTraceReader {
+public:
+  explicit BlockCacheTraceReader(std::unique_ptr<TraceReader> &&reader);
+
+  // Must be called once, before the first ReadAccess().
+  Status ReadHeader();
+
+  // Returns NotFound at the end of the trace.
+  Status ReadAccess(BlockCacheTraceRecord *record);
+
+private:
+  std::unique_ptr<TraceReader> reader_;
+  std::string buffer_;
+  uint64_t last_ts_;
+};
+
+} // namespace leveldb
@@ -0,0 +1,232 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "table/cache_simulator.h"
+
+#include <iterator>
+#include <list>
+#include <map>
+
+namespace leveldb {
+
+namespace {
+
+// LRU and FIFO only differ in whether a hit moves the block to the front.
+class ListSimCache : public SimCache {
+ public:
+  ListSimCache(uint64_t capacity, bool move_on_hit)
+      : SimCache(capacity), move_on_hit_(move_on_hit), usage_(0) {}
+
+  const char *Name() const override { return move_on_hit_ ? "lru" : "fifo"; }
+
+  bool Access(const SimAccess &access) override {
+    auto iter = table_.find(access.key);
+    if (iter != table_.end()) {
+      if (move_on_hit_) { list_.splice(list_.begin(), list_, iter->second); }
+      return true;
+    }
+    if (access.no_insert || access.charge > capacity_) { return false; }
+    while (usage_ + access.charge > capacity_) {
+      const Entry &victim = list_.back();
+      usage_ -= victim.charge;
+      table_.erase(victim.key);
+      list_.pop_back();
+    }
+    list_.push_front(Entry{access.key, access.charge});
+    table_[access.key] = list_.begin();
+    usage_ += access.charge;
+    return false;
+  }
+
+ private:
+  struct Entry {
+    SimBlockKey key;
+    uint64_t charge;
+  };
+
+  const bool move_on_hit_;
+  uint64_t usage_;
+  std::list<Entry> list_; // front is the newest (or most recently used)
+  std::unordered_map<SimBlockKey, std::list<Entry>::iterator, SimBlockKeyHash>
+      table_;
+};
+
+class ClockSimCache : public SimCache {
+ public:
+  explicit ClockSimCache(uint64_t capacity)
+      : SimCache(capacity), usage_(0), hand_(ring_.end()) {}
+
+  const char *Name() const override { return "clock"; }
+
+  bool Access(const SimAccess &access) override {
+    auto iter = table_.find(access.key);
+    if (iter != table_.end()) {
+      iter->second->referenced = true;
+      return true;
+    }
+    if (access.no_insert || access.charge > capacity_) { return false; }
+    while (usage_ + access.charge > capacity_) {
+      if (hand_ == ring_.end()) { hand_ = ring_.begin(); }
+      if (hand_->referenced) {
+        hand_->referenced = false;
+        ++hand_;
+      } else {
+        usage_ -= hand_->charge;
+        table_.erase(hand_->key);
+        hand_ = ring_.erase(hand_);
+      }
+    }
+    // Just behind the hand, so it is the last block the hand reaches
+    table_[access.key] =
+        ring_.insert(hand_, Entry{access.key, access.charge, false});
+    usage_ += access.charge;
+    return false;
+  }
+
+ private:
+  struct Entry {
+    SimBlockKey key;
+    uint64_t charge;
+    bool referenced;
+  };
+
+  uint64_t usage_;
+  std::list<Entry> ring_;
+  std::list<Entry>::iterator hand_; // end() wraps around to begin()
+  std::unordered_map<SimBlockKey, std::list<Entry>::iterator, SimBlockKeyHash>
+      table_;
+};
+
+class OptimalSimCache : public SimCache {
+ public:
+  explicit OptimalSimCache(uint64_t capacity) : SimCache(capacity), usage_(0) {}
+
+  const char *Name() const override { return "opt"; }
+
+  bool Access(const SimAccess &access) override {
+    auto iter = table_.find(access.key);
+    if (iter != table_.end()) {
+      by_next_access_.erase(iter->second.position);
+      iter->second.position =
+          by_next_access_.emplace(access.next_access, access.key);
+      return true;
+    }
+    if (access.no_insert || access.charge > capacity_) { return false; }
+    Entry entry;
+    entry.charge = access.charge;
+    entry.position = by_next_access_.emplace(access.next_access, access.key);
+    table_[access.key] = entry;
+    usage_ += access.charge;
+    // May evict the new block itself, i.e. bypass the cache, when every
+    // resident block is needed sooner.
+    while (usage_ > capacity_) {
+      auto victim = std::prev(by_next_access_.end());
+      auto victim_entry = table_.find(victim->second);
+      usage_ -= victim_entry->second.charge;
+      table_.erase(victim_entry);
+      by_next_access_.erase(victim);
+    }
+    return false;
+  }
+
+ private:
+  struct Entry {
+    uint64_t charge;
+    std::multimap<uint64_t, SimBlockKey>::iterator position;
+  };
+
+  uint64_t usage_;
+  // Resident blocks ordered by the index of their next access
+  std::multimap<uint64_t, SimBlockKey> by_next_access_;
+  std::unordered_map<SimBlockKey, Entry, SimBlockKeyHash> table_;
+};
+
+} // namespace
+
+std::unique_ptr<SimCache> NewLRUSimCache(uint64_t capacity) {
+  return std::unique_ptr<SimCache>(new ListSimCache(capacity, true));
+}
+
+std::unique_ptr<SimCache> NewFIFOSimCache(uint64_t capacity) {
+  return std::unique_ptr<SimCache>(new ListSimCache(capacity, false));
+}
+
+std::unique_ptr<SimCache> NewClockSimCache(uint64_t capacity) {
+  return std::unique_ptr<SimCache>(new ClockSimCache(capacity));
+}
+
+std::unique_ptr<SimCache> NewOptimalSimCache(uint64_t capacity) {
+  return std::unique_ptr<SimCache>(new OptimalSimCache(capacity));
+}
+
+std::unique_ptr<SimCache> NewSimCache(const std::string &policy,
+                                      uint64_t capacity) {
+  if (policy == "lru") { return NewLRUSimCache(capacity); }
+  if (policy == "fifo") { return NewFIFOSimCache(capacity); }
+  if (policy == "clock") { return NewClockSimCache(capacity); }
+  if (policy == "opt") { return NewOptimalSimCache(capacity); }
+  return nullptr;
+}
+
+CacheSimulator::CacheSimulator() : working_set_size_(0), observed_misses_(0) {}
+
+void CacheSimulator::Add(const BlockCacheTraceRecord &record) {
+  SimAccess access;
+  access.key = SimBlockKey{record.file_number, record.block_offset};
+  access.charge = record.block_size;
+  access.next_access = SimAccess::kNoNextAccess;
+  access.no_insert = record.no_insert;
+
+  const uint64_t index = accesses_.size();
+  auto iter = last_access_.find(access.key);
+  if (iter == last_access_.end()) {
+    last_access_.emplace(access.key, index);
+    working_set_size_ += access.charge;
+  } else {
+    accesses_[iter->second].next_access = index;
+    iter->second = index;
+  }
+  if (!record.is_cache_hit) { observed_misses_++; }
+  accesses_.push_back(access);
+}
+
+Status CacheSimulator::AddTrace(BlockCacheTraceReader *reader) {
+  BlockCacheTraceRecord record;
+  while (true) {
+    Status s = reader->ReadAccess(&record);
+    if (s.IsNotFound()) { return Status::OK(); }
+    if (!s.ok()) { return s; }
+    Add(record);
+  }
+}
+
+SimResult CacheSimulator::Simulate(SimCache *cache) {
+  SimResult result;
+  result.policy = cache->Name();
+  result.capacity = cache->capacity();
+  for (const SimAccess &access : accesses_) {
+    result.accesses++;
+    result.bytes_accessed += access.charge;
+    if (!cache->Access(access)) {
+      result.misses++;
+      result.bytes_missed += access.charge;
+    }
+  }
+  return result;
+}
+
+std::vector<SimResult> CacheSimulator::MissRatioCurve(
+    const std::vector<std::string> &policies,
+    const std::vector<uint64_t> &capacities) {
+  std::vector<SimResult> results;
+  for (const std::string &policy : policies) {
+    for (uint64_t capacity : capacities) {
+      std::unique_ptr<SimCache> cache = NewSimCache(policy, capacity);
+      if (cache != nullptr) { results.push_back(Simulate(cache.get())); }
+    }
+  }
+  return results;
+}
+
+} // namespace leveldb
@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "leveldb/status.h"
+#include "table/block_cache_tracer.h"
+
+namespace leveldb {
+
+// Blocks are identified by the file they belong to and their offset.
+struct SimBlockKey {
+  uint64_t file_number;
+  uint64_t block_offset;
+
+  bool operator==(const SimBlockKey &other) const {
+    return file_number == other.file_number &&
+           block_offset == other.block_offset;
+  }
+};
+
+struct SimBlockKeyHash {
+  size_t operator()(const SimBlockKey &key) const {
+    return static_cast<size_t>(key.file_number * 0x9e3779b97f4a7c15ull ^
+                               key.block_offset);
+  }
+};
+
+// One replayed block access.
+struct SimAccess {
+  SimBlockKey key;
+  uint64_t charge;
+  // Index of the next access to the same block, or kNoNextAccess.  Only
+  // the clairvoyant policy looks at it.
+  uint64_t next_access;
+  bool no_insert;
+
+  static const uint64_t kNoNextAccess = ~static_cast<uint64_t>(0);
+};
+
+// A simulated block cache holding at most "capacity" bytes of blocks.
+class SimCache {
+public:
+  explicit SimCache(uint64_t capacity) : capacity_(capacity) {}
+  virtual ~SimCache() = default;
+
+  virtual const char *Name() const = 0;
+
+  // Look up the block of "access" and return true on a hit.  On a miss the
+  // block is admitted unless access.no_insert is set or it can never fit.
+  virtual bool Access(const SimAccess &access) = 0;
+
+  uint64_t capacity() const { return capacity_; }
+
+protected:
+  const uint64_t capacity_;
+};
+
+// Least recently used.
+std::unique_ptr<SimCache> NewLRUSimCache(uint64_t capacity);
+
+// First in, first out: hits do not change the eviction order.
+std::unique_ptr<SimCache> NewFIFOSimCache(uint64_t capacity);
+
+// CLOCK (second chance): a hit sets a reference bit, and the hand clears
+// it once before the block becomes evictable.
+std::unique_ptr<SimCache> NewClockSimCache(uint64_t capacity);
+
+// Belady's clairvoyant policy: evicts the block whose next access is
+// furthest in the future.  Gives a lower bound for the miss ratio.
+std::unique_ptr<SimCache> NewOptimalSimCache(uint64_t capacity);
+
+// Returns nullptr if "policy" is not one of "lru", "fifo", "clock", "opt".
+std::unique_ptr<SimCache> NewSimCache(const std::string &policy,
+                                      uint64_t capacity);
+
+struct SimResult {
+  std::string policy;
+  uint64_t capacity = 0;
+  uint64_t accesses = 0;
+  uint64_t misses = 0;
+  uint64_t bytes_accessed = 0;
+  uint64_t bytes_missed = 0;
+
+  double miss_ratio() const {
+    return accesses == 0 ? 0.0 : static_cast<double>(misses) / accesses;
+  }
+  double byte_miss_ratio() const {
+    return bytes_accessed == 0
+               ? 0.0
+               : static_cast<double>(bytes_missed) / bytes_accessed;
+  }
+};
+
+// CacheSimulator holds a block cache trace in memory and replays it
+// against simulated caches, e.g. to build a miss-ratio curve.
+class CacheSimulator {
+public:
+  CacheSimulator();
+
+  // Append one traced access.
+  void Add(const BlockCacheTraceRecord &record);
+
+  // Append every access of the trace read by "reader".
+  Status AddTrace(BlockCacheTraceReader *reader);
+
+  // Replay all accesses against "cache".
+  SimResult Simulate(SimCache *cache);
+
+  // Replay against each of "policies" at each of "capacities".
+  std::vector<SimResult> MissRatioCurve(
+      const std::vector<std::string> &policies,
+      const std::vector<uint64_t> &capacities);
+
+  uint64_t num_accesses() const { return accesses_.size(); }
+
+  // Total size of the distinct blocks accessed.
+  uint64_t working_set_size() const { return working_set_size_; }
+
+  // Miss ratio of the traced cache itself.
+  double observed_miss_ratio() const {
+    return accesses_.empty()
+               ? 0.0
+               : static_cast<double>(observed_misses_) / accesses_.size();
+  }
+
+private:
+  std::vector<SimAccess> accesses_;
+  // Index of the latest access to each block, to link up next_access
+  std::unordered_map<SimBlockKey, uint64_t, SimBlockKeyHash> last_access_;
+  uint64_t working_set_size_;
+  uint64_t observed_misses_;
+};
+
+} // namespace leveldb
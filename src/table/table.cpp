@@ -0,0 +1,486 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "table/table.h"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "comparator.h"
+#include "leveldb/cache.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/options.h"
+#include "leveldb/statistics.h"
+#include "port/port.h"
+#include "table/block.h"
+#include "table/block_cache_tracer.h"
+#include "table/filter_block.h"
+#include "table/format.h"
+#include "table/two_level_iterator.h"
+#include "util/coding.h"
+#include "util/perf_context_imp.h"
+
+namespace leveldb {
+
+struct Table::Rep {
+  ~Rep() {
+    delete filter;
+    delete[] filter_data;
+    delete index_block;
+  }
+
+  Options options;
+  Status status;
+  std::unique_ptr<RandomAccessFile> file;
+  uint64_t cache_id;
+  uint64_t compressed_cache_id;
+  FilterBlockReader *filter;
+  const char *filter_data;
+
+  BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
+  BlockHandle index_handle;
+  // Loaded by LoadIndexAndFilter(), at Open() unless deferred
+  std::once_flag index_once;
+  Status index_status;
+  Block *index_block;
+};
+
+Status Table::Open(const Options &options,
+                   std::unique_ptr<RandomAccessFile> &&file, uint64_t size,
+                   Table **table) {
+  *table = nullptr;
+  if (size < Footer::kEncodedLength) {
+    return Status::Corruption("file is too short to be an sstable");
+  }
+
+  char footer_space[Footer::kEncodedLength];
+  Slice footer_input;
+  Status s = file->Read(size - Footer::kEncodedLength, Footer::kEncodedLength,
+                        &footer_input, footer_space);
+  if (!s.ok()) return s;
+
+  Footer footer;
+  s = footer.DecodeFrom(&footer_input);
+  if (!s.ok()) return s;
+
+  Rep *rep = new Table::Rep;
+  rep->options = options;
+  rep->file = std::move(file);
+  rep->metaindex_handle = footer.metaindex_handle();
+  rep->index_handle = footer.index_handle();
+  rep->index_block = nullptr;
+  rep->cache_id =
+      (options.block_cache ? options.block_cache->NewId() : 0);
+  rep->compressed_cache_id =
+      (options.block_cache_compressed
+           ? options.block_cache_compressed->NewId()
+           : 0);
+  rep->filter_data = nullptr;
+  rep->filter = nullptr;
+  Table *t = new Table(rep);
+  if (!options.defer_table_index_loading) {
+    s = t->LoadIndexAndFilter();
+    if (!s.ok()) {
+      delete t;
+      return s;
+    }
+  }
+  *table = t;
+  return s;
+}
+
+Status Table::LoadIndexAndFilter() const {
+  std::call_once(rep_->index_once, [this]() {
+    // Read the index block
+    BlockContents index_block_contents;
+    ReadOptions opt;
+    if (rep_->options.paranoid_checks) { opt.verify_checksums = true; }
+    rep_->index_status =
+        ReadBlock(rep_->file.get(), opt, rep_->options.compression_opts,
+                  rep_->index_handle, &index_block_contents);
+    if (rep_->index_status.ok()) {
+      // We've successfully read the footer and the index block: we're
+      // ready to serve requests.
+      rep_->index_block = new Block(index_block_contents);
+      ReadMeta();
+    }
+  });
+  return rep_->index_status;
+}
+
+void Table::ReadMeta() const {
+  if (rep_->options.filter_policy == nullptr) {
+    return;  // Do not need any metadata
+  }
+
+  ReadOptions opt;
+  if (rep_->options.paranoid_checks) { opt.verify_checksums = true; }
+  BlockContents contents;
+  if (!ReadBlock(rep_->file.get(), opt, rep_->options.compression_opts,
+                 rep_->metaindex_handle, &contents)
+           .ok()) {
+    // Do not propagate errors since meta info is not needed for operation
+    return;
+  }
+  Block *meta = new Block(contents);
+
+  Iterator *iter = meta->NewIterator(BytewiseComparator());
+  std::string key = "filter.";
+  key.append(rep_->options.filter_policy->Name());
+  iter->Seek(key);
+  if (iter->Valid() && iter->key() == Slice(key)) { ReadFilter(iter->value()); }
+  delete iter;
+  delete meta;
+}
+
+void Table::ReadFilter(const Slice &filter_handle_value) const {
+  Slice v = filter_handle_value;
+  BlockHandle filter_handle;
+  if (!filter_handle.DecodeFrom(&v).ok()) { return; }
+
+  // We might want to unify with ReadBlock() if we start
+  // requiring checksum verification in Table::Open.
+  ReadOptions opt;
+  if (rep_->options.paranoid_checks) { opt.verify_checksums = true; }
+  BlockContents block;
+  if (!ReadBlock(rep_->file.get(), opt, rep_->options.compression_opts,
+                 filter_handle, &block)
+           .ok()) {
+    return;
+  }
+  if (block.heap_allocated) {
+    rep_->filter_data = block.data.data();  // Will need to delete later
+  }
+  rep_->filter = new FilterBlockReader(rep_->options.filter_policy, block.data);
+}
+
+Table::~Table() { delete rep_; }
+
+struct Table::BlockReaderArg {
+  const Table *table;
+  const BlockCacheLookupContext *context; // may be null
+
+  // Cleanup function for a heap-allocated arg that owns its context
+  static void Delete(void *arg, void *ignored) {
+    BlockReaderArg *reader_arg = reinterpret_cast<BlockReaderArg *>(arg);
+    delete reader_arg->context;
+    delete reader_arg;
+  }
+};
+
+static void DeleteBlock(void *arg, void *ignored) {
+  delete reinterpret_cast<Block *>(arg);
+}
+
+static void DeleteCachedBlock(const Slice &key, void *value) {
+  Block *block = reinterpret_cast<Block *>(value);
+  delete block;
+}
+
+// The secondary cache copy of a block outlives the table that read it, so
+// it is always compressed with the default options rather than the table's.
+static const CompressionOptions &CachedBlockCompressionOptions() {
+  static const CompressionOptions kOptions;
+  return kOptions;
+}
+
+// Saves a block for the secondary cache compressed with "type", as the
+// table would store it, followed by the type byte.  Blocks that do not
+// compress by 12.5% are saved as they are.
+template <CompressionType type>
+static void SaveCachedBlock(void *value, std::string *out) {
+  Block *block = reinterpret_cast<Block *>(value);
+  const size_t size = block->size();
+  std::string compressed;
+  bool ok = false;
+  if constexpr (type == kSnappyCompression) {
+    ok = port::Snappy_Compress(block->data(), size, &compressed);
+  } else if constexpr (type == kZlibCompression) {
+    const CompressionOptions &zlib = CachedBlockCompressionOptions();
+    ok = port::Zlib_Compress(zlib.window_bits, zlib.level, zlib.strategy,
+                             block->data(), size, &compressed);
+  }
+  if (ok && compressed.size() < size - (size / 8u)) {
+    out->append(compressed);
+    out->push_back(static_cast<char>(type));
+  } else {
+    out->append(block->data(), size);
+    out->push_back(static_cast<char>(kNoCompression));
+  }
+}
+
+static void *CreateCachedBlock(const Slice &data, size_t *charge) {
+  if (data.empty()) { return nullptr; }
+  const size_t n = data.size() - 1;
+  BlockContents contents;
+  if (data[n] == kNoCompression) {
+    char *buf = new char[n];
+    std::memcpy(buf, data.data(), n);
+    contents.data = Slice(buf, n);
+    contents.cachable = true;
+    contents.heap_allocated = true;
+  } else if (!UncompressBlockContents(data.data(), n,
+                                      CachedBlockCompressionOptions(),
+                                      &contents)
+                  .ok()) {
+    return nullptr;
+  }
+  Block *block = new Block(contents);
+  *charge = block->size();
+  return block;
+}
+
+// Lets blocks evicted from the block cache move to its secondary cache,
+// compressed like the table's own blocks
+static const Cache::CacheItemHelper *BlockCacheHelper(CompressionType type) {
+  static const Cache::CacheItemHelper kSnappyHelper = {
+      &SaveCachedBlock<kSnappyCompression>, &CreateCachedBlock,
+      &DeleteCachedBlock};
+  static const Cache::CacheItemHelper kZlibHelper = {
+      &SaveCachedBlock<kZlibCompression>, &CreateCachedBlock,
+      &DeleteCachedBlock};
+  static const Cache::CacheItemHelper kNoCompressionHelper = {
+      &SaveCachedBlock<kNoCompression>, &CreateCachedBlock,
+      &DeleteCachedBlock};
+  switch (type) {
+    case kSnappyCompression:
+      return &kSnappyHelper;
+    case kZlibCompression:
+      return &kZlibHelper;
+    default:
+      return &kNoCompressionHelper;
+  }
+}
+
+static void DeleteCompressedBlock(const Slice &key, void *value) {
+  delete reinterpret_cast<std::string *>(value);
+}
+
+static void ReleaseBlock(void *arg, void *h) {
+  Cache *cache = reinterpret_cast<Cache *>(arg);
+  Cache::Handle *handle = reinterpret_cast<Cache::Handle *>(h);
+  cache->Release(handle);
+}
+
+// Convert an index iterator value (i.e., an encoded BlockHandle)
+// into an iterator over the contents of the corresponding block.
+Iterator *Table::BlockReader(void *arg, const ReadOptions &options,
+                             const Slice &index_value) {
+  const BlockReaderArg *reader_arg = reinterpret_cast<BlockReaderArg *>(arg);
+  const Table *table = reader_arg->table;
+  const BlockCacheLookupContext *context = reader_arg->context;
+  const Options &table_options = table->rep_->options;
+  Cache *block_cache = table_options.block_cache.get();
+  const std::shared_ptr<Statistics> &statistics = table_options.statistics;
+  Block *block = nullptr;
+  Cache::Handle *cache_handle = nullptr;
+
+  BlockHandle handle;
+  Slice input = index_value;
+  Status s = handle.DecodeFrom(&input);
+  // We intentionally allow extra stuff in index_value so that we
+  // can add more features in the future.
+
+  if (s.ok()) {
+    BlockContents contents;
+    if (block_cache != nullptr) {
+      char cache_key_buffer[16];
+      EncodeFixed64(cache_key_buffer, table->rep_->cache_id);
+      EncodeFixed64(cache_key_buffer + 8, handle.offset());
+      Slice key(cache_key_buffer, sizeof(cache_key_buffer));
+      const Cache::CacheItemHelper *helper =
+          BlockCacheHelper(table_options.compression);
+      if (options.fill_cache) {
+        cache_handle = block_cache->Lookup(key, helper);
+      } else {
+        // A block found in the secondary cache is not moved into this one
+        cache_handle = block_cache->Lookup(key);
+        if (cache_handle == nullptr) {
+          block = reinterpret_cast<Block *>(
+              block_cache->LookupSecondary(key, helper));
+        }
+      }
+      const bool is_cache_hit = (cache_handle != nullptr || block != nullptr);
+      bool no_insert = false;
+      if (is_cache_hit) {
+        if (cache_handle != nullptr) {
+          block = reinterpret_cast<Block *>(block_cache->Value(cache_handle));
+        }
+        RecordTick(statistics, BLOCK_CACHE_HIT);
+        PERF_COUNTER_ADD(block_cache_hit_count, 1);
+      } else {
+        RecordTick(statistics, BLOCK_CACHE_MISS);
+        s = table->ReadDataBlock(options, handle, &contents);
+        if (s.ok()) {
+          block = new Block(contents);
+          if (contents.cachable && options.fill_cache) {
+            cache_handle =
+                block_cache->Insert(key, block, block->size(), helper);
+          } else {
+            no_insert = true;
+          }
+        }
+      }
+      if (block != nullptr && context != nullptr &&
+          context->tracer != nullptr && context->tracer->IsTracing()) {
+        BlockCacheTraceRecord record;
+        record.file_number = context->file_number;
+        record.block_offset = handle.offset();
+        record.block_size = block->size();
+        record.block_type = kTraceDataBlock;
+        record.caller = context->caller;
+        record.level = context->level;
+        record.is_cache_hit = is_cache_hit;
+        record.no_insert = no_insert;
+        context->tracer->WriteBlockAccess(record);
+      }
+    } else {
+      s = table->ReadDataBlock(options, handle, &contents);
+      if (s.ok()) { block = new Block(contents); }
+    }
+  }
+
+  Iterator *iter;
+  if (block != nullptr) {
+    iter = block->NewIterator(table->rep_->options.comparator);
+    if (cache_handle == nullptr) {
+      iter->RegisterCleanup(&DeleteBlock, block, nullptr);
+    } else {
+      iter->RegisterCleanup(&ReleaseBlock, block_cache, cache_handle);
+    }
+  } else {
+    iter = NewErrorIterator(s);
+  }
+  return iter;
+}
+
+Status Table::ReadDataBlock(const ReadOptions &options,
+                            const BlockHandle &handle,
+                            BlockContents *contents) const {
+  const CompressionOptions &compression_opts = rep_->options.compression_opts;
+  Cache *compressed_cache = rep_->options.block_cache_compressed.get();
+  if (compressed_cache == nullptr) {
+    return ReadBlock(rep_->file.get(), options, compression_opts, handle,
+                     contents);
+  }
+  const std::shared_ptr<Statistics> &statistics = rep_->options.statistics;
+  char cache_key_buffer[16];
+  EncodeFixed64(cache_key_buffer, rep_->compressed_cache_id);
+  EncodeFixed64(cache_key_buffer + 8, handle.offset());
+  Slice key(cache_key_buffer, sizeof(cache_key_buffer));
+  Cache::Handle *cache_handle = compressed_cache->Lookup(key);
+  if (cache_handle != nullptr) {
+    RecordTick(statistics, BLOCK_CACHE_COMPRESSED_HIT);
+    const std::string *compressed = reinterpret_cast<const std::string *>(
+        compressed_cache->Value(cache_handle));
+    // Checksums were verified, if asked for, when the block was read
+    Status s = UncompressBlockContents(compressed->data(),
+                                       compressed->size() - 1,
+                                       compression_opts, contents);
+    compressed_cache->Release(cache_handle);
+    return s;
+  }
+
+  RecordTick(statistics, BLOCK_CACHE_COMPRESSED_MISS);
+  if (!options.fill_cache) {
+    return ReadBlock(rep_->file.get(), options, compression_opts, handle,
+                     contents);
+  }
+  std::string *compressed = new std::string;
+  Status s = ReadBlock(rep_->file.get(), options, compression_opts, handle,
+                       contents, compressed);
+  if (s.ok() && !compressed->empty()) {
+    compressed_cache->Release(compressed_cache->Insert(
+        key, compressed, compressed->size(), &DeleteCompressedBlock));
+  } else {
+    delete compressed;
+  }
+  return s;
+}
+
+Iterator *Table::NewIterator(const ReadOptions &options,
+                             const BlockCacheLookupContext *context) const {
+  Status s = LoadIndexAndFilter();
+  if (!s.ok()) { return NewErrorIterator(s); }
+  // The iterator outlives the caller's context, so it keeps its own copy.
+  BlockReaderArg *arg = new BlockReaderArg;
+  arg->table = this;
+  arg->context =
+      (context != nullptr) ? new BlockCacheLookupContext(*context) : nullptr;
+  Iterator *iter = NewTwoLevelIterator(
+      rep_->index_block->NewIterator(rep_->options.comparator),
+      &Table::BlockReader, arg, options);
+  iter->RegisterCleanup(&BlockReaderArg::Delete, arg, nullptr);
+  return iter;
+}
+
+Status Table::InternalGet(const ReadOptions &options, const Slice &k,
+                          void *arg,
+                          void (*handle_result)(void *, const Slice &,
+                                                const Slice &),
+                          const BlockCacheLookupContext *context) {
+  Status s = LoadIndexAndFilter();
+  if (!s.ok()) { return s; }
+  Iterator *iiter = rep_->index_block->NewIterator(rep_->options.comparator);
+  iiter->Seek(k);
+  if (iiter->Valid()) {
+    Slice handle_value = iiter->value();
+    FilterBlockReader *filter = rep_->filter;
+    BlockHandle handle;
+    if (filter != nullptr && handle.DecodeFrom(&handle_value).ok() &&
+        !filter->KeyMayMatch(handle.offset(), k)) {
+      // Not found
+      RecordTick(rep_->options.statistics, BLOOM_FILTER_USEFUL);
+      PERF_COUNTER_ADD(bloom_sst_miss_count, 1);
+    } else {
+      if (filter != nullptr) { PERF_COUNTER_ADD(bloom_sst_hit_count, 1); }
+      BlockReaderArg reader_arg = {this, context};
+      Iterator *block_iter = BlockReader(&reader_arg, options, iiter->value());
+      block_iter->Seek(k);
+      if (block_iter->Valid()) {
+        (*handle_result)(arg, block_iter->key(), block_iter->value());
+      }
+      s = block_iter->status();
+      delete block_iter;
+    }
+  }
+  if (s.ok()) { s = iiter->status(); }
+  delete iiter;
+  return s;
+}
+
+uint64_t Table::ApproximateOffsetOf(const Slice &key) const {
+  if (!LoadIndexAndFilter().ok()) {
+    // As below for a key past the end: close to the whole file size
+    return rep_->metaindex_handle.offset();
+  }
+  Iterator *index_iter =
+      rep_->index_block->NewIterator(rep_->options.comparator);
+  index_iter->Seek(key);
+  uint64_t result;
+  if (index_iter->Valid()) {
+    BlockHandle handle;
+    Slice input = index_iter->value();
+    Status s = handle.DecodeFrom(&input);
+    if (s.ok()) {
+      result = handle.offset();
+    } else {
+      // Strange: we can't decode the block handle in the index block.
+      // We'll just return the offset of the metaindex block, which is
+      // close to the whole file size for this case.
+      result = rep_->metaindex_handle.offset();
+    }
+  } else {
+    // key is past the last key in the file.  Approximate the offset
+    // by returning the offset of the metaindex block (which is
+    // right near the end of the file).
+    result = rep_->metaindex_handle.offset();
+  }
+  delete index_iter;
+  return result;
+}
+
+}  // namespace leveldb
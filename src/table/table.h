@@ -0,0 +1,92 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "leveldb/iterator.h"
+
+namespace leveldb {
+
+class Block;
+struct BlockContents;
+struct BlockCacheLookupContext;
+class BlockHandle;
+struct Options;
+class RandomAccessFile;
+struct ReadOptions;
+
+// A Table is a sorted map from strings to strings.  Tables are
+// immutable and persistent.  A Table may be safely accessed from
+// multiple threads without external synchronization.
+class Table {
+public:
+  // Attempt to open the table that is stored in bytes [0..file_size)
+  // of "file", and read the metadata entries necessary to allow
+  // retrieving data from the table.
+  //
+  // Unless options.defer_table_index_loading, that includes the index
+  // and filter blocks; otherwise only the footer is read here.
+  //
+  // If successful, returns ok and sets "*table" to the newly opened
+  // table.  The client should delete "*table" when no longer needed.
+  // If there was an error while initializing the table, sets "*table"
+  // to nullptr and returns a non-ok status.  Takes ownership of "file".
+  static Status Open(const Options &options,
+                     std::unique_ptr<RandomAccessFile> &&file,
+                     uint64_t file_size, Table **table);
+
+  Table(const Table &) = delete;
+  Table &operator=(const Table &) = delete;
+
+  ~Table();
+
+  // Returns a new iterator over the table contents.
+  // The result of NewIterator() is initially invalid (caller must
+  // call one of the Seek methods on the iterator before using it).
+  // If "context" has a tracer, block cache accesses made by the
+  // iterator are traced with it.
+  Iterator *NewIterator(const ReadOptions &,
+                        const BlockCacheLookupContext *context = nullptr) const;
+
+  // Given a key, return an approximate byte offset in the file where
+  // the data for that key begins (or would begin if the key were
+  // present in the file).  The returned value is in terms of file
+  // bytes, and so includes effects like compression of the underlying data.
+  // E.g., the approximate offset of the last key in the table will
+  // be close to the file length.
+  uint64_t ApproximateOffsetOf(const Slice &key) const;
+
+  // Calls (*handle_result)(arg, ...) with the entry found after a call
+  // to Seek(key).  May not make such a call if filter policy says
+  // that key is not present.
+  Status InternalGet(const ReadOptions &, const Slice &key, void *arg,
+                     void (*handle_result)(void *arg, const Slice &k,
+                                           const Slice &v),
+                     const BlockCacheLookupContext *context = nullptr);
+
+private:
+  struct Rep;
+  struct BlockReaderArg;
+
+  // "arg" is a BlockReaderArg
+  static Iterator *BlockReader(void *arg, const ReadOptions &, const Slice &);
+
+  explicit Table(Rep *rep) : rep_(rep) {}
+
+  // Read the index and filter blocks on the first call; every call
+  // returns the status of that read.  Thread-safe.
+  Status LoadIndexAndFilter() const;
+  void ReadMeta() const;
+  void ReadFilter(const Slice &filter_handle_value) const;
+  // Read a data block, through the compressed block cache if there is one
+  Status ReadDataBlock(const ReadOptions &options, const BlockHandle &handle,
+                       BlockContents *contents) const;
+
+  Rep *const rep_;
+};
+
+}  // namespace leveldb
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/trace.h"
+#include "table/block_cache_tracer.h"
+#include "table/cache_simulator.h"
+
+namespace leveldb {
+
+static SimAccess Block(uint64_t offset, uint64_t charge = 1) {
+  SimAccess access;
+  access.key = SimBlockKey{1, offset};
+  access.charge = charge;
+  access.next_access = SimAccess::kNoNextAccess;
+  access.no_insert = false;
+  return access;
+}
+
+TEST(BlockCacheTraceTest, EncodeDecode) {
+  BlockCacheTraceRecord record;
+  record.access_timestamp = 1000;
+  record.file_number = 7;
+  record.block_offset = 4096;
+  record.block_size = 4000;
+  record.block_type = kTraceDataBlock;
+  record.caller = kCompaction;
+  record.level = -1;
+  record.is_cache_hit = false;
+  record.no_insert = true;
+  uint64_t last_ts = 0;
+  std::string encoded;
+  EncodeBlockCacheTraceRecord(record, &last_ts, &encoded);
+
+  last_ts = 0;
+  BlockCacheTraceRecord decoded;
+  ASSERT_TRUE(DecodeBlockCacheTraceRecord(encoded, &last_ts, &decoded).ok());
+  ASSERT_EQ(1000u, decoded.access_timestamp);
+  ASSERT_EQ(7u, decoded.file_number);
+  ASSERT_EQ(4096u, decoded.block_offset);
+  ASSERT_EQ(4000u, decoded.block_size);
+  ASSERT_EQ(kCompaction, decoded.caller);
+  ASSERT_EQ(-1, decoded.level);
+  ASSERT_FALSE(decoded.is_cache_hit);
+  ASSERT_TRUE(decoded.no_insert);
+
+  ASSERT_FALSE(DecodeBlockCacheTraceRecord(Slice(encoded.data(), 3), &last_ts,
+                                           &decoded)
+                   .ok());
+}
+
+TEST(CacheSimulatorTest, LRUAndFIFO) {
+  // Capacity for two blocks; block 0 is touched before block 2 evicts
+  std::unique_ptr<SimCache> lru = NewLRUSimCache(2);
+  std::unique_ptr<SimCache> fifo = NewFIFOSimCache(2);
+  for (SimCache *cache : {lru.get(), fifo.get()}) {
+    ASSERT_FALSE(cache->Access(Block(0)));
+    ASSERT_FALSE(cache->Access(Block(1)));
+    ASSERT_TRUE(cache->Access(Block(0)));
+    ASSERT_FALSE(cache->Access(Block(2)));
+  }
+  ASSERT_TRUE(lru->Access(Block(0)));   // block 1 was evicted
+  ASSERT_FALSE(fifo->Access(Block(0))); // block 0 was the oldest
+}
+
+TEST(CacheSimulatorTest, Clock) {
+  std::unique_ptr<SimCache> clock = NewClockSimCache(2);
+  ASSERT_FALSE(clock->Access(Block(0)));
+  ASSERT_FALSE(clock->Access(Block(1)));
+  ASSERT_TRUE(clock->Access(Block(0)));
+  // Block 0 gets a second chance, block 1 goes
+  ASSERT_FALSE(clock->Access(Block(2)));
+  ASSERT_TRUE(clock->Access(Block(0)));
+  ASSERT_FALSE(clock->Access(Block(1)));
+}
+
+TEST(CacheSimulatorTest, NoInsertAndOversized) {
+  std::unique_ptr<SimCache> lru = NewLRUSimCache(10);
+  SimAccess no_insert = Block(0);
+  no_insert.no_insert = true;
+  ASSERT_FALSE(lru->Access(no_insert));
+  ASSERT_FALSE(lru->Access(Block(0)));
+  ASSERT_TRUE(lru->Access(no_insert));
+  ASSERT_FALSE(lru->Access(Block(1, 11)));
+  ASSERT_FALSE(lru->Access(Block(1, 11)));
+}
+
+TEST(CacheSimulatorTest, MissRatioCurve) {
+  // A loop over three blocks: LRU and FIFO always miss with room for two,
+  // while the optimal policy keeps one of them.
+  CacheSimulator simulator;
+  for (int round = 0; round < 10; round++) {
+    for (uint64_t offset = 0; offset < 3; offset++) {
+      BlockCacheTraceRecord record;
+      record.file_number = 1;
+      record.block_offset = offset;
+      record.block_size = 1;
+      simulator.Add(record);
+    }
+  }
+  ASSERT_EQ(30u, simulator.num_accesses());
+  ASSERT_EQ(3u, simulator.working_set_size());
+
+  std::vector<SimResult> curve =
+      simulator.MissRatioCurve({"lru", "fifo", "clock", "opt"}, {2, 3});
+  ASSERT_EQ(8u, curve.size());
+  for (const SimResult &result : curve) {
+    if (result.capacity == 3) {
+      ASSERT_EQ(3u, result.misses) << result.policy;
+    } else if (result.policy == "opt") {
+      ASSERT_LT(result.misses, 30u);
+      ASSERT_GT(result.misses, 3u);
+    } else {
+      ASSERT_EQ(30u, result.misses) << result.policy;
+      ASSERT_DOUBLE_EQ(1.0, result.miss_ratio());
+    }
+  }
+}
+
+TEST(CacheSimulatorTest, TraceFromDB) {
+  Env *env = Env::Default();
+  std::string dir;
+  env->GetTestDirectory(&dir);
+  const std::string dbname = dir + "/block_cache_trace_db";
+  const std::string trace_file = dir + "/block_cache_trace";
+  Options options;
+  options.create_if_missing = true;
+  DestroyDB(dbname, options);
+
+  DB *db;
+  ASSERT_TRUE(DB::Open(options, dbname, &db).ok());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(
+        db->Put(WriteOptions(), "key" + std::to_string(i), "value").ok());
+  }
+  ASSERT_TRUE(db->Flush(FlushOptions()).ok());
+
+  std::unique_ptr<TraceWriter> writer;
+  ASSERT_TRUE(NewFileTraceWriter(env, trace_file, &writer).ok());
+  ASSERT_TRUE(db->StartBlockCacheTrace(TraceOptions(), std::move(writer)).ok());
+  std::string value;
+  ASSERT_TRUE(db->Get(ReadOptions(), "key1", &value).ok());
+  ASSERT_TRUE(db->Get(ReadOptions(), "key2", &value).ok());
+  ASSERT_TRUE(db->EndBlockCacheTrace().ok());
+  ASSERT_FALSE(db->EndBlockCacheTrace().ok());
+  delete db;
+
+  std::unique_ptr<TraceReader> trace_reader;
+  ASSERT_TRUE(NewFileTraceReader(env, trace_file, &trace_reader).ok());
+  BlockCacheTraceReader reader(std::move(trace_reader));
+  ASSERT_TRUE(reader.ReadHeader().ok());
+  BlockCacheTraceRecord first, second;
+  ASSERT_TRUE(reader.ReadAccess(&first).ok());
+  ASSERT_TRUE(reader.ReadAccess(&second).ok());
+  ASSERT_TRUE(reader.ReadAccess(&second).IsNotFound());
+  ASSERT_EQ(kUserGet, first.caller);
+  ASSERT_EQ(kTraceDataBlock, first.block_type);
+  ASSERT_GT(first.block_size, 0u);
+  ASSERT_GE(first.level, 0);
+  // Both keys live in the same data block, which the first Get loaded
+  ASSERT_FALSE(first.is_cache_hit);
+  ASSERT_TRUE(second.is_cache_hit);
+  ASSERT_EQ(first.file_number, second.file_number);
+  ASSERT_EQ(first.block_offset, second.block_offset);
+
+  env->DeleteFile(trace_file);
+  DestroyDB(dbname, options);
+}
+
+} // namespace leveldb
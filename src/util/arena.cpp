@@ -2,12 +2,17 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <new>
 
 namespace leveldb {
 constexpr int kBlockSize = 4096;
+constexpr size_t kAlign = (sizeof(void *) > 8) ? sizeof(void *) : 8;
 
 Arena::Arena()
-    : alloc_ptr_(nullptr), alloc_bytes_remaining_(0), blocks_memory_(0) {}
+    : alloc_ptr_(nullptr),
+      alloc_bytes_remaining_(0),
+      concurrent_block_(nullptr),
+      memory_usage_(0) {}
 
 Arena::~Arena() {
   for (size_t i = 0; i < blocks_.size(); i++) { delete[] blocks_[i]; }
@@ -32,8 +37,8 @@ char *Arena::AllocateFallback(size_t bytes) {
 }
 char *Arena::AllocateNewBlock(size_t bytes) {
   char *result = new char[bytes];
-  blocks_memory_ += bytes;
   blocks_.push_back(result);
+  memory_usage_.fetch_add(bytes + sizeof(char *), std::memory_order_relaxed);
   return result;
 }
 
@@ -57,4 +62,42 @@ char *Arena::AllocateAligned(size_t bytes) {
   return result;
 }
 
+char *Arena::AllocateAlignedConcurrently(size_t bytes) {
+  assert(bytes > 0);
+  if (bytes > kBlockSize / 4) {
+    // Large objects get a block of their own, as in AllocateFallback()
+    std::lock_guard<std::mutex> l(mutex_);
+    return AllocateNewBlock(bytes);
+  }
+  // Rounding every size up keeps every offset aligned
+  const size_t needed = (bytes + kAlign - 1) & ~(kAlign - 1);
+  ConcurrentBlock *block = concurrent_block_.load(std::memory_order_acquire);
+  while (true) {
+    if (block != nullptr) {
+      const size_t offset =
+          block->used.fetch_add(needed, std::memory_order_relaxed);
+      if (offset + needed <= block->size) {
+        char *result = reinterpret_cast<char *>(block + 1) + offset;
+        assert((reinterpret_cast<uintptr_t>(result) & (kAlign - 1)) == 0);
+        return result;
+      }
+    }
+    // We waste the remaining space in the current block.
+    block = NewConcurrentBlock(block);
+  }
+}
+
+Arena::ConcurrentBlock *Arena::NewConcurrentBlock(ConcurrentBlock *full) {
+  std::lock_guard<std::mutex> l(mutex_);
+  ConcurrentBlock *block = concurrent_block_.load(std::memory_order_acquire);
+  if (block != full) { return block; }
+  static_assert(sizeof(ConcurrentBlock) % kAlign == 0);
+  block = new (AllocateNewBlock(sizeof(ConcurrentBlock) + kBlockSize))
+      ConcurrentBlock;
+  block->used.store(0, std::memory_order_relaxed);
+  block->size = kBlockSize;
+  concurrent_block_.store(block, std::memory_order_release);
+  return block;
+}
+
 }  // namespace leveldb
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <mutex>
 #include <vector>
 
 namespace leveldb {
@@ -24,16 +26,33 @@ class Arena {
   // Allocate memory with the normal alignment guarantees provided by malloc.
   char *AllocateAligned(size_t bytes);
 
+  // Thread-safe variant of AllocateAligned().  Threads bump an atomic
+  // offset into a shared block, and lock only to start a new block or for
+  // large allocations.  An arena must not mix it with the unsynchronized
+  // variants while several threads allocate.
+  char *AllocateAlignedConcurrently(size_t bytes);
+
   // Returns an estimate of the total memory usage of data allocated
-  // by the arena.
+  // by the arena.  Safe to call while another thread is allocating.
   size_t MemoryUsage() const {
-    return blocks_memory_ + blocks_.capacity() * sizeof(char *);
+    return memory_usage_.load(std::memory_order_relaxed);
   }
 
  private:
   char *AllocateFallback(size_t bytes);
   char *AllocateNewBlock(size_t block_bytes);
 
+  // Header of the blocks AllocateAlignedConcurrently() carves up, followed
+  // by "size" bytes.  "used" may run past "size" once the block is full.
+  struct ConcurrentBlock {
+    std::atomic<size_t> used;
+    size_t size;
+  };
+
+  // Installs a new concurrent block unless another thread has already
+  // replaced "full", and returns the current one.
+  ConcurrentBlock *NewConcurrentBlock(ConcurrentBlock *full);
+
   // Allocation state
   char *alloc_ptr_;
   size_t alloc_bytes_remaining_;
@@ -41,8 +60,15 @@ class Arena {
   // Array of new[] allocated memory blocks
   std::vector<char *> blocks_;
 
-  // Bytes of memory in blocks allocated so far
-  size_t blocks_memory_;
+  // Block shared by AllocateAlignedConcurrently() callers, or null
+  std::atomic<ConcurrentBlock *> concurrent_block_;
+
+  // Serializes changes to blocks_ from AllocateAlignedConcurrently()
+  std::mutex mutex_;
+
+  // Total memory usage of the arena.  Atomic so that readers such as the
+  // DB property code can poll it without holding the writer's lock.
+  std::atomic<size_t> memory_usage_;
 };
 
 inline char *Arena::Allocate(size_t bytes) {
@@ -0,0 +1,245 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "db/key_compare.h"
+#include "leveldb/slice.h"
+#include "util/arena.h"
+#include "util/bit_packing.h"
+#include "util/coding.h"
+#include "util/hash.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+static void BM_ArenaAllocate(benchmark::State &state) {
+  const size_t bytes = state.range(0);
+  for (auto _ : state) {
+    Arena arena;
+    for (int i = 0; i < 1000; i++) {
+      benchmark::DoNotOptimize(arena.Allocate(bytes));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_ArenaAllocate)->Arg(8)->Arg(64)->Arg(1024);
+
+static void BM_ArenaAllocateAligned(benchmark::State &state) {
+  const size_t bytes = state.range(0);
+  for (auto _ : state) {
+    Arena arena;
+    for (int i = 0; i < 1000; i++) {
+      benchmark::DoNotOptimize(arena.AllocateAligned(bytes));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_ArenaAllocateAligned)->Arg(7)->Arg(64)->Arg(1024);
+
+// Values whose varint encoding takes 1, 2, 3, ... bytes, chosen by the
+// range argument as the maximum number of significant bits.
+static std::vector<uint64_t> VarintValues(int max_bits) {
+  Random64 rnd(301);
+  std::vector<uint64_t> values(4096);
+  for (uint64_t &v : values) {
+    v = rnd.Next() & ((max_bits >= 64) ? ~0ull : ((1ull << max_bits) - 1));
+  }
+  return values;
+}
+
+static void BM_EncodeVarint32(benchmark::State &state) {
+  const std::vector<uint64_t> values = VarintValues(state.range(0));
+  char buf[5 * 4096];
+  for (auto _ : state) {
+    char *p = buf;
+    for (uint64_t v : values) {
+      p = EncodeVarint32(p, static_cast<uint32_t>(v));
+    }
+    benchmark::DoNotOptimize(p);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_EncodeVarint32)->Arg(7)->Arg(14)->Arg(32);
+
+static void BM_DecodeVarint32(benchmark::State &state) {
+  const std::vector<uint64_t> values = VarintValues(state.range(0));
+  std::string encoded;
+  for (uint64_t v : values) { PutVarint32(&encoded, static_cast<uint32_t>(v)); }
+  const char *limit = encoded.data() + encoded.size();
+  for (auto _ : state) {
+    const char *p = encoded.data();
+    uint32_t v;
+    while (p < limit) {
+      p = GetVarint32Ptr(p, limit, &v);
+      benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_DecodeVarint32)->Arg(7)->Arg(14)->Arg(32);
+
+static void BM_DecodeVarint32Batch(benchmark::State &state) {
+  const std::vector<uint64_t> values = VarintValues(state.range(0));
+  std::string encoded;
+  for (uint64_t v : values) { PutVarint32(&encoded, static_cast<uint32_t>(v)); }
+  const char *limit = encoded.data() + encoded.size();
+  std::vector<uint32_t> out(values.size());
+  for (auto _ : state) {
+    const char *p =
+        DecodeVarint32Batch(encoded.data(), limit, out.size(), out.data());
+    benchmark::DoNotOptimize(p);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_DecodeVarint32Batch)->Arg(7)->Arg(14)->Arg(32);
+
+static void BM_EncodeVarint64(benchmark::State &state) {
+  const std::vector<uint64_t> values = VarintValues(state.range(0));
+  char buf[10 * 4096];
+  for (auto _ : state) {
+    char *p = buf;
+    for (uint64_t v : values) { p = EncodeVarint64(p, v); }
+    benchmark::DoNotOptimize(p);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_EncodeVarint64)->Arg(7)->Arg(32)->Arg(64);
+
+static void BM_DecodeVarint64(benchmark::State &state) {
+  const std::vector<uint64_t> values = VarintValues(state.range(0));
+  std::string encoded;
+  for (uint64_t v : values) { PutVarint64(&encoded, v); }
+  const char *limit = encoded.data() + encoded.size();
+  for (auto _ : state) {
+    const char *p = encoded.data();
+    uint64_t v;
+    while (p < limit) {
+      p = GetVarint64Ptr(p, limit, &v);
+      benchmark::DoNotOptimize(v);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_DecodeVarint64)->Arg(7)->Arg(32)->Arg(64);
+
+static void BM_DecodeVarint64Batch(benchmark::State &state) {
+  const std::vector<uint64_t> values = VarintValues(state.range(0));
+  std::string encoded;
+  for (uint64_t v : values) { PutVarint64(&encoded, v); }
+  const char *limit = encoded.data() + encoded.size();
+  std::vector<uint64_t> out(values.size());
+  for (auto _ : state) {
+    const char *p =
+        DecodeVarint64Batch(encoded.data(), limit, out.size(), out.data());
+    benchmark::DoNotOptimize(p);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(BM_DecodeVarint64Batch)->Arg(7)->Arg(32)->Arg(64);
+
+static void BM_Hash(benchmark::State &state) {
+  const std::string data(state.range(0), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Hash(data.data(), data.size(), 0xbc9f1d34));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Hash)->Arg(8)->Arg(16)->Arg(64)->Arg(1024);
+
+static void BM_Hash64(benchmark::State &state) {
+  const std::string data(state.range(0), 'x');
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Hash64(data.data(), data.size(), 0xbc9f1d34));
+  }
+  state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_Hash64)->Arg(8)->Arg(16)->Arg(64)->Arg(128)->Arg(1024);
+
+// Compares two slices that share a prefix of range(0) bytes.
+static void BM_SliceCompare(benchmark::State &state) {
+  std::string a(state.range(0), 'k');
+  std::string b = a;
+  a.push_back('a');
+  b.push_back('b');
+  const Slice sa(a);
+  const Slice sb(b);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sa.compare(sb));
+  }
+}
+BENCHMARK(BM_SliceCompare)->Arg(0)->Arg(16)->Arg(128);
+
+// Same as BM_SliceCompare with the inline comparison used by the
+// devirtualized search loops.
+static void BM_BytewiseCompare(benchmark::State &state) {
+  std::string a(state.range(0), 'k');
+  std::string b = a;
+  a.push_back('a');
+  b.push_back('b');
+  const Slice sa(a);
+  const Slice sb(b);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(BytewiseCompare(sa, sb));
+  }
+}
+BENCHMARK(BM_BytewiseCompare)->Arg(0)->Arg(16)->Arg(128);
+
+static void BM_BitStreamGetInt(benchmark::State &state) {
+  const uint32_t bits = state.range(0);
+  const size_t count = 4096;
+  std::string stream((count * bits + 7) / 8, '\0');
+  Random64 rnd(301);
+  for (size_t i = 0; i < count; i++) {
+    BitStreamPutInt(&stream, i * bits, bits, rnd.Next());
+  }
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; i++) {
+      benchmark::DoNotOptimize(
+          BitStreamGetInt(stream.data(), stream.size(), i * bits, bits));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_BitStreamGetInt)->Arg(3)->Arg(13)->Arg(32)->Arg(64);
+
+static void BM_BitUnpack(benchmark::State &state) {
+  const uint32_t bits = state.range(0);
+  const size_t count = 4096;
+  std::vector<uint32_t> values(count);
+  Random64 rnd(301);
+  for (uint32_t &v : values) {
+    v = static_cast<uint32_t>(rnd.Next()) &
+        (bits == 32 ? ~0u : (1u << bits) - 1);
+  }
+  std::string packed(BitPackedSize(count, bits), '\0');
+  BitPack(values.data(), count, bits, packed.data());
+  for (auto _ : state) {
+    BitUnpack(packed.data(), count, bits, values.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_BitUnpack)->Arg(3)->Arg(13)->Arg(32);
+
+static void BM_BitPack(benchmark::State &state) {
+  const uint32_t bits = state.range(0);
+  const size_t count = 4096;
+  std::vector<uint32_t> values(count);
+  Random64 rnd(301);
+  for (uint32_t &v : values) { v = static_cast<uint32_t>(rnd.Next()); }
+  std::string packed(BitPackedSize(count, bits), '\0');
+  for (auto _ : state) {
+    BitPack(values.data(), count, bits, packed.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_BitPack)->Arg(3)->Arg(13)->Arg(32);
+
+} // namespace leveldb
@@ -0,0 +1,263 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "util/bit_packing.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "port/port.h"
+#include "util/coding.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace leveldb {
+
+static inline uint32_t LowBitsMask32(uint32_t bits) {
+  return bits >= 32 ? ~0u : (1u << bits) - 1;
+}
+
+// Value "index" of a packed array of "len" bytes.  Reads a whole word when
+// it fits in the buffer, which covers all but the last few values.
+// REQUIRES: bits <= 56 unless the word does not fit
+static inline uint64_t GetPacked(const char *src, size_t len, size_t index,
+                                 uint32_t bits) {
+  const size_t bit = index * bits;
+  const size_t byte = bit / 8;
+  if (bits <= 56 && byte + 8 <= len) {
+    const uint64_t mask = (1ull << bits) - 1;
+    return (DecodeFixed64(src + byte) >> (bit % 8)) & mask;
+  }
+  return BitStreamGetInt(src, len, bit, bits);
+}
+
+uint32_t MaxBits(const uint32_t *values, size_t n) {
+  uint32_t all = 0;
+  for (size_t i = 0; i < n; i++) { all |= values[i]; }
+  return all == 0 ? 0 : 32 - __builtin_clz(all);
+}
+
+void BitPack(const uint32_t *values, size_t n, uint32_t bits, char *dst) {
+  assert(bits >= 1 && bits <= 32);
+  const uint64_t mask = LowBitsMask32(bits);
+  // Never holds more than 63 pending bits: < 32 before a value is added
+  uint64_t pending = 0;
+  uint32_t num_pending = 0;
+  for (size_t i = 0; i < n; i++) {
+    pending |= (values[i] & mask) << num_pending;
+    num_pending += bits;
+    if (num_pending >= 32) {
+      EncodeFixed32(dst, static_cast<uint32_t>(pending));
+      dst += 4;
+      pending >>= 32;
+      num_pending -= 32;
+    }
+  }
+  for (; num_pending > 0; num_pending -= std::min(num_pending, 8u)) {
+    *dst++ = static_cast<char>(pending);
+    pending >>= 8;
+  }
+}
+
+static void BitUnpackPortable(const char *src, size_t len, size_t first,
+                              size_t n, uint32_t bits, uint32_t *out) {
+  for (size_t i = 0; i < n; i++) {
+    out[i] = static_cast<uint32_t>(GetPacked(src, len, first + i, bits));
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace {
+
+// Eight consecutive values span exactly "bits" bytes.  The AVX2 decoder
+// loads the 16 bytes holding values 0-3 into the low lane and the 16 bytes
+// holding values 4-7 into the high lane, shuffles the 4 bytes covering
+// each value into its 32-bit slot, then shifts and masks.  A 4-byte window
+// holds any value of up to 25 bits whatever its bit alignment.
+const uint32_t kMaxAVX2UnpackBits = 25;
+
+struct UnpackShuffle {
+  alignas(32) uint8_t shuffle[32];
+  alignas(32) uint32_t shift[8];
+  uint32_t high_offset; // byte offset of the high lane's 16 bytes
+};
+
+struct UnpackShuffleTable {
+  UnpackShuffle entries[kMaxAVX2UnpackBits + 1];
+
+  UnpackShuffleTable() {
+    for (uint32_t bits = 1; bits <= kMaxAVX2UnpackBits; bits++) {
+      UnpackShuffle *e = &entries[bits];
+      e->high_offset = 4 * bits / 8;
+      for (uint32_t i = 0; i < 8; i++) {
+        const uint32_t lane_base = i < 4 ? 0 : e->high_offset * 8;
+        const uint32_t bit = i * bits - lane_base;
+        for (uint32_t k = 0; k < 4; k++) {
+          e->shuffle[(i / 4) * 16 + (i % 4) * 4 + k] =
+              static_cast<uint8_t>(bit / 8 + k);
+        }
+        e->shift[i] = bit % 8;
+      }
+    }
+  }
+};
+
+} // namespace
+
+__attribute__((target("avx2"))) static void
+BitUnpackAVX2(const char *src, size_t n, uint32_t bits, uint32_t *out) {
+  static const UnpackShuffleTable table;
+  const UnpackShuffle &e = table.entries[bits];
+  const __m256i shuffle =
+      _mm256_load_si256(reinterpret_cast<const __m256i *>(e.shuffle));
+  const __m256i shift =
+      _mm256_load_si256(reinterpret_cast<const __m256i *>(e.shift));
+  const __m256i mask = _mm256_set1_epi32(static_cast<int>(LowBitsMask32(bits)));
+  const size_t len = BitPackedSize(n, bits);
+  size_t i = 0;
+  for (const char *p = src; n - i >= 8; i += 8, p += bits) {
+    if (static_cast<size_t>(p - src) + e.high_offset + 16 > len) { break; }
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const __m128i hi =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + e.high_offset));
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    v = _mm256_shuffle_epi8(v, shuffle);
+    v = _mm256_and_si256(_mm256_srlv_epi32(v, shift), mask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), v);
+  }
+  BitUnpackPortable(src, len, i, n - i, bits, out + i);
+}
+
+static bool HaveAVX2() { return __builtin_cpu_supports("avx2"); }
+
+#endif
+
+void BitUnpack(const char *src, size_t n, uint32_t bits, uint32_t *out) {
+  assert(bits >= 1 && bits <= 32);
+  // Empty input may come with null pointers, which memcpy does not allow
+  if (n == 0) { return; }
+  if (bits == 32 && port::kLittleEndian) {
+    std::memcpy(out, src, n * sizeof(uint32_t));
+    return;
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool use_avx2 = HaveAVX2();
+  if (use_avx2 && bits <= kMaxAVX2UnpackBits) {
+    BitUnpackAVX2(src, n, bits, out);
+    return;
+  }
+#endif
+  BitUnpackPortable(src, BitPackedSize(n, bits), 0, n, bits, out);
+}
+
+void PutFrameOfReference(std::string *dst, const uint64_t *values, size_t n) {
+  PutVarint32(dst, static_cast<uint32_t>(n));
+  std::vector<uint32_t> deltas;
+  for (size_t start = 0; start < n; start += kFrameOfReferenceSize) {
+    const size_t frame_size = std::min(n - start, kFrameOfReferenceSize);
+    const uint64_t *frame = values + start;
+    const auto [min, max] = std::minmax_element(frame, frame + frame_size);
+    const uint64_t range = *max - *min;
+    const uint32_t bits = range == 0 ? 0 : 64 - __builtin_clzll(range);
+    PutVarint64(dst, *min);
+    dst->push_back(static_cast<char>(bits));
+    if (bits == 0) { continue; }
+
+    const size_t offset = dst->size();
+    dst->resize(offset + BitPackedSize(frame_size, bits));
+    char *packed = &(*dst)[offset];
+    if (bits <= 32) {
+      deltas.resize(frame_size);
+      for (size_t i = 0; i < frame_size; i++) {
+        deltas[i] = static_cast<uint32_t>(frame[i] - *min);
+      }
+      BitPack(deltas.data(), frame_size, bits, packed);
+    } else {
+      for (size_t i = 0; i < frame_size; i++) {
+        BitStreamPutInt(packed, BitPackedSize(frame_size, bits), i * bits,
+                        bits, frame[i] - *min);
+      }
+    }
+  }
+}
+
+bool GetFrameOfReference(Slice *input, std::vector<uint64_t> *values) {
+  FrameOfReferenceReader reader;
+  if (!reader.Init(*input)) { return false; }
+  values->resize(reader.size());
+  reader.DecodeRange(0, reader.size(), values->data());
+  input->remove_prefix(reader.encoded_size());
+  return true;
+}
+
+FrameOfReferenceReader::FrameOfReferenceReader()
+    : count_(0), encoded_size_(0) {}
+
+bool FrameOfReferenceReader::Init(const Slice &input) {
+  frames_.clear();
+  Slice in = input;
+  uint32_t count;
+  if (!GetVarint32(&in, &count)) { return false; }
+  for (size_t start = 0; start < count; start += kFrameOfReferenceSize) {
+    const size_t frame_size =
+        std::min<size_t>(count - start, kFrameOfReferenceSize);
+    Frame frame;
+    if (!GetVarint64(&in, &frame.base) || in.empty()) { return false; }
+    frame.bits = static_cast<unsigned char>(in[0]);
+    in.remove_prefix(1);
+    const size_t packed_size = BitPackedSize(frame_size, frame.bits);
+    if (frame.bits > 64 || in.size() < packed_size) { return false; }
+    frame.packed = in.data();
+    in.remove_prefix(packed_size);
+    frames_.push_back(frame);
+  }
+  count_ = count;
+  encoded_size_ = input.size() - in.size();
+  return true;
+}
+
+uint64_t FrameOfReferenceReader::Get(size_t i) const {
+  assert(i < count_);
+  const Frame &frame = frames_[i / kFrameOfReferenceSize];
+  if (frame.bits == 0) { return frame.base; }
+  const size_t frame_size =
+      std::min(count_ - i / kFrameOfReferenceSize * kFrameOfReferenceSize,
+               kFrameOfReferenceSize);
+  return frame.base + GetPacked(frame.packed,
+                                BitPackedSize(frame_size, frame.bits),
+                                i % kFrameOfReferenceSize, frame.bits);
+}
+
+void FrameOfReferenceReader::DecodeRange(size_t first, size_t n,
+                                         uint64_t *out) const {
+  assert(first + n <= count_);
+  uint32_t deltas[kFrameOfReferenceSize];
+  while (n > 0) {
+    const size_t start = first / kFrameOfReferenceSize * kFrameOfReferenceSize;
+    const size_t frame_size = std::min(count_ - start, kFrameOfReferenceSize);
+    const Frame &frame = frames_[first / kFrameOfReferenceSize];
+    const size_t skip = first - start;
+    const size_t todo = std::min(n, frame_size - skip);
+    if (frame.bits == 0) {
+      std::fill(out, out + todo, frame.base);
+    } else if (frame.bits <= 32 && skip == 0) {
+      BitUnpack(frame.packed, todo, frame.bits, deltas);
+      for (size_t i = 0; i < todo; i++) { out[i] = frame.base + deltas[i]; }
+    } else {
+      const size_t len = BitPackedSize(frame_size, frame.bits);
+      for (size_t i = 0; i < todo; i++) {
+        out[i] = frame.base + GetPacked(frame.packed, len, skip + i, frame.bits);
+      }
+    }
+    first += todo;
+    n -= todo;
+    out += todo;
+  }
+}
+
+} // namespace leveldb
@@ -0,0 +1,91 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+// Fixed-width bit packing of integer arrays, and a frame-of-reference codec
+// built on it, for compact index and filter structures.
+//
+// Packed arrays use the BitStreamPutInt() layout: value i occupies bits
+// [i*bits, (i+1)*bits) of the buffer, least significant bit first, so a
+// single value can still be read in place with BitStreamGetInt().
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+// Number of bytes taken by "n" packed values of "bits" bits each.
+inline size_t BitPackedSize(size_t n, uint32_t bits) {
+  return (n * bits + 7) / 8;
+}
+
+// Number of bits needed for the largest of values[0..n-1] (0 if all are 0).
+uint32_t MaxBits(const uint32_t *values, size_t n);
+
+// Pack values[0..n-1] into BitPackedSize(n, bits) bytes at dst.  Bits of a
+// value above "bits" are dropped.
+// REQUIRES: 1 <= bits <= 32
+void BitPack(const uint32_t *values, size_t n, uint32_t bits, char *dst);
+
+// Inverse of BitPack().  Uses AVX2 when the CPU has it and bits <= 25.
+// REQUIRES: src holds BitPackedSize(n, bits) bytes, 1 <= bits <= 32
+void BitUnpack(const char *src, size_t n, uint32_t bits, uint32_t *out);
+
+// Frame-of-reference coding.  Values are split into frames of
+// kFrameOfReferenceSize; each frame stores its minimum and the bit-packed
+// offsets from it, so clustered values (block offsets, sorted key hashes,
+// restart positions) take a few bits each whatever their magnitude.
+//
+//    count     varint32
+//    per frame:
+//      base    varint64  -- minimum of the frame
+//      bits    uint8     -- width of (value - base), 0..64
+//      packed  BitPackedSize(frame_size, bits) bytes
+const size_t kFrameOfReferenceSize = 128;
+
+void PutFrameOfReference(std::string *dst, const uint64_t *values, size_t n);
+
+// Decode a whole encoding from the front of *input and advance past it.
+bool GetFrameOfReference(Slice *input, std::vector<uint64_t> *values);
+
+// Random access to an encoding produced by PutFrameOfReference().  Refers
+// to the encoded bytes, which must outlive the reader.
+class FrameOfReferenceReader {
+public:
+  FrameOfReferenceReader();
+
+  // Parse the frame headers at the front of "input".  Returns false if the
+  // encoding is malformed.
+  bool Init(const Slice &input);
+
+  size_t size() const { return count_; }
+
+  // Bytes of "input" taken by the encoding.
+  size_t encoded_size() const { return encoded_size_; }
+
+  // REQUIRES: i < size()
+  uint64_t Get(size_t i) const;
+
+  // Decode values [first, first+n).
+  // REQUIRES: first + n <= size()
+  void DecodeRange(size_t first, size_t n, uint64_t *out) const;
+
+private:
+  struct Frame {
+    uint64_t base;
+    uint32_t bits;
+    const char *packed;
+  };
+
+  size_t count_;
+  size_t encoded_size_;
+  std::vector<Frame> frames_;
+};
+
+} // namespace leveldb
@@ -6,6 +6,10 @@
 
 #include <algorithm>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 namespace leveldb {
 
 void EncodeFixed32(char *buf, uint32_t value) {
@@ -174,6 +178,198 @@ bool GetLengthPrefixedSlice(Slice *input, Slice *result) {
   }
 }
 
+// Batch varint decoding.  The portable versions are plain loops over the
+// single-value decoders; the SSSE3 versions follow the Masked VByte idea:
+// the continuation bits of the next 8 input bytes index a table holding a
+// pshufb mask that moves up to four complete varints of at most 4 bytes
+// into their own 32-bit lanes, whose 7-bit groups are then packed with a
+// few shifts.  Anything the table cannot handle (long varints, the last few
+// values, the last 16 input bytes) goes through the scalar decoder.
+
+static const char *DecodeVarint32BatchPortable(const char *p,
+                                               const char *limit, size_t n,
+                                               uint32_t *out) {
+  for (size_t i = 0; i < n && p != nullptr; i++) {
+    p = GetVarint32Ptr(p, limit, &out[i]);
+  }
+  return p;
+}
+
+static const char *DecodeVarint64BatchPortable(const char *p,
+                                               const char *limit, size_t n,
+                                               uint64_t *out) {
+  for (size_t i = 0; i < n && p != nullptr; i++) {
+    if (p < limit && (*reinterpret_cast<const unsigned char *>(p) & 128) == 0) {
+      out[i] = *reinterpret_cast<const unsigned char *>(p);
+      p++;
+    } else {
+      p = GetVarint64Ptr(p, limit, &out[i]);
+    }
+  }
+  return p;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace {
+
+struct VarintShuffle {
+  alignas(16) uint8_t shuffle[16];
+  uint8_t num_values; // 0 if the first varint is longer than 4 bytes
+  uint8_t consumed;   // input bytes spanned by those values
+};
+
+// Indexed by the continuation bits of 8 consecutive input bytes
+struct VarintShuffleTable {
+  VarintShuffle entries[256];
+
+  VarintShuffleTable() {
+    for (int mask = 0; mask < 256; mask++) {
+      VarintShuffle *e = &entries[mask];
+      std::memset(e->shuffle, 0x80, sizeof(e->shuffle)); // 0x80 yields zero
+      e->num_values = 0;
+      e->consumed = 0;
+      int start = 0;
+      while (e->num_values < 4) {
+        int end = start;
+        while (end < 8 && (mask & (1 << end)) != 0) { end++; }
+        if (end == 8 || end - start >= 4) { break; }
+        for (int b = start; b <= end; b++) {
+          e->shuffle[e->num_values * 4 + (b - start)] = static_cast<uint8_t>(b);
+        }
+        e->num_values++;
+        start = end + 1;
+      }
+      e->consumed = static_cast<uint8_t>(start);
+    }
+  }
+};
+
+// Gathers the varints described by "e" from "bytes", skipping the first
+// "offset" bytes, and returns them as four 32-bit lanes.
+__attribute__((target("ssse3"))) inline __m128i
+GatherVarints(__m128i bytes, const VarintShuffle &e, int offset) {
+  // Indices of 0x80 and up stay >= 0x80, i.e. still produce zero bytes
+  const __m128i shuffle = _mm_add_epi8(
+      _mm_load_si128(reinterpret_cast<const __m128i *>(e.shuffle)),
+      _mm_set1_epi8(static_cast<char>(offset)));
+  const __m128i v = _mm_shuffle_epi8(bytes, shuffle);
+  // Byte k of each lane holds bits [7k, 7k+7) of the value
+  return _mm_or_si128(
+      _mm_or_si128(
+          _mm_and_si128(v, _mm_set1_epi32(0x7f)),
+          _mm_srli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7f00)), 1)),
+      _mm_or_si128(
+          _mm_srli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7f0000)), 2),
+          _mm_srli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7f000000)), 3)));
+}
+
+} // namespace
+
+__attribute__((target("ssse3"))) static const char *
+DecodeVarint32BatchSSSE3(const char *p, const char *limit, size_t n,
+                         uint32_t *out) {
+  static const VarintShuffleTable table;
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  while (n - i >= 4 && limit - p >= 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+    if (mask == 0 && n - i >= 16) {
+      // Sixteen single-byte values
+      const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+      const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+      __m128i *dst = reinterpret_cast<__m128i *>(out + i);
+      _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+      i += 16;
+      p += 16;
+      continue;
+    }
+    const VarintShuffle &e = table.entries[mask & 0xff];
+    if (e.num_values == 0) {
+      p = GetVarint32PtrFallback(p, limit, &out[i++]);
+      if (p == nullptr) { return nullptr; }
+      continue;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     GatherVarints(bytes, e, 0));
+    i += e.num_values;
+    p += e.consumed;
+    // The next 8 bytes are still within the 16 loaded, which halves the
+    // loop-carried load -> table -> pointer dependency per value
+    const VarintShuffle &e2 = table.entries[(mask >> e.consumed) & 0xff];
+    if (e2.num_values != 0 && n - i >= 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                       GatherVarints(bytes, e2, e.consumed));
+      i += e2.num_values;
+      p += e2.consumed;
+    }
+  }
+  return DecodeVarint32BatchPortable(p, limit, n - i, out + i);
+}
+
+__attribute__((target("ssse3"))) static const char *
+DecodeVarint64BatchSSSE3(const char *p, const char *limit, size_t n,
+                         uint64_t *out) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  while (n - i >= 16 && limit - p >= 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+    if (mask != 0) {
+      // Copy the single-byte values in front of the first long one, then
+      // decode that one
+      for (int run = __builtin_ctz(mask); run > 0; run--) {
+        out[i++] = *reinterpret_cast<const unsigned char *>(p++);
+      }
+      p = GetVarint64Ptr(p, limit, &out[i++]);
+      if (p == nullptr) { return nullptr; }
+      continue;
+    }
+    const __m128i halves[2] = {_mm_unpacklo_epi8(bytes, zero),
+                               _mm_unpackhi_epi8(bytes, zero)};
+    __m128i *dst = reinterpret_cast<__m128i *>(out + i);
+    for (const __m128i &h : halves) {
+      const __m128i lo = _mm_unpacklo_epi16(h, zero);
+      const __m128i hi = _mm_unpackhi_epi16(h, zero);
+      _mm_storeu_si128(dst++, _mm_unpacklo_epi32(lo, zero));
+      _mm_storeu_si128(dst++, _mm_unpackhi_epi32(lo, zero));
+      _mm_storeu_si128(dst++, _mm_unpacklo_epi32(hi, zero));
+      _mm_storeu_si128(dst++, _mm_unpackhi_epi32(hi, zero));
+    }
+    i += 16;
+    p += 16;
+  }
+  return DecodeVarint64BatchPortable(p, limit, n - i, out + i);
+}
+
+static bool HaveSSSE3() { return __builtin_cpu_supports("ssse3"); }
+
+#endif
+
+const char *DecodeVarint32Batch(const char *p, const char *limit, size_t n,
+                                uint32_t *out) {
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool use_ssse3 = HaveSSSE3();
+  if (use_ssse3) { return DecodeVarint32BatchSSSE3(p, limit, n, out); }
+#endif
+  return DecodeVarint32BatchPortable(p, limit, n, out);
+}
+
+const char *DecodeVarint64Batch(const char *p, const char *limit, size_t n,
+                                uint64_t *out) {
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool use_ssse3 = HaveSSSE3();
+  if (use_ssse3) { return DecodeVarint64BatchSSSE3(p, limit, n, out); }
+#endif
+  return DecodeVarint64BatchPortable(p, limit, n, out);
+}
+
 void BitStreamPutInt(char *dst, size_t dstlen, size_t offset, uint32_t bits,
                      uint64_t value) {
   assert((offset + bits + 7) / 8 <= dstlen);
@@ -42,6 +42,17 @@ bool GetLengthPrefixedSlice(Slice *input, Slice *result);
 const char *GetVarint32Ptr(const char *p, const char *limit, uint32_t *v);
 const char *GetVarint64Ptr(const char *p, const char *limit, uint64_t *v);
 
+// Bulk variants of GetVarint32Ptr/GetVarint64Ptr for runs of consecutive
+// varints: decode "n" values from [p..limit-1] into out[0..n-1] and return
+// a pointer just past the last one, or nullptr if the input is truncated or
+// malformed (out[] is then partially written).  On x86 CPUs with SSSE3 the
+// 32-bit variant decodes up to four values per shuffle and both variants
+// widen runs of single-byte values sixteen at a time.
+const char *DecodeVarint32Batch(const char *p, const char *limit, size_t n,
+                                uint32_t *out);
+const char *DecodeVarint64Batch(const char *p, const char *limit, size_t n,
+                                uint64_t *out);
+
 // Returns the length of the varint32 or varint64 encoding of "v"
 int VarintLength(uint64_t v);
 
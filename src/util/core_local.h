@@ -0,0 +1,81 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "port/port.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+// An array of T with one element per core (rounded up to a power of two).
+// Writers touch the element of the core they are running on, so hot
+// counters do not bounce a shared cache line between cores; readers that
+// need a total walk every element with AccessAtCore().
+//
+// T should be aligned to port::kCacheLineSize so that neighbouring elements
+// never share a line.
+template <typename T>
+class CoreLocalArray {
+ public:
+  CoreLocalArray();
+
+  // No copying allowed
+  CoreLocalArray(const CoreLocalArray &) = delete;
+  void operator=(const CoreLocalArray &) = delete;
+
+  size_t Size() const { return static_cast<size_t>(1) << size_shift_; }
+
+  // Returns the element for the core the caller is running on.
+  T *Access() const { return AccessElementAndIndex().first; }
+
+  // Same as Access() but also returns the index of the element.
+  std::pair<T *, size_t> AccessElementAndIndex() const;
+
+  // REQUIRES: core_idx < Size()
+  T *AccessAtCore(size_t core_idx) const {
+    assert(core_idx < Size());
+    return &data_[core_idx];
+  }
+
+ private:
+  std::unique_ptr<T[]> data_;
+  int size_shift_;
+};
+
+template <typename T>
+CoreLocalArray<T>::CoreLocalArray() {
+  unsigned int num_cpus = std::thread::hardware_concurrency();
+  // hardware_concurrency() may return 0 when the value is not computable
+  if (num_cpus == 0) num_cpus = 1;
+  size_shift_ = 0;
+  while ((1u << size_shift_) < num_cpus) { size_shift_++; }
+  data_.reset(new T[static_cast<size_t>(1) << size_shift_]);
+}
+
+template <typename T>
+std::pair<T *, size_t> CoreLocalArray<T>::AccessElementAndIndex() const {
+  int cpuid = port::PhysicalCoreID();
+  size_t core_idx;
+  if (cpuid < 0) {
+    // Cpu id is not available; spread threads over the shards instead.
+    static thread_local Random rnd(
+        static_cast<uint32_t>(
+            std::hash<std::thread::id>()(std::this_thread::get_id())) |
+        1);
+    core_idx = rnd.Next() & (Size() - 1);
+  } else {
+    core_idx = static_cast<size_t>(cpuid) & (Size() - 1);
+  }
+  return {AccessAtCore(core_idx), core_idx};
+}
+
+}  // namespace leveldb
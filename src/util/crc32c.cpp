@@ -0,0 +1,78 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A portable implementation of crc32c, optimized to handle
+// four bytes at a time.
+
+#include "util/crc32c.h"
+
+#include <array>
+
+#include "util/coding.h"
+
+namespace leveldb::crc32c {
+
+namespace {
+
+// Castagnoli polynomial, reflected.
+constexpr uint32_t kPolynomial = 0x82f63b78;
+
+// kTables[0] is the classic byte-at-a-time table; kTables[k][b] is the crc
+// of byte b followed by k zero bytes, which lets Extend() fold four input
+// bytes per step ("slicing-by-4").
+using Tables = std::array<std::array<uint32_t, 256>, 4>;
+
+constexpr Tables MakeTables() {
+  Tables t{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+    }
+    t[0][i] = crc;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (int k = 1; k < 4; k++) {
+      t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+    }
+  }
+  return t;
+}
+
+constexpr Tables kTables = MakeTables();
+
+}  // namespace
+
+uint32_t Extend(uint32_t crc, const char *buf, size_t size) {
+  const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
+  const uint8_t *e = p + size;
+  uint32_t l = crc ^ 0xffffffffu;
+
+#define STEP1                                   \
+  do {                                          \
+    l = kTables[0][(l ^ *p++) & 0xff] ^ (l >> 8); \
+  } while (0)
+
+  // Point x at first 4-byte aligned byte in string.  This might be
+  // just past the end of the string.
+  const uintptr_t pval = reinterpret_cast<uintptr_t>(p);
+  const uint8_t *x = reinterpret_cast<const uint8_t *>(((pval + 3) >> 2) << 2);
+  if (x <= e) {
+    // Process bytes until finished or p is 4-byte aligned
+    while (p != x) { STEP1; }
+  }
+  // Process bytes 4 at a time
+  while ((e - p) >= 4) {
+    l ^= DecodeFixed32(reinterpret_cast<const char *>(p));
+    l = kTables[3][l & 0xff] ^ kTables[2][(l >> 8) & 0xff] ^
+        kTables[1][(l >> 16) & 0xff] ^ kTables[0][l >> 24];
+    p += 4;
+  }
+  // Process the last few bytes
+  while (p != e) { STEP1; }
+#undef STEP1
+  return l ^ 0xffffffffu;
+}
+
+}  // namespace leveldb::crc32c
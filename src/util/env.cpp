@@ -0,0 +1,104 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/env.h"
+
+#include "leveldb/options.h"
+
+namespace leveldb {
+
+Env::~Env() {}
+
+SequentialFile::~SequentialFile() {}
+
+RandomAccessFile::~RandomAccessFile() {}
+
+WritableFile::~WritableFile() {}
+
+Logger::~Logger() {}
+
+FileLock::~FileLock() {}
+
+void Log(Logger *info_log, const char *format, ...) {
+  if (info_log != nullptr) {
+    va_list ap;
+    va_start(ap, format);
+    info_log->Logv(format, ap);
+    va_end(ap);
+  }
+}
+
+void Log(const shared_ptr<Logger> &info_log, const char *format, ...) {
+  if (info_log) {
+    va_list ap;
+    va_start(ap, format);
+    info_log->Logv(format, ap);
+    va_end(ap);
+  }
+}
+
+static Status DoWriteStringToFile(Env *env, const Slice &data,
+                                  const std::string &fname, bool should_sync) {
+  unique_ptr<WritableFile> file;
+  EnvOptions soptions;
+  Status s = env->NewWritableFile(fname, &file, soptions);
+  if (!s.ok()) { return s; }
+  s = file->Append(data);
+  if (s.ok() && should_sync) { s = file->Sync(); }
+  if (s.ok()) { s = file->Close(); }
+  file.reset();  // Will auto-close if we did not close above
+  if (!s.ok()) { env->DeleteFile(fname); }
+  return s;
+}
+
+Status WriteStringToFile(Env *env, const Slice &data,
+                         const std::string &fname) {
+  return DoWriteStringToFile(env, data, fname, false);
+}
+
+Status WriteStringToFileSync(Env *env, const Slice &data,
+                             const std::string &fname) {
+  return DoWriteStringToFile(env, data, fname, true);
+}
+
+Status ReadFileToString(Env *env, const std::string &fname,
+                        std::string *data) {
+  EnvOptions soptions;
+  data->clear();
+  unique_ptr<SequentialFile> file;
+  Status s = env->NewSequentialFile(fname, &file, soptions);
+  if (!s.ok()) { return s; }
+  static const int kBufferSize = 8192;
+  char *space = new char[kBufferSize];
+  while (true) {
+    Slice fragment;
+    s = file->Read(kBufferSize, &fragment, space);
+    if (!s.ok()) { break; }
+    data->append(fragment.data(), fragment.size());
+    if (fragment.empty()) { break; }
+  }
+  delete[] space;
+  return s;
+}
+
+EnvWrapper::~EnvWrapper() {}
+
+EnvOptions::EnvOptions(const Options &options) {
+  use_os_buffer = options.allow_os_buffer;
+  use_mmap_reads = options.allow_mmap_reads;
+  use_mmap_writes = options.allow_mmap_writes;
+  set_fd_cloexec = options.is_fd_close_on_exec;
+  bytes_per_sync = options.bytes_per_sync;
+}
+
+EnvOptions::EnvOptions() {
+  Options options;
+  use_os_buffer = options.allow_os_buffer;
+  use_mmap_reads = options.allow_mmap_reads;
+  use_mmap_writes = options.allow_mmap_writes;
+  set_fd_cloexec = options.is_fd_close_on_exec;
+  bytes_per_sync = options.bytes_per_sync;
+}
+
+}  // namespace leveldb
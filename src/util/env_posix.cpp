@@ -1,12 +1,36 @@
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "leveldb/env.h"
+#include "leveldb/slice.h"
 #include "leveldb/status.h"
+#include "util/iostats_context_imp.h"
+#include "util/posix_logger.h"
+
 namespace leveldb {
 namespace {
 
-int g_open_read_only_file_limit = -1;
 // Common flags defined for all posix open operations
 #if defined(HAVE_O_CLOEXEC)
 constexpr const int kOpenBaseFlags = O_CLOEXEC;
@@ -15,18 +39,286 @@ constexpr const int kOpenBaseFlags = 0;
 #endif  // defined(HAVE_O_CLOEXEC)
 
 constexpr const size_t kWritableFileBufferSize = 65536;
+
+Status PosixError(const std::string &context, int error_number) {
+  if (error_number == ENOENT) {
+    return Status::NotFound(context, std::strerror(error_number));
+  } else {
+    return Status::IOError(context, std::strerror(error_number));
+  }
+}
+
+int OpenFlags(const EnvOptions &options) {
+  return options.set_fd_cloexec ? (kOpenBaseFlags | O_CLOEXEC)
+                                : kOpenBaseFlags;
+}
+
 }  // namespace
 
+class PosixSequentialFile final : public SequentialFile {
+ public:
+  PosixSequentialFile(std::string filename, int fd)
+      : fd_(fd), filename_(std::move(filename)) {}
+  ~PosixSequentialFile() override { close(fd_); }
+
+  Status Read(size_t n, Slice *result, char *scratch) override {
+    Status status;
+    while (true) {
+      ::ssize_t read_size = ::read(fd_, scratch, n);
+      if (read_size < 0) {  // Read error.
+        if (errno == EINTR) { continue; }  // Retry
+        status = PosixError(filename_, errno);
+        break;
+      }
+      *result = Slice(scratch, read_size);
+      IOSTATS_ADD(bytes_read, read_size);
+      break;
+    }
+    return status;
+  }
+
+  Status Skip(uint64_t n) override {
+    if (::lseek(fd_, n, SEEK_CUR) == static_cast<off_t>(-1)) {
+      return PosixError(filename_, errno);
+    }
+    return Status::OK();
+  }
+
+ private:
+  const int fd_;
+  const std::string filename_;
+};
+
+class PosixRandomAccessFile final : public RandomAccessFile {
+ public:
+  PosixRandomAccessFile(std::string filename, int fd)
+      : fd_(fd), filename_(std::move(filename)) {}
+  ~PosixRandomAccessFile() override { close(fd_); }
+
+  Status Read(uint64_t offset, size_t n, Slice *result,
+              char *scratch) const override {
+    Status status;
+    ::ssize_t read_size;
+    {
+      IOSTATS_TIMER_GUARD(read_nanos);
+      read_size = ::pread(fd_, scratch, n, static_cast<off_t>(offset));
+    }
+    *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
+    if (read_size < 0) {
+      // An error: return a non-ok status.
+      status = PosixError(filename_, errno);
+    } else {
+      IOSTATS_ADD(bytes_read, read_size);
+    }
+    return status;
+  }
+
+  void Hint(AccessPattern pattern) override {
+#if defined(POSIX_FADV_NORMAL)
+    int advice = POSIX_FADV_NORMAL;
+    switch (pattern) {
+      case NORMAL:
+        advice = POSIX_FADV_NORMAL;
+        break;
+      case RANDOM:
+        advice = POSIX_FADV_RANDOM;
+        break;
+      case SEQUENTIAL:
+        advice = POSIX_FADV_SEQUENTIAL;
+        break;
+      case WILLNEED:
+        advice = POSIX_FADV_WILLNEED;
+        break;
+      case DONTNEED:
+        advice = POSIX_FADV_DONTNEED;
+        break;
+    }
+    ::posix_fadvise(fd_, 0, 0, advice);
+#else
+    (void)pattern;
+#endif
+  }
+
+ private:
+  const int fd_;
+  const std::string filename_;
+};
+
 class PosixWritableFile final : public WritableFile {
  public:
+  PosixWritableFile(std::string filename, int fd)
+      : pos_(0),
+        fd_(fd),
+        is_manifest_(IsManifest(filename)),
+        filename_(std::move(filename)),
+        dirname_(Dirname(filename_)),
+        filesize_(0) {}
+
   PosixWritableFile(const PosixWritableFile &) = delete;
   PosixWritableFile(PosixWritableFile &&) = delete;
   PosixWritableFile &operator=(const PosixWritableFile &) = delete;
   PosixWritableFile &operator=(PosixWritableFile &&) = delete;
-  ~PosixWritableFile() override {}
-  Status Append(const Slice &data) override {}
+  ~PosixWritableFile() override {
+    if (fd_ >= 0) {
+      // Ignoring any potential errors
+      Close();
+    }
+  }
+
+  Status Append(const Slice &data) override {
+    size_t write_size = data.size();
+    const char *write_data = data.data();
+    filesize_ += write_size;
+
+    // Fit as much as possible into buffer.
+    size_t copy_size = std::min(write_size, kWritableFileBufferSize - pos_);
+    std::memcpy(buf_ + pos_, write_data, copy_size);
+    write_data += copy_size;
+    write_size -= copy_size;
+    pos_ += copy_size;
+    if (write_size == 0) { return Status::OK(); }
+
+    // Can't fit in buffer, so need to do at least one write.
+    Status status = FlushBuffer();
+    if (!status.ok()) { return status; }
+
+    // Small writes go to buffer, large writes are written directly.
+    if (write_size < kWritableFileBufferSize) {
+      std::memcpy(buf_, write_data, write_size);
+      pos_ = write_size;
+      return Status::OK();
+    }
+    return WriteUnbuffered(write_data, write_size);
+  }
+
+  Status Close() override {
+    Status status = FlushBuffer();
+    const int close_result = ::close(fd_);
+    if (close_result < 0 && status.ok()) {
+      status = PosixError(filename_, errno);
+    }
+    fd_ = -1;
+    return status;
+  }
+
+  Status Flush() override { return FlushBuffer(); }
+
+  Status Sync() override {
+    // Ensure new files referred to by the manifest are in the filesystem.
+    //
+    // This needs to happen before the manifest file is flushed to disk, to
+    // avoid crashing in a state where the manifest refers to files that are not
+    // yet on disk.
+    Status status = SyncDirIfManifest();
+    if (!status.ok()) { return status; }
+
+    status = FlushBuffer();
+    if (!status.ok()) { return status; }
+
+    return SyncFd(fd_, filename_, false);
+  }
+
+  Status Fsync() override {
+    Status status = SyncDirIfManifest();
+    if (!status.ok()) { return status; }
+
+    status = FlushBuffer();
+    if (!status.ok()) { return status; }
+
+    return SyncFd(fd_, filename_, true);
+  }
+
+  uint64_t GetFileSize() override { return filesize_; }
 
  private:
+  Status FlushBuffer() {
+    Status status = WriteUnbuffered(buf_, pos_);
+    pos_ = 0;
+    return status;
+  }
+
+  Status WriteUnbuffered(const char *data, size_t size) {
+    IOSTATS_TIMER_GUARD(write_nanos);
+    while (size > 0) {
+      ssize_t write_result = ::write(fd_, data, size);
+      if (write_result < 0) {
+        if (errno == EINTR) { continue; }  // Retry
+        return PosixError(filename_, errno);
+      }
+      IOSTATS_ADD(bytes_written, write_result);
+      data += write_result;
+      size -= write_result;
+    }
+    return Status::OK();
+  }
+
+  Status SyncDirIfManifest() {
+    Status status;
+    if (!is_manifest_) { return status; }
+
+    int fd = ::open(dirname_.c_str(), O_RDONLY | kOpenBaseFlags);
+    if (fd < 0) {
+      status = PosixError(dirname_, errno);
+    } else {
+      status = SyncFd(fd, dirname_, true);
+      ::close(fd);
+    }
+    return status;
+  }
+
+  // Ensures that all the caches associated with the given file descriptor's
+  // data are flushed all the way to durable media, and can withstand power
+  // failures.
+  //
+  // The path argument is only used to populate the description string in the
+  // returned Status if an error occurs.
+  static Status SyncFd(int fd, const std::string &fd_path, bool full) {
+    IOSTATS_TIMER_GUARD(fsync_nanos);
+#if defined(__linux__)
+    bool sync_success =
+        full ? (::fsync(fd) == 0) : (::fdatasync(fd) == 0);
+#else
+    (void)full;
+    bool sync_success = ::fsync(fd) == 0;
+#endif
+
+    if (sync_success) { return Status::OK(); }
+    return PosixError(fd_path, errno);
+  }
+
+  // Returns the directory name in a path pointing to a file.
+  //
+  // Returns "." if the path does not contain any directory separator.
+  static std::string Dirname(const std::string &filename) {
+    std::string::size_type separator_pos = filename.rfind('/');
+    if (separator_pos == std::string::npos) { return std::string("."); }
+    // The filename component should not contain a path separator. If it does,
+    // the splitting was done incorrectly.
+    assert(filename.find('/', separator_pos + 1) == std::string::npos);
+
+    return filename.substr(0, separator_pos);
+  }
+
+  // Extracts the file name from a path pointing to a file.
+  //
+  // The returned Slice points to |filename|'s data buffer, so it is only valid
+  // while |filename| is alive and unchanged.
+  static Slice Basename(const std::string &filename) {
+    std::string::size_type separator_pos = filename.rfind('/');
+    if (separator_pos == std::string::npos) { return Slice(filename); }
+    // The filename component should not contain a path separator. If it does,
+    // the splitting was done incorrectly.
+    assert(filename.find('/', separator_pos + 1) == std::string::npos);
+
+    return Slice(filename.data() + separator_pos + 1,
+                 filename.length() - separator_pos - 1);
+  }
+
+  // True if the given file is a manifest file.
+  static bool IsManifest(const std::string &filename) {
+    return Basename(filename).starts_with("MANIFEST");
+  }
+
   // buf_[0, pos_ - 1] contains data to be written to fd_.
   char buf_[kWritableFileBufferSize];
   size_t pos_;
@@ -35,6 +327,415 @@ class PosixWritableFile final : public WritableFile {
   const bool is_manifest_;  // True if the file's name starts with MANIFEST.
   const std::string filename_;
   const std::string dirname_;  // The directory of filename_.
+  uint64_t filesize_;
 };
 
-}  // namespace leveldb
\ No newline at end of file
+int LockOrUnlock(int fd, bool lock) {
+  errno = 0;
+  struct ::flock file_lock_info;
+  std::memset(&file_lock_info, 0, sizeof(file_lock_info));
+  file_lock_info.l_type = (lock ? F_WRLCK : F_UNLCK);
+  file_lock_info.l_whence = SEEK_SET;
+  file_lock_info.l_start = 0;
+  file_lock_info.l_len = 0;  // Lock/unlock entire file.
+  return ::fcntl(fd, F_SETLK, &file_lock_info);
+}
+
+// Instances are thread-safe because they are immutable.
+class PosixFileLock : public FileLock {
+ public:
+  PosixFileLock(int fd, std::string filename)
+      : fd_(fd), filename_(std::move(filename)) {}
+
+  int fd() const { return fd_; }
+  const std::string &filename() const { return filename_; }
+
+ private:
+  const int fd_;
+  const std::string filename_;
+};
+
+// Tracks the files locked by PosixEnv::LockFile().
+//
+// We maintain a separate set instead of relying on fcntl(F_SETLK) because
+// fcntl(F_SETLK) does not provide any protection against multiple uses from the
+// same process.
+//
+// Instances are thread-safe because all member data is guarded by a mutex.
+class PosixLockTable {
+ public:
+  bool Insert(const std::string &fname) {
+    std::lock_guard<std::mutex> l(mu_);
+    bool succeeded = locked_files_.insert(fname).second;
+    return succeeded;
+  }
+  void Remove(const std::string &fname) {
+    std::lock_guard<std::mutex> l(mu_);
+    locked_files_.erase(fname);
+  }
+
+ private:
+  std::mutex mu_;
+  std::set<std::string> locked_files_;
+};
+
+class PosixEnv : public Env {
+ public:
+  PosixEnv();
+  ~PosixEnv() override {
+    static const char msg[] =
+        "PosixEnv singleton destroyed. Unsupported behavior!\n";
+    std::fwrite(msg, 1, sizeof(msg), stderr);
+    std::abort();
+  }
+
+  Status NewSequentialFile(const std::string &filename,
+                           unique_ptr<SequentialFile> *result,
+                           const EnvOptions &options) override {
+    IOSTATS_TIMER_GUARD(open_nanos);
+    int fd = ::open(filename.c_str(), O_RDONLY | OpenFlags(options));
+    if (fd < 0) {
+      result->reset();
+      return PosixError(filename, errno);
+    }
+
+    result->reset(new PosixSequentialFile(filename, fd));
+    return Status::OK();
+  }
+
+  Status NewRandomAccessFile(const std::string &filename,
+                             unique_ptr<RandomAccessFile> *result,
+                             const EnvOptions &options) override {
+    IOSTATS_TIMER_GUARD(open_nanos);
+    result->reset();
+    int fd = ::open(filename.c_str(), O_RDONLY | OpenFlags(options));
+    if (fd < 0) { return PosixError(filename, errno); }
+
+    result->reset(new PosixRandomAccessFile(filename, fd));
+    return Status::OK();
+  }
+
+  Status NewWritableFile(const std::string &filename,
+                         unique_ptr<WritableFile> *result,
+                         const EnvOptions &options) override {
+    IOSTATS_TIMER_GUARD(open_nanos);
+    int fd = ::open(filename.c_str(),
+                    O_TRUNC | O_WRONLY | O_CREAT | OpenFlags(options), 0644);
+    if (fd < 0) {
+      result->reset();
+      return PosixError(filename, errno);
+    }
+
+    result->reset(new PosixWritableFile(filename, fd));
+    return Status::OK();
+  }
+
+  bool FileExists(const std::string &filename) override {
+    return ::access(filename.c_str(), F_OK) == 0;
+  }
+
+  Status GetChildren(const std::string &directory_path,
+                     std::vector<std::string> *result) override {
+    result->clear();
+    ::DIR *dir = ::opendir(directory_path.c_str());
+    if (dir == nullptr) { return PosixError(directory_path, errno); }
+    struct ::dirent *entry;
+    while ((entry = ::readdir(dir)) != nullptr) {
+      result->emplace_back(entry->d_name);
+    }
+    ::closedir(dir);
+    return Status::OK();
+  }
+
+  Status DeleteFile(const std::string &filename) override {
+    if (::unlink(filename.c_str()) != 0) {
+      return PosixError(filename, errno);
+    }
+    return Status::OK();
+  }
+
+  Status CreateDir(const std::string &dirname) override {
+    if (::mkdir(dirname.c_str(), 0755) != 0) {
+      return PosixError(dirname, errno);
+    }
+    return Status::OK();
+  }
+
+  Status CreateDirIfMissing(const std::string &dirname) override {
+    if (::mkdir(dirname.c_str(), 0755) != 0) {
+      if (errno != EEXIST) { return PosixError(dirname, errno); }
+      struct ::stat st;
+      if (::stat(dirname.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+        return Status::IOError(dirname, "exists but is not a directory");
+      }
+    }
+    return Status::OK();
+  }
+
+  Status DeleteDir(const std::string &dirname) override {
+    if (::rmdir(dirname.c_str()) != 0) { return PosixError(dirname, errno); }
+    return Status::OK();
+  }
+
+  Status GetFileSize(const std::string &filename, uint64_t *size) override {
+    struct ::stat file_stat;
+    if (::stat(filename.c_str(), &file_stat) != 0) {
+      *size = 0;
+      return PosixError(filename, errno);
+    }
+    *size = file_stat.st_size;
+    return Status::OK();
+  }
+
+  Status GetFileModificationTime(const std::string &filename,
+                                 uint64_t *file_mtime) override {
+    struct ::stat file_stat;
+    if (::stat(filename.c_str(), &file_stat) != 0) {
+      return PosixError(filename, errno);
+    }
+    *file_mtime = static_cast<uint64_t>(file_stat.st_mtime);
+    return Status::OK();
+  }
+
+  Status RenameFile(const std::string &from, const std::string &to) override {
+    if (std::rename(from.c_str(), to.c_str()) != 0) {
+      return PosixError(from, errno);
+    }
+    return Status::OK();
+  }
+
+  Status LockFile(const std::string &filename, FileLock **lock) override {
+    *lock = nullptr;
+
+    int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | kOpenBaseFlags, 0644);
+    if (fd < 0) { return PosixError(filename, errno); }
+
+    if (!locks_.Insert(filename)) {
+      ::close(fd);
+      return Status::IOError("lock " + filename, "already held by process");
+    }
+
+    if (LockOrUnlock(fd, true) == -1) {
+      int lock_errno = errno;
+      ::close(fd);
+      locks_.Remove(filename);
+      return PosixError("lock " + filename, lock_errno);
+    }
+
+    *lock = new PosixFileLock(fd, filename);
+    return Status::OK();
+  }
+
+  Status UnlockFile(FileLock *lock) override {
+    PosixFileLock *posix_file_lock = static_cast<PosixFileLock *>(lock);
+    if (LockOrUnlock(posix_file_lock->fd(), false) == -1) {
+      return PosixError("unlock " + posix_file_lock->filename(), errno);
+    }
+    locks_.Remove(posix_file_lock->filename());
+    ::close(posix_file_lock->fd());
+    delete posix_file_lock;
+    return Status::OK();
+  }
+
+  void Schedule(void (*background_work_function)(void *background_work_arg),
+                void *background_work_arg) override;
+
+  void StartThread(void (*thread_main)(void *thread_main_arg),
+                   void *thread_main_arg) override {
+    std::thread new_thread(thread_main, thread_main_arg);
+    new_thread.detach();
+  }
+
+  Status GetTestDirectory(std::string *result) override {
+    const char *env = std::getenv("TEST_TMPDIR");
+    if (env && env[0] != '\0') {
+      *result = env;
+    } else {
+      char buf[100];
+      std::snprintf(buf, sizeof(buf), "/tmp/leveldbtest-%d",
+                    static_cast<int>(::geteuid()));
+      *result = buf;
+    }
+
+    // The CreateDir status is ignored because the directory may already exist.
+    CreateDir(*result);
+
+    return Status::OK();
+  }
+
+  Status NewLogger(const std::string &filename,
+                   shared_ptr<Logger> *result) override {
+    int fd = ::open(filename.c_str(),
+                    O_APPEND | O_WRONLY | O_CREAT | kOpenBaseFlags, 0644);
+    if (fd < 0) {
+      result->reset();
+      return PosixError(filename, errno);
+    }
+
+    std::FILE *fp = ::fdopen(fd, "w");
+    if (fp == nullptr) {
+      ::close(fd);
+      result->reset();
+      return PosixError(filename, errno);
+    } else {
+      result->reset(new PosixLogger(fp));
+      return Status::OK();
+    }
+  }
+
+  uint64_t NowMicros() override {
+    static constexpr uint64_t kUsecondsPerSecond = 1000000;
+    struct ::timeval tv;
+    ::gettimeofday(&tv, nullptr);
+    return static_cast<uint64_t>(tv.tv_sec) * kUsecondsPerSecond + tv.tv_usec;
+  }
+
+  uint64_t NowNanos() override {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+  void SleepForMicroseconds(int micros) override {
+    std::this_thread::sleep_for(std::chrono::microseconds(micros));
+  }
+
+  Status GetHostName(char *name, uint64_t len) override {
+    int ret = gethostname(name, len);
+    if (ret < 0) {
+      if (errno == EFAULT || errno == EINVAL) {
+        return Status::InvalidArgument(strerror(errno));
+      } else {
+        return PosixError("GetHostName", errno);
+      }
+    }
+    return Status::OK();
+  }
+
+  Status GetCurrentTime(int64_t *unix_time) override {
+    time_t ret = time(nullptr);
+    if (ret == (time_t)-1) { return PosixError("GetCurrentTime", errno); }
+    *unix_time = static_cast<int64_t>(ret);
+    return Status::OK();
+  }
+
+  Status GetAbsolutePath(const std::string &db_path,
+                         std::string *output_path) override {
+    if (!db_path.empty() && db_path[0] == '/') {
+      *output_path = db_path;
+      return Status::OK();
+    }
+
+    char the_path[256];
+    char *ret = getcwd(the_path, 256);
+    if (ret == nullptr) { return PosixError("getcwd", errno); }
+
+    *output_path = ret;
+    output_path->append("/").append(db_path);
+    return Status::OK();
+  }
+
+  // Allow increasing the number of worker threads.
+  void SetBackgroundThreads(int num) override {
+    std::lock_guard<std::mutex> l(background_work_mutex_);
+    if (num > max_background_threads_) { max_background_threads_ = num; }
+    while (num_background_threads_ < max_background_threads_) {
+      num_background_threads_++;
+      std::thread background_thread(PosixEnv::BackgroundThreadEntryPoint,
+                                    this);
+      background_thread.detach();
+    }
+  }
+
+  std::string TimeToString(uint64_t secondsSince1970) override {
+    const time_t seconds = (time_t)secondsSince1970;
+    struct tm t;
+    int maxsize = 64;
+    std::string dummy;
+    dummy.reserve(maxsize);
+    dummy.resize(maxsize);
+    char *p = &dummy[0];
+    localtime_r(&seconds, &t);
+    snprintf(p, maxsize, "%04d/%02d/%02d-%02d:%02d:%02d ", t.tm_year + 1900,
+             t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+    dummy.resize(strlen(p));
+    return dummy;
+  }
+
+ private:
+  void BackgroundThreadMain();
+
+  static void BackgroundThreadEntryPoint(PosixEnv *env) {
+    env->BackgroundThreadMain();
+  }
+
+  // Stores the work item data in a Schedule() call.
+  //
+  // Instances are constructed on the thread calling Schedule() and used on the
+  // background thread.
+  //
+  // This structure is thread-safe because it is immutable.
+  struct BackgroundWorkItem {
+    explicit BackgroundWorkItem(void (*function)(void *arg), void *arg)
+        : function(function), arg(arg) {}
+
+    void (*const function)(void *);
+    void *const arg;
+  };
+
+  std::mutex background_work_mutex_;
+  std::condition_variable background_work_cv_;
+  int max_background_threads_;  // Guarded by background_work_mutex_
+  int num_background_threads_;  // Guarded by background_work_mutex_
+
+  // Guarded by background_work_mutex_
+  std::deque<BackgroundWorkItem> background_work_queue_;
+
+  PosixLockTable locks_;  // Thread-safe.
+};
+
+PosixEnv::PosixEnv() : max_background_threads_(1), num_background_threads_(0) {}
+
+void PosixEnv::Schedule(
+    void (*background_work_function)(void *background_work_arg),
+    void *background_work_arg) {
+  std::unique_lock<std::mutex> l(background_work_mutex_);
+
+  // Start the background threads, if necessary.
+  while (num_background_threads_ < max_background_threads_) {
+    num_background_threads_++;
+    std::thread background_thread(PosixEnv::BackgroundThreadEntryPoint, this);
+    background_thread.detach();
+  }
+
+  background_work_queue_.emplace_back(background_work_function,
+                                      background_work_arg);
+  background_work_cv_.notify_one();
+}
+
+void PosixEnv::BackgroundThreadMain() {
+  while (true) {
+    std::unique_lock<std::mutex> l(background_work_mutex_);
+
+    // Wait until there is work to be done.
+    background_work_cv_.wait(l,
+                             [this] { return !background_work_queue_.empty(); });
+
+    assert(!background_work_queue_.empty());
+    auto background_work_function = background_work_queue_.front().function;
+    void *background_work_arg = background_work_queue_.front().arg;
+    background_work_queue_.pop_front();
+
+    l.unlock();
+    background_work_function(background_work_arg);
+  }
+}
+
+Env *Env::Default() {
+  // The singleton is intentionally leaked; background threads may still be
+  // running when static destructors run.
+  static Env *default_env = new PosixEnv;
+  return default_env;
+}
+
+}  // namespace leveldb
@@ -6,6 +6,10 @@
 
 #include "coding.h"
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 namespace leveldb {
 
 uint32_t Hash(const char *data, size_t n, uint32_t seed) {
@@ -41,4 +45,300 @@ uint32_t Hash(const char *data, size_t n, uint32_t seed) {
   return h;
 }
 
-}  // namespace leveldb
\ No newline at end of file
+// Hash64() and Hash128() follow the structure of XXH3: separate code paths
+// for 0-3, 4-8, 9-16, 17-128, 129-240 bytes and longer inputs, each keyed
+// with a different part of a fixed 192-byte secret.
+
+namespace {
+
+const uint64_t kPrime32_1 = 0x9e3779b1u;
+const uint64_t kPrime64_1 = 0x9e3779b185ebca87ull;
+const uint64_t kPrime64_2 = 0xc2b2ae3d27d4eb4full;
+const uint64_t kPrime64_3 = 0x165667b19e3779f9ull;
+
+const size_t kSecretSize = 192;
+const size_t kStripeLen = 64;
+const size_t kSecretConsumeRate = 8;
+const size_t kStripesPerBlock = (kSecretSize - kStripeLen) / kSecretConsumeRate;
+const size_t kBlockLen = kStripeLen * kStripesPerBlock;
+const size_t kMidSizeMax = 240;
+
+// Little-endian bytes of a splitmix64 sequence
+struct Secret {
+  alignas(64) char bytes[kSecretSize];
+
+  constexpr Secret() : bytes() {
+    uint64_t state = 0x243f6a8885a308d3ull; // digits of pi
+    for (size_t i = 0; i < kSecretSize; i += 8) {
+      state += 0x9e3779b97f4a7c15ull;
+      uint64_t z = state;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      z ^= z >> 31;
+      for (size_t b = 0; b < 8; b++) {
+        bytes[i + b] = static_cast<char>(z >> (8 * b));
+      }
+    }
+  }
+};
+
+constexpr Secret kSecret;
+
+inline uint64_t Read64(const char *p) { return DecodeFixed64(p); }
+inline uint64_t Read32(const char *p) { return DecodeFixed32(p); }
+
+inline uint64_t Rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// Fold the 128-bit product of a and b
+inline uint64_t Mul128Fold64(uint64_t a, uint64_t b) {
+  const __uint128_t product = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(product) ^
+         static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t Avalanche(uint64_t h) {
+  h ^= h >> 37;
+  h *= 0x165667919e3779f9ull;
+  h ^= h >> 32;
+  return h;
+}
+
+inline uint64_t RRMXMX(uint64_t h, uint64_t len) {
+  h ^= Rotl64(h, 49) ^ Rotl64(h, 24);
+  h *= 0x9fb21c651e98df25ull;
+  h ^= (h >> 35) + len;
+  h *= 0x9fb21c651e98df25ull;
+  return h ^ (h >> 28);
+}
+
+inline uint64_t Mix16(const char *p, const char *secret, uint64_t seed) {
+  return Mul128Fold64(Read64(p) ^ (Read64(secret) + seed),
+                      Read64(p + 8) ^ (Read64(secret + 8) - seed));
+}
+
+uint64_t HashUpTo16(const char *p, size_t n, const char *secret,
+                    uint64_t seed) {
+  if (n > 8) {
+    const uint64_t flip1 = (Read64(secret + 24) ^ Read64(secret + 32)) + seed;
+    const uint64_t flip2 = (Read64(secret + 40) ^ Read64(secret + 48)) - seed;
+    const uint64_t lo = Read64(p) ^ flip1;
+    const uint64_t hi = Read64(p + n - 8) ^ flip2;
+    return Avalanche(n + __builtin_bswap64(lo) + hi + Mul128Fold64(lo, hi));
+  }
+  if (n >= 4) {
+    seed ^= static_cast<uint64_t>(
+                __builtin_bswap32(static_cast<uint32_t>(seed)))
+            << 32;
+    const uint64_t flip = (Read64(secret + 8) ^ Read64(secret + 16)) - seed;
+    const uint64_t input = Read32(p + n - 4) + (Read32(p) << 32);
+    return RRMXMX(input ^ flip, n);
+  }
+  if (n > 0) {
+    const uint64_t c1 = static_cast<unsigned char>(p[0]);
+    const uint64_t c2 = static_cast<unsigned char>(p[n >> 1]);
+    const uint64_t c3 = static_cast<unsigned char>(p[n - 1]);
+    const uint64_t combined = (c1 << 16) | (c2 << 24) | c3 | (n << 8);
+    const uint64_t flip = (Read32(secret) ^ Read32(secret + 4)) + seed;
+    return Avalanche((combined ^ flip) * kPrime64_1);
+  }
+  return Avalanche(seed ^ Read64(secret + 56) ^ Read64(secret + 64));
+}
+
+uint64_t HashUpTo128(const char *p, size_t n, const char *secret,
+                     uint64_t seed) {
+  uint64_t acc = n * kPrime64_1;
+  if (n > 32) {
+    if (n > 64) {
+      if (n > 96) {
+        acc += Mix16(p + 48, secret + 96, seed);
+        acc += Mix16(p + n - 64, secret + 112, seed);
+      }
+      acc += Mix16(p + 32, secret + 64, seed);
+      acc += Mix16(p + n - 48, secret + 80, seed);
+    }
+    acc += Mix16(p + 16, secret + 32, seed);
+    acc += Mix16(p + n - 32, secret + 48, seed);
+  }
+  acc += Mix16(p, secret, seed);
+  acc += Mix16(p + n - 16, secret + 16, seed);
+  return Avalanche(acc);
+}
+
+uint64_t HashUpTo240(const char *p, size_t n, const char *secret,
+                     uint64_t seed) {
+  uint64_t acc = n * kPrime64_1;
+  for (size_t i = 0; i < 8; i++) {
+    acc += Mix16(p + 16 * i, secret + 16 * i, seed);
+  }
+  acc = Avalanche(acc);
+  for (size_t i = 8; i < n / 16; i++) {
+    acc += Mix16(p + 16 * i, secret + 16 * (i - 8) + 3, seed);
+  }
+  acc += Mix16(p + n - 16, secret + kSecretSize - 17, seed);
+  return Avalanche(acc);
+}
+
+uint64_t HashShort(const char *p, size_t n, uint64_t seed) {
+  if (n <= 16) { return HashUpTo16(p, n, kSecret.bytes, seed); }
+  if (n <= 128) { return HashUpTo128(p, n, kSecret.bytes, seed); }
+  return HashUpTo240(p, n, kSecret.bytes, seed);
+}
+
+// Long inputs: every 64-byte stripe is added into eight 64-bit
+// accumulators, keyed by a window of the secret that slides 8 bytes per
+// stripe; after each block of 16 stripes the accumulators are scrambled.
+void InitAccumulators(uint64_t seed, uint64_t acc[8]) {
+  static const uint64_t kInit[8] = {
+      0xc2b2ae3du,          kPrime64_1, kPrime64_2, kPrime64_3,
+      0x85ebca77c2b2ae63ull, 0x85ebca77u, 0x27d4eb2f165667c5ull, kPrime32_1};
+  for (int i = 0; i < 8; i++) {
+    acc[i] = kInit[i] + (i % 2 == 0 ? seed : -seed);
+  }
+}
+
+void Accumulate512Scalar(uint64_t acc[8], const char *p, const char *secret) {
+  for (int i = 0; i < 8; i++) {
+    const uint64_t data = Read64(p + 8 * i);
+    const uint64_t key = data ^ Read64(secret + 8 * i);
+    acc[i ^ 1] += data;
+    acc[i] += (key & 0xffffffffu) * (key >> 32);
+  }
+}
+
+void ScrambleScalar(uint64_t acc[8], const char *secret) {
+  for (int i = 0; i < 8; i++) {
+    uint64_t a = acc[i];
+    a ^= a >> 47;
+    a ^= Read64(secret + 8 * i);
+    acc[i] = a * kPrime32_1;
+  }
+}
+
+void HashLongScalar(const char *p, size_t n, uint64_t acc[8]) {
+  const char *secret = kSecret.bytes;
+  const size_t num_blocks = (n - 1) / kBlockLen;
+  for (size_t b = 0; b < num_blocks; b++) {
+    for (size_t s = 0; s < kStripesPerBlock; s++) {
+      Accumulate512Scalar(acc, p + b * kBlockLen + s * kStripeLen,
+                          secret + s * kSecretConsumeRate);
+    }
+    ScrambleScalar(acc, secret + kSecretSize - kStripeLen);
+  }
+  const size_t num_stripes = ((n - 1) - num_blocks * kBlockLen) / kStripeLen;
+  for (size_t s = 0; s < num_stripes; s++) {
+    Accumulate512Scalar(acc, p + num_blocks * kBlockLen + s * kStripeLen,
+                        secret + s * kSecretConsumeRate);
+  }
+  // Last stripe, overlapping the previous one if n is not a multiple of 64
+  Accumulate512Scalar(acc, p + n - kStripeLen,
+                      secret + kSecretSize - kStripeLen - 7);
+}
+
+#if defined(__x86_64__)
+
+// Same computation as the scalar loop, four accumulators per register.
+__attribute__((target("avx2"))) inline void
+Accumulate512AVX2(__m256i acc[2], const char *p, const char *secret) {
+  for (int i = 0; i < 2; i++) {
+    const __m256i data =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p) + i);
+    const __m256i secret_words =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(secret) + i);
+    const __m256i key = _mm256_xor_si256(data, secret_words);
+    const __m256i product =
+        _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32));
+    // acc[i ^ 1] += data[i]: swap the 64-bit halves of each 128-bit lane
+    const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    acc[i] = _mm256_add_epi64(acc[i], _mm256_add_epi64(product, swapped));
+  }
+}
+
+__attribute__((target("avx2"))) inline void ScrambleAVX2(__m256i acc[2],
+                                                        const char *secret) {
+  const __m256i prime = _mm256_set1_epi32(static_cast<int>(kPrime32_1));
+  for (int i = 0; i < 2; i++) {
+    __m256i a = acc[i];
+    a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+    a = _mm256_xor_si256(
+        a, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(secret) + i));
+    // 64x32-bit multiply from two 32x32->64 products
+    const __m256i lo = _mm256_mul_epu32(a, prime);
+    const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+    acc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+  }
+}
+
+__attribute__((target("avx2"))) void HashLongAVX2(const char *p, size_t n,
+                                                  uint64_t acc_out[8]) {
+  const char *secret = kSecret.bytes;
+  __m256i acc[2] = {
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc_out)),
+      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(acc_out) + 1)};
+  const size_t num_blocks = (n - 1) / kBlockLen;
+  for (size_t b = 0; b < num_blocks; b++) {
+    for (size_t s = 0; s < kStripesPerBlock; s++) {
+      Accumulate512AVX2(acc, p + b * kBlockLen + s * kStripeLen,
+                        secret + s * kSecretConsumeRate);
+    }
+    ScrambleAVX2(acc, secret + kSecretSize - kStripeLen);
+  }
+  const size_t num_stripes = ((n - 1) - num_blocks * kBlockLen) / kStripeLen;
+  for (size_t s = 0; s < num_stripes; s++) {
+    Accumulate512AVX2(acc, p + num_blocks * kBlockLen + s * kStripeLen,
+                      secret + s * kSecretConsumeRate);
+  }
+  Accumulate512AVX2(acc, p + n - kStripeLen,
+                    secret + kSecretSize - kStripeLen - 7);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc_out), acc[0]);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(acc_out) + 1, acc[1]);
+}
+
+#endif
+
+void HashLong(const char *p, size_t n, uint64_t seed, uint64_t acc[8]) {
+  InitAccumulators(seed, acc);
+#if defined(__x86_64__)
+  static const bool use_avx2 = __builtin_cpu_supports("avx2");
+  if (use_avx2) {
+    HashLongAVX2(p, n, acc);
+    return;
+  }
+#endif
+  HashLongScalar(p, n, acc);
+}
+
+uint64_t MergeAccumulators(const uint64_t acc[8], const char *secret,
+                           uint64_t start) {
+  uint64_t result = start;
+  for (int i = 0; i < 4; i++) {
+    result += Mul128Fold64(acc[2 * i] ^ Read64(secret + 16 * i),
+                           acc[2 * i + 1] ^ Read64(secret + 16 * i + 8));
+  }
+  return Avalanche(result);
+}
+
+} // namespace
+
+uint64_t Hash64(const char *data, size_t n, uint64_t seed) {
+  if (n <= kMidSizeMax) { return HashShort(data, n, seed); }
+  uint64_t acc[8];
+  HashLong(data, n, seed, acc);
+  return MergeAccumulators(acc, kSecret.bytes + 11, n * kPrime64_1);
+}
+
+void Hash128(const char *data, size_t n, uint64_t seed, uint64_t *low,
+             uint64_t *high) {
+  if (n <= kMidSizeMax) {
+    // Two independently seeded passes; short inputs are cheap to re-read
+    *low = HashShort(data, n, seed ^ kPrime64_2);
+    *high = HashShort(data, n, seed ^ kPrime64_3);
+    return;
+  }
+  uint64_t acc[8];
+  HashLong(data, n, seed, acc);
+  *low = MergeAccumulators(acc, kSecret.bytes + 11, n * kPrime64_1);
+  *high = MergeAccumulators(acc, kSecret.bytes + kSecretSize - kStripeLen - 11,
+                            ~(n * kPrime64_2));
+}
+
+}  // namespace leveldb
@@ -8,5 +8,22 @@
 #include <cstdint>
 
 namespace leveldb {
+
+// 32-bit murmur-like hash.  Its values are stored in existing files (bloom
+// filters), so it must never change.
 uint32_t Hash(const char *data, size_t n, uint32_t seed);
-}
\ No newline at end of file
+
+// 64-bit hash in the XXH3 family: a multiply-fold of 16-byte chunks for
+// keys up to 240 bytes and 64-byte stripes over eight accumulators beyond
+// that, vectorized with AVX2 when the CPU has it.  Much faster than Hash()
+// on keys of more than a few bytes.  Values do not depend on the CPU, and
+// are stored in existing files (64-bit bloom filters), so it must never
+// change either.
+uint64_t Hash64(const char *data, size_t n, uint64_t seed);
+
+// 128-bit variant of Hash64() for when 64 bits of entropy are not enough.
+// *low is not necessarily equal to Hash64() of the same input.
+void Hash128(const char *data, size_t n, uint64_t seed, uint64_t *low,
+             uint64_t *high);
+
+} // namespace leveldb
@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "leveldb/statistics.h"
+
+namespace leveldb {
+
+// Maps a value to one of a fixed set of exponentially growing buckets.
+// Bucket limits start at 1, 2 and then grow by ~1.5x (rounded to two
+// significant digits) up to the max uint64_t, which gives 109
+// buckets with a relative error below 50% for any recorded value.
+class HistogramBucketMapper {
+ public:
+  HistogramBucketMapper();
+
+  // Number of buckets required.
+  size_t BucketCount() const { return bucket_values_.size(); }
+
+  uint64_t LastValue() const { return max_bucket_value_; }
+  uint64_t FirstValue() const { return min_bucket_value_; }
+
+  // Upper limit (inclusive) of values that fall into "bucket_number".
+  uint64_t BucketLimit(size_t bucket_number) const {
+    assert(bucket_number < BucketCount());
+    return bucket_values_[bucket_number];
+  }
+
+  // Returns the index of the bucket that "value" falls into.
+  size_t IndexForValue(uint64_t value) const;
+
+ private:
+  std::vector<uint64_t> bucket_values_;
+  uint64_t max_bucket_value_;
+  uint64_t min_bucket_value_;
+};
+
+// The bucket layout shared by every histogram.
+const HistogramBucketMapper &GetHistogramBucketMapper();
+
+// Raw histogram state.  Add() only uses relaxed atomic loads and stores, so
+// it never takes a lock; when several threads record into the same
+// HistogramStat some samples may be lost, which is why StatisticsImpl keeps
+// one HistogramStat per core.  Readers may run concurrently with writers and
+// see a slightly inconsistent but never torn view.
+struct HistogramStat {
+  HistogramStat();
+
+  // No copying allowed
+  HistogramStat(const HistogramStat &) = delete;
+  void operator=(const HistogramStat &) = delete;
+
+  void Clear();
+  bool Empty() const { return num() == 0; }
+  void Add(uint64_t value);
+  // Folds the content of "other" into this histogram.
+  void Merge(const HistogramStat &other);
+
+  uint64_t min() const { return min_.load(std::memory_order_relaxed); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  uint64_t num() const { return num_.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  uint64_t sum_squares() const {
+    return sum_squares_.load(std::memory_order_relaxed);
+  }
+  uint64_t bucket_at(size_t b) const {
+    return buckets_[b].load(std::memory_order_relaxed);
+  }
+
+  double Median() const { return Percentile(50.0); }
+  double Percentile(double p) const;
+  double Average() const;
+  double StandardDeviation() const;
+  void Data(HistogramData *const data) const;
+  std::string ToString() const;
+
+  // 109 buckets are needed to cover the uint64_t range with a 1.5x step.
+  enum { kMaxBuckets = 109 };
+
+  std::atomic_uint_fast64_t min_;
+  std::atomic_uint_fast64_t max_;
+  std::atomic_uint_fast64_t num_;
+  std::atomic_uint_fast64_t sum_;
+  std::atomic_uint_fast64_t sum_squares_;
+  std::atomic_uint_fast64_t buckets_[kMaxBuckets];
+  const uint64_t num_buckets_;
+};
+
+// A standalone Histogram backed by a single HistogramStat.
+class HistogramImpl : public Histogram {
+ public:
+  HistogramImpl() { Clear(); }
+
+  // No copying allowed
+  HistogramImpl(const HistogramImpl &) = delete;
+  void operator=(const HistogramImpl &) = delete;
+
+  void Clear() override { stats_.Clear(); }
+  void Add(uint64_t value) override { stats_.Add(value); }
+  void Merge(const HistogramImpl &other) { stats_.Merge(other.stats_); }
+  void Merge(const HistogramStat &other) { stats_.Merge(other); }
+
+  std::string ToString() const override { return stats_.ToString(); }
+
+  double Median() const override { return stats_.Median(); }
+  double Percentile(double p) const override { return stats_.Percentile(p); }
+  double Average() const override { return stats_.Average(); }
+  double StandardDeviation() const override {
+    return stats_.StandardDeviation();
+  }
+  void Data(HistogramData *const data) const override { stats_.Data(data); }
+
+  uint64_t Count() const { return stats_.num(); }
+
+ private:
+  HistogramStat stats_;
+};
+
+}  // namespace leveldb
@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cstring>
+#include <sstream>
+
+#include "util/iostats_context_imp.h"
+
+namespace leveldb {
+
+thread_local IOStatsContext iostats_context;
+
+IOStatsContext *get_iostats_context() { return &iostats_context; }
+
+void IOStatsContext::Reset() {
+  // Every member is a plain counter.
+  memset(this, 0, sizeof(*this));
+}
+
+#define IOSTATS_CONTEXT_OUTPUT(counter)          \
+  if (!exclude_zero_counters || counter > 0) {   \
+    ss << #counter << " = " << counter << ", ";  \
+  }
+
+std::string IOStatsContext::ToString(bool exclude_zero_counters) const {
+  std::ostringstream ss;
+  IOSTATS_CONTEXT_OUTPUT(thread_pool_id);
+  IOSTATS_CONTEXT_OUTPUT(bytes_read);
+  IOSTATS_CONTEXT_OUTPUT(bytes_written);
+  IOSTATS_CONTEXT_OUTPUT(open_nanos);
+  IOSTATS_CONTEXT_OUTPUT(allocate_nanos);
+  IOSTATS_CONTEXT_OUTPUT(write_nanos);
+  IOSTATS_CONTEXT_OUTPUT(read_nanos);
+  IOSTATS_CONTEXT_OUTPUT(range_sync_nanos);
+  IOSTATS_CONTEXT_OUTPUT(fsync_nanos);
+  IOSTATS_CONTEXT_OUTPUT(prepare_write_nanos);
+  IOSTATS_CONTEXT_OUTPUT(logger_nanos);
+  std::string str = ss.str();
+  // Drop the trailing ", "
+  if (str.size() >= 2) str.erase(str.size() - 2);
+  return str;
+}
+
+#undef IOSTATS_CONTEXT_OUTPUT
+
+}  // namespace leveldb
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "leveldb/iostats_context.h"
+#include "util/perf_step_timer.h"
+
+namespace leveldb {
+
+extern thread_local IOStatsContext iostats_context;
+
+}  // namespace leveldb
+
+#if defined(NIOSTATS_CONTEXT)
+
+#define IOSTATS_ADD(metric, value)
+#define IOSTATS_RESET(metric)
+#define IOSTATS(metric) 0
+#define IOSTATS_TIMER_GUARD(metric)
+
+#else
+
+// increment a specific counter by the specified value
+#define IOSTATS_ADD(metric, value) (iostats_context.metric += value)
+
+// reset a specific counter to zero
+#define IOSTATS_RESET(metric) (iostats_context.metric = 0)
+
+#define IOSTATS(metric) (iostats_context.metric)
+
+// Declare and set start time of the timer
+#define IOSTATS_TIMER_GUARD(metric)                                   \
+  PerfStepTimer iostats_step_timer_##metric(&(iostats_context.metric)); \
+  iostats_step_timer_##metric.Start();
+
+#endif
@@ -0,0 +1,180 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/options.h"
+
+#include <cinttypes>
+#include <limits>
+
+#include "comparator.h"
+#include "leveldb/env.h"
+
+namespace leveldb {
+
+Options::Options()
+    : comparator(BytewiseComparator()),
+      merge_operator(nullptr),
+      compaction_filter(nullptr),
+      create_if_missing(false),
+      error_if_exists(false),
+      paranoid_checks(false),
+      env(Env::Default()),
+      info_log(nullptr),
+      write_buffer_size(4 << 20),
+      max_write_buffer_number(2),
+      min_write_buffer_number_to_merge(1),
+      write_buffer_manager(nullptr),
+      db_write_buffer_size(0),
+      max_open_files(1000),
+      max_file_opening_threads(0),
+      defer_table_index_loading(false),
+      pin_l0_filter_and_index_blocks(false),
+      block_cache(nullptr),
+      block_cache_compressed(nullptr),
+      row_cache(nullptr),
+      block_size(4096),
+      block_restart_interval(16),
+      compression(kSnappyCompression),
+      filter_policy(nullptr),
+      num_levels(7),
+      level0_file_num_compaction_trigger(4),
+      level0_slowdown_writes_trigger(8),
+      level0_stop_writes_trigger(12),
+      soft_pending_compaction_bytes_limit(64ull << 30),
+      hard_pending_compaction_bytes_limit(256ull << 30),
+      delayed_write_rate(16 << 20),
+      max_mem_compaction_level(2),
+      target_file_size_base(2 * 1048576),
+      target_file_size_multiplier(1),
+      max_bytes_for_level_base(10 * 1048576),
+      max_bytes_for_level_multiplier(10),
+      max_bytes_for_level_multiplier_additional(num_levels, 1),
+      expanded_compaction_factor(25),
+      source_compaction_factor(1),
+      max_grandparent_overlap_factor(10),
+      statistics(nullptr),
+      disableDataSync(false),
+      use_fsync(false),
+      db_stats_log_interval(1800),
+      db_log_dir(""),
+      disable_seek_compaction(false),
+      delete_obsolete_files_period_micros(0),
+      max_background_compactions(1),
+      max_log_file_size(0),
+      log_file_time_to_roll(0),
+      keep_log_file_num(1000),
+      rate_limit(0.0),
+      rate_limit_delay_milliseconds(1000),
+      max_manifest_file_size(std::numeric_limits<uint64_t>::max()),
+      no_block_cache(false),
+      table_cache_numshardbits(4),
+      disable_auto_compactions(false),
+      WAL_ttl_seconds(0),
+      manifest_preallocation_size(4 * 1024 * 1024),
+      purge_redundant_kvs_while_flush(true),
+      allow_os_buffer(true),
+      allow_readahead(true),
+      allow_readahead_compactions(true),
+      allow_mmap_reads(false),
+      allow_mmap_writes(true),
+      is_fd_close_on_exec(true),
+      skip_log_error_on_recovery(false),
+      wal_recovery_threads(4),
+      stats_dump_period_sec(3600),
+      block_size_deviation(10),
+      advise_random_on_open(true),
+      access_hint_on_compaction_start(NORMAL),
+      use_adaptive_mutex(false),
+      bytes_per_sync(0),
+      enable_pipelined_write(false),
+      unordered_write(false),
+      manual_wal_flush(false) {}
+
+void Options::Dump(Logger *log) const {
+  Log(log, "            Options.comparator: %s", comparator->Name());
+  Log(log, "     Options.create_if_missing: %d", create_if_missing);
+  Log(log, "       Options.error_if_exists: %d", error_if_exists);
+  Log(log, "       Options.paranoid_checks: %d", paranoid_checks);
+  Log(log, "                   Options.env: %p", env);
+  Log(log, "              Options.info_log: %p", info_log.get());
+  Log(log, "     Options.write_buffer_size: %zd", write_buffer_size);
+  Log(log, " Options.max_write_buffer_number: %d", max_write_buffer_number);
+  Log(log, "  Options.write_buffer_manager: %p", write_buffer_manager.get());
+  Log(log, "  Options.db_write_buffer_size: %zd", db_write_buffer_size);
+  Log(log, "        Options.max_open_files: %d", max_open_files);
+  Log(log, "Options.max_file_opening_threads: %d", max_file_opening_threads);
+  Log(log, "Options.defer_table_index_loading: %d", defer_table_index_loading);
+  Log(log, "Options.pin_l0_filter_and_index_blocks: %d",
+      pin_l0_filter_and_index_blocks);
+  Log(log, "           Options.block_cache: %p", block_cache.get());
+  Log(log, "Options.block_cache_compressed: %p", block_cache_compressed.get());
+  Log(log, "             Options.row_cache: %p", row_cache.get());
+  Log(log, "            Options.block_size: %zd", block_size);
+  Log(log, "Options.block_restart_interval: %d", block_restart_interval);
+  Log(log, "           Options.compression: %d", compression);
+  Log(log, "         Options.filter_policy: %p", filter_policy);
+  Log(log, "            Options.num_levels: %d", num_levels);
+  Log(log, "   Options.disableDataSync: %d", disableDataSync);
+  Log(log, "         Options.use_fsync: %d", use_fsync);
+  Log(log, "Options.level0_file_num_compaction_trigger: %d",
+      level0_file_num_compaction_trigger);
+  Log(log, "   Options.level0_slowdown_writes_trigger: %d",
+      level0_slowdown_writes_trigger);
+  Log(log, "       Options.level0_stop_writes_trigger: %d",
+      level0_stop_writes_trigger);
+  Log(log, "Options.soft_pending_compaction_bytes_limit: %" PRIu64,
+      soft_pending_compaction_bytes_limit);
+  Log(log, "Options.hard_pending_compaction_bytes_limit: %" PRIu64,
+      hard_pending_compaction_bytes_limit);
+  Log(log, "               Options.delayed_write_rate: %" PRIu64,
+      delayed_write_rate);
+  Log(log, "         Options.max_mem_compaction_level: %d",
+      max_mem_compaction_level);
+  Log(log, "            Options.target_file_size_base: %d",
+      target_file_size_base);
+  Log(log, "      Options.target_file_size_multiplier: %d",
+      target_file_size_multiplier);
+  Log(log, "         Options.max_bytes_for_level_base: %" PRIu64,
+      max_bytes_for_level_base);
+  Log(log, "   Options.max_bytes_for_level_multiplier: %d",
+      max_bytes_for_level_multiplier);
+  Log(log, "       Options.max_background_compactions: %d",
+      max_background_compactions);
+  Log(log, "            Options.stats_dump_period_sec: %u",
+      stats_dump_period_sec);
+  Log(log, "            Options.db_stats_log_interval: %d",
+      db_stats_log_interval);
+  Log(log, "         Options.disable_auto_compactions: %d",
+      disable_auto_compactions);
+  Log(log, "               Options.use_adaptive_mutex: %d", use_adaptive_mutex);
+  Log(log, "           Options.enable_pipelined_write: %d",
+      enable_pipelined_write);
+  Log(log, "                  Options.unordered_write: %d", unordered_write);
+  Log(log, "                 Options.manual_wal_flush: %d", manual_wal_flush);
+  Log(log, "             Options.wal_recovery_threads: %d",
+      wal_recovery_threads);
+}
+
+Options *Options::PrepareForBulkLoad() {
+  // never slowdown ingest.
+  level0_file_num_compaction_trigger = (1 << 30);
+  level0_slowdown_writes_trigger = (1 << 30);
+  level0_stop_writes_trigger = (1 << 30);
+  soft_pending_compaction_bytes_limit = 0;
+  hard_pending_compaction_bytes_limit = 0;
+
+  // no auto compactions please. The application should issue a
+  // manual compaction after all data is loaded into L0.
+  disable_auto_compactions = true;
+  disable_seek_compaction = true;
+  disableDataSync = true;
+
+  // A manual compaction run should pick all files in L0 in
+  // a single compaction run.
+  source_compaction_factor = (1 << 30);
+
+  return this;
+}
+
+}  // namespace leveldb
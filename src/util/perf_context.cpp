@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cinttypes>
+#include <cstring>
+#include <sstream>
+
+#include "util/perf_context_imp.h"
+
+namespace leveldb {
+
+thread_local PerfLevel perf_level = kDisable;
+thread_local PerfContext perf_context;
+
+void SetPerfLevel(PerfLevel level) {
+  assert(level > kUninitialized);
+  assert(level < kOutOfBounds);
+  perf_level = level;
+}
+
+PerfLevel GetPerfLevel() { return perf_level; }
+
+PerfContext *get_perf_context() { return &perf_context; }
+
+void PerfContext::Reset() {
+  // Every member is a plain counter.
+  memset(this, 0, sizeof(*this));
+}
+
+#define PERF_CONTEXT_OUTPUT(counter)             \
+  if (!exclude_zero_counters || (counter > 0)) { \
+    ss << #counter << " = " << counter << ", ";  \
+  }
+
+std::string PerfContext::ToString(bool exclude_zero_counters) const {
+  std::ostringstream ss;
+  PERF_CONTEXT_OUTPUT(user_key_comparison_count);
+  PERF_CONTEXT_OUTPUT(block_cache_hit_count);
+  PERF_CONTEXT_OUTPUT(block_read_count);
+  PERF_CONTEXT_OUTPUT(block_read_byte);
+  PERF_CONTEXT_OUTPUT(block_read_time);
+  PERF_CONTEXT_OUTPUT(block_checksum_time);
+  PERF_CONTEXT_OUTPUT(block_decompress_time);
+  PERF_CONTEXT_OUTPUT(internal_key_skipped_count);
+  PERF_CONTEXT_OUTPUT(internal_delete_skipped_count);
+  PERF_CONTEXT_OUTPUT(get_snapshot_time);
+  PERF_CONTEXT_OUTPUT(get_from_memtable_time);
+  PERF_CONTEXT_OUTPUT(get_from_memtable_count);
+  PERF_CONTEXT_OUTPUT(get_post_process_time);
+  PERF_CONTEXT_OUTPUT(get_from_output_files_time);
+  PERF_CONTEXT_OUTPUT(seek_on_memtable_time);
+  PERF_CONTEXT_OUTPUT(seek_on_memtable_count);
+  PERF_CONTEXT_OUTPUT(next_on_memtable_count);
+  PERF_CONTEXT_OUTPUT(seek_child_seek_time);
+  PERF_CONTEXT_OUTPUT(seek_child_seek_count);
+  PERF_CONTEXT_OUTPUT(seek_min_heap_time);
+  PERF_CONTEXT_OUTPUT(seek_internal_seek_time);
+  PERF_CONTEXT_OUTPUT(find_next_user_entry_time);
+  PERF_CONTEXT_OUTPUT(write_wal_time);
+  PERF_CONTEXT_OUTPUT(write_memtable_time);
+  PERF_CONTEXT_OUTPUT(write_delay_time);
+  PERF_CONTEXT_OUTPUT(write_pre_and_post_process_time);
+  PERF_CONTEXT_OUTPUT(db_mutex_lock_nanos);
+  PERF_CONTEXT_OUTPUT(bloom_memtable_hit_count);
+  PERF_CONTEXT_OUTPUT(bloom_memtable_miss_count);
+  PERF_CONTEXT_OUTPUT(bloom_sst_hit_count);
+  PERF_CONTEXT_OUTPUT(bloom_sst_miss_count);
+  std::string str = ss.str();
+  // Drop the trailing ", "
+  if (str.size() >= 2) str.erase(str.size() - 2);
+  return str;
+}
+
+#undef PERF_CONTEXT_OUTPUT
+
+}  // namespace leveldb
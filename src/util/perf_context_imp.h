@@ -0,0 +1,46 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "leveldb/perf_context.h"
+#include "util/perf_step_timer.h"
+
+namespace leveldb {
+
+extern thread_local PerfContext perf_context;
+
+}  // namespace leveldb
+
+#if defined(NPERF_CONTEXT)
+
+#define PERF_TIMER_GUARD(metric)
+#define PERF_TIMER_MEASURE(metric)
+#define PERF_TIMER_STOP(metric)
+#define PERF_TIMER_START(metric)
+#define PERF_COUNTER_ADD(metric, value)
+
+#else
+
+// Stop the timer and update the metric
+#define PERF_TIMER_STOP(metric) perf_step_timer_##metric.Stop();
+
+#define PERF_TIMER_START(metric) perf_step_timer_##metric.Start();
+
+// Declare and set start time of the timer
+#define PERF_TIMER_GUARD(metric)                                  \
+  PerfStepTimer perf_step_timer_##metric(&(perf_context.metric)); \
+  perf_step_timer_##metric.Start();
+
+// Update metric with time elapsed since last START. start time is reset
+// to current timestamp.
+#define PERF_TIMER_MEASURE(metric) perf_step_timer_##metric.Measure();
+
+// Increase metric value
+#define PERF_COUNTER_ADD(metric, value)     \
+  if (perf_level >= PerfLevel::kEnableCount) { \
+    perf_context.metric += value;           \
+  }
+
+#endif
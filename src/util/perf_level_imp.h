@@ -0,0 +1,13 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "leveldb/perf_context.h"
+
+namespace leveldb {
+
+extern thread_local PerfLevel perf_level;
+
+}  // namespace leveldb
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "leveldb/env.h"
+#include "util/perf_level_imp.h"
+
+namespace leveldb {
+
+// Adds the nanoseconds between Start() and Stop() (or destruction) to
+// *metric, but only if the calling thread's perf level is at least
+// "enable_level" when the timer is constructed.  When disabled no clock is
+// read at all.
+class PerfStepTimer {
+ public:
+  explicit PerfStepTimer(uint64_t *metric,
+                         PerfLevel enable_level = PerfLevel::kEnableTime)
+      : perf_counter_enabled_(perf_level >= enable_level),
+        env_(perf_counter_enabled_ ? Env::Default() : nullptr),
+        start_(0),
+        metric_(metric) {}
+
+  ~PerfStepTimer() { Stop(); }
+
+  // No copying allowed
+  PerfStepTimer(const PerfStepTimer &) = delete;
+  void operator=(const PerfStepTimer &) = delete;
+
+  void Start() {
+    if (perf_counter_enabled_) { start_ = env_->NowNanos(); }
+  }
+
+  // Adds the time elapsed so far and restarts the measurement.
+  void Measure() {
+    if (start_) {
+      uint64_t now = env_->NowNanos();
+      *metric_ += now - start_;
+      start_ = now;
+    }
+  }
+
+  void Stop() {
+    if (start_) {
+      *metric_ += env_->NowNanos() - start_;
+      start_ = 0;
+    }
+  }
+
+ private:
+  const bool perf_counter_enabled_;
+  Env *const env_;
+  uint64_t start_;
+  uint64_t *metric_;
+};
+
+}  // namespace leveldb
@@ -0,0 +1,313 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "leveldb/secondary_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace leveldb {
+
+SecondaryCache::~SecondaryCache() {}
+
+namespace {
+
+// The log is split into segments of up to this size, and into at least
+// kMinSegments, so that dropping the oldest one gives up a small share of
+// the cache.  A segment is filled in memory and written out in one go by
+// the writer thread, so that inserts never wait for the disk.
+constexpr size_t kMaxSegmentSize = 4 << 20;
+constexpr size_t kMinSegments = 4;
+
+// Every value is followed by the Hash64() of its bytes, which unlike a crc
+// costs little next to the copy.  The files never outlive the process, so
+// they do not depend on the hash staying the same across versions.
+constexpr size_t kTrailerSize = 8;
+
+class LogStructuredSecondaryCache : public SecondaryCache {
+public:
+  LogStructuredSecondaryCache(Env *env, const std::string &path,
+                              size_t capacity)
+      : env_(env),
+        path_(path),
+        segment_size_(std::min(kMaxSegmentSize, capacity / kMinSegments)),
+        max_segments_(segment_size_ > 0 ? capacity / segment_size_ : 0),
+        next_segment_number_(0),
+        shutting_down_(false),
+        writer_running_(false),
+        write_errors_(0) {}
+
+  ~LogStructuredSecondaryCache() override {
+    {
+      // Segments still waiting for the writer are dropped with the rest
+      std::unique_lock<std::mutex> l(mutex_);
+      shutting_down_ = true;
+      writer_cv_.notify_all();
+      while (writer_running_) { writer_cv_.wait(l); }
+    }
+    for (const std::shared_ptr<Segment> &segment : segments_) {
+      if (segment->file != nullptr) {
+        env_->DeleteFile(SegmentFileName(segment->number));
+      }
+    }
+  }
+
+  // Clears out the files of an earlier instance; their index is gone.
+  Status Open() {
+    Status s = env_->CreateDirIfMissing(path_);
+    if (!s.ok()) { return s; }
+    std::vector<std::string> children;
+    s = env_->GetChildren(path_, &children);
+    if (!s.ok()) { return s; }
+    const size_t suffix_size = std::strlen(kSuffix);
+    for (const std::string &child : children) {
+      if (child.size() > suffix_size &&
+          child.compare(child.size() - suffix_size, suffix_size, kSuffix) ==
+              0) {
+        env_->DeleteFile(path_ + "/" + child);
+      }
+    }
+    writer_running_ = true;
+    env_->StartThread(&LogStructuredSecondaryCache::WriterMain, this);
+    return Status::OK();
+  }
+
+  const char *Name() const override { return "LogStructuredSecondaryCache"; }
+
+  Status Insert(const Slice &key, const Slice &value) override {
+    const size_t record_size = value.size() + kTrailerSize;
+    if (record_size > segment_size_) { return Status::OK(); }
+    const uint64_t hash = Hash64(value.data(), value.size(), 0);
+    char trailer[kTrailerSize];
+    EncodeFixed64(trailer, hash);
+
+    const std::string k = key.ToString();
+    std::lock_guard<std::mutex> l(mutex_);
+    // A value read from here and evicted again is usually unchanged, and
+    // its copy still good
+    auto it = index_.find(k);
+    if (it != index_.end() && it->second.size == value.size() &&
+        it->second.hash == hash) {
+      return Status::OK();
+    }
+    if (segments_.empty() ||
+        segments_.back()->buffer.size() + record_size > segment_size_) {
+      if (!segments_.empty()) {
+        // Nothing appends to a full segment any more, and readers copy out
+        // of its buffer under the lock until the file replaces it.
+        pending_.push_back(segments_.back());
+        writer_cv_.notify_all();
+      }
+      StartSegment();
+    }
+    Segment *segment = segments_.back().get();
+    Location &location = index_[k];
+    location.segment = segment->number;
+    location.offset = segment->buffer.size();
+    location.size = value.size();
+    location.hash = hash;
+    segment->buffer.append(value.data(), value.size());
+    segment->buffer.append(trailer, kTrailerSize);
+    segment->keys.push_back(k);
+    return Status::OK();
+  }
+
+  bool Lookup(const Slice &key, std::string *value) override {
+    Location location;
+    std::shared_ptr<RandomAccessFile> file;
+    {
+      std::lock_guard<std::mutex> l(mutex_);
+      auto it = index_.find(key.ToString());
+      if (it == index_.end()) { return false; }
+      location = it->second;
+      Segment *segment = FindSegment(location.segment);
+      if (segment->file == nullptr) {
+        value->assign(segment->buffer.data() + location.offset,
+                      location.size);
+        return true;
+      }
+      file = segment->file;
+    }
+
+    // Read without the lock; the file stays readable even if its segment
+    // is dropped meanwhile.
+    value->resize(location.size + kTrailerSize);
+    Slice result;
+    Status s = file->Read(location.offset, value->size(), &result,
+                          value->data());
+    if (!s.ok() || result.size() != value->size() ||
+        DecodeFixed64(result.data() + location.size) !=
+            Hash64(result.data(), location.size, 0)) {
+      Erase(key);
+      return false;
+    }
+    if (result.data() != value->data()) {
+      value->assign(result.data(), location.size);
+    } else {
+      value->resize(location.size);
+    }
+    return true;
+  }
+
+  void Erase(const Slice &key) override {
+    std::lock_guard<std::mutex> l(mutex_);
+    index_.erase(key.ToString());
+  }
+
+  uint64_t NumWriteErrors() const override {
+    return write_errors_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr const char *kSuffix = ".cache";
+
+  struct Segment {
+    uint64_t number;
+    // The contents while the segment is filled and written out, after
+    // which reads go to "file"
+    std::string buffer;
+    std::shared_ptr<RandomAccessFile> file;
+    // Keys appended to the segment, to unindex them when it is dropped
+    std::vector<std::string> keys;
+    // Set if the segment was dropped before its file replaced the buffer
+    bool dropped = false;
+  };
+
+  struct Location {
+    uint64_t segment;
+    uint64_t offset;
+    size_t size;
+    uint64_t hash;  // Hash64() of the value, as in its trailer
+  };
+
+  std::string SegmentFileName(uint64_t number) const {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "/%06llu",
+                  static_cast<unsigned long long>(number));
+    return path_ + buf + kSuffix;
+  }
+
+  // REQUIRES: mutex_ held, and "number" is a live segment
+  Segment *FindSegment(uint64_t number) const {
+    return segments_[number - segments_.front()->number].get();
+  }
+
+  // Opens a new segment for appends, dropping the oldest ones beyond the
+  // capacity.
+  // REQUIRES: mutex_ held
+  void StartSegment() {
+    auto segment = std::make_shared<Segment>();
+    segment->number = next_segment_number_++;
+    segment->buffer.reserve(segment_size_);
+    segments_.push_back(std::move(segment));
+    while (segments_.size() > std::max<size_t>(max_segments_, 1)) {
+      Segment *oldest = segments_.front().get();
+      for (const std::string &key : oldest->keys) {
+        auto it = index_.find(key);
+        // Later inserts of the same key point elsewhere
+        if (it != index_.end() && it->second.segment == oldest->number) {
+          index_.erase(it);
+        }
+      }
+      if (oldest->file != nullptr) {
+        env_->DeleteFile(SegmentFileName(oldest->number));
+      } else {
+        oldest->dropped = true;
+      }
+      segments_.pop_front();
+    }
+  }
+
+  static void WriterMain(void *arg) {
+    reinterpret_cast<LogStructuredSecondaryCache *>(arg)->WriterLoop();
+  }
+
+  // Writes out full segments, oldest first, until shutdown
+  void WriterLoop() {
+    std::unique_lock<std::mutex> l(mutex_);
+    while (true) {
+      while (!shutting_down_ && pending_.empty()) { writer_cv_.wait(l); }
+      if (shutting_down_) { break; }
+      std::shared_ptr<Segment> segment = std::move(pending_.front());
+      pending_.pop_front();
+      if (segment->dropped) { continue; }
+      l.unlock();
+      WriteSegment(segment);
+      l.lock();
+    }
+    writer_running_ = false;
+    writer_cv_.notify_all();
+  }
+
+  // REQUIRES: mutex_ not held
+  void WriteSegment(const std::shared_ptr<Segment> &segment) {
+    const std::string fname = SegmentFileName(segment->number);
+    std::unique_ptr<WritableFile> writer;
+    Status s = env_->NewWritableFile(fname, &writer, EnvOptions());
+    if (s.ok()) { s = writer->Append(segment->buffer); }
+    if (s.ok()) { s = writer->Close(); }
+    std::unique_ptr<RandomAccessFile> reader;
+    if (s.ok()) { s = env_->NewRandomAccessFile(fname, &reader, EnvOptions()); }
+
+    std::lock_guard<std::mutex> l(mutex_);
+    if (s.ok() && !segment->dropped) {
+      segment->file = std::move(reader);
+      std::string().swap(segment->buffer);
+    } else {
+      // A failed segment is served from memory until it is dropped.
+      if (!s.ok()) { write_errors_.fetch_add(1, std::memory_order_relaxed); }
+      env_->DeleteFile(fname);
+    }
+  }
+
+  Env *const env_;
+  const std::string path_;
+  const size_t segment_size_;
+  const size_t max_segments_;
+
+  std::mutex mutex_;
+  // Live segments, oldest first, with consecutive numbers
+  std::deque<std::shared_ptr<Segment>> segments_;
+  uint64_t next_segment_number_;
+  std::unordered_map<std::string, Location> index_;
+  // Full segments waiting for the writer thread, oldest first
+  std::deque<std::shared_ptr<Segment>> pending_;
+  // Signalled when a segment is queued, at shutdown, and when the writer
+  // exits
+  std::condition_variable writer_cv_;
+  bool shutting_down_;
+  bool writer_running_;
+
+  std::atomic<uint64_t> write_errors_;
+};
+
+} // namespace
+
+Status NewLogStructuredSecondaryCache(Env *env, const std::string &path,
+                                      size_t capacity,
+                                      std::shared_ptr<SecondaryCache> *result) {
+  auto cache =
+      std::make_shared<LogStructuredSecondaryCache>(env, path, capacity);
+  Status s = cache->Open();
+  if (s.ok()) {
+    *result = std::move(cache);
+  } else {
+    result->reset();
+  }
+  return s;
+}
+
+} // namespace leveldb
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "util/statistics.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+namespace leveldb {
+
+std::shared_ptr<Statistics> CreateDBStatistics() {
+  return std::make_shared<StatisticsImpl>();
+}
+
+StatisticsImpl::StatisticsImpl() {}
+
+StatisticsImpl::~StatisticsImpl() {}
+
+long StatisticsImpl::getTickerCount(Tickers tickerType) {
+  assert(tickerType < TICKER_ENUM_MAX);
+  uint64_t res = 0;
+  for (size_t core_idx = 0; core_idx < per_core_stats_.Size(); ++core_idx) {
+    res += per_core_stats_.AccessAtCore(core_idx)->tickers_[tickerType].load(
+        std::memory_order_relaxed);
+  }
+  return static_cast<long>(res);
+}
+
+void StatisticsImpl::recordTick(Tickers tickerType, uint64_t count) {
+  assert(tickerType < TICKER_ENUM_MAX);
+  per_core_stats_.Access()->tickers_[tickerType].fetch_add(
+      count, std::memory_order_relaxed);
+}
+
+void StatisticsImpl::measureTime(Histograms histogramType, uint64_t time) {
+  assert(histogramType < HISTOGRAM_ENUM_MAX);
+  per_core_stats_.Access()->histograms_[histogramType].Add(time);
+}
+
+void StatisticsImpl::getHistogram(Histograms histogramType,
+                                  HistogramImpl *result) {
+  assert(histogramType < HISTOGRAM_ENUM_MAX);
+  result->Clear();
+  for (size_t core_idx = 0; core_idx < per_core_stats_.Size(); ++core_idx) {
+    const HistogramStat &stat =
+        per_core_stats_.AccessAtCore(core_idx)->histograms_[histogramType];
+    if (stat.Empty()) continue;
+    result->Merge(stat);
+  }
+}
+
+void StatisticsImpl::histogramData(Histograms type,
+                                   HistogramData *const data) {
+  HistogramImpl merged;
+  getHistogram(type, &merged);
+  merged.Data(data);
+}
+
+std::string Statistics::ToString() {
+  std::string res;
+  res.reserve(20000);
+  char buffer[200];
+  for (const auto &t : TickersNameMap) {
+    snprintf(buffer, sizeof(buffer), "%s COUNT : %ld\n", t.second.c_str(),
+             getTickerCount(t.first));
+    res.append(buffer);
+  }
+  for (const auto &h : HistogramsNameMap) {
+    HistogramData hData;
+    histogramData(h.first, &hData);
+    snprintf(buffer, sizeof(buffer),
+             "%s statistics Percentiles :=> 50 : %f 95 : %f 99 : %f\n",
+             h.second.c_str(), hData.median, hData.percentile95,
+             hData.percentile99);
+    res.append(buffer);
+  }
+  res.shrink_to_fit();
+  return res;
+}
+
+}  // namespace leveldb
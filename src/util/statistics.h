@@ -0,0 +1,51 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "leveldb/statistics.h"
+#include "port/port.h"
+#include "util/core_local.h"
+#include "util/histogram.h"
+
+namespace leveldb {
+
+// Statistics backed by one cache-line aligned shard per core.  recordTick()
+// and measureTime() only touch the shard of the core the caller runs on, so
+// the hot path never contends on a shared cache line; getTickerCount() and
+// histogramData() sum all shards and are comparatively expensive.
+class StatisticsImpl : public Statistics {
+ public:
+  StatisticsImpl();
+  ~StatisticsImpl() override;
+
+  // No copying allowed
+  StatisticsImpl(const StatisticsImpl &) = delete;
+  void operator=(const StatisticsImpl &) = delete;
+
+  long getTickerCount(Tickers tickerType) override;
+  void recordTick(Tickers tickerType, uint64_t count) override;
+  void measureTime(Histograms histogramType, uint64_t time) override;
+  void histogramData(Histograms type, HistogramData *const data) override;
+
+  // Sum of all shards of "histogramType" as a single histogram.
+  void getHistogram(Histograms histogramType, HistogramImpl *result);
+
+ private:
+  struct alignas(port::kCacheLineSize) StatisticsData {
+    std::atomic_uint_fast64_t tickers_[TICKER_ENUM_MAX] = {{0}};
+    HistogramStat histograms_[HISTOGRAM_ENUM_MAX];
+  };
+
+  static_assert(sizeof(StatisticsData) % port::kCacheLineSize == 0,
+                "StatisticsData must not share a cache line with its "
+                "neighbour shard");
+
+  CoreLocalArray<StatisticsData> per_core_stats_;
+};
+
+}  // namespace leveldb
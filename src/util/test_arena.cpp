@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <thread>
+#include <vector>
+
 #include "util/arena.h"
 #include "util/random.h"
 
@@ -60,4 +64,35 @@ TEST(ArenaTest, Simple) {
   }
 }
 
+TEST(ArenaTest, AllocateAlignedConcurrently) {
+  Arena arena;
+  constexpr int kThreads = 4;
+  constexpr int kAllocations = 20000;
+  std::vector<std::vector<std::pair<size_t, char*>>> allocated(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&arena, &allocated, t] {
+      Random rnd(301 + t);
+      for (int i = 0; i < kAllocations; i++) {
+        const size_t s = rnd.OneIn(1000) ? 1 + rnd.Uniform(3000)
+                                         : 1 + rnd.Uniform(100);
+        char* r = arena.AllocateAlignedConcurrently(s);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(r) % 8);
+        for (size_t b = 0; b < s; b++) { r[b] = static_cast<char>(t); }
+        allocated[t].push_back(std::make_pair(s, r));
+      }
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+
+  // No allocation overlaps one made by another thread
+  for (int t = 0; t < kThreads; t++) {
+    for (const auto& [num_bytes, p] : allocated[t]) {
+      for (size_t b = 0; b < num_bytes; b++) {
+        ASSERT_EQ(t, static_cast<int>(p[b]));
+      }
+    }
+  }
+}
+
 }  // namespace leveldb
\ No newline at end of file
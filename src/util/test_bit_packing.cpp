@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "util/bit_packing.h"
+#include "util/coding.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+TEST(BitPackingTest, PackUnpack) {
+  Random64 rnd(301);
+  for (uint32_t bits = 1; bits <= 32; bits++) {
+    for (size_t n : {0, 1, 7, 8, 9, 31, 100, 1000}) {
+      std::vector<uint32_t> values(n);
+      for (uint32_t &v : values) {
+        v = static_cast<uint32_t>(rnd.Next()) &
+            (bits == 32 ? ~0u : (1u << bits) - 1);
+      }
+      std::string packed(BitPackedSize(n, bits), '\0');
+      BitPack(values.data(), n, bits, packed.data());
+      // Same layout as the single-value bit stream routines
+      for (size_t i = 0; i < n; i++) {
+        ASSERT_EQ(values[i], BitStreamGetInt(&packed, i * bits, bits));
+      }
+      std::vector<uint32_t> out(n);
+      BitUnpack(packed.data(), n, bits, out.data());
+      ASSERT_EQ(values, out) << "bits=" << bits << " n=" << n;
+      ASSERT_LE(MaxBits(values.data(), n), bits);
+    }
+  }
+}
+
+TEST(BitPackingTest, MaxBits) {
+  const uint32_t values[] = {0, 5, 3};
+  ASSERT_EQ(0u, MaxBits(values, 1));
+  ASSERT_EQ(3u, MaxBits(values, 3));
+  const uint32_t top = 0x80000000u;
+  ASSERT_EQ(32u, MaxBits(&top, 1));
+}
+
+TEST(BitPackingTest, FrameOfReference) {
+  Random64 rnd(301);
+  // Clustered offsets, a constant run, and a frame with a 64-bit range
+  std::vector<uint64_t> values;
+  for (int i = 0; i < 300; i++) {
+    values.push_back((1ull << 40) + i * 4096 + rnd.Uniform(100));
+  }
+  for (int i = 0; i < 130; i++) { values.push_back(7); }
+  values.push_back(0);
+  values.push_back(~0ull);
+
+  std::string encoded;
+  PutFrameOfReference(&encoded, values.data(), values.size());
+  // Each frame of offsets needs about 20 bits per value
+  ASSERT_LT(encoded.size(), values.size() * 8 / 2);
+  encoded.append("trailer");
+
+  Slice input(encoded);
+  std::vector<uint64_t> decoded;
+  ASSERT_TRUE(GetFrameOfReference(&input, &decoded));
+  ASSERT_EQ(values, decoded);
+  ASSERT_EQ("trailer", input.ToString());
+
+  FrameOfReferenceReader reader;
+  ASSERT_TRUE(reader.Init(encoded));
+  ASSERT_EQ(values.size(), reader.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    ASSERT_EQ(values[i], reader.Get(i)) << i;
+  }
+  std::vector<uint64_t> range(200);
+  reader.DecodeRange(100, 200, range.data());
+  ASSERT_TRUE(std::equal(range.begin(), range.end(), values.begin() + 100));
+
+  ASSERT_FALSE(reader.Init(Slice(encoded.data(), 20)));
+
+  std::string empty;
+  PutFrameOfReference(&empty, nullptr, 0);
+  input = empty;
+  ASSERT_TRUE(GetFrameOfReference(&input, &decoded));
+  ASSERT_TRUE(decoded.empty());
+}
+
+} // namespace leveldb
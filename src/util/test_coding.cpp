@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "util/coding.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+// Values of mixed encoded lengths, with runs of single-byte values so that
+// every decoding path gets exercised.
+static std::vector<uint64_t> MixedValues(int n, int max_bits) {
+  Random64 rnd(301);
+  std::vector<uint64_t> values(n);
+  for (int i = 0; i < n; i++) {
+    const int bits = (i / 20) % 3 == 0 ? 7 : 1 + rnd.Next() % max_bits;
+    values[i] = rnd.Next() & (bits >= 64 ? ~0ull : (1ull << bits) - 1);
+  }
+  return values;
+}
+
+TEST(CodingTest, DecodeVarint32Batch) {
+  const std::vector<uint64_t> values = MixedValues(1000, 32);
+  std::string encoded;
+  for (uint64_t v : values) { PutVarint32(&encoded, static_cast<uint32_t>(v)); }
+  const char *limit = encoded.data() + encoded.size();
+
+  for (size_t n : {0, 1, 3, 4, 15, 16, 17, 1000}) {
+    std::vector<uint32_t> out(n);
+    const char *p = DecodeVarint32Batch(encoded.data(), limit, n, out.data());
+    ASSERT_NE(nullptr, p);
+    const char *q = encoded.data();
+    for (size_t i = 0; i < n; i++) {
+      uint32_t expected;
+      q = GetVarint32Ptr(q, limit, &expected);
+      ASSERT_EQ(expected, out[i]) << "n=" << n << " i=" << i;
+    }
+    ASSERT_EQ(q, p);
+  }
+
+  std::vector<uint32_t> out(1001);
+  ASSERT_EQ(nullptr,
+            DecodeVarint32Batch(encoded.data(), limit, 1001, out.data()));
+  // Truncated last value
+  ASSERT_EQ(nullptr,
+            DecodeVarint32Batch(encoded.data(), limit - 1, 1000, out.data()));
+  // Over-long varint
+  const std::string bad(20, '\xff');
+  ASSERT_EQ(nullptr, DecodeVarint32Batch(bad.data(), bad.data() + bad.size(),
+                                         4, out.data()));
+}
+
+TEST(CodingTest, DecodeVarint64Batch) {
+  const std::vector<uint64_t> values = MixedValues(1000, 64);
+  std::string encoded;
+  for (uint64_t v : values) { PutVarint64(&encoded, v); }
+  const char *limit = encoded.data() + encoded.size();
+
+  std::vector<uint64_t> out(values.size());
+  ASSERT_EQ(limit, DecodeVarint64Batch(encoded.data(), limit, values.size(),
+                                       out.data()));
+  ASSERT_EQ(values, out);
+  ASSERT_EQ(nullptr, DecodeVarint64Batch(encoded.data(), limit - 1,
+                                         values.size(), out.data()));
+}
+
+} // namespace leveldb
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "comparator.h"
+#include "db/dbformat.h"
+
+namespace leveldb {
+
+static std::string Separator(const std::string &start,
+                             const std::string &limit) {
+  std::string result = start;
+  BytewiseComparator()->FindShortestSeparator(&result, limit);
+  return result;
+}
+
+static std::string Successor(const std::string &key) {
+  std::string result = key;
+  BytewiseComparator()->FindShortSuccessor(&result);
+  return result;
+}
+
+static std::string IKey(const std::string &user_key, uint64_t seq,
+                        ValueType type) {
+  std::string encoded;
+  AppendInternalKey(&encoded, ParsedInternalKey(user_key, seq, type));
+  return encoded;
+}
+
+TEST(BytewiseComparatorTest, FindShortestSeparator) {
+  ASSERT_EQ("b", Separator("abc", "cde"));
+  ASSERT_EQ("foo", Separator("foo", "foo"));
+  // One is a prefix of the other
+  ASSERT_EQ("foo", Separator("foo", "foobar"));
+  ASSERT_EQ("foobar", Separator("foobar", "foo"));
+  // Adjacent first differing byte: bump the next byte instead
+  ASSERT_EQ("/t/01230", Separator("/t/0123/table/part-00017", "/t/0124/a"));
+  ASSERT_EQ("ab\xff\xff", Separator("ab\xff\xff", "ac"));
+  ASSERT_EQ("ab\xff\x02", Separator("ab\xff\x01", "ac"));
+}
+
+TEST(BytewiseComparatorTest, FindShortSuccessor) {
+  ASSERT_EQ("g", Successor("foo"));
+  ASSERT_EQ(std::string("\xff\xff\x01"),
+            Successor(std::string("\xff\xff\x00\x12", 4)));
+  ASSERT_EQ("\xff\xff", Successor("\xff\xff"));
+  ASSERT_EQ("", Successor(""));
+}
+
+TEST(BytewiseComparatorTest, InternalKeyShortening) {
+  const InternalKeyComparator icmp(BytewiseComparator());
+  std::string key = IKey("foo", 100, kTypeValue);
+  icmp.FindShortestSeparator(&key, IKey("hello", 200, kTypeValue));
+  ASSERT_EQ(IKey("g", kMaxSequenceNumber, kValueTypeForSeek), key);
+
+  // Same user key, or a user key that cannot be shortened: unchanged
+  key = IKey("foo", 100, kTypeValue);
+  icmp.FindShortestSeparator(&key, IKey("foo", 99, kTypeValue));
+  ASSERT_EQ(IKey("foo", 100, kTypeValue), key);
+  icmp.FindShortestSeparator(&key, IKey("foobar", 200, kTypeValue));
+  ASSERT_EQ(IKey("foo", 100, kTypeValue), key);
+
+  key = IKey("foo", 100, kTypeValue);
+  icmp.FindShortSuccessor(&key);
+  ASSERT_EQ(IKey("g", kMaxSequenceNumber, kValueTypeForSeek), key);
+}
+
+} // namespace leveldb
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <utility>
+
+#include "util/hash.h"
+#include "util/random.h"
+
+namespace leveldb {
+
+static std::string RandomBytes(size_t n) {
+  Random64 rnd(301);
+  std::string s(n, '\0');
+  for (char &c : s) { c = static_cast<char>(rnd.Next()); }
+  return s;
+}
+
+TEST(HashTest, HashIsStable) {
+  // Hash() values are stored on disk by existing bloom filters.  Bytes
+  // above 0x7f are sign-extended, so these differ from upstream LevelDB.
+  const char data1[1] = {static_cast<char>(0x62)};
+  const char data2[2] = {static_cast<char>(0xc3), static_cast<char>(0x97)};
+  const char data3[3] = {static_cast<char>(0xe2), static_cast<char>(0x99),
+                         static_cast<char>(0xa5)};
+  ASSERT_EQ(Hash(nullptr, 0, 0xbc9f1d34), 0xbc9f1d34);
+  ASSERT_EQ(Hash(data1, sizeof(data1), 0xbc9f1d34), 0xef1345c4);
+  ASSERT_EQ(Hash(data2, sizeof(data2), 0xbc9f1d34), 0x0f2ba540);
+  ASSERT_EQ(Hash(data3, sizeof(data3), 0xbc9f1d34), 0x530174ee);
+}
+
+TEST(HashTest, Hash64IsStable) {
+  // Hash64() values are stored on disk by "leveldb.BuiltinBloomFilter64"
+  // filters.  One length from each code path, with the bloom filter seed.
+  std::string data;
+  for (int i = 0; i < 300; i++) {
+    data.push_back(static_cast<char>(i * 7 + 1));
+  }
+  const std::pair<size_t, uint64_t> expected[] = {
+      {0, 0x9cc37fa23930b3d9ull},   {1, 0x9e1af5234e4559bbull},
+      {3, 0x9571d7052f71d594ull},   {4, 0x098ae0eb5e50e180ull},
+      {8, 0x8e5402275c7c8f36ull},   {9, 0x9edf8aa1b525a65bull},
+      {16, 0x78fbbb8f0c19fc82ull},  {17, 0xa8a73a8d3d65a077ull},
+      {128, 0x55418f245b45b189ull}, {129, 0x7bf71ff7b4408340ull},
+      {240, 0xdf2197b9a7a4a05dull}, {241, 0xe60b9690756bf122ull},
+      {300, 0xd67eb687860833f8ull},
+  };
+  for (const auto &[n, hash] : expected) {
+    ASSERT_EQ(hash, Hash64(data.data(), n, 0xbc9f1d34)) << n;
+  }
+}
+
+TEST(HashTest, Hash64DistinctAcrossLengths) {
+  // Prefixes of one buffer, so every length code path is exercised,
+  // including the long path with full blocks and a partial last stripe.
+  const std::string data = RandomBytes(2200);
+  std::set<uint64_t> seen;
+  std::set<std::pair<uint64_t, uint64_t>> seen128;
+  for (size_t n = 0; n <= data.size(); n++) {
+    ASSERT_TRUE(seen.insert(Hash64(data.data(), n, 0)).second) << n;
+    uint64_t low, high;
+    Hash128(data.data(), n, 0, &low, &high);
+    ASSERT_TRUE(seen128.insert({low, high}).second) << n;
+  }
+}
+
+TEST(HashTest, Hash64Seed) {
+  const std::string data = RandomBytes(2000);
+  for (size_t n : {0, 3, 8, 16, 100, 200, 1000, 2000}) {
+    ASSERT_EQ(Hash64(data.data(), n, 7), Hash64(data.data(), n, 7));
+    ASSERT_NE(Hash64(data.data(), n, 7), Hash64(data.data(), n, 8)) << n;
+  }
+}
+
+TEST(HashTest, Hash64Avalanche) {
+  // Flipping any single input bit should flip about half the output bits
+  for (size_t n : {1, 4, 12, 16, 64, 128, 200, 240, 500, 1024, 1500}) {
+    std::string data = RandomBytes(n);
+    const uint64_t base = Hash64(data.data(), n, 0);
+    int flipped = 0;
+    for (size_t bit = 0; bit < 8 * n; bit++) {
+      data[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+      const uint64_t h = Hash64(data.data(), n, 0);
+      data[bit / 8] ^= static_cast<char>(1 << (bit % 8));
+      ASSERT_NE(base, h) << n << " " << bit;
+      flipped += __builtin_popcountll(base ^ h);
+    }
+    const double average = static_cast<double>(flipped) / (8 * n);
+    ASSERT_GT(average, 28.0) << n;
+    ASSERT_LT(average, 36.0) << n;
+  }
+}
+
+TEST(HashTest, Hash64SameOnEveryCPU) {
+  // Computed with the portable long-input path; a vectorized path that
+  // disagrees with it fails here.
+  const std::string data = RandomBytes(5000);
+  ASSERT_EQ(Hash64(data.data(), 241, 42), 0xf671594c44449f18ull);
+  ASSERT_EQ(Hash64(data.data(), 1025, 42), 0xbee28ded5d323261ull);
+  ASSERT_EQ(Hash64(data.data(), 4999, 42), 0xcf209231cba4ad03ull);
+  uint64_t low, high;
+  Hash128(data.data(), 4999, 42, &low, &high);
+  ASSERT_EQ(high, 0xd312e38ef5e687baull);
+}
+
+} // namespace leveldb
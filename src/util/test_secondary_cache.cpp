@@ -0,0 +1,299 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "leveldb/cache.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/secondary_cache.h"
+#include "port/port.h"
+
+namespace leveldb {
+
+class SecondaryCacheTest : public testing::Test {
+public:
+  SecondaryCacheTest() : env_(Env::Default()) {
+    env_->GetTestDirectory(&path_);
+    path_ += "/secondary_cache_test";
+  }
+
+  ~SecondaryCacheTest() override { DeleteFiles(); }
+
+  int NumFiles() {
+    std::vector<std::string> children;
+    env_->GetChildren(path_, &children);
+    int n = 0;
+    for (const std::string &child : children) {
+      if (child != "." && child != "..") { n++; }
+    }
+    return n;
+  }
+
+  void DeleteFiles() {
+    std::vector<std::string> children;
+    env_->GetChildren(path_, &children);
+    for (const std::string &child : children) {
+      env_->DeleteFile(path_ + "/" + child);
+    }
+    env_->DeleteDir(path_);
+  }
+
+  Env *env_;
+  std::string path_;
+};
+
+TEST_F(SecondaryCacheTest, LogStructured) {
+  std::shared_ptr<SecondaryCache> cache;
+  ASSERT_TRUE(
+      NewLogStructuredSecondaryCache(env_, path_, 64 << 10, &cache).ok());
+  std::string value;
+  ASSERT_FALSE(cache->Lookup("missing", &value));
+
+  // 16KB segments: the first ones are written out in the background and
+  // read back from file
+  const std::string filler(1000, 'x');
+  for (int i = 0; i < 40; i++) {
+    ASSERT_TRUE(cache->Insert("key" + std::to_string(i),
+                              std::to_string(i) + filler)
+                    .ok());
+  }
+  for (int i = 0; i < 1000 && NumFiles() < 2; i++) {
+    env_->SleepForMicroseconds(10000);
+  }
+  ASSERT_EQ(2, NumFiles());
+  for (int i = 0; i < 40; i++) {
+    ASSERT_TRUE(cache->Lookup("key" + std::to_string(i), &value));
+    ASSERT_EQ(std::to_string(i) + filler, value);
+  }
+
+  // An unchanged value is not written again, so it does not push the
+  // oldest segment out
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(cache->Insert("key5", "5" + filler).ok());
+  }
+  ASSERT_TRUE(cache->Lookup("key2", &value));
+
+  // Later values win, and erased keys are gone
+  ASSERT_TRUE(cache->Insert("key0", "new").ok());
+  ASSERT_TRUE(cache->Lookup("key0", &value));
+  ASSERT_EQ("new", value);
+  cache->Erase("key1");
+  ASSERT_FALSE(cache->Lookup("key1", &value));
+
+  // The oldest segments are dropped to stay within the capacity
+  for (int i = 40; i < 200; i++) {
+    ASSERT_TRUE(cache->Insert("key" + std::to_string(i), filler).ok());
+  }
+  ASSERT_FALSE(cache->Lookup("key2", &value));
+  ASSERT_TRUE(cache->Lookup("key199", &value));
+  ASSERT_LE(NumFiles(), 4);
+  ASSERT_EQ(0u, cache->NumWriteErrors());
+
+  cache.reset();
+  ASSERT_EQ(0, NumFiles());
+}
+
+TEST_F(SecondaryCacheTest, ReopenClearsFiles) {
+  ASSERT_TRUE(env_->CreateDirIfMissing(path_).ok());
+  std::unique_ptr<WritableFile> file;
+  ASSERT_TRUE(env_->NewWritableFile(path_ + "/000001.cache", &file,
+                                    EnvOptions())
+                  .ok());
+  ASSERT_TRUE(file->Append("stale").ok());
+  ASSERT_TRUE(file->Close().ok());
+
+  std::shared_ptr<SecondaryCache> cache;
+  ASSERT_TRUE(
+      NewLogStructuredSecondaryCache(env_, path_, 64 << 10, &cache).ok());
+  ASSERT_EQ(0, NumFiles());
+}
+
+TEST_F(SecondaryCacheTest, WriteErrors) {
+  std::shared_ptr<SecondaryCache> cache;
+  ASSERT_TRUE(
+      NewLogStructuredSecondaryCache(env_, path_, 64 << 10, &cache).ok());
+  // Segment files cannot be created without the directory
+  DeleteFiles();
+  const std::string filler(1000, 'x');
+  for (int i = 0; i < 20; i++) {
+    ASSERT_TRUE(cache->Insert("key" + std::to_string(i), filler).ok());
+  }
+  for (int i = 0; i < 1000 && cache->NumWriteErrors() == 0; i++) {
+    env_->SleepForMicroseconds(10000);
+  }
+  ASSERT_EQ(1u, cache->NumWriteErrors());
+
+  // The failed segment is still served from memory
+  std::string value;
+  ASSERT_TRUE(cache->Lookup("key0", &value));
+  ASSERT_EQ(filler, value);
+}
+
+namespace {
+
+void SaveString(void *value, std::string *out) {
+  out->append(*reinterpret_cast<std::string *>(value));
+}
+
+void *CreateString(const Slice &data, size_t *charge) {
+  *charge = data.size();
+  return new std::string(data.ToString());
+}
+
+void DeleteString(const Slice &key, void *value) {
+  delete reinterpret_cast<std::string *>(value);
+}
+
+const Cache::CacheItemHelper kStringHelper = {&SaveString, &CreateString,
+                                              &DeleteString};
+
+} // namespace
+
+TEST_F(SecondaryCacheTest, BehindLRUCache) {
+  std::shared_ptr<SecondaryCache> secondary;
+  ASSERT_TRUE(
+      NewLogStructuredSecondaryCache(env_, path_, 1 << 20, &secondary).ok());
+  std::shared_ptr<Cache> cache = NewLRUCache(10000, 0, secondary);
+
+  const std::string filler(1000, 'v');
+  for (int i = 0; i < 100; i++) {
+    std::string *value = new std::string(std::to_string(i) + filler);
+    cache->Release(cache->Insert("key" + std::to_string(i), value,
+                                 value->size(), &kStringHelper));
+  }
+  ASSERT_LE(cache->TotalCharge(), 10000u);
+
+  // Evicted entries come back from the secondary cache
+  ASSERT_EQ(nullptr, cache->Lookup("key0"));
+  Cache::Handle *handle = cache->Lookup("key0", &kStringHelper);
+  ASSERT_NE(nullptr, handle);
+  ASSERT_EQ("0" + filler,
+            *reinterpret_cast<std::string *>(cache->Value(handle)));
+  cache->Release(handle);
+  // Now back in the cache itself
+  handle = cache->Lookup("key0");
+  ASSERT_NE(nullptr, handle);
+  cache->Release(handle);
+  ASSERT_EQ(nullptr, cache->Lookup("missing", &kStringHelper));
+
+  // It is saved again when evicted again
+  secondary->Erase("key0");
+  for (int i = 100; i < 200; i++) {
+    std::string *value = new std::string(std::to_string(i) + filler);
+    cache->Release(cache->Insert("key" + std::to_string(i), value,
+                                 value->size(), &kStringHelper));
+  }
+  ASSERT_EQ(nullptr, cache->Lookup("key0"));
+  handle = cache->Lookup("key0", &kStringHelper);
+  ASSERT_NE(nullptr, handle);
+  cache->Release(handle);
+
+  // Values can be read from the secondary cache without moving them
+  const size_t charge = cache->TotalCharge();
+  std::string *value = reinterpret_cast<std::string *>(
+      cache->LookupSecondary("key1", &kStringHelper));
+  ASSERT_NE(nullptr, value);
+  ASSERT_EQ("1" + filler, *value);
+  kStringHelper.deleter("key1", value);
+  ASSERT_EQ(charge, cache->TotalCharge());
+  ASSERT_EQ(nullptr, cache->Lookup("key1"));
+  ASSERT_EQ(nullptr, cache->LookupSecondary("missing", &kStringHelper));
+}
+
+namespace {
+
+// Counts the hits of the cache it wraps, and the bytes inserted
+class CountingSecondaryCache : public SecondaryCache {
+public:
+  explicit CountingSecondaryCache(std::shared_ptr<SecondaryCache> target)
+      : target_(std::move(target)), hits_(0), inserted_bytes_(0) {}
+
+  const char *Name() const override { return "CountingSecondaryCache"; }
+  Status Insert(const Slice &key, const Slice &value) override {
+    inserted_bytes_ += value.size();
+    return target_->Insert(key, value);
+  }
+  bool Lookup(const Slice &key, std::string *value) override {
+    const bool hit = target_->Lookup(key, value);
+    if (hit) { hits_++; }
+    return hit;
+  }
+  void Erase(const Slice &key) override { target_->Erase(key); }
+  uint64_t NumWriteErrors() const override {
+    return target_->NumWriteErrors();
+  }
+
+  int hits() const { return hits_; }
+  size_t inserted_bytes() const { return inserted_bytes_; }
+
+private:
+  std::shared_ptr<SecondaryCache> target_;
+  std::atomic<int> hits_;
+  std::atomic<size_t> inserted_bytes_;
+};
+
+} // namespace
+
+TEST_F(SecondaryCacheTest, ServesDBReads) {
+  std::shared_ptr<SecondaryCache> log;
+  ASSERT_TRUE(
+      NewLogStructuredSecondaryCache(env_, path_, 16 << 20, &log).ok());
+  auto counting = std::make_shared<CountingSecondaryCache>(log);
+
+  std::string dbname;
+  env_->GetTestDirectory(&dbname);
+  dbname += "/secondary_cache_db_test";
+  Options options;
+  options.create_if_missing = true;
+  options.compression = kZlibCompression;
+  // Room for a few blocks only
+  options.block_cache = NewLRUCache(16 << 10, 0, counting);
+  DestroyDB(dbname, options);
+  DB *db;
+  ASSERT_TRUE(DB::Open(options, dbname, &db).ok());
+  const std::string value(100, 'v');
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_TRUE(db->Put(WriteOptions(), std::to_string(i), value).ok());
+  }
+  ASSERT_TRUE(db->Flush(FlushOptions()).ok());
+
+  std::string result;
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 2000; i += 10) {
+      ASSERT_TRUE(db->Get(ReadOptions(), std::to_string(i), &result).ok());
+      ASSERT_EQ(value, result);
+    }
+  }
+  ASSERT_GT(counting->hits(), 0);
+
+  // Reads that do not fill the cache use the secondary cache without
+  // moving blocks into the block cache
+  options.block_cache->Prune();
+  ASSERT_EQ(0u, options.block_cache->TotalCharge());
+  const int hits = counting->hits();
+  ReadOptions no_fill;
+  no_fill.fill_cache = false;
+  for (int i = 0; i < 2000; i += 10) {
+    ASSERT_TRUE(db->Get(no_fill, std::to_string(i), &result).ok());
+    ASSERT_EQ(value, result);
+  }
+  ASSERT_GT(counting->hits(), hits);
+  ASSERT_EQ(0u, options.block_cache->TotalCharge());
+  // Blocks are saved compressed, with zlib compiled in: a fraction of the
+  // 220KB they take uncompressed
+  const CompressionOptions zlib;
+  std::string compressed;
+  if (port::Zlib_Compress(zlib.window_bits, zlib.level, zlib.strategy,
+                          value.data(), value.size(), &compressed)) {
+    ASSERT_LT(counting->inserted_bytes(), 50000u);
+  }
+
+  delete db;
+  DestroyDB(dbname, options);
+}
+
+} // namespace leveldb
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "util/histogram.h"
+#include "util/statistics.h"
+
+namespace leveldb {
+
+TEST(HistogramTest, BucketMapper) {
+  const HistogramBucketMapper &mapper = GetHistogramBucketMapper();
+  ASSERT_EQ(mapper.BucketCount(), (size_t) HistogramStat::kMaxBuckets);
+  ASSERT_EQ(mapper.IndexForValue(0), 0u);
+  ASSERT_EQ(mapper.IndexForValue(1), 0u);
+  ASSERT_EQ(mapper.IndexForValue(2), 1u);
+  ASSERT_EQ(mapper.IndexForValue(3), 2u);
+  for (size_t b = 1; b < mapper.BucketCount(); b++) {
+    ASSERT_LT(mapper.BucketLimit(b - 1), mapper.BucketLimit(b));
+    ASSERT_EQ(mapper.IndexForValue(mapper.BucketLimit(b)), b);
+    ASSERT_EQ(mapper.IndexForValue(mapper.BucketLimit(b - 1) + 1), b);
+  }
+}
+
+TEST(HistogramTest, Percentiles) {
+  HistogramImpl histogram;
+  for (uint64_t i = 1; i <= 100; i++) { histogram.Add(i); }
+  ASSERT_EQ(histogram.Count(), 100u);
+  ASSERT_DOUBLE_EQ(histogram.Average(), 50.5);
+  // Buckets have a relative error below 50%.
+  ASSERT_NEAR(histogram.Median(), 50, 25);
+  ASSERT_NEAR(histogram.Percentile(99), 99, 50);
+  ASSERT_LE(histogram.Percentile(100), 100);
+
+  histogram.Clear();
+  ASSERT_EQ(histogram.Count(), 0u);
+  ASSERT_EQ(histogram.Median(), 0);
+}
+
+TEST(StatisticsTest, ConcurrentTickers) {
+  std::shared_ptr<Statistics> stats = CreateDBStatistics();
+  const int kThreads = 8;
+  const int kTicks = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&stats]() {
+      for (int i = 0; i < kTicks; i++) {
+        RecordTick(stats, NUMBER_KEYS_WRITTEN);
+        RecordTick(stats, BYTES_WRITTEN, 10);
+      }
+    });
+  }
+  for (auto &t : threads) { t.join(); }
+  ASSERT_EQ(stats->getTickerCount(NUMBER_KEYS_WRITTEN), kThreads * kTicks);
+  ASSERT_EQ(stats->getTickerCount(BYTES_WRITTEN), kThreads * kTicks * 10);
+  ASSERT_EQ(stats->getTickerCount(BYTES_READ), 0);
+}
+
+TEST(StatisticsTest, HistogramAggregation) {
+  std::shared_ptr<Statistics> stats = CreateDBStatistics();
+  std::thread writer([&stats]() {
+    for (uint64_t i = 0; i < 1000; i++) { MeasureTime(stats, DB_GET, 100); }
+  });
+  writer.join();
+  for (uint64_t i = 0; i < 1000; i++) { MeasureTime(stats, DB_GET, 100); }
+
+  HistogramData data;
+  stats->histogramData(DB_GET, &data);
+  ASSERT_DOUBLE_EQ(data.average, 100);
+  ASSERT_DOUBLE_EQ(data.median, 100);
+  ASSERT_DOUBLE_EQ(data.standard_deviation, 0);
+  ASSERT_NE(stats->ToString().find("rocksdb.db.get.micros"), std::string::npos);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,121 @@
+// SPDX-FileCopyrightText: LakeSoul Contributors
+//
+// SPDX-License-Identifier: Apache-2.0
+
+#include "leveldb/write_buffer_manager.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "util/coding.h"
+
+namespace leveldb {
+
+namespace {
+
+// Memtable memory is charged to the cache in units of this size, so that
+// small arena growth does not turn into a cache insert every time.
+constexpr size_t kSizeDummyEntry = 256 * 1024;
+
+void DeleteDummyEntry(const Slice &key, void *value) {}
+
+} // namespace
+
+WriteBufferManager::WriteBufferManager(size_t buffer_size,
+                                       std::shared_ptr<Cache> cache)
+    : buffer_size_(buffer_size),
+      mutable_limit_(buffer_size * 7 / 8),
+      memory_used_(0),
+      memory_active_(0),
+      cache_(std::move(cache)),
+      dummy_size_(0) {}
+
+WriteBufferManager::~WriteBufferManager() {
+  assert(consumers_.empty());
+  for (const auto &entry : dummy_entries_) { ReleaseDummyEntry(entry); }
+}
+
+void WriteBufferManager::ReserveMem(size_t mem) {
+  memory_used_.fetch_add(mem, std::memory_order_relaxed);
+  memory_active_.fetch_add(mem, std::memory_order_relaxed);
+  if (cache_ != nullptr) {
+    std::lock_guard<std::mutex> l(cache_mutex_);
+    AdjustCacheCharge();
+  }
+}
+
+void WriteBufferManager::ScheduleFreeMem(size_t mem) {
+  assert(memory_active_.load(std::memory_order_relaxed) >= mem);
+  memory_active_.fetch_sub(mem, std::memory_order_relaxed);
+}
+
+void WriteBufferManager::FreeMem(size_t mem) {
+  assert(memory_used_.load(std::memory_order_relaxed) >= mem);
+  memory_used_.fetch_sub(mem, std::memory_order_relaxed);
+  if (cache_ != nullptr) {
+    std::lock_guard<std::mutex> l(cache_mutex_);
+    AdjustCacheCharge();
+  }
+}
+
+void WriteBufferManager::AdjustCacheCharge() {
+  const size_t used = memory_used_.load(std::memory_order_relaxed);
+  size_t charged = dummy_entries_.size() * kSizeDummyEntry;
+  while (charged < used) {
+    // Every dummy entry needs its own key; the value is never looked up.
+    const uint64_t id = cache_->NewId();
+    char key[sizeof(id)];
+    EncodeFixed64(key, id);
+    Cache::Handle *handle = cache_->Insert(Slice(key, sizeof(key)), nullptr,
+                                           kSizeDummyEntry, &DeleteDummyEntry);
+    dummy_entries_.emplace_back(id, handle);
+    charged += kSizeDummyEntry;
+  }
+  // Give memory back with some slack, so that usage hovering around an
+  // entry boundary does not insert and erase the same entry over and over.
+  while (!dummy_entries_.empty() && used < charged / 4 * 3 &&
+         charged - kSizeDummyEntry >= used) {
+    ReleaseDummyEntry(dummy_entries_.back());
+    dummy_entries_.pop_back();
+    charged -= kSizeDummyEntry;
+  }
+  dummy_size_.store(charged, std::memory_order_relaxed);
+}
+
+void WriteBufferManager::ReleaseDummyEntry(
+    const std::pair<uint64_t, Cache::Handle *> &entry) {
+  // Erase() as well, so that the entry does not linger in the LRU list
+  // holding its charge until it happens to be evicted.
+  char key[sizeof(entry.first)];
+  EncodeFixed64(key, entry.first);
+  cache_->Erase(Slice(key, sizeof(key)));
+  cache_->Release(entry.second);
+}
+
+void WriteBufferManager::RegisterConsumer(Consumer *consumer) {
+  std::lock_guard<std::mutex> l(consumers_mutex_);
+  consumers_.push_back(consumer);
+}
+
+void WriteBufferManager::UnregisterConsumer(Consumer *consumer) {
+  std::lock_guard<std::mutex> l(consumers_mutex_);
+  consumers_.erase(std::remove(consumers_.begin(), consumers_.end(), consumer),
+                   consumers_.end());
+}
+
+WriteBufferManager::Consumer *WriteBufferManager::RequestFlushOfLargest() {
+  std::lock_guard<std::mutex> l(consumers_mutex_);
+  Consumer *largest = nullptr;
+  size_t largest_usage = 0;
+  for (Consumer *consumer : consumers_) {
+    const size_t usage = consumer->MutableMemTableUsage();
+    if (usage > largest_usage) {
+      largest = consumer;
+      largest_usage = usage;
+    }
+  }
+  if (largest != nullptr) { largest->RequestFlush(); }
+  return largest;
+}
+
+} // namespace leveldb
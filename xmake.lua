@@ -3,15 +3,16 @@ add_rules("mode.debug", "mode.release")
 set_languages("c++20")
 
 add_requires("gtest", {configs = {main = true, gmock = true}})
+add_requires("benchmark")
 
-local src_files = os.files("src/**.cpp")
+local src_files = {}
 
--- local test_files =  {}
-for i,f in ipairs(src_files) do
+-- every src/**/test_*.cpp is a standalone gtest binary and every
+-- src/**/bench_*.cpp a standalone Google Benchmark binary, everything else
+-- goes into the library
+for _, f in ipairs(os.files("src/**.cpp")) do
     local file_name = path.basename(f)
     if string.match(file_name, "^test_") ~= nil then
-        table.remove(src_files,i)
-        -- table.append(test_files,f)
         target(file_name)
             set_kind("binary")
             add_packages("gtest")
@@ -20,7 +21,21 @@ for i,f in ipairs(src_files) do
             add_files(f)
             add_deps("rocksdb")
             set_group("tests")
-
+    elseif string.match(file_name, "^bench_") ~= nil then
+        -- `xmake run -g benchmarks` also writes <name>.json next to the
+        -- binary so that CI can diff the results against a baseline
+        target(file_name)
+            set_kind("binary")
+            add_packages("benchmark")
+            add_includedirs("src", "include")
+            add_links("benchmark_main")
+            add_files(f)
+            add_deps("rocksdb")
+            set_group("benchmarks")
+            set_runargs("--benchmark_out=" .. file_name .. ".json",
+                        "--benchmark_out_format=json")
+    else
+        table.insert(src_files, f)
     end
 end
 
@@ -31,6 +46,30 @@ target("rocksdb")
     add_includedirs("include", {pulic = true})
     add_includedirs("src")
 
+target("db_bench")
+    set_kind("binary")
+    add_files("binary/db_bench.cpp")
+    add_includedirs("src", "include")
+    add_deps("rocksdb")
+    add_syslinks("pthread")
+    set_group("benchmarks")
+
+target("trace_replay")
+    set_kind("binary")
+    add_files("binary/trace_replay.cpp")
+    add_includedirs("src", "include")
+    add_deps("rocksdb")
+    add_syslinks("pthread")
+    set_group("tools")
+
+target("block_cache_trace_analyzer")
+    set_kind("binary")
+    add_files("binary/block_cache_trace_analyzer.cpp")
+    add_includedirs("src", "include")
+    add_deps("rocksdb")
+    add_syslinks("pthread")
+    set_group("tools")
+
 includes("tests")
 
 --